@@ -0,0 +1,212 @@
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "AsyncMemory.h"
+#include "ChildTarget.h"
+
+// Values read per frame, and frames measured
+static const size_t kValues = 256;
+static const int kFrames = 2000;
+
+// Values the benchmark reads from the target
+static int32_t values[kValues];
+
+static double NanosecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Queues a read whose callback holds the I/O thread until release is set, and waits until it holds it
+static void BlockThread(AsyncMemory& async, std::shared_future<void> release) {
+	std::shared_ptr<std::promise<void>> blocked = std::make_shared<std::promise<void>>();
+	std::future<void> holding = blocked->get_future();
+	async.ReadMemory((uintptr_t)&values[0], sizeof(int32_t), [blocked, release](AsyncStatus, const uint8_t*, size_t) {
+		blocked->set_value();
+		release.wait();
+	});
+	holding.wait();
+}
+
+int main() {
+	for (size_t i = 0; i < kValues; ++i) {
+		values[i] = (int32_t)i * 3;
+	}
+
+	// Target process: keep the values alive until the parent is done
+	ChildTarget target;
+	if (!target.Start()) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	int status = 0;
+	{
+		AsyncMemory async(memory);
+
+		// Every value comes back through its future
+		std::vector<std::future<AsyncValue<int32_t>>> reads;
+		for (size_t i = 0; i < kValues; ++i) {
+			reads.push_back(async.Read<int32_t>((uintptr_t)&values[i]));
+		}
+		for (size_t i = 0; i < kValues; ++i) {
+			AsyncValue<int32_t> result = reads[i].get();
+			if (!result.Succeeded() || result.value != (int32_t)i * 3) {
+				fprintf(stderr, "Value %zu was not read\n", i);
+				status = 1;
+			}
+		}
+
+		// Requests run in the order they were queued, so a read sees the write queued before it
+		std::future<AsyncStatus> first = async.Write<int32_t>((uintptr_t)&values[0], 100);
+		std::future<AsyncValue<int32_t>> between = async.Read<int32_t>((uintptr_t)&values[0]);
+		std::future<AsyncStatus> second = async.Write<int32_t>((uintptr_t)&values[0], 200);
+		std::future<AsyncValue<std::vector<uint8_t>>> after = async.ReadMemory((uintptr_t)&values[0], sizeof(int32_t));
+		AsyncValue<int32_t> seen = between.get();
+		AsyncValue<std::vector<uint8_t>> last = after.get();
+		if (first.get() != AsyncStatus::Completed || second.get() != AsyncStatus::Completed || seen.value != 100
+			|| last.value.size() != sizeof(int32_t) || *(const int32_t*)last.value.data() != 200) {
+			fprintf(stderr, "Reads and writes did not run in order\n");
+			status = 1;
+		}
+		async.Write<int32_t>((uintptr_t)&values[0], 0).get();
+
+		// An unmapped address fails without affecting its neighbours in the batch
+		std::future<AsyncValue<int32_t>> before = async.Read<int32_t>((uintptr_t)&values[1]);
+		std::future<AsyncValue<int32_t>> unmapped = async.Read<int32_t>(0);
+		std::future<AsyncValue<int32_t>> next = async.Read<int32_t>((uintptr_t)&values[2]);
+		if (!before.get().Succeeded() || unmapped.get().status != AsyncStatus::Failed || !next.get().Succeeded()) {
+			fprintf(stderr, "A failed read affected its neighbours\n");
+			status = 1;
+		}
+
+		// Requests that go stale while the thread is busy are dropped instead of read
+		std::promise<void> release;
+		BlockThread(async, release.get_future().share());
+		CancellationToken frame = CancellationToken::Create();
+		AsyncRequestOptions cancellable;
+		cancellable.token = frame;
+		AsyncRequestOptions expiring;
+		expiring.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+		std::future<AsyncValue<int32_t>> cancelled = async.Read<int32_t>((uintptr_t)&values[1], cancellable);
+		std::future<AsyncStatus> cancelledWrite = async.Write<int32_t>((uintptr_t)&values[1], -1, cancellable);
+		std::future<AsyncValue<int32_t>> expired = async.Read<int32_t>((uintptr_t)&values[1], expiring);
+		std::future<AsyncValue<int32_t>> kept = async.Read<int32_t>((uintptr_t)&values[1]);
+		frame.Cancel();
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		release.set_value();
+		if (cancelled.get().status != AsyncStatus::Cancelled || cancelledWrite.get() != AsyncStatus::Cancelled
+			|| expired.get().status != AsyncStatus::Expired || kept.get().value != 3) {
+			fprintf(stderr, "Stale requests were not dropped\n");
+			status = 1;
+		}
+
+		// Reading a frame of values one call at a time
+		int64_t checksum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < kFrames; ++frame) {
+			for (size_t i = 0; i < kValues; ++i) {
+				checksum += memory.Read<int32_t>((uintptr_t)&values[i]);
+			}
+		}
+		double syncNs = NanosecondsSince(start) / kFrames;
+
+		// The same frame queued as futures; the thread submits what queued up meanwhile as one batch
+		int64_t futureChecksum = 0;
+		double futureQueueNs = 0;
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < kFrames; ++frame) {
+			auto queued = std::chrono::steady_clock::now();
+			reads.clear();
+			for (size_t i = 0; i < kValues; ++i) {
+				reads.push_back(async.Read<int32_t>((uintptr_t)&values[i]));
+			}
+			futureQueueNs += NanosecondsSince(queued);
+			for (std::future<AsyncValue<int32_t>>& read : reads) {
+				futureChecksum += read.get().value;
+			}
+		}
+		double futureNs = NanosecondsSince(start) / kFrames;
+		futureQueueNs /= kFrames;
+
+		// As one future for the whole frame
+		std::vector<uintptr_t> addresses;
+		for (size_t i = 0; i < kValues; ++i) {
+			addresses.push_back((uintptr_t)&values[i]);
+		}
+		int64_t groupChecksum = 0;
+		double groupQueueNs = 0;
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < kFrames; ++frame) {
+			auto queued = std::chrono::steady_clock::now();
+			std::future<std::vector<AsyncValue<int32_t>>> group = async.Read<int32_t>(addresses);
+			groupQueueNs += NanosecondsSince(queued);
+			for (const AsyncValue<int32_t>& value : group.get()) {
+				groupChecksum += value.value;
+			}
+		}
+		double groupNs = NanosecondsSince(start) / kFrames;
+		groupQueueNs /= kFrames;
+
+		// And as callbacks, waiting only for the last one
+		int64_t callbackChecksum = 0;
+		double callbackQueueNs = 0;
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < kFrames; ++frame) {
+			auto queued = std::chrono::steady_clock::now();
+			std::promise<void> done;
+			for (size_t i = 0; i < kValues; ++i) {
+				async.ReadMemory((uintptr_t)&values[i], sizeof(int32_t), [&, i](AsyncStatus, const uint8_t* data, size_t) {
+					callbackChecksum += data ? *(const int32_t*)data : 0;
+					if (i == kValues - 1) {
+						done.set_value();
+					}
+				});
+			}
+			callbackQueueNs += NanosecondsSince(queued);
+			done.get_future().wait();
+		}
+		double callbackNs = NanosecondsSince(start) / kFrames;
+		callbackQueueNs /= kFrames;
+
+		if (checksum != futureChecksum || checksum != groupChecksum || checksum != callbackChecksum) {
+			fprintf(stderr, "Asynchronous reads returned other values than synchronous ones\n");
+			status = 1;
+		}
+
+		AsyncStatistics statistics = async.GetStatistics();
+		// The caller only blocks while queueing; the rest of the frame time it is free to do other work
+		printf("%24s %14s %14s\n", "read a frame", "total ns", "caller ns");
+		printf("%24s %14.0f %14.0f\n", "one call per value", syncNs, syncNs);
+		printf("%24s %14.0f %14.0f\n", "one future per value", futureNs, futureQueueNs);
+		printf("%24s %14.0f %14.0f\n", "one future per frame", groupNs, groupQueueNs);
+		printf("%24s %14.0f %14.0f\n", "callbacks", callbackNs, callbackQueueNs);
+		printf("speedup %.1fx per value, %.1fx per frame, %.1fx with callbacks\n", syncNs / futureNs, syncNs / groupNs, syncNs / callbackNs);
+		printf("%zu requests in %zu batches, %.1f per batch, largest %zu\n",
+			statistics.submitted, statistics.batches, statistics.GetAverageBatch(), statistics.largestBatch);
+
+		// Destroying an AsyncMemory cancels what is still queued
+		std::unique_ptr<AsyncMemory> doomed(new AsyncMemory(memory));
+		std::promise<void> releaseDoomed;
+		BlockThread(*doomed, releaseDoomed.get_future().share());
+		std::future<AsyncValue<int32_t>> abandoned = doomed->Read<int32_t>((uintptr_t)&values[1]);
+		std::thread releaser([&releaseDoomed] {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			releaseDoomed.set_value();
+		});
+		doomed.reset();
+		releaser.join();
+		if (abandoned.get().status != AsyncStatus::Cancelled) {
+			fprintf(stderr, "A queued request survived the destructor\n");
+			status = 1;
+		}
+	}
+
+	target.Stop();
+	return status;
+}
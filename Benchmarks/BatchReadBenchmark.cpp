@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "ChildTarget.h"
+#include "Memory.h"
+
+// Distance between two benchmarked fields, so that a batch touches many different pages
+static const size_t kFieldStride = 1024;
+
+// Number of times every batch size is measured
+static const int kIterations = 2000;
+
+int main() {
+	// Field counts per tick to compare, up to more than one IOV_MAX chunk
+	const size_t fieldCounts[] = { 1, 16, 64, 256, 1024, 4096 };
+	const size_t maxFields = 4096;
+
+	// Allocate the fields before forking, so the child has them at the same addresses
+	std::vector<int> fields(maxFields * kFieldStride / sizeof(int));
+
+	// Target process: give every field a known value, signal the parent and wait until it is done
+	ChildTarget target;
+	bool started = target.Start(
+		[&] {
+			for (size_t i = 0; i < maxFields; ++i) {
+				fields[i * kFieldStride / sizeof(int)] = (int)(i * 3);
+			}
+		},
+		[](char) {});
+	if (!started) {
+		return 1;
+	}
+
+	HANDLE process = Platform::OpenProcessHandle(target.GetProcessID());
+	if (!process) {
+		fprintf(stderr, "Failed to open child process %d\n", (int)target.GetProcessID());
+		return 1;
+	}
+
+	printf("%8s %16s %16s %10s\n", "fields", "Read<int> ns", "ReadBatch ns", "speedup");
+
+	for (size_t fieldCount : fieldCounts) {
+		std::vector<int> values(fieldCount);
+		std::vector<BatchEntry> entries(fieldCount);
+		for (size_t i = 0; i < fieldCount; ++i) {
+			entries[i].address = (uintptr_t)&fields[i * kFieldStride / sizeof(int)];
+			entries[i].buffer = &values[i];
+			entries[i].size = sizeof(int);
+		}
+
+		// One Read<int> call, and therefore one system call, per field
+		auto start = std::chrono::steady_clock::now();
+		long long checksum = 0;
+		for (int iteration = 0; iteration < kIterations; ++iteration) {
+			for (size_t i = 0; i < fieldCount; ++i) {
+				checksum += Memory::Read<int>(process, entries[i].address);
+			}
+		}
+		double loopNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kIterations;
+
+		// The same fields as one vectored batch
+		start = std::chrono::steady_clock::now();
+		bool success = true;
+		for (int iteration = 0; iteration < kIterations; ++iteration) {
+			success &= Memory::ReadBatch(process, entries);
+		}
+		double batchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kIterations;
+
+		// Both paths must have read the child's values, not the parent's zeroes
+		long long expected = 0;
+		for (size_t i = 0; i < fieldCount; ++i) {
+			expected += (long long)i * 3;
+			success &= values[i] == (int)(i * 3);
+		}
+		if (!success || checksum != expected * kIterations) {
+			fprintf(stderr, "Read mismatch for %zu fields\n", fieldCount);
+			return 1;
+		}
+
+		printf("%8zu %16.0f %16.0f %9.1fx\n", fieldCount, loopNs, batchNs, loopNs / batchNs);
+	}
+
+	Platform::CloseProcessHandle(process);
+	target.Stop();
+	return 0;
+}
@@ -0,0 +1,429 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "ChildTarget.h"
+#include "Scanner.h"
+
+// Objects are placed in slots of this size, so they never overlap
+static const size_t kSlotSize = 0x100;
+
+// Every 64 KiB a planted value sits at this offset of the first slot, which holds no object
+static const size_t kPlantStride = 1 << 16;
+static const size_t kPlantOffset = 0xF0;
+static const int32_t kPlantedValue = 0x5EED1234;
+
+// Offsets of the next pointer and of the value in a chain node
+static const unsigned int kNextOffset = 0x18;
+static const unsigned int kValueOffset = 0x20;
+
+// Signature planted in the last slot of the heap, so finding it searches every region
+static const char* kSignature = "DE AD ?? EF 13 37 C0 DE ?? ?? 5E ED 00 11 22 33";
+static const uint8_t kSignatureBytes[16] = { 0xDE, 0xAD, 0xBE, 0xEF, 0x13, 0x37, 0xC0, 0xDE, 0x01, 0x02, 0x5E, 0xED, 0x00, 0x11, 0x22, 0x33 };
+
+// Reads and writes timed per latency measurement
+static const size_t kLatencyOps = 100000;
+
+// Most chains the root table holds
+static const size_t kMaxChains = 1 << 16;
+
+// Receives the values read, so the reads are not optimized away
+static volatile int64_t sink = 0;
+
+// Roots of the pointer chains, in the main module like the statics a real target has
+static uintptr_t chainRoots[kMaxChains];
+
+/**
+ * @brief Shape of the stand-in target, set from the command line.
+ */
+struct TargetLayout {
+	size_t heapMegabytes = 256;  // Total size of the heap regions
+	size_t regionMegabytes = 16; // Size of each region
+	size_t chains = 1024;        // Pointer chains from chainRoots into the heap
+	size_t depth = 4;            // Pointers followed per chain
+	size_t strings = 1024;       // NUL-terminated strings planted in the heap
+	size_t stringLength = 32;    // Characters per string, below kSlotSize
+	uint64_t seed = 1;           // Seed of everything random, so runs are comparable
+};
+
+/**
+ * @brief The heap of the stand-in target and where everything was planted.
+ *
+ * It is built before the fork, so the parent knows every address in the child.
+ */
+struct Target {
+	std::vector<MemoryRegion> regions;
+	std::vector<uintptr_t> chainResults;  // Final address of every chain
+	std::vector<uintptr_t> strings;       // Address of every string
+	std::vector<uintptr_t> scratch;       // Slots the write benchmark may overwrite
+	std::vector<uintptr_t> fields;        // Slots the read benchmarks read
+	uintptr_t signature = 0;              // Address of the signature
+	size_t plantedValues = 0;
+};
+
+/**
+ * @brief One measurement of the suite.
+ */
+struct Result {
+	std::string name;
+	std::string unit;
+	double value = 0;
+	size_t threads = 1;
+};
+
+/**
+ * @brief Hands out random free slots of the heap.
+ */
+class SlotAllocator {
+private:
+	const Target& target;
+	size_t slotsPerRegion;
+	std::unordered_set<uintptr_t> used;
+	std::mt19937_64& random;
+
+public:
+	SlotAllocator(const Target& target, size_t regionSize, std::mt19937_64& random) : target(target), slotsPerRegion(regionSize / kSlotSize), random(random) {
+	}
+
+	bool Reserve(uintptr_t address) {
+		return this->used.insert(address).second;
+	}
+
+	uintptr_t Next() {
+		for (;;) {
+			const MemoryRegion& region = this->target.regions[this->random() % this->target.regions.size()];
+			size_t slot = this->random() % this->slotsPerRegion;
+
+			// The first slot of every 64 KiB holds a planted value
+			if (slot % (kPlantStride / kSlotSize) == 0) {
+				continue;
+			}
+
+			uintptr_t address = region.base + slot * kSlotSize;
+			if (this->used.insert(address).second) {
+				return address;
+			}
+		}
+	}
+};
+
+/**
+ * @brief Maps the heap regions, fills them with random words and plants values, chains, strings and signatures.
+ */
+static bool BuildTarget(const TargetLayout& layout, Target& target) {
+	size_t regionSize = layout.regionMegabytes << 20;
+	size_t regionCount = std::max<size_t>(1, layout.heapMegabytes / layout.regionMegabytes);
+	std::mt19937_64 random(layout.seed);
+
+	for (size_t i = 0; i < regionCount; ++i) {
+		void* base = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (base == MAP_FAILED) {
+			perror("mmap");
+			return false;
+		}
+
+		// Random words, none of them equal to the planted value
+		uint64_t state = random();
+		uint32_t* words = (uint32_t*)base;
+		for (size_t j = 0; j < regionSize / sizeof(uint32_t); ++j) {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			words[j] = (uint32_t)state == (uint32_t)kPlantedValue ? 0 : (uint32_t)state;
+		}
+		for (size_t offset = kPlantOffset; offset < regionSize; offset += kPlantStride) {
+			std::memcpy((uint8_t*)base + offset, &kPlantedValue, sizeof(kPlantedValue));
+			++target.plantedValues;
+		}
+
+		MemoryRegion region;
+		region.base = (uintptr_t)base;
+		region.size = regionSize;
+		region.writable = true;
+		target.regions.push_back(region);
+	}
+
+	SlotAllocator slots(target, regionSize, random);
+	target.signature = target.regions.back().base + regionSize - kSlotSize;
+	slots.Reserve(target.signature);
+	std::memcpy((void*)target.signature, kSignatureBytes, sizeof(kSignatureBytes));
+
+	// Chains of depth pointers: chainRoots[i] -> node + kNextOffset -> ... -> last node + kValueOffset
+	for (size_t i = 0; i < layout.chains; ++i) {
+		uintptr_t node = slots.Next();
+		chainRoots[i] = node;
+		for (size_t hop = 1; hop < layout.depth; ++hop) {
+			uintptr_t next = slots.Next();
+			std::memcpy((void*)(node + kNextOffset), &next, sizeof(next));
+			node = next;
+		}
+		target.chainResults.push_back(node + kValueOffset);
+	}
+
+	for (size_t i = 0; i < layout.strings; ++i) {
+		char* text = (char*)slots.Next();
+		for (size_t j = 0; j < layout.stringLength; ++j) {
+			text[j] = (char)('a' + random() % 26);
+		}
+		text[layout.stringLength] = '\0';
+		target.strings.push_back((uintptr_t)text);
+	}
+
+	for (size_t i = 0; i < 4096; ++i) {
+		target.scratch.push_back(slots.Next());
+		target.fields.push_back(slots.Next());
+	}
+	return true;
+}
+
+/**
+ * @brief Runs an operation count times and returns the nanoseconds per operation.
+ */
+template <typename Operation>
+static double TimeNanoseconds(size_t count, Operation operation) {
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; ++i) {
+		operation(i);
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+}
+
+/**
+ * @brief Writes a string as a JSON string literal.
+ */
+static void WriteJsonString(FILE* file, const std::string& text) {
+	fputc('"', file);
+	for (char character : text) {
+		if (character == '"' || character == '\\') {
+			fputc('\\', file);
+		}
+		if ((unsigned char)character >= 0x20) {
+			fputc(character, file);
+		}
+	}
+	fputc('"', file);
+}
+
+/**
+ * @brief Writes the layout and every result as one JSON object.
+ */
+static void WriteJson(FILE* file, const std::string& label, const TargetLayout& layout, const std::vector<Result>& results) {
+	fprintf(file, "{\n\t\"label\": ");
+	WriteJsonString(file, label);
+	fprintf(file, ",\n\t\"timestamp\": %lld,\n\t\"simd\": ", (long long)std::time(nullptr));
+	WriteJsonString(file, GetSimdLevelName(GetSimdLevel()));
+	fprintf(file, ",\n\t\"hardwareThreads\": %u,\n", std::max(1u, std::thread::hardware_concurrency()));
+	fprintf(file, "\t\"layout\": { \"heapMegabytes\": %zu, \"regionMegabytes\": %zu, \"chains\": %zu, \"depth\": %zu, \"strings\": %zu, \"stringLength\": %zu, \"seed\": %llu },\n",
+		layout.heapMegabytes, layout.regionMegabytes, layout.chains, layout.depth, layout.strings, layout.stringLength, (unsigned long long)layout.seed);
+	fprintf(file, "\t\"results\": [\n");
+	for (size_t i = 0; i < results.size(); ++i) {
+		fprintf(file, "\t\t{ \"name\": ");
+		WriteJsonString(file, results[i].name);
+		fprintf(file, ", \"unit\": ");
+		WriteJsonString(file, results[i].unit);
+		fprintf(file, ", \"value\": %.6g, \"threads\": %zu }%s\n", results[i].value, results[i].threads, i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "\t]\n}\n");
+}
+
+/**
+ * @brief Prints the command line options.
+ */
+static void PrintUsage(const char* program) {
+	fprintf(stderr, "Usage: %s [--heap MiB] [--region MiB] [--chains N] [--depth N] [--strings N] [--seed N] [--threads N] [--label TEXT] [--output FILE]\n", program);
+}
+
+int main(int argc, char** argv) {
+	TargetLayout layout;
+	size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::string label, output;
+	for (int i = 1; i < argc; ++i) {
+		const char* option = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!value) {
+			PrintUsage(argv[0]);
+			return 1;
+		}
+
+		if (!std::strcmp(option, "--heap")) {
+			layout.heapMegabytes = std::strtoull(value, nullptr, 10);
+		}
+		else if (!std::strcmp(option, "--region")) {
+			layout.regionMegabytes = std::max<size_t>(1, std::strtoull(value, nullptr, 10));
+		}
+		else if (!std::strcmp(option, "--chains")) {
+			layout.chains = std::min<size_t>(kMaxChains, std::strtoull(value, nullptr, 10));
+		}
+		else if (!std::strcmp(option, "--depth")) {
+			layout.depth = std::max<size_t>(1, std::strtoull(value, nullptr, 10));
+		}
+		else if (!std::strcmp(option, "--strings")) {
+			layout.strings = std::strtoull(value, nullptr, 10);
+		}
+		else if (!std::strcmp(option, "--seed")) {
+			layout.seed = std::strtoull(value, nullptr, 10);
+		}
+		else if (!std::strcmp(option, "--threads")) {
+			maxThreads = std::max<size_t>(1, std::strtoull(value, nullptr, 10));
+		}
+		else if (!std::strcmp(option, "--label")) {
+			label = value;
+		}
+		else if (!std::strcmp(option, "--output")) {
+			output = value;
+		}
+		else {
+			PrintUsage(argv[0]);
+			return 1;
+		}
+		++i;
+	}
+
+	fprintf(stderr, "building a %zu MiB target in %zu MiB regions\n", layout.heapMegabytes, layout.regionMegabytes);
+	Target target;
+	if (!BuildTarget(layout, target)) {
+		return 1;
+	}
+
+	// Target process: keep the heap alive until the parent is done
+	ChildTarget child;
+	if (!child.Start()) {
+		return 1;
+	}
+
+	std::vector<Result> results;
+	int status = 0;
+
+	// Attach time, including the lookup of the main module
+	const size_t attaches = 20;
+	double attachNanoseconds = TimeNanoseconds(attaches, [&](size_t) {
+		Memory attached(child.GetProcessID());
+		status |= !attached.isAttached();
+	});
+	results.push_back({ "attach", "ms", attachNanoseconds / 1e6 });
+
+	Memory& memory = child.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	// Read<T>, TryRead<T> and Write<T> latency on random slots
+	int64_t sum = 0;
+	const std::vector<uintptr_t>& fields = target.fields;
+	results.push_back({ "read_int32", "ns/op", TimeNanoseconds(kLatencyOps, [&](size_t i) { sum += memory.Read<int32_t>(fields[i % fields.size()]); }) });
+	results.push_back({ "try_read_int32", "ns/op", TimeNanoseconds(kLatencyOps, [&](size_t i) { sum += memory.TryRead<int32_t>(fields[i % fields.size()]).value_or(0); }) });
+	results.push_back({ "write_int32", "ns/op", TimeNanoseconds(kLatencyOps, [&](size_t i) { memory.Write<int32_t>(target.scratch[i % target.scratch.size()], (int32_t)i); }) });
+
+	// Cached reads of 256 fields on 16 pages, one frame per pass
+	memory.EnableCache();
+	results.push_back({ "read_int32_cached", "ns/op", TimeNanoseconds(kLatencyOps, [&](size_t i) {
+		if (i % 256 == 0) {
+			memory.BeginFrame();
+		}
+		sum += memory.Read<int32_t>(fields[i % 16] + (i % 256 / 16) * sizeof(int32_t) * 4);
+	}) });
+	memory.DisableCache();
+
+	// GetAddress chains per second, checked against the planted results
+	std::vector<unsigned int> offsets(layout.depth, kNextOffset);
+	offsets.back() = kValueOffset;
+	std::vector<uintptr_t> bases(layout.chains);
+	for (size_t i = 0; i < layout.chains; ++i) {
+		bases[i] = (uintptr_t)&chainRoots[i] - memory.GetModuleBaseAddress();
+	}
+
+	size_t chainOps = std::max<size_t>(layout.chains, 20000);
+	size_t wrongChains = 0;
+	double chainNanoseconds = TimeNanoseconds(chainOps, [&](size_t i) {
+		wrongChains += memory.GetAddress(bases[i % layout.chains], offsets) != target.chainResults[i % layout.chains];
+	});
+	results.push_back({ "get_address", "chains/s", 1e9 / chainNanoseconds });
+	chainNanoseconds = TimeNanoseconds(chainOps, [&](size_t i) {
+		wrongChains += memory.TryGetAddress(bases[i % layout.chains], offsets) != target.chainResults[i % layout.chains];
+	});
+	results.push_back({ "try_get_address", "chains/s", 1e9 / chainNanoseconds });
+
+	PointerResolver resolver;
+	for (size_t i = 0; i < layout.chains; ++i) {
+		resolver.Add(PointerPath(bases[i], offsets));
+	}
+	std::vector<uintptr_t> resolved;
+	size_t rounds = std::max<size_t>(1, chainOps / std::max<size_t>(1, layout.chains));
+	chainNanoseconds = TimeNanoseconds(rounds, [&](size_t) {
+		memory.GetAddresses(resolver, resolved);
+	});
+	wrongChains += resolved != target.chainResults;
+	results.push_back({ "get_addresses_batched", "chains/s", 1e9 * layout.chains / chainNanoseconds });
+	if (wrongChains) {
+		fprintf(stderr, "%zu chains resolved to the wrong address\n", wrongChains);
+		status = 1;
+	}
+
+	// ReadString into a caller buffer and into a std::string
+	if (!target.strings.empty()) {
+		char buffer[256];
+		size_t wrongStrings = 0;
+		results.push_back({ "read_string", "ns/op", TimeNanoseconds(kLatencyOps, [&](size_t i) {
+			wrongStrings += memory.ReadString(target.strings[i % target.strings.size()], buffer, sizeof(buffer)) != layout.stringLength;
+		}) });
+		results.push_back({ "read_string_std", "ns/op", TimeNanoseconds(kLatencyOps, [&](size_t i) {
+			wrongStrings += memory.ReadString(target.strings[i % target.strings.size()], 255).size() != layout.stringLength;
+		}) });
+		if (wrongStrings) {
+			fprintf(stderr, "%zu strings were read with the wrong length\n", wrongStrings);
+			status = 1;
+		}
+	}
+
+	// Value scans with 1, 2, 4, ... threads
+	for (size_t threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+		ScanOptions options;
+		options.threadCount = threads;
+		options.writableOnly = true;
+		Scanner scanner(memory, options);
+		ScanResults<int32_t> found = scanner.FirstScan<int32_t>(kPlantedValue);
+		if (found.GetCount() < target.plantedValues) {
+			fprintf(stderr, "The scan found %zu of %zu planted values\n", found.GetCount(), target.plantedValues);
+			status = 1;
+		}
+		results.push_back({ "scan_int32", "GB/s", scanner.GetStatistics().GetThroughput(), threads });
+
+		if (threads == maxThreads) {
+			break;
+		}
+	}
+
+	// Signature search over the heap regions
+	auto start = std::chrono::steady_clock::now();
+	std::vector<uintptr_t> signatures = memory.FindPatterns(target.regions, { Pattern(kSignature) });
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (signatures[0] != target.signature) {
+		fprintf(stderr, "The signature search found %p, expected %p\n", (void*)signatures[0], (void*)target.signature);
+		status = 1;
+	}
+	size_t heapBytes = target.regions.size() * target.regions[0].size;
+	results.push_back({ "find_patterns", "GB/s", heapBytes / seconds / 1e9 });
+
+	child.Stop();
+
+	FILE* file = output.empty() ? stdout : fopen(output.c_str(), "w");
+	if (!file) {
+		perror("fopen");
+		return 1;
+	}
+	WriteJson(file, label, layout, results);
+	if (file != stdout) {
+		fclose(file);
+	}
+
+	sink = sum;
+	return status;
+}
@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "ChildTarget.h"
+#include "Memory.h"
+
+// Entities in the child's entity list, as in a typical game loop
+static const size_t kEntityCount = 64;
+
+// Size of one entity structure in bytes
+static const size_t kEntitySize = 512;
+
+// Fields read from every entity per frame
+static const size_t kFieldOffsets[] = { 0x04, 0x08, 0x0C, 0x30, 0x34, 0x38, 0xEC, 0x1F0 };
+
+// Frames simulated per configuration
+static const size_t kFrames = 2000;
+
+/**
+ * @brief Reads every field of every entity once, as one frame of a game loop, and returns their sum.
+ */
+static long long ReadFrame(Memory& memory, uintptr_t entities) {
+	long long sum = 0;
+	for (size_t entity = 0; entity < kEntityCount; ++entity) {
+		for (size_t offset : kFieldOffsets) {
+			sum += memory.Read<int>(entities + entity * kEntitySize + offset);
+		}
+	}
+	return sum;
+}
+
+int main() {
+	// Allocated before fork, so the entity list has the same address in the child
+	std::vector<uint8_t> entities(kEntityCount * kEntitySize);
+	for (size_t i = 0; i < entities.size(); ++i) {
+		entities[i] = (uint8_t)(i * 7);
+	}
+	uintptr_t address = (uintptr_t)entities.data();
+
+	// Target process: keep the entity list alive until the parent is done
+	ChildTarget target;
+	if (!target.Start()) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	size_t reads = kEntityCount * (sizeof(kFieldOffsets) / sizeof(kFieldOffsets[0]));
+	printf("%zu entities, %zu field reads per frame, %zu frames\n", kEntityCount, reads, kFrames);
+	printf("%-10s %12s %12s %10s %10s\n", "cache", "us/frame", "misses/frame", "hit rate", "pages");
+
+	long long expected = 0;
+	int status = 0;
+
+	for (bool cached : { false, true }) {
+		if (cached) {
+			memory.EnableCache();
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for (size_t frame = 0; frame < kFrames; ++frame) {
+			memory.BeginFrame();
+			long long sum = ReadFrame(memory, address);
+
+			// Both configurations must see the same values
+			if (!cached && frame == 0) {
+				expected = sum;
+			} else if (sum != expected) {
+				fprintf(stderr, "Frame %zu read %lld, expected %lld\n", frame, sum, expected);
+				status = 1;
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		PageCacheStatistics statistics = memory.GetCacheStatistics();
+		printf("%-10s %12.2f %12.2f %9.1f%% %10zu\n", cached ? "enabled" : "disabled", seconds / kFrames * 1e6,
+			cached ? (double)statistics.misses / kFrames : (double)reads, statistics.GetHitRate() * 100, statistics.pages);
+	}
+
+	// Writes go through to the target and update the cached page
+	uintptr_t health = address + 0xEC;
+	memory.Read<int>(health);
+	memory.Write<int>(health, 999);
+	if (memory.Read<int>(health) != 999 || Memory::Read<int>(memory.GetProcess(), health) != 999) {
+		fprintf(stderr, "Write through the cache was not visible\n");
+		status = 1;
+	}
+
+	target.Stop();
+	return status;
+}
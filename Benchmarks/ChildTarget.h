@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Memory.h"
+
+/**
+ * @brief A forked child process for a benchmark to attach to.
+ *
+ * Data allocated before Start exists at the same address in the child, so a benchmark builds its
+ * target data, starts the child and reads the data back through the child's memory. The child
+ * waits until Stop (or the destruction of the ChildTarget), running the commands sent by Command
+ * in between:
+ *
+ *     ChildTarget target;
+ *     if (!target.Start([&](char step) { ApplyStep(step, heap); })) {
+ *         return 1;
+ *     }
+ *     Memory& memory = target.Attach();
+ *     if (!memory.isAttached()) {
+ *         return 1;
+ *     }
+ *     target.Command(kIncrease); // returns once the child applied the step
+ *
+ * Commands are single nonzero bytes; 0 is sent by Stop and ends the child.
+ */
+class ChildTarget {
+private:
+	pid_t child = -1;
+	int command = -1; // Write end of the pipe carrying commands to the child
+	int done = -1;    // Read end of the pipe carrying the child's replies
+	std::unique_ptr<Memory> memory;
+
+	// Sends a byte to the child, and waits for its reply unless the byte stops it
+	bool Send(char byte) {
+		if (write(this->command, &byte, 1) != 1) {
+			return false;
+		}
+		return byte == 0 || read(this->done, &byte, 1) == 1;
+	}
+
+public:
+	ChildTarget() = default;
+
+	ChildTarget(const ChildTarget&) = delete;
+	ChildTarget& operator=(const ChildTarget&) = delete;
+
+	/**
+	 * @brief Stops the child if it still runs.
+	 */
+	~ChildTarget() {
+		this->Stop();
+	}
+
+	/**
+	 * @brief Forks the child and waits until it is ready.
+	 *
+	 * @param setup Runs in the child before it reports ready, e.g. to fill memory only the child holds.
+	 * @param handle Runs in the child for every command, given the command byte.
+	 * @return True if the child runs, false if the pipes or the fork failed.
+	 */
+	template <typename Setup, typename Handle>
+	bool Start(const Setup& setup, const Handle& handle) {
+		int commandPipe[2], donePipe[2];
+		if (pipe(commandPipe) || pipe(donePipe)) {
+			perror("pipe");
+			return false;
+		}
+
+		this->child = fork();
+		if (this->child < 0) {
+			perror("fork");
+			close(commandPipe[0]);
+			close(commandPipe[1]);
+			close(donePipe[0]);
+			close(donePipe[1]);
+			return false;
+		}
+		if (this->child == 0) {
+			// Without the parent's ends, a parent that dies without Stop still ends the child
+			close(commandPipe[1]);
+			close(donePipe[0]);
+			setup();
+			char byte = 0;
+			write(donePipe[1], &byte, 1);
+			while (read(commandPipe[0], &byte, 1) == 1 && byte != 0) {
+				handle(byte);
+				write(donePipe[1], &byte, 1);
+			}
+			_exit(0);
+		}
+
+		close(commandPipe[0]);
+		close(donePipe[1]);
+		this->command = commandPipe[1];
+		this->done = donePipe[0];
+		char byte = 0;
+		return read(this->done, &byte, 1) == 1;
+	}
+
+	/**
+	 * @brief Forks a child that runs commands.
+	 */
+	template <typename Handle>
+	bool Start(const Handle& handle) {
+		return this->Start([] {}, handle);
+	}
+
+	/**
+	 * @brief Forks a child that only keeps its memory alive.
+	 */
+	bool Start() {
+		return this->Start([](char) {});
+	}
+
+	/**
+	 * @brief Runs a command in the child and waits until it finished.
+	 *
+	 * @param byte The command, which must not be 0.
+	 */
+	bool Command(char byte) {
+		return byte != 0 && this->Send(byte);
+	}
+
+	/**
+	 * @brief Attaches to the child on the first call, printing the error if that fails.
+	 *
+	 * @return The Memory instance attached to the child; check isAttached.
+	 */
+	Memory& Attach() {
+		if (!this->memory) {
+			this->memory.reset(new Memory((DWORD)this->child));
+			if (!this->memory->isAttached()) {
+				fprintf(stderr, "Failed to attach to child: %s\n", this->memory->GetErrorMessage().c_str());
+			}
+		}
+		return *this->memory;
+	}
+
+	/**
+	 * @brief Returns the process ID of the child, which stays valid after Stop.
+	 */
+	DWORD GetProcessID() const {
+		return (DWORD)this->child;
+	}
+
+	/**
+	 * @brief Ends the child and waits for it to exit. The Memory instance stays valid, but reads fail from now on.
+	 */
+	void Stop() {
+		if (this->command < 0) {
+			return;
+		}
+
+		this->Send(0);
+		close(this->command);
+		close(this->done);
+		this->command = -1;
+		this->done = -1;
+		waitpid(this->child, nullptr, 0);
+	}
+};
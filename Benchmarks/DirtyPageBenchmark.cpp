@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "ChildTarget.h"
+#include "Scanner.h"
+
+// Value of every 16th element of the child's heap when the first scan runs
+static const int32_t kInitialValue = 100;
+
+// Number of rescans after the first scan
+static const int kStepCount = 3;
+
+// Elements per 4 KiB page
+static const size_t kPageElements = 0x1000 / sizeof(int32_t);
+
+// Each step writes one page out of this many, leaving the rest of the heap untouched
+static const size_t kPageStride = 1024;
+
+/**
+ * @brief Applies one step to the heap, as the target process does: the first element of a few pages changes.
+ */
+static void ApplyStep(int step, std::vector<int32_t>& heap) {
+	for (size_t i = step * kPageElements; i < heap.size(); i += kPageStride * kPageElements) {
+		heap[i] += step;
+	}
+}
+
+int main(int argc, char** argv) {
+	// Size of the child's heap in MiB, configurable from the command line
+	size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+	size_t count = megabytes * (1 << 20) / sizeof(int32_t);
+
+	// Allocated before fork, so the heap has the same address in the child
+	std::vector<int32_t> heap(count);
+	for (size_t i = 0; i < count; ++i) {
+		heap[i] = i % 16 == 0 ? kInitialValue : -1 - (int32_t)i;
+	}
+
+	// Target process: apply every step it is told to and report back
+	ChildTarget target;
+	if (!target.Start([&](char step) { ApplyStep(step, heap); })) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	// The same scans with and without skipping clean pages
+	ScanOptions options;
+	options.writableOnly = true;
+	Scanner full(memory, options);
+	Scanner tracked(memory, options);
+	DirtyPageTracker tracker(memory.GetProcess());
+	tracked.SetDirtyTracker(&tracker);
+
+	ScanResults<int32_t> fullResults = full.FirstScan<int32_t>(kInitialValue);
+	ScanResults<int32_t> trackedResults = tracked.FirstScan<int32_t>(kInitialValue);
+	printf("heap %zu MiB, %zu results, soft-dirty tracking %s\n", megabytes, trackedResults.GetCount(),
+		tracker.IsTracking() ? "available" : "unavailable, reading everything");
+	printf("%-10s %12s %12s %12s %12s %12s\n", "step", "results", "full MiB", "full ms", "dirty MiB", "dirty ms");
+
+	const char* names[kStepCount + 1] = { "first", "unchanged", "changed", "unchanged" };
+	int status = 0;
+
+	for (int step = 1; step <= kStepCount; ++step) {
+		// Let the child write a few pages, then rescan with both scanners
+		target.Command((char)step);
+
+		NextScanCompare compare = step == 2 ? NextScanCompare::Changed : NextScanCompare::Unchanged;
+		tracked.NextScan(trackedResults, compare);
+		full.NextScan(fullResults, compare);
+
+		// Skipping clean pages must not change a single result
+		if (trackedResults.GetAddresses() != fullResults.GetAddresses()) {
+			fprintf(stderr, "Step %s kept %zu results with tracking, %zu without\n", names[step], trackedResults.GetCount(), fullResults.GetCount());
+			status = 1;
+			break;
+		}
+
+		const ScanStatistics& fullStatistics = full.GetStatistics();
+		const ScanStatistics& trackedStatistics = tracked.GetStatistics();
+		printf("%-10s %12zu %12.1f %12.2f %12.1f %12.2f\n", names[step], trackedResults.GetCount(),
+			fullStatistics.bytesScanned / 1048576.0, fullStatistics.seconds * 1e3,
+			trackedStatistics.bytesScanned / 1048576.0, trackedStatistics.seconds * 1e3);
+	}
+
+	target.Stop();
+	return status;
+}
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "ChildTarget.h"
+#include "Scanner.h"
+
+// Size of the heap searched, in MiB
+static const size_t kHeapMegabytes = 128;
+
+// Share of the heap's 32-bit words holding the common value
+static const double kCommonShare = 0.1;
+
+// Structures matching the whole group, and near misses that only fail one field
+static const size_t kPlanted = 50;
+static const size_t kDecoys = 1000;
+
+// The structure searched for: health at +0, a float in [0, 1] at +8 and a heap pointer at +0x10
+struct Player {
+	int32_t health;
+	int32_t padding0;
+	float ratio;
+	int32_t padding1;
+	void* target;
+};
+
+int main() {
+	// A heap full of 100s and random words, with the structures and decoys at 8 byte aligned places
+	size_t words = (kHeapMegabytes << 20) / sizeof(uint32_t);
+	std::vector<uint32_t> heap(words);
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> share(0.0, 1.0);
+	for (uint32_t& word : heap) {
+		word = share(random) < kCommonShare ? 100 : random();
+	}
+
+	int32_t* pointee = new int32_t(5);
+	std::vector<uintptr_t> planted;
+	size_t stride = words / (kPlanted + 2 * kDecoys + 1) & ~(size_t)1;
+	for (size_t i = 0; i < kPlanted + 2 * kDecoys; ++i) {
+		Player player = { 100, 0, 0.5f, 0, pointee };
+		if (i >= kPlanted + kDecoys) {
+			player.target = (void*)(uintptr_t)0x1234;
+		}
+		else if (i >= kPlanted) {
+			player.ratio = 2.0f;
+		}
+
+		uint32_t* at = &heap[(i + 1) * stride];
+		std::memcpy(at, &player, sizeof(player));
+		if (i < kPlanted) {
+			planted.push_back((uintptr_t)at);
+		}
+	}
+
+	// Target process: keep the heap alive until the parent is done
+	ChildTarget target;
+	if (!target.Start()) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	ScanOptions options;
+	options.writableOnly = true;
+	Scanner scanner(memory, options);
+	int status = 0;
+
+	// The single value scan finds every 100
+	ScanResults<int32_t> single = scanner.FirstScan<int32_t>(100);
+	ScanStatistics singleStatistics = scanner.GetStatistics();
+
+	// The group scan finds the structures
+	ScanGroup group;
+	group.Add<int32_t>(0x0, 100);
+	group.Add(0x8, ScanPredicate<float>::Between(0.0f, 1.0f));
+	group.AddPointer(0x10);
+	std::vector<uintptr_t> found = scanner.GroupScan(group);
+	ScanStatistics groupStatistics = scanner.GetStatistics();
+
+	printf("heap %zu MiB, %.0f%% of the words hold 100, %zu structures, %zu near misses\n", kHeapMegabytes, kCommonShare * 100, kPlanted, 2 * kDecoys);
+	printf("%-14s %12s %10s %10s\n", "scan", "results", "seconds", "GB/s");
+	printf("%-14s %12zu %10.3f %10.2f\n", "int == 100", single.GetCount(), singleStatistics.seconds, singleStatistics.GetThroughput());
+	printf("%-14s %12zu %10.3f %10.2f\n", "group", found.size(), groupStatistics.seconds, groupStatistics.GetThroughput());
+
+	// Inside the heap, exactly the planted structures match
+	uintptr_t begin = (uintptr_t)heap.data(), end = begin + heap.size() * sizeof(uint32_t);
+	std::vector<uintptr_t> inHeap;
+	for (uintptr_t address : found) {
+		if (address >= begin && address < end) {
+			inHeap.push_back(address);
+		}
+	}
+	if (inHeap != planted) {
+		fprintf(stderr, "The group scan found %zu structures in the heap, expected %zu\n", inHeap.size(), planted.size());
+		status = 1;
+	}
+
+	target.Stop();
+	return status;
+}
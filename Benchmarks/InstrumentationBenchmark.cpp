@@ -0,0 +1,82 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "ChildTarget.h"
+#include "Memory.h"
+
+// Calls made per API, and probes recorded to measure the cost of recording
+static const size_t kCalls = 20000;
+static const size_t kOverheadRecords = 10000000;
+
+// A value, a string and a two level chain in the target
+static int32_t value = 42;
+static char name[] = "instrumented";
+static int32_t* inner = &value;
+static int32_t** outer = &inner;
+
+int main() {
+	// Target process: keep the globals alive until the parent is done
+	ChildTarget target;
+	if (!target.Start()) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	// Every instrumented API, with one failing read in every ten, timing every call
+	size_t defaultInterval = Instrumentation::GetSampleInterval();
+	Instrumentation::SetSampleInterval(1);
+	Instrumentation::Reset();
+	int64_t sum = 0;
+	uintptr_t base = (uintptr_t)&outer - memory.GetModuleBaseAddress();
+	for (size_t i = 0; i < kCalls; ++i) {
+		sum += memory.Read<int32_t>(i % 10 ? (uintptr_t)&value : 0);
+		memory.Write<int32_t>((uintptr_t)&value, 42);
+		sum += memory.ReadString((uintptr_t)name, 32).size();
+		sum += memory.GetAddress(base, { 0x0, 0x0 }) == (uintptr_t)&value;
+	}
+	sum += memory.GetRegions().size();
+
+	InstrumentationReport report = Instrumentation::Collect();
+	printf("%s", report.ToText().c_str());
+	printf("%s\n", report.ToJson().c_str());
+
+	int status = 0;
+	if (!Instrumentation::IsEnabled()) {
+		printf("instrumentation is disabled, configure with -DMEMORYHACKING_INSTRUMENTATION=ON to record\n");
+	}
+	else {
+		const ProbeStatistics& reads = report.Get(Probe::Read);
+		const ProbeStatistics& hops = report.Get(Probe::AddressHop);
+		if (reads.calls != kCalls || reads.timed != kCalls || reads.failures != kCalls / 10 || reads.bytes != (kCalls - kCalls / 10) * sizeof(int32_t) ||
+			report.Get(Probe::Write).calls != kCalls || report.Get(Probe::ReadString).calls != kCalls ||
+			hops.calls != 2 * kCalls || hops.failures || report.Get(Probe::RegionEnumeration).calls != 1) {
+			fprintf(stderr, "The recorded calls do not match the calls made\n");
+			status = 1;
+		}
+
+		// The cost of recording alone, without a call around it, timing every call and one in the default interval
+		for (size_t interval : { (size_t)1, defaultInterval }) {
+			Instrumentation::SetSampleInterval(interval);
+			auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < kOverheadRecords; ++i) {
+				MEMORY_PROBE_START(probeStart);
+				MEMORY_PROBE_END(probeStart, Probe::Read, true, sizeof(int32_t));
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			printf("recording a probe timing 1 call in %zu costs %.2f ns\n", interval, seconds * 1e9 / kOverheadRecords);
+		}
+	}
+
+	if (sum == 0) {
+		fprintf(stderr, "Nothing was read\n");
+		status = 1;
+	}
+
+	target.Stop();
+	return status;
+}
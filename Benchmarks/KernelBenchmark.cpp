@@ -0,0 +1,146 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "ScanKernels.h"
+
+// Size of the buffer every kernel runs over
+static const size_t kBufferSize = 4 << 20;
+
+// Times every kernel runs over the buffer when measuring throughput
+static const int kIterations = 5;
+
+// Number of mismatches between the vector and scalar kernels
+static int failures = 0;
+
+// Plants copies of a value at random offsets, so every predicate has matches at all alignments
+template <typename T>
+void Plant(std::vector<uint8_t>& buffer, T value, std::mt19937& random) {
+	for (int i = 0; i < 1000; ++i) {
+		size_t offset = random() % (buffer.size() - sizeof(T));
+		std::memcpy(buffer.data() + offset, &value, sizeof(T));
+	}
+}
+
+// Runs one kernel configuration at a fixed instruction set and returns its offsets and GB/s
+template <typename T>
+double Run(const ScanPredicate<T>& predicate, const ScanInput& input, SimdLevel level, std::vector<uint32_t>& offsets, int iterations) {
+	auto start = std::chrono::steady_clock::now();
+	for (int iteration = 0; iteration < iterations; ++iteration) {
+		offsets.clear();
+		ScanKernel<T>::Find(predicate, input, offsets, level);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return (double)(input.limit - input.first) * iterations / seconds / 1e9;
+}
+
+// Compares every instruction set with the scalar kernel over many strides and start offsets
+template <typename T>
+void Verify(const char* name, const char* compare, const ScanPredicate<T>& predicate, const std::vector<uint8_t>& buffer) {
+	const size_t strides[] = { 1, 2, 3, 4, 8, 12, 16, 32, 64 };
+	const SimdLevel levels[] = { SimdLevel::SSE42, SimdLevel::AVX2 };
+
+	for (size_t stride : strides) {
+		for (size_t first = 0; first < 5; ++first) {
+			// Odd sizes and limits make the scalar tail handle a few candidates as well
+			ScanInput input;
+			input.data = buffer.data();
+			input.size = buffer.size() - first * 3;
+			input.first = first;
+			input.limit = input.size - first;
+			input.stride = stride;
+
+			std::vector<uint32_t> expected, actual;
+			Run(predicate, input, SimdLevel::Scalar, expected, 1);
+
+			for (SimdLevel level : levels) {
+				if (level > GetSimdLevel()) {
+					continue;
+				}
+				Run(predicate, input, level, actual, 1);
+				if (actual != expected) {
+					fprintf(stderr, "MISMATCH %s %s %s stride %zu first %zu: %zu vs %zu offsets\n",
+						name, compare, GetSimdLevelName(level), stride, first, actual.size(), expected.size());
+					++failures;
+				}
+			}
+		}
+	}
+}
+
+// Measures packed (stride == sizeof(T)) and every-byte (stride 1) scans at every instruction set
+template <typename T>
+void Measure(const char* name, const char* compare, const ScanPredicate<T>& predicate, const std::vector<uint8_t>& buffer) {
+	const size_t strides[] = { sizeof(T), 1 };
+
+	for (size_t stride : strides) {
+		ScanInput input;
+		input.data = buffer.data();
+		input.size = buffer.size();
+		input.limit = buffer.size();
+		input.stride = stride;
+
+		std::vector<uint32_t> offsets;
+		printf("%-9s %-8s %6zu", name, compare, stride);
+		for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE42, SimdLevel::AVX2 }) {
+			if (level > GetSimdLevel()) {
+				printf(" %10s", "-");
+				continue;
+			}
+			printf(" %10.2f", Run(predicate, input, level, offsets, kIterations));
+		}
+		printf(" %10zu\n", offsets.size());
+	}
+}
+
+template <typename T>
+void Benchmark(const char* name, T value, T low, T high, T epsilon) {
+	// Random bytes with planted values, so the buffer holds matches, near misses, NaNs and infinities
+	std::mt19937 random(1234);
+	std::vector<uint8_t> buffer(kBufferSize);
+	for (uint8_t& byte : buffer) {
+		byte = (uint8_t)random();
+	}
+	Plant(buffer, value, random);
+	Plant(buffer, low, random);
+	Plant(buffer, high, random);
+	Plant(buffer, (T)(value + epsilon / 2), random);
+
+	ScanPredicate<T> equal = ScanPredicate<T>::Equal(value);
+	ScanPredicate<T> between = ScanPredicate<T>::Between(low, high);
+	ScanPredicate<T> near = ScanPredicate<T>::Near(value, epsilon);
+
+	Verify(name, "equal", equal, buffer);
+	Verify(name, "between", between, buffer);
+	Verify(name, "near", near, buffer);
+
+	Measure(name, "equal", equal, buffer);
+	Measure(name, "between", between, buffer);
+	Measure(name, "near", near, buffer);
+}
+
+int main() {
+	printf("Best instruction set: %s\n", GetSimdLevelName(GetSimdLevel()));
+	printf("%-9s %-8s %6s %10s %10s %10s %10s\n", "type", "compare", "stride", "Scalar", "SSE4.2", "AVX2", "matches");
+
+	Benchmark<int8_t>("int8", 100, -5, 5, 2);
+	Benchmark<uint8_t>("uint8", 100, 200, 250, 2);
+	Benchmark<int16_t>("int16", 1000, -500, 500, 10);
+	Benchmark<uint16_t>("uint16", 1000, 40000, 50000, 10);
+	Benchmark<int32_t>("int32", 100, -1000, 1000, 5);
+	Benchmark<uint32_t>("uint32", 100, 3000000000u, 3000001000u, 5);
+	Benchmark<int64_t>("int64", 100, -1000, 1000, 5);
+	Benchmark<uint64_t>("uint64", 100, 1ull << 63, (1ull << 63) + 1000, 5);
+	Benchmark<float>("float", 100.0f, 0.0f, 1.0f, 0.01f);
+	Benchmark<double>("double", 100.0, 0.0, 1.0, 0.01);
+
+	// Non-zero exit code when any vector kernel disagrees with the scalar reference
+	if (failures) {
+		fprintf(stderr, "%d kernel mismatches\n", failures);
+		return 1;
+	}
+
+	printf("All vector kernels match the scalar kernel\n");
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "ChildTarget.h"
+#include "Memory.h"
+
+// Addresses symbolized per run, as in a large report
+static const size_t kAddressCount = 1 << 20;
+
+// Name lookups and refreshes timed per method
+static const size_t kLookups = 200;
+
+/**
+ * @brief Returns the seconds elapsed since start.
+ */
+static double SecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+	// Target process: the same modules as this benchmark
+	ChildTarget target;
+	if (!target.Start()) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	int status = 0;
+	ModuleMap& map = memory.GetModuleMap();
+	const std::vector<ModuleEntry>& modules = map.GetModules();
+	if (modules.empty()) {
+		fprintf(stderr, "No modules found\n");
+		return 1;
+	}
+	std::wstring name = modules.back().name;
+	printf("%zu modules, %zu regions\n", modules.size(), map.GetRegions().size());
+	printf("%-36s %12s\n", "operation", "ns/call");
+
+	// Every lookup parses the maps file again
+	auto start = std::chrono::steady_clock::now();
+	uintptr_t base = 0;
+	for (size_t i = 0; i < kLookups; ++i) {
+		base = Memory::GetModuleBaseAddress(memory.GetProcessID(), name.c_str());
+	}
+	printf("%-36s %12.0f\n", "static GetModuleBaseAddress", SecondsSince(start) / kLookups * 1e9);
+
+	// Lookups served from the hash map
+	start = std::chrono::steady_clock::now();
+	uintptr_t mapped = 0;
+	for (size_t i = 0; i < kLookups * 1000; ++i) {
+		mapped += memory.GetModuleBaseAddress(name);
+	}
+	printf("%-36s %12.0f\n", "member GetModuleBaseAddress", SecondsSince(start) / (kLookups * 1000) * 1e9);
+	if (mapped != base * kLookups * 1000) {
+		fprintf(stderr, "The map found %s at a different base\n", std::string(name.begin(), name.end()).c_str());
+		status = 1;
+	}
+
+	// A refresh with no module changes only compares the signature
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < kLookups; ++i) {
+		map.Refresh();
+	}
+	printf("%-36s %12.0f\n", "Refresh, unchanged", SecondsSince(start) / kLookups * 1e9);
+
+	// A full rebuild enumerates modules and regions and parses every module
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < kLookups; ++i) {
+		ModuleMap fresh(memory.GetProcess());
+		fresh.Refresh();
+	}
+	printf("%-36s %12.0f\n", "full enumeration", SecondsSince(start) / kLookups * 1e9);
+
+	// Random addresses, most of them inside modules
+	std::mt19937_64 random(1234);
+	std::vector<uintptr_t> addresses(kAddressCount);
+	for (uintptr_t& address : addresses) {
+		const ModuleEntry& module = modules[random() % modules.size()];
+		address = module.base + random() % (module.size + module.size / 8);
+	}
+
+	// Symbolize everything, checking against a linear search
+	char text[256];
+	size_t total = 0;
+	start = std::chrono::steady_clock::now();
+	for (uintptr_t address : addresses) {
+		total += map.Symbolize(address, text, sizeof(text));
+	}
+	printf("%-36s %12.1f\n", "Symbolize", SecondsSince(start) / kAddressCount * 1e9);
+
+	ModuleLocation location;
+	start = std::chrono::steady_clock::now();
+	size_t inside = 0;
+	for (uintptr_t address : addresses) {
+		inside += map.Lookup(address, location);
+	}
+	printf("%-36s %12.1f\n", "Lookup", SecondsSince(start) / kAddressCount * 1e9);
+
+	for (size_t i = 0; i < 1000; ++i) {
+		uintptr_t address = addresses[i];
+		const ModuleEntry* expected = nullptr;
+		for (const ModuleEntry& module : modules) {
+			if (address >= module.base && address < module.base + module.size) {
+				expected = &module;
+			}
+		}
+
+		map.Symbolize(address, text, sizeof(text));
+		char reference[256];
+		if (expected) {
+			snprintf(reference, sizeof(reference), "%s+%zX", std::string(expected->name.begin(), expected->name.end()).c_str(), (size_t)(address - expected->base));
+		} else {
+			snprintf(reference, sizeof(reference), "%zX", (size_t)address);
+		}
+		if (strcmp(text, reference) || map.FindByAddress(address) != expected) {
+			fprintf(stderr, "Symbolized %#zx as %s, expected %s\n", (size_t)address, text, reference);
+			status = 1;
+			break;
+		}
+	}
+	printf("%zu of %zu addresses inside modules, %zu characters\n", inside, kAddressCount, total);
+
+	target.Stop();
+	return status;
+}
@@ -0,0 +1,177 @@
+#include <cstdio>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <vector>
+#include "ChildTarget.h"
+#include "Scanner.h"
+
+// Value of every even element of the child's heap when the first scan runs
+static const int32_t kInitialValue = 100;
+
+// Value written by the last step and searched for with an exact next scan
+static const int32_t kFinalValue = 7;
+
+// Number of narrowing steps after the first scan
+static const int kStepCount = 5;
+
+// Command making the child protect one page in the middle of its heap
+static const char kProtectPage = 'p';
+
+// Size of the protected page
+static const uintptr_t kPageSize = 0x1000;
+
+/**
+ * @brief Applies one step of the narrowing sequence to the heap, as the target process does.
+ */
+static void ApplyStep(int step, std::vector<int32_t>& heap) {
+	for (size_t i = 0; i < heap.size(); ++i) {
+		switch (step) {
+		case 1: // Every 8th element increases
+			if (i % 8 == 0) heap[i] = kInitialValue + 1 + (int32_t)(i / 8 % 7);
+			break;
+		case 2: // Every 64th element changes
+			if (i % 64 == 0) heap[i] += 1000;
+			break;
+		case 4: // Every 4096th element decreases
+			if (i % 4096 == 0) heap[i] -= 2000;
+			break;
+		case 5: // Every 65536th element becomes the final value
+			if (i % 65536 == 0) heap[i] = kFinalValue;
+			break;
+		default: // Nothing changes
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Returns true if element i of the heap should survive the given step.
+ */
+static bool Survives(int step, size_t i) {
+	static const size_t kModulus[kStepCount + 1] = { 2, 8, 64, 64, 4096, 65536 };
+	return i % kModulus[step] == 0;
+}
+
+int main(int argc, char** argv) {
+	// Size of the child's heap in MiB, configurable from the command line
+	size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+	size_t count = megabytes * (1 << 20) / sizeof(int32_t);
+
+	// Allocated before fork, so the heap has the same address in the child
+	std::vector<int32_t> heap(count);
+	for (size_t i = 0; i < count; ++i) {
+		heap[i] = i % 2 == 0 ? kInitialValue : -1 - (int32_t)i;
+	}
+	uintptr_t heapBegin = (uintptr_t)heap.data();
+	uintptr_t heapEnd = (uintptr_t)(heap.data() + count);
+
+	// A whole page in the middle of the heap, which the child protects for the last check
+	uintptr_t protectedPage = ((heapBegin + heapEnd) / 2 + kPageSize - 1) & ~(kPageSize - 1);
+
+	// Target process: apply every step it is told to and report back
+	ChildTarget target;
+	bool started = target.Start([&](char step) {
+		if (step == kProtectPage) {
+			mprotect((void*)protectedPage, kPageSize, PROT_NONE);
+		}
+		else {
+			ApplyStep(step, heap);
+		}
+	});
+	if (!started) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	ScanOptions options;
+	options.writableOnly = true;
+	Scanner scanner(memory, options);
+
+	printf("heap %zu MiB, %zu threads\n", megabytes, scanner.GetThreadCount());
+	printf("%-10s %12s %12s %10s %12s %8s %10s %10s\n", "step", "results", "in heap", "KiB", "vector KiB", "dense", "MiB read", "seconds");
+
+	const char* names[kStepCount + 1] = { "first", "increased", "changed", "unchanged", "decreased", "equal" };
+	ScanResults<int32_t> results;
+	int status = 0;
+
+	for (int step = 0; step <= kStepCount; ++step) {
+		if (step == 0) {
+			results = scanner.FirstScan<int32_t>(kInitialValue);
+		} else {
+			// Let the child change its heap, then narrow the results
+			target.Command((char)step);
+
+			switch (step) {
+			case 1: scanner.NextScan(results, NextScanCompare::Increased); break;
+			case 2: scanner.NextScan(results, NextScanCompare::Changed); break;
+			case 3: scanner.NextScan(results, NextScanCompare::Unchanged); break;
+			case 4: scanner.NextScan(results, NextScanCompare::Decreased); break;
+			default: scanner.NextScan(results, ScanPredicate<int32_t>::Equal(kFinalValue)); break;
+			}
+		}
+
+		// Results outside the heap come from the rest of the child and are not checked
+		size_t inHeap = 0;
+		bool wrong = false;
+		results.ForEach([&](uintptr_t address, int32_t) {
+			if (address >= heapBegin && address < heapEnd) {
+				++inHeap;
+				wrong |= !Survives(step, (address - heapBegin) / sizeof(int32_t));
+			}
+		});
+
+		size_t expected = 0;
+		for (size_t i = 0; i < count; ++i) {
+			expected += Survives(step, i);
+		}
+
+		if (wrong || inHeap != expected) {
+			fprintf(stderr, "Step %s found %zu heap results, expected %zu\n", names[step], inHeap, expected);
+			status = 1;
+			break;
+		}
+
+		size_t dense = 0;
+		for (const ScanResults<int32_t>::Region& region : results.GetRegions()) {
+			dense += region.IsDense();
+		}
+
+		const ScanStatistics& statistics = scanner.GetStatistics();
+		printf("%-10s %12zu %12zu %10zu %12zu %4zu/%-3zu %10zu %10.4f\n", names[step], results.GetCount(), inHeap,
+			results.GetMemoryUsage() >> 10, results.GetCount() * sizeof(uintptr_t) >> 10,
+			dense, results.GetRegions().size(), statistics.bytesScanned >> 20, statistics.seconds);
+	}
+
+	// A page protected after the first scan only drops the results on that page, even in a dense chunk
+	if (status == 0) {
+		ScanResults<int32_t> dense = scanner.FirstScan<int32_t>(kInitialValue);
+		size_t before = 0, onPage = 0;
+		dense.ForEach([&](uintptr_t address, int32_t) {
+			before += address >= heapBegin && address < heapEnd;
+			onPage += address >= protectedPage && address < protectedPage + kPageSize;
+		});
+
+		target.Command(kProtectPage);
+		scanner.NextScan(dense, NextScanCompare::Unchanged);
+
+		size_t after = 0;
+		bool wrong = false;
+		dense.ForEach([&](uintptr_t address, int32_t) {
+			after += address >= heapBegin && address < heapEnd;
+			wrong |= address >= protectedPage && address < protectedPage + kPageSize;
+		});
+		printf("protected page: %zu heap results, %zu on the page, %zu kept\n", before, onPage, after);
+
+		if (wrong || onPage == 0 || after != before - onPage) {
+			fprintf(stderr, "Expected %zu heap results to survive the protected page, found %zu\n", before - onPage, after);
+			status = 1;
+		}
+	}
+
+	target.Stop();
+	return status;
+}
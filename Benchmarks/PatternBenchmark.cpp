@@ -0,0 +1,169 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "ChildTarget.h"
+#include "Memory.h"
+
+// Number of signatures resolved per search, as a large cheat table would at attach time
+static const size_t kPatternCount = 200;
+
+// Number of signatures in the small set, which is searched with the vector prefilter
+static const size_t kSmallSetCount = 10;
+
+// Length of every signature, with the displacement bytes 3 to 6 as wildcards
+static const size_t kPatternLength = 16;
+
+/**
+ * @brief Returns the seconds elapsed since start.
+ */
+static double SecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Checks that every pattern was found at or before the position it was taken from.
+ */
+static bool CheckMatches(const std::vector<uint8_t>& image, uintptr_t base, const std::vector<Pattern>& patterns,
+	const std::vector<size_t>& sources, const std::vector<uintptr_t>& found) {
+	for (size_t i = 0; i < patterns.size(); ++i) {
+		if (found[i] < base || found[i] > base + sources[i] || !patterns[i].Matches(image.data() + (found[i] - base))) {
+			fprintf(stderr, "Pattern %zu found at %#zx, taken from %#zx\n", i, (size_t)found[i], (size_t)(base + sources[i]));
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Resolves all patterns with one PatternSet pass and returns the first match of each.
+ */
+static std::vector<uintptr_t> FindAll(const PatternSet& set, const std::vector<uint8_t>& image, uintptr_t base, SimdLevel level) {
+	std::vector<std::vector<uintptr_t>> matches(set.GetCount());
+	set.Find(image.data(), image.size(), image.size(), base, matches, 1, level);
+
+	std::vector<uintptr_t> found;
+	for (const std::vector<uintptr_t>& match : matches) {
+		found.push_back(match.empty() ? 0 : match.front());
+	}
+	return found;
+}
+
+int main(int argc, char** argv) {
+	// Size of the synthetic module image in MiB, configurable from the command line
+	size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+	size_t size = megabytes << 20;
+
+	// Fill the image with bytes that are distributed roughly like x86 code
+	static const uint8_t kCodeBytes[] = { 0x00, 0xFF, 0xCC, 0x48, 0x8B, 0x89, 0x0F, 0xE8, 0x85, 0x83, 0x8D, 0xC3, 0x74, 0x75 };
+	std::mt19937 random(1234);
+	std::vector<uint8_t> image(size);
+	for (uint8_t& byte : image) {
+		uint32_t value = random();
+		byte = value % 100 < 60 ? kCodeBytes[(value >> 8) % sizeof(kCodeBytes)] : (uint8_t)(value >> 16);
+	}
+
+	// Take every signature from a random position, with the displacement bytes wildcarded
+	std::vector<Pattern> patterns;
+	std::vector<size_t> sources;
+	for (size_t i = 0; i < kPatternCount; ++i) {
+		size_t source = random() % (size - kPatternLength);
+		Pattern pattern;
+		pattern.bytes.assign(image.begin() + source, image.begin() + source + kPatternLength);
+		pattern.mask.assign(kPatternLength, 1);
+		for (size_t j = 3; j < 7; ++j) {
+			pattern.bytes[j] = 0;
+			pattern.mask[j] = 0;
+		}
+		patterns.push_back(pattern);
+		sources.push_back(source);
+	}
+
+	uintptr_t base = (uintptr_t)image.data();
+
+	printf("image %zu MiB, %zu patterns of %zu bytes\n", megabytes, kPatternCount, kPatternLength);
+	printf("%-34s %10s\n", "search", "ms");
+
+	// Baseline: compare every pattern at every position until it matches
+	auto start = std::chrono::steady_clock::now();
+	std::vector<uintptr_t> found(kPatternCount, 0);
+	for (size_t i = 0; i < kPatternCount; ++i) {
+		for (size_t position = 0; position + kPatternLength <= size; ++position) {
+			if (patterns[i].Matches(image.data() + position)) {
+				found[i] = base + position;
+				break;
+			}
+		}
+	}
+	double naive = SecondsSince(start);
+	if (!CheckMatches(image, base, patterns, sources, found)) {
+		return 1;
+	}
+	printf("%-34s %10.2f\n", "naive, one pattern at a time", naive * 1e3);
+
+	// Horspool, one pattern at a time
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < kPatternCount; ++i) {
+		PatternSet single;
+		single.Add(patterns[i]);
+		found[i] = FindAll(single, image, base, SimdLevel::Scalar).front();
+	}
+	double horspool = SecondsSince(start);
+	if (!CheckMatches(image, base, patterns, sources, found)) {
+		return 1;
+	}
+	printf("%-34s %10.2f\n", "Horspool, one pattern at a time", horspool * 1e3);
+
+	// All patterns in a single pass, at every instruction set the CPU supports. A small set
+	// uses the vector prefilter, the full set the exact pair lookup.
+	for (size_t count : { kSmallSetCount, kPatternCount }) {
+		PatternSet subset;
+		std::vector<Pattern> subsetPatterns(patterns.begin(), patterns.begin() + count);
+		std::vector<size_t> subsetSources(sources.begin(), sources.begin() + count);
+		for (const Pattern& pattern : subsetPatterns) {
+			subset.Add(pattern);
+		}
+
+		for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE42, SimdLevel::AVX2 }) {
+			if (level > GetSimdLevel()) {
+				continue;
+			}
+
+			start = std::chrono::steady_clock::now();
+			found = FindAll(subset, image, base, level);
+			double seconds = SecondsSince(start);
+			if (!CheckMatches(image, base, subsetPatterns, subsetSources, found)) {
+				return 1;
+			}
+
+			char name[64];
+			snprintf(name, sizeof(name), "single pass, %zu patterns, %s", count, GetSimdLevelName(level));
+			printf("%-34s %10.2f\n", name, seconds * 1e3);
+		}
+	}
+
+	// End to end against a child process, including the bulk copy of the image
+	// Target process: the image was allocated before fork, so it has the same address here
+	ChildTarget target;
+	if (!target.Start()) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	start = std::chrono::steady_clock::now();
+	found = Memory::FindPatterns(memory.GetProcess(), base, size, patterns);
+	double remote = SecondsSince(start);
+
+	target.Stop();
+
+	if (!CheckMatches(image, base, patterns, sources, found)) {
+		return 1;
+	}
+	printf("%-34s %10.2f\n", "FindPatterns on a child process", remote * 1e3);
+	return 0;
+}
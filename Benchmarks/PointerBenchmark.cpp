@@ -0,0 +1,164 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "ChildTarget.h"
+#include "Memory.h"
+
+// Entities in the child's player list
+static const size_t kEntityCount = 64;
+
+// Size of one entity structure in bytes
+static const size_t kEntitySize = 512;
+
+// Offset of the player list pointer in the game structure
+static const unsigned int kListOffset = 0x10;
+
+// Offset of the weapon pointer in an entity, and the weapon fields behind it
+static const unsigned int kWeaponOffset = 0x100;
+static const unsigned int kWeaponFields[] = { 0x20, 0x24 };
+
+// Fields read directly from every entity
+static const unsigned int kEntityFields[] = { 0x04, 0x30, 0x34, 0x38, 0xEC, 0xF0 };
+
+// Paths per entity, its own fields first
+static const size_t kPathsPerEntity = sizeof(kEntityFields) / sizeof(kEntityFields[0]) + sizeof(kWeaponFields) / sizeof(kWeaponFields[0]);
+
+// Number of times every method resolves all paths
+static const size_t kIterations = 2000;
+
+// Resolves per frame in the link caching run, e.g. a 60 Hz tick with links refreshed every frame
+static const size_t kResolvesPerFrame = 8;
+
+int main() {
+	// Build the pointer graph before fork, so the child has it at the same addresses:
+	// game pointer -> game -> player list -> entity -> weapon
+	std::vector<uint8_t> entities(kEntityCount * kEntitySize);
+	std::vector<uint8_t> weapons(kEntityCount * 64);
+	std::vector<uintptr_t> list(kEntityCount);
+	std::vector<uintptr_t> game(8);
+	uintptr_t gamePointer = (uintptr_t)game.data();
+
+	game[kListOffset / sizeof(uintptr_t)] = (uintptr_t)list.data();
+	for (size_t i = 0; i < kEntityCount; ++i) {
+		list[i] = (uintptr_t)&entities[i * kEntitySize];
+		*(uintptr_t*)&entities[i * kEntitySize + kWeaponOffset] = (uintptr_t)&weapons[i * 64];
+	}
+
+	// Every field of every entity as its own path, with the expected result
+	std::vector<PointerPath> paths;
+	std::vector<std::vector<unsigned int>> offsets;
+	std::vector<uintptr_t> expected;
+	for (size_t i = 0; i < kEntityCount; ++i) {
+		for (unsigned int field : kEntityFields) {
+			offsets.push_back({ kListOffset, (unsigned int)(i * sizeof(uintptr_t)), field });
+			expected.push_back(list[i] + field);
+		}
+		for (unsigned int field : kWeaponFields) {
+			offsets.push_back({ kListOffset, (unsigned int)(i * sizeof(uintptr_t)), kWeaponOffset, field });
+			expected.push_back((uintptr_t)&weapons[i * 64] + field);
+		}
+	}
+	for (const std::vector<unsigned int>& chain : offsets) {
+		paths.push_back(PointerPath((uintptr_t)&gamePointer, chain));
+	}
+
+	// Target process: keep the pointer graph alive until the parent is done
+	ChildTarget target;
+	if (!target.Start()) {
+		return 1;
+	}
+
+	HANDLE process = Platform::OpenProcessHandle(target.GetProcessID());
+	if (!process) {
+		fprintf(stderr, "Failed to open child process %d\n", (int)target.GetProcessID());
+		return 1;
+	}
+
+	PointerResolver resolver;
+	for (const PointerPath& path : paths) {
+		resolver.Add(path);
+	}
+
+	size_t hops = 0;
+	for (const PointerPath& path : paths) {
+		hops += path.GetDepth();
+	}
+
+	printf("%zu paths, %zu pointer hops, %zu distinct links\n", paths.size(), hops, resolver.GetLinkCount());
+	printf("%-34s %12s %12s\n", "method", "us/resolve", "reads");
+
+	int status = 0;
+	std::vector<uintptr_t> addresses(paths.size());
+
+	// Checks the addresses of the last iteration against the pointer graph
+	auto check = [&](const char* method) {
+		for (size_t i = 0; i < paths.size(); ++i) {
+			if (addresses[i] != expected[i]) {
+				fprintf(stderr, "%s resolved path %zu to %#zx, expected %#zx\n", method, i, (size_t)addresses[i], (size_t)expected[i]);
+				status = 1;
+				return;
+			}
+		}
+	};
+
+	// One ReadProcessMemory per hop, with the offsets passed as a vector
+	auto start = std::chrono::steady_clock::now();
+	for (size_t iteration = 0; iteration < kIterations; ++iteration) {
+		for (size_t i = 0; i < paths.size(); ++i) {
+			addresses[i] = Memory::GetAddress(process, (uintptr_t)&gamePointer, offsets[i]);
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	check("GetAddress");
+	printf("%-34s %12.2f %12zu\n", "GetAddress, offset vectors", seconds / kIterations * 1e6, hops);
+
+	// One read per hop, with allocation-free paths
+	start = std::chrono::steady_clock::now();
+	for (size_t iteration = 0; iteration < kIterations; ++iteration) {
+		for (size_t i = 0; i < paths.size(); ++i) {
+			addresses[i] = Memory::GetAddress(process, 0, paths[i]);
+		}
+	}
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	check("GetAddress(PointerPath)");
+	printf("%-34s %12.2f %12zu\n", "GetAddress, PointerPath", seconds / kIterations * 1e6, hops);
+
+	// Shared prefixes read once, one batch per level
+	start = std::chrono::steady_clock::now();
+	for (size_t iteration = 0; iteration < kIterations; ++iteration) {
+		Memory::GetAddresses(process, 0, resolver, addresses);
+	}
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	check("PointerResolver");
+	printf("%-34s %12.2f %12zu\n", "PointerResolver", seconds / kIterations * 1e6, resolver.GetLastReadCount());
+
+	// Links cached for the rest of the frame after the first resolve
+	resolver.SetLinkCaching(true);
+	size_t reads = 0;
+	start = std::chrono::steady_clock::now();
+	for (size_t iteration = 0; iteration < kIterations; ++iteration) {
+		if (iteration % kResolvesPerFrame == 0) {
+			resolver.BeginFrame();
+		}
+		Memory::GetAddresses(process, 0, resolver, addresses);
+		reads += resolver.GetLastReadCount();
+	}
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	check("PointerResolver with link caching");
+	printf("%-34s %12.2f %12.1f\n", "PointerResolver, links cached", seconds / kIterations * 1e6, (double)reads / kIterations);
+
+	// A null entity pointer makes the weapon pointer read below it fail, which resolves the weapon paths to 0
+	uintptr_t invalid = 0;
+	size_t first = 3 * kPathsPerEntity;
+	Memory::WriteMemory(process, (uintptr_t)&list[3], &invalid, sizeof(invalid));
+	resolver.BeginFrame();
+	if (Memory::GetAddresses(process, 0, resolver, addresses) || addresses[first] != kEntityFields[0] ||
+		addresses[first + kPathsPerEntity - 1] != 0 || addresses[first + kPathsPerEntity] != expected[first + kPathsPerEntity]) {
+		fprintf(stderr, "A broken link was not reported\n");
+		status = 1;
+	}
+
+	target.Stop();
+	Platform::CloseProcessHandle(process);
+	return status;
+}
@@ -0,0 +1,103 @@
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unistd.h>
+#include <vector>
+#include "ChildTarget.h"
+#include "PointerScanner.h"
+
+// Nodes of the pointer-heavy heap the scan has to wade through
+static const size_t kNodeCount = 1 << 20;
+
+// Pointers per heap node
+static const size_t kNodePointers = 8;
+
+// Static variable holding the first pointer of the chain to the target
+static uintptr_t root = 0;
+
+int main(int argc, char** argv) {
+	// Size of the pointer-heavy heap in MiB of nodes, configurable from the command line
+	size_t nodeCount = argc > 1 ? (std::strtoul(argv[1], nullptr, 10) << 20) / (kNodePointers * sizeof(uintptr_t)) : kNodeCount;
+
+	// A heap of nodes pointing at random other nodes, allocated before fork so the child has it at the same address
+	std::mt19937_64 random(1234);
+	std::vector<uintptr_t> nodes(nodeCount * kNodePointers);
+	for (uintptr_t& pointer : nodes) {
+		pointer = (uintptr_t)&nodes[(random() % nodeCount) * kNodePointers];
+	}
+
+	// The chain to find: root -> first + 0x18 -> second + 0x40 -> target at third + 0x2C
+	std::vector<uint8_t> first(0x100), second(0x100), third(0x100);
+	root = (uintptr_t)first.data();
+	*(uintptr_t*)&first[0x18] = (uintptr_t)second.data();
+	*(uintptr_t*)&second[0x40] = (uintptr_t)third.data();
+	uintptr_t target = (uintptr_t)&third[0x2C];
+	const std::vector<unsigned int> expected = { 0x18, 0x40, 0x2C };
+
+	// Target process: keep the pointers alive until the parent is done
+	ChildTarget child;
+	if (!child.Start()) {
+		return 1;
+	}
+
+	Memory& memory = child.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	int status = 0;
+
+	// An index that does not fit into the budget is refused
+	PointerScanOptions small;
+	small.memoryBudget = 1 << 20;
+	PointerScanner refused(memory, small);
+	if (refused.BuildIndex()) {
+		fprintf(stderr, "An index larger than the budget was built\n");
+		status = 1;
+	}
+
+	PointerScanOptions options;
+	options.maxDepth = 4;
+	options.maxOffset = 0x400;
+	PointerScanner scanner(memory, options);
+
+	if (!scanner.BuildIndex()) {
+		fprintf(stderr, "BuildIndex failed: %s\n", scanner.GetErrorMessage().c_str());
+		return 1;
+	}
+
+	const PointerScanStatistics& statistics = scanner.GetStatistics();
+	printf("index: %zu regions, %.1f MiB read, %zu pointers, %.1f MiB index, %.1f ms\n", statistics.regionCount,
+		statistics.bytesScanned / 1048576.0, statistics.pointerCount, statistics.indexBytes / 1048576.0, statistics.indexSeconds * 1e3);
+
+	std::string path = "/tmp/PointerScanBenchmark." + std::to_string(getpid()) + ".ptr";
+	if (!scanner.Scan(target, path)) {
+		fprintf(stderr, "Scan failed: %s\n", scanner.GetErrorMessage().c_str());
+		return 1;
+	}
+	printf("scan: depth %zu, offsets up to %#zx, %zu paths, %.1f ms\n", options.maxDepth, options.maxOffset,
+		statistics.pathCount, statistics.scanSeconds * 1e3);
+
+	// Every path must lead to the target, and the planted chain must be among them
+	PointerScanHeader header;
+	size_t paths = 0, broken = 0;
+	bool found = false;
+	bool valid = PointerScanner::ReadResults(path, header, [&](const PointerScanResult& result) {
+		const ModuleEntry& module = header.modules[result.module];
+		if (Memory::GetAddress(memory.GetProcess(), module.base, result.ToPath()) != target) {
+			++broken;
+		}
+		found |= module.base + result.offset == (uintptr_t)&root && result.offsets == expected;
+		++paths;
+		return true;
+	});
+	remove(path.c_str());
+
+	if (!valid || paths != statistics.pathCount || broken || !found || header.target != target) {
+		fprintf(stderr, "Read %zu of %zu paths, %zu broken, planted chain %s\n", paths, statistics.pathCount, broken, found ? "found" : "missing");
+		status = 1;
+	}
+
+	child.Stop();
+	return status;
+}
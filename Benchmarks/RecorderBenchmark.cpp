@@ -0,0 +1,184 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "ChildTarget.h"
+#include "Recorder.h"
+
+// Recorded columns, split evenly over four value types
+static const size_t kColumns = 300;
+
+// Every this many columns changes with the generation, the others stay constant
+static const size_t kChangeStride = 10;
+
+// Generations the child steps through, one every kStepMicroseconds
+static const int kGenerations = 400;
+static const int kStepMicroseconds = 5000;
+
+// Values of the target, one array per type
+static int32_t ints[kColumns / 4];
+static float floats[kColumns / 4];
+static double doubles[kColumns / 4];
+static uint16_t shorts[kColumns / 4];
+
+/**
+ * @brief Sets every value for a generation; constant columns ignore it.
+ */
+static void SetGeneration(int generation) {
+	for (size_t i = 0; i < kColumns / 4; ++i) {
+		int step = i % kChangeStride == 0 ? generation : 0;
+		ints[i] = (int32_t)(i * 1000000 + step);
+		floats[i] = (float)(i * 1000 + step);
+		doubles[i] = i * 1e6 + step;
+		shorts[i] = (uint16_t)(i * 100 + step);
+	}
+}
+
+/**
+ * @brief Returns the generation a recorded value belongs to, or -1 if it is not a value of any generation.
+ */
+static int GetGeneration(const RecordingReader& reader, size_t column) {
+	size_t i = column / 4;
+	double value = 0, base = 0;
+	switch (column % 4) {
+	case 0: value = reader.GetValue<int32_t>(column); base = i * 1000000.0; break;
+	case 1: value = reader.GetValue<float>(column); base = i * 1000.0; break;
+	case 2: value = reader.GetValue<double>(column); base = i * 1e6; break;
+	default: value = reader.GetValue<uint16_t>(column); base = i * 100.0; break;
+	}
+
+	double generation = value - base;
+	if (i % kChangeStride != 0) {
+		return generation == 0 ? 0 : -1;
+	}
+	return generation >= 0 && generation <= kGenerations && generation == (int)generation ? (int)generation : -1;
+}
+
+int main(int argc, char** argv) {
+	// Samples per second, configurable from the command line
+	double rate = argc > 1 ? std::strtod(argv[1], nullptr) : 2000.0;
+
+	SetGeneration(0);
+
+	// Target process: step through the generations when told to
+	ChildTarget target;
+	bool started = target.Start([](char) {
+		for (int generation = 1; generation <= kGenerations; ++generation) {
+			usleep(kStepMicroseconds);
+			SetGeneration(generation);
+		}
+	});
+	if (!started) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	RecordOptions options;
+	options.rate = rate;
+	Recorder recorder(memory, options);
+	for (size_t i = 0; i < kColumns / 4; ++i) {
+		recorder.AddColumn<int32_t>((uintptr_t)&ints[i]);
+		recorder.AddColumn<float>((uintptr_t)&floats[i]);
+		recorder.AddColumn<double>((uintptr_t)&doubles[i]);
+		recorder.AddColumn<uint16_t>((uintptr_t)&shorts[i]);
+	}
+
+	std::string path = "/tmp/RecorderBenchmark." + std::to_string(getpid()) + ".rec";
+	if (!recorder.Start(path)) {
+		fprintf(stderr, "Start failed: %s\n", recorder.GetErrorMessage().c_str());
+		return 1;
+	}
+
+	// Record the child stepping through its generations, plus a little of the final state
+	auto start = std::chrono::steady_clock::now();
+	target.Command(1);
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	bool stopped = recorder.Stop();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	target.Stop();
+
+	int status = 0;
+	RecordStatistics statistics = recorder.GetStatistics();
+	printf("%zu columns at %.0f Hz for %.2f s\n", kColumns, rate, seconds);
+	printf("%zu samples, %zu missed, %zu dropped, %zu blocks, %.1f KiB, %.1f bytes per sample (%zu raw)\n", statistics.sampleCount,
+		statistics.missedTicks, statistics.droppedSamples, statistics.blockCount, statistics.fileSize / 1024.0,
+		statistics.sampleCount ? (double)statistics.fileSize / statistics.sampleCount : 0.0, kColumns / 4 * (4 + 4 + 8 + 2));
+	printf("longest sample %.1f us, latest sample %.1f us behind schedule\n", statistics.maxSampleSeconds * 1e6, statistics.maxLateSeconds * 1e6);
+	if (!stopped || statistics.droppedSamples || statistics.failedReads) {
+		fprintf(stderr, "Recording failed: %s\n", recorder.GetErrorMessage().c_str());
+		status = 1;
+	}
+
+	// Every value must belong to a generation, and no column may go back in time
+	RecordingReader reader;
+	if (!reader.Open(path)) {
+		fprintf(stderr, "Open failed: %s\n", reader.GetErrorMessage().c_str());
+		return 1;
+	}
+
+	std::vector<uint64_t> timestamps;
+	std::vector<int> last(kColumns, 0);
+	bool wrong = false;
+	start = std::chrono::steady_clock::now();
+	while (reader.Next()) {
+		timestamps.push_back(reader.GetTimestamp());
+		for (size_t column = 0; column < kColumns; ++column) {
+			int generation = GetGeneration(reader, column);
+			wrong |= generation < last[column];
+			last[column] = generation;
+		}
+	}
+	double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("decoded %zu samples at %.1f M samples/s\n", timestamps.size(), timestamps.size() / decodeSeconds / 1e6);
+
+	for (size_t column = 0; column < kColumns; ++column) {
+		wrong |= last[column] != (column / 4 % kChangeStride == 0 ? kGenerations : 0);
+	}
+	if (wrong || timestamps.size() != statistics.sampleCount || reader.GetSampleCount() != statistics.sampleCount) {
+		fprintf(stderr, "The recording does not match the target (%zu of %zu samples)\n", timestamps.size(), statistics.sampleCount);
+		status = 1;
+	}
+
+	// Seeking lands on the first sample at or after the time, with the same values as reading up to it
+	std::mt19937_64 random(1234);
+	for (int i = 0; i < 100 && !timestamps.empty(); ++i) {
+		uint64_t time = random() % (timestamps.back() + 1);
+		size_t expected = std::lower_bound(timestamps.begin(), timestamps.end(), time) - timestamps.begin();
+		if (!reader.Seek(time) || reader.GetTimestamp() != timestamps[expected]) {
+			fprintf(stderr, "Seek to %llu ns failed\n", (unsigned long long)time);
+			status = 1;
+			break;
+		}
+
+		std::vector<uint64_t> values(kColumns);
+		for (size_t column = 0; column < kColumns; ++column) {
+			values[column] = reader.GetRawValue(column);
+		}
+
+		RecordingReader sequential;
+		sequential.Open(path);
+		for (size_t j = 0; j <= expected; ++j) {
+			sequential.Next();
+		}
+		for (size_t column = 0; column < kColumns; ++column) {
+			wrong |= sequential.GetRawValue(column) != values[column];
+		}
+		if (wrong) {
+			fprintf(stderr, "Seek to %llu ns decoded different values\n", (unsigned long long)time);
+			status = 1;
+			break;
+		}
+	}
+
+	reader.Close();
+	remove(path.c_str());
+	return status;
+}
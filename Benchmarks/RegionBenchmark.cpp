@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sys/mman.h>
+#include <thread>
+#include <vector>
+#include "ChildTarget.h"
+#include "Memory.h"
+
+// Pointer chains resolved, and how many times each one is resolved
+static const size_t kChains = 2000;
+static const size_t kRounds = 20;
+
+// A node of the chains: root -> first -> second -> third, whose value is the result
+struct Node {
+	Node* next;
+	uintptr_t value;
+};
+
+// Roots of the chains in the main module, and the arena holding their nodes
+static Node* roots[kChains];
+static Node* arena = nullptr;
+static const size_t kArenaSize = 3 * kChains * sizeof(Node);
+
+// What each chain runs into
+enum class Hop { Valid, NullRoot, Dangling, Kernel, NullNext };
+static Hop hops[kChains];
+
+/**
+ * @brief Maps a new arena and links the valid chains through it.
+ */
+static void BuildArena() {
+	arena = (Node*)mmap(nullptr, kArenaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	for (size_t i = 0; i < kChains; ++i) {
+		Node* node = &arena[3 * i];
+		node[0].next = hops[i] == Hop::NullNext ? nullptr : &node[1];
+		node[1].next = &node[2];
+		node[2].value = i;
+		if (hops[i] == Hop::Valid || hops[i] == Hop::NullNext) {
+			roots[i] = node;
+		}
+	}
+}
+
+/**
+ * @brief Resolves every chain kRounds times and returns the seconds taken.
+ */
+template <typename Resolve>
+static double Time(Resolve resolve) {
+	auto start = std::chrono::steady_clock::now();
+	for (size_t round = 0; round < kRounds; ++round) {
+		for (size_t i = 0; i < kChains; ++i) {
+			resolve(i);
+		}
+	}
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+	// 40% of the chains are valid, the rest hit null, freed memory, kernel space or a null link, like a loading target
+	std::mt19937 random(3);
+	for (size_t i = 0; i < kChains; ++i) {
+		unsigned kind = random() % 20;
+		hops[i] = kind < 8 ? Hop::Valid : kind < 14 ? Hop::NullRoot : kind < 18 ? Hop::Dangling : kind < 19 ? Hop::Kernel : Hop::NullNext;
+	}
+
+	// Dangling roots point into memory that was freed before the target started
+	BuildArena();
+	Node* freed = (Node*)mmap(nullptr, kArenaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	for (size_t i = 0; i < kChains; ++i) {
+		roots[i] = hops[i] == Hop::Dangling ? &freed[i] : hops[i] == Hop::Kernel ? (Node*)~(uintptr_t)0xFFF : nullptr;
+	}
+	munmap(freed, kArenaSize);
+	for (size_t i = 0; i < kChains; ++i) {
+		if (hops[i] == Hop::Valid || hops[i] == Hop::NullNext) {
+			roots[i] = &arena[3 * i];
+		}
+	}
+
+	// Target process: frees its arena on 'u' and maps a new one on 'm'
+	ChildTarget target;
+	bool started = target.Start([](char byte) {
+		if (byte == 'u') {
+			munmap(arena, kArenaSize);
+		}
+		else if (byte == 'm') {
+			BuildArena();
+		}
+	});
+	if (!started) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	// Chains are resolved relative to the main module, like GetAddress(0x17E0A8, { 0x0, 0x0, 0x8 })
+	std::vector<unsigned int> offsets = { 0x0, 0x0, 0x8 };
+	std::vector<uintptr_t> bases(kChains);
+	for (size_t i = 0; i < kChains; ++i) {
+		bases[i] = (uintptr_t)&roots[i] - memory.GetModuleBaseAddress();
+	}
+
+	std::vector<uintptr_t> plain(kChains), checked(kChains);
+	double plainSeconds = Time([&](size_t i) { plain[i] = memory.GetAddress(bases[i], offsets); });
+	double checkedSeconds = Time([&](size_t i) { checked[i] = memory.TryGetAddress(bases[i], offsets).value_or(0); });
+	RegionTableStatistics statistics = memory.GetRegionTable().GetStatistics();
+
+	printf("%zu chains resolved %zu times, %zu%% valid\n", kChains, kRounds, (size_t)std::count(hops, hops + kChains, Hop::Valid) * 100 / kChains);
+	printf("%-14s %10s %12s\n", "resolve", "ms", "us/chain");
+	printf("%-14s %10.1f %12.3f\n", "GetAddress", plainSeconds * 1e3, plainSeconds * 1e6 / (kChains * kRounds));
+	printf("%-14s %10.1f %12.3f\n", "TryGetAddress", checkedSeconds * 1e3, checkedSeconds * 1e6 / (kChains * kRounds));
+	printf("checks %zu, syscalls avoided %zu (%.0f%%), refreshes %zu, stale reads %zu\n", statistics.checks, statistics.avoided,
+		statistics.GetAvoidedRate() * 100, statistics.refreshes, statistics.staleReads);
+
+	int status = 0;
+	for (size_t i = 0; i < kChains; ++i) {
+		uintptr_t expected = hops[i] == Hop::Valid ? (uintptr_t)&arena[3 * i + 2].value : 0;
+		if (plain[i] != expected || checked[i] != expected) {
+			fprintf(stderr, "Chain %zu resolved to %p and %p, expected %p\n", i, (void*)plain[i], (void*)checked[i], (void*)expected);
+			status = 1;
+			break;
+		}
+	}
+
+	// Once the target frees the arena, one read fails, the table is refreshed and the other hops are skipped
+	std::this_thread::sleep_for(std::chrono::milliseconds(150));
+	target.Command('u');
+	memory.GetRegionTable().ResetStatistics();
+	size_t resolved = 0;
+	for (size_t i = 0; i < kChains; ++i) {
+		resolved += memory.TryGetAddress(bases[i], offsets).has_value();
+	}
+	statistics = memory.GetRegionTable().GetStatistics();
+	printf("after the arena was freed: %zu resolved, stale reads %zu, refreshes %zu\n", resolved, statistics.staleReads, statistics.refreshes);
+	if (resolved || statistics.staleReads != 1) {
+		fprintf(stderr, "Expected no chain to resolve and one stale read\n");
+		status = 1;
+	}
+
+	// A new arena is found by the refresh on the first miss after the refresh interval
+	target.Command('m');
+	std::this_thread::sleep_for(std::chrono::milliseconds(150));
+	std::optional<uintptr_t> moved = memory.TryRead<uintptr_t>((uintptr_t)&arena);
+	resolved = 0;
+	for (size_t i = 0; moved && i < kChains; ++i) {
+		std::optional<uintptr_t> address = memory.TryGetAddress(bases[i], offsets);
+		resolved += hops[i] == Hop::Valid && address == *moved + (3 * i + 2) * sizeof(Node) + sizeof(Node*);
+	}
+	size_t valid = (size_t)std::count(hops, hops + kChains, Hop::Valid);
+	printf("after a new arena was mapped: %zu of %zu resolved\n", resolved, valid);
+	if (resolved != valid) {
+		fprintf(stderr, "Expected every valid chain to resolve through the new arena\n");
+		status = 1;
+	}
+
+	target.Stop();
+	return status;
+}
@@ -0,0 +1,71 @@
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "ChildTarget.h"
+#include "Scanner.h"
+
+// Value planted in the child's heap and searched for by every scan
+static const int32_t kPlantedValue = 0x7EADBEEF;
+
+// Distance between two planted values
+static const size_t kPlantStride = 1 << 16;
+
+int main(int argc, char** argv) {
+	// Size of the child's heap in MiB, configurable from the command line
+	size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+	size_t count = megabytes * (1 << 20) / sizeof(int32_t);
+
+	// Target process: fill the heap with values that never equal the planted one, then plant it
+	std::vector<int32_t> heap;
+	ChildTarget target;
+	bool started = target.Start(
+		[&] {
+			heap.resize(count);
+			for (size_t i = 0; i < count; ++i) {
+				heap[i] = (int32_t)i;
+			}
+			for (size_t i = 0; i < count; i += kPlantStride) {
+				heap[i] = kPlantedValue;
+			}
+		},
+		[](char) {});
+	if (!started) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	size_t expected = (count + kPlantStride - 1) / kPlantStride;
+	size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	printf("heap %zu MiB, %zu planted values\n", megabytes, expected);
+	printf("%8s %12s %12s %10s %10s\n", "threads", "MiB", "results", "seconds", "GB/s");
+
+	// Scan with 1, 2, 4, ... threads up to the number of hardware threads
+	for (size_t threads = 1;; threads = std::min(threads * 2, hardwareThreads)) {
+		ScanOptions options;
+		options.threadCount = threads;
+		options.writableOnly = true;
+
+		Scanner scanner(memory, options);
+		ScanResults<int32_t> results = scanner.FirstScan<int32_t>(kPlantedValue);
+		const ScanStatistics& statistics = scanner.GetStatistics();
+
+		if (results.GetCount() < expected) {
+			fprintf(stderr, "Found %zu of %zu planted values\n", results.GetCount(), expected);
+			return 1;
+		}
+
+		printf("%8zu %12zu %12zu %10.3f %10.2f\n", threads, statistics.bytesScanned >> 20, results.GetCount(), statistics.seconds, statistics.GetThroughput());
+
+		if (threads == hardwareThreads) {
+			break;
+		}
+	}
+
+	target.Stop();
+	return 0;
+}
@@ -0,0 +1,200 @@
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include "SessionManager.h"
+
+// Worker processes forked at first, killed again, and spawned while the manager is tracking
+static const size_t kWorkers = 200;
+static const size_t kKilled = 50;
+static const size_t kSpawned = 20;
+
+// Region every worker scans for its planted values, and the number of values planted
+static const size_t kRegionSize = 1 << 20;
+static const size_t kPlanted = 64;
+static const int32_t kPlantedValue = 0x5E55104;
+
+// Index of the worker, set by every worker after the fork
+static int32_t workerIndex = -1;
+
+// Returns the parent of a process, read from /proc/<pid>/stat after the command name
+static pid_t GetParentID(DWORD processID) {
+	std::ifstream file("/proc/" + std::to_string(processID) + "/stat");
+	std::string stat((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	size_t name = stat.rfind(')');
+	return name == std::string::npos ? 0 : (pid_t)std::strtol(stat.c_str() + name + 4, nullptr, 10);
+}
+
+// Forks a worker that plants its values and waits to be killed
+static pid_t SpawnWorker(int32_t index, int32_t* region, int ready) {
+	pid_t child = fork();
+	if (child == 0) {
+		workerIndex = index;
+		for (size_t i = 0; i < kPlanted; ++i) {
+			region[i * (kRegionSize / sizeof(int32_t) / kPlanted)] = kPlantedValue;
+		}
+		char byte = 0;
+		write(ready, &byte, 1);
+		for (;;) {
+			pause();
+		}
+	}
+	return child;
+}
+
+// Kills and reaps workers
+static void KillAll(const std::vector<pid_t>& children) {
+	for (pid_t child : children) {
+		if (child > 0) {
+			kill(child, SIGKILL);
+			waitpid(child, nullptr, 0);
+		}
+	}
+}
+
+static double SecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+	// The region is mapped before forking, so every worker has it at the same address
+	int32_t* region = (int32_t*)mmap(nullptr, kRegionSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	int ready[2];
+	if (region == MAP_FAILED || pipe(ready)) {
+		perror("setup");
+		return 1;
+	}
+
+	std::vector<pid_t> workers;
+	for (size_t i = 0; i < kWorkers; ++i) {
+		workers.push_back(SpawnWorker((int32_t)i, region, ready[1]));
+		if (workers.back() < 0) {
+			perror("fork");
+			KillAll(workers);
+			return 1;
+		}
+	}
+	char byte = 0;
+	for (size_t i = 0; i < kWorkers; ++i) {
+		read(ready[0], &byte, 1);
+	}
+
+	// Attach to every child of this process, and to those forked later
+	SessionManager manager;
+	pid_t self = getpid();
+	auto start = std::chrono::steady_clock::now();
+	size_t attached = manager.Track([self](DWORD processID, const std::wstring&) { return GetParentID(processID) == self; });
+	double attachSeconds = SecondsSince(start);
+
+	int status = 0;
+	if (attached != kWorkers) {
+		fprintf(stderr, "Attached to %zu of %zu workers\n", attached, kWorkers);
+		status = 1;
+	}
+
+	// Every worker reports its own index
+	start = std::chrono::steady_clock::now();
+	std::vector<SessionValue<std::optional<int32_t>>> indices = manager.Read<int32_t>((uintptr_t)&workerIndex);
+	double readSeconds = SecondsSince(start);
+	for (const SessionValue<std::optional<int32_t>>& index : indices) {
+		if (!index.value || *index.value < 0 || *index.value >= (int32_t)kWorkers || workers[*index.value] != (pid_t)index.processID) {
+			fprintf(stderr, "Worker %u returned the wrong index\n", (unsigned)index.processID);
+			status = 1;
+		}
+	}
+
+	// Every worker is scanned with its chunks spread over the shared pool
+	start = std::chrono::steady_clock::now();
+	std::vector<SessionValue<ScanResults<int32_t>>> scans = manager.FirstScan(ScanPredicate<int32_t>::Equal(kPlantedValue));
+	double scanSeconds = SecondsSince(start);
+	size_t found = 0;
+	for (const SessionValue<ScanResults<int32_t>>& scan : scans) {
+		size_t planted = 0;
+		for (uintptr_t address : scan.value.GetAddresses()) {
+			planted += address >= (uintptr_t)region && address < (uintptr_t)region + kRegionSize;
+		}
+		if (planted != kPlanted) {
+			fprintf(stderr, "Worker %u has %zu planted values instead of %zu\n", (unsigned)scan.processID, planted, kPlanted);
+			status = 1;
+		}
+		found += planted;
+	}
+
+	// A tick of every watcher
+	for (const std::shared_ptr<Session>& session : manager.GetSessions()) {
+		session->GetWatcher().Watch<int32_t>((uintptr_t)&workerIndex);
+	}
+	start = std::chrono::steady_clock::now();
+	manager.Tick();
+	double tickSeconds = SecondsSince(start);
+
+	// A refresh without changes only lists the process IDs and polls the handles
+	start = std::chrono::steady_clock::now();
+	size_t changes = manager.Refresh();
+	double idleSeconds = SecondsSince(start);
+	start = std::chrono::steady_clock::now();
+	Memory::GetProcessID(L"no-such-process");
+	double snapshotSeconds = SecondsSince(start);
+	if (changes) {
+		fprintf(stderr, "A refresh without changes reported %zu\n", changes);
+		status = 1;
+	}
+
+	// Exits are seen through the handles, even before the parent reaps the workers
+	for (size_t i = 0; i < kKilled; ++i) {
+		kill(workers[i], SIGKILL);
+	}
+	std::vector<pid_t> spawned;
+	for (size_t i = 0; i < kSpawned; ++i) {
+		spawned.push_back(SpawnWorker((int32_t)(kWorkers + i), region, ready[1]));
+		if (spawned.back() < 0) {
+			perror("fork");
+			KillAll(workers);
+			KillAll(spawned);
+			return 1;
+		}
+	}
+	for (size_t i = 0; i < kSpawned; ++i) {
+		read(ready[0], &byte, 1);
+	}
+	manager.Start();
+	start = std::chrono::steady_clock::now();
+	while (manager.GetSessionCount() != kWorkers - kKilled + kSpawned && SecondsSince(start) < 5) {
+		Sleep(1);
+	}
+	manager.Stop();
+
+	size_t exits = 0, spawns = 0;
+	SessionEvent event;
+	while (manager.PollEvent(event)) {
+		exits += event.type == SessionEvent::Exited;
+		spawns += event.type == SessionEvent::Attached;
+	}
+
+	SessionStatistics statistics = manager.GetStatistics();
+	if (exits != kKilled || spawns != kWorkers + kSpawned || manager.GetSessionCount() != kWorkers - kKilled + kSpawned || statistics.failedAttaches) {
+		fprintf(stderr, "Tracked %zu exits and %zu attaches, %zu sessions, %zu failed attaches\n", exits, spawns, manager.GetSessionCount(), statistics.failedAttaches);
+		status = 1;
+	}
+
+	printf("%zu workers on %zu threads\n", kWorkers, manager.GetThreadPool().GetThreadCount());
+	printf("%-28s %10.2f ms\n", "attach", attachSeconds * 1e3);
+	printf("%-28s %10.2f ms\n", "read one value each", readSeconds * 1e3);
+	printf("%-28s %10.2f ms (%zu values)\n", "scan each", scanSeconds * 1e3, found);
+	printf("%-28s %10.2f ms\n", "tick each watcher", tickSeconds * 1e3);
+	printf("%-28s %10.2f ms\n", "refresh without changes", idleSeconds * 1e3);
+	printf("%-28s %10.2f ms\n", "one full process snapshot", snapshotSeconds * 1e3);
+	printf("%zu refreshes, %zu names looked up, %zu exits, %zu attaches\n",
+		statistics.refreshCount, statistics.lookupCount, statistics.exitCount, statistics.attachCount);
+
+	KillAll(workers);
+	KillAll(spawned);
+	return status;
+}
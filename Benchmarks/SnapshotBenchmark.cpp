@@ -0,0 +1,181 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unistd.h>
+#include <vector>
+#include "ChildTarget.h"
+#include "Scanner.h"
+
+// Elements of a 4 KiB page
+static const size_t kPageSize = 0x1000;
+
+// Game-like entity record filling the structured pages
+struct Entity {
+	uint32_t id;
+	uint32_t flags;
+	float health;
+	float position[3];
+	uint64_t target;
+	uint8_t padding[32];
+};
+
+// Every this many entities takes damage between the snapshot and the scan
+static const size_t kDamageStride = 1000;
+
+/**
+ * @brief Fills the heap with a mix of page kinds: random, structured, repeated and zero pages.
+ */
+static void FillHeap(uint8_t* heap, size_t size) {
+	std::mt19937_64 random(1234);
+	for (size_t page = 0; page < size / kPageSize; ++page) {
+		uint8_t* data = heap + page * kPageSize;
+		switch (page % 8) {
+		case 0: // Random bytes, which do not compress
+			for (size_t i = 0; i < kPageSize; i += 8) {
+				uint64_t value = random();
+				std::memcpy(data + i, &value, 8);
+			}
+			break;
+		case 2: // The same as the page before it
+			std::memcpy(data, data - kPageSize, kPageSize);
+			break;
+		case 6:
+		case 7: // Untouched zero pages
+			break;
+		default: // Entity records
+			for (Entity* entity = (Entity*)data; entity < (Entity*)(data + kPageSize); ++entity) {
+				entity->id = (uint32_t)(entity - (Entity*)heap);
+				entity->flags = 1;
+				entity->health = 100.0f;
+				for (float& coordinate : entity->position) {
+					coordinate = (float)(random() % 1000);
+				}
+				entity->target = (uint64_t)(uintptr_t)heap + random() % (size / sizeof(Entity)) * sizeof(Entity);
+			}
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Returns true if the page holds entity records.
+ */
+static bool IsEntityPage(size_t page) {
+	return page % 8 == 1 || page % 8 == 3 || page % 8 == 4 || page % 8 == 5;
+}
+
+int main(int argc, char** argv) {
+	// Size of the child's heap in MiB, configurable from the command line
+	size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+	size_t size = megabytes << 20;
+
+	// Allocated before fork, so the heap has the same address and contents in the child
+	uint8_t* heap = (uint8_t*)aligned_alloc(kPageSize, size);
+	std::memset(heap, 0, size);
+	FillHeap(heap, size);
+	uintptr_t heapBegin = (uintptr_t)heap;
+	uintptr_t heapEnd = heapBegin + size;
+
+	// Target process: damage some entities when told to, then wait for the end
+	ChildTarget target;
+	bool started = target.Start([&](char) {
+		size_t count = 0;
+		for (size_t page = 0; page < size / kPageSize; ++page) {
+			for (Entity* entity = (Entity*)(heap + page * kPageSize); IsEntityPage(page) && entity < (Entity*)(heap + (page + 1) * kPageSize); ++entity) {
+				if (count++ % kDamageStride == 0) {
+					entity->health -= 25.0f;
+				}
+			}
+		}
+	});
+	if (!started) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	ScanOptions options;
+	options.writableOnly = true;
+	Scanner scanner(memory, options);
+	int status = 0;
+
+	// Capture once in memory and once spilled to a file, both must hold the heap exactly
+	Snapshot snapshot, spilled;
+	std::string path = "/tmp/SnapshotBenchmark." + std::to_string(getpid()) + ".bin";
+	if (!snapshot.Capture(scanner) || !spilled.Capture(scanner, path)) {
+		fprintf(stderr, "Capture failed: %s\n", spilled.GetErrorMessage().c_str());
+		return 1;
+	}
+
+	printf("heap %zu MiB, %zu threads\n", megabytes, scanner.GetThreadCount());
+	printf("%-10s %10s %8s %8s %8s %8s %10s %10s %8s\n", "snapshot", "pages", "zero", "repeat", "lz", "raw", "stored MiB", "RAM MiB", "seconds");
+	for (Snapshot* captured : { &snapshot, &spilled }) {
+		const SnapshotStatistics& statistics = captured->GetStatistics();
+		printf("%-10s %10zu %8zu %8zu %8zu %8zu %10.1f %10.1f %8.3f\n", captured == &snapshot ? "memory" : "spilled",
+			statistics.pageCount, statistics.zeroPages, statistics.repeatedPages, statistics.compressedPages, statistics.rawPages,
+			statistics.storedBytes / 1048576.0, captured->GetMemoryUsage() / 1048576.0, statistics.seconds);
+
+		// Reading the heap back decompresses every page of it
+		std::vector<uint8_t> copy(size);
+		auto start = std::chrono::steady_clock::now();
+		bool read = captured->Read(heapBegin, copy.data(), size);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("%-10s read back at %.2f GB/s\n", "", size / seconds / 1e9);
+		if (!read || std::memcmp(copy.data(), heap, size) != 0) {
+			fprintf(stderr, "The snapshot does not match the heap\n");
+			status = 1;
+		}
+	}
+
+	// Let the child damage its entities, then find them by their decreased health
+	target.Command(1);
+
+	size_t entities = 0;
+	for (size_t page = 0; page < size / kPageSize; ++page) {
+		entities += IsEntityPage(page) ? kPageSize / sizeof(Entity) : 0;
+	}
+	size_t expected = (entities + kDamageStride - 1) / kDamageStride;
+
+	printf("%-26s %10s %10s %8s\n", "scan", "results", "in heap", "GB/s");
+	for (Snapshot* captured : { &snapshot, &spilled }) {
+		ScanResults<float> results = scanner.FirstScan<float>(*captured, NextScanCompare::Decreased);
+
+		size_t inHeap = 0;
+		bool wrong = false;
+		results.ForEach([&](uintptr_t address, float value) {
+			if (address >= heapBegin && address < heapEnd) {
+				++inHeap;
+				wrong |= (address - heapBegin) % sizeof(Entity) != offsetof(Entity, health) || value != 75.0f;
+			}
+		});
+		printf("%-26s %10zu %10zu %8.2f\n", captured == &snapshot ? "decreased, memory" : "decreased, spilled",
+			results.GetCount(), inHeap, scanner.GetStatistics().GetThroughput());
+
+		if (wrong || inHeap != expected) {
+			fprintf(stderr, "Found %zu damaged entities, expected %zu\n", inHeap, expected);
+			status = 1;
+		}
+	}
+
+	// For reference, a plain first scan reading the same memory without a snapshot
+	scanner.FirstScan<float>(75.0f);
+	printf("%-26s %10zu %10s %8.2f\n", "equal, no snapshot", scanner.GetStatistics().resultCount, "", scanner.GetStatistics().GetThroughput());
+
+	// The spill file belongs to the snapshot
+	spilled.Clear();
+	if (access(path.c_str(), F_OK) == 0) {
+		fprintf(stderr, "The spill file was not deleted\n");
+		remove(path.c_str());
+		status = 1;
+	}
+
+	target.Stop();
+	free(heap);
+	return status;
+}
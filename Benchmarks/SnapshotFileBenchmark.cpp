@@ -0,0 +1,205 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unistd.h>
+#include <vector>
+#include "ChildTarget.h"
+#include "PointerScanner.h"
+#include "SnapshotFile.h"
+
+// Elements of a 4 KiB page
+static const size_t kPageSize = 0x1000;
+
+// Every this many pages holds the marker value the offline scan looks for
+static const size_t kMarkerStride = 64;
+
+// Every this many pages is written by the child between the two captures
+static const size_t kChangeStride = 97;
+
+// Static variable holding the first pointer of the chain to the target
+static uintptr_t root = 0;
+
+/**
+ * @brief Returns the seconds elapsed since a point in time.
+ */
+static double Seconds(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	// Size of the child's heap in MiB, configurable from the command line
+	size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+	size_t size = megabytes << 20;
+	size_t pageCount = size / kPageSize;
+
+	// Random data with a marker value on some pages, allocated before fork so the child has it at the same address
+	std::mt19937_64 random(1234);
+	uint8_t* heap = (uint8_t*)aligned_alloc(kPageSize, size);
+	for (size_t i = 0; i < size; i += 8) {
+		uint64_t value = random() | 1;
+		std::memcpy(heap + i, &value, 8);
+	}
+	const uint64_t marker = random() & ~(uint64_t)1;
+	for (size_t page = 0; page < pageCount; page += kMarkerStride) {
+		std::memcpy(heap + page * kPageSize + 0x100, &marker, 8);
+	}
+
+	// A signature made at runtime, so its bytes exist nowhere else in the process
+	uint8_t* signature = heap + size / 2 + 0x234;
+	char text[64];
+	std::snprintf(text, sizeof(text), "%02X %02X ?? %02X %02X %02X", signature[0], signature[1], signature[3], signature[4], signature[5]);
+
+	// The chain to find: root -> first + 0x18 -> second + 0x40 -> target at third + 0x2C
+	std::vector<uint8_t> first(0x100), second(0x100), third(0x100);
+	root = (uintptr_t)first.data();
+	*(uintptr_t*)&first[0x18] = (uintptr_t)second.data();
+	*(uintptr_t*)&second[0x40] = (uintptr_t)third.data();
+	uintptr_t target = (uintptr_t)&third[0x2C];
+	const std::vector<unsigned int> expected = { 0x18, 0x40, 0x2C };
+
+	// Target process: change some pages when told to, then wait for the end
+	ChildTarget child;
+	bool started = child.Start([&](char) {
+		for (size_t page = 0; page < pageCount; page += kChangeStride) {
+			heap[page * kPageSize + 0x800] ^= 0xFF;
+		}
+	});
+	if (!started) {
+		return 1;
+	}
+
+	Memory& memory = child.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	int status = 0;
+	uintptr_t heapBegin = (uintptr_t)heap;
+	uintptr_t heapEnd = heapBegin + size;
+
+	// For reference, the marker scan on the live process
+	ScanOptions options;
+	options.writableOnly = true;
+	Scanner live(memory, options);
+	live.FirstScan<uint64_t>(marker);
+	double liveThroughput = live.GetStatistics().GetThroughput();
+
+	// Capture before and after the child changes its pages
+	std::string beforePath = "/tmp/SnapshotFileBenchmark." + std::to_string(getpid()) + ".before";
+	std::string afterPath = "/tmp/SnapshotFileBenchmark." + std::to_string(getpid()) + ".after";
+	SnapshotFile before, after;
+	auto start = std::chrono::steady_clock::now();
+	if (!before.Capture(memory, beforePath)) {
+		fprintf(stderr, "Capture failed: %s\n", before.GetErrorMessage().c_str());
+		return 1;
+	}
+	double captureSeconds = Seconds(start);
+
+	child.Command(1);
+	if (!after.Capture(memory, afterPath)) {
+		fprintf(stderr, "Capture failed: %s\n", after.GetErrorMessage().c_str());
+		return 1;
+	}
+
+	// Everything below runs on the files alone
+	child.Stop();
+
+	size_t captured = 0;
+	for (const MemoryRegion& region : before.GetRegions()) {
+		captured += region.size;
+	}
+	printf("heap %zu MiB, captured %.1f MiB in %zu runs at %.2f GB/s\n", megabytes, captured / 1048576.0,
+		before.GetRegions().size(), captured / captureSeconds / 1e9);
+
+	// Reopening parses nothing but the tables
+	start = std::chrono::steady_clock::now();
+	SnapshotFile reopened;
+	bool opened = reopened.Open(beforePath);
+	printf("%-24s %8.3f ms\n", "open", Seconds(start) * 1e3);
+	if (!opened || reopened.GetProcessID() != child.GetProcessID() || reopened.GetModules().size() != before.GetModules().size() ||
+		reopened.GetModuleInfo().lpBaseOfDll != before.GetModuleInfo().lpBaseOfDll || reopened.GetProcessName().empty()) {
+		fprintf(stderr, "Reopening the capture failed: %s\n", reopened.GetErrorMessage().c_str());
+		status = 1;
+	}
+
+	// The heap must read back exactly, through a copy and through a view
+	std::vector<uint8_t> copy(size);
+	if (!reopened.ReadMemory(heapBegin, copy.data(), size) || std::memcmp(copy.data(), heap, size) != 0 ||
+		reopened.GetView(heapBegin, size) == nullptr || std::memcmp(reopened.GetView(heapBegin, size), heap, size) != 0) {
+		fprintf(stderr, "The capture does not match the heap\n");
+		status = 1;
+	}
+
+	// Offline scan for the marker
+	Scanner offline(reopened, options);
+	ScanResults<uint64_t> results = offline.FirstScan<uint64_t>(marker);
+	size_t inHeap = 0;
+	results.ForEach([&](uintptr_t address, uint64_t /*value*/) {
+		inHeap += address >= heapBegin && address < heapEnd;
+	});
+	printf("%-24s %8.2f GB/s, live %.2f GB/s\n", "scan", offline.GetStatistics().GetThroughput(), liveThroughput);
+	if (inHeap != (pageCount + kMarkerStride - 1) / kMarkerStride) {
+		fprintf(stderr, "Found %zu markers in the heap, expected %zu\n", inHeap, (pageCount + kMarkerStride - 1) / kMarkerStride);
+		status = 1;
+	}
+
+	// Offline pattern search
+	start = std::chrono::steady_clock::now();
+	std::vector<uintptr_t> matches = Memory::FindPatterns(reopened, reopened.GetRegions(), { Pattern(text) });
+	printf("%-24s %8.2f GB/s\n", "pattern", captured / Seconds(start) / 1e9);
+	if (matches[0] != (uintptr_t)signature) {
+		fprintf(stderr, "Pattern found at %#zx, expected %#zx\n", (size_t)matches[0], (size_t)(uintptr_t)signature);
+		status = 1;
+	}
+
+	// Offline pointer scan for the planted chain
+	PointerScanOptions pointerOptions;
+	pointerOptions.maxDepth = 3;
+	pointerOptions.maxOffset = 0x100;
+	PointerScanner pointers(reopened, pointerOptions);
+	std::string pointerPath = "/tmp/SnapshotFileBenchmark." + std::to_string(getpid()) + ".ptr";
+	bool found = false;
+	PointerScanHeader header;
+	if (pointers.BuildIndex() && pointers.Scan(target, pointerPath)) {
+		PointerScanner::ReadResults(pointerPath, header, [&](const PointerScanResult& result) {
+			found |= header.modules[result.module].base + result.offset == (uintptr_t)&root && result.offsets == expected;
+			return !found;
+		});
+	}
+	remove(pointerPath.c_str());
+	printf("%-24s %8.1f ms, %zu paths\n", "pointer scan", (pointers.GetStatistics().indexSeconds + pointers.GetStatistics().scanSeconds) * 1e3,
+		pointers.GetStatistics().pathCount);
+	if (!found) {
+		fprintf(stderr, "The planted pointer chain was not found offline\n");
+		status = 1;
+	}
+
+	// Diff the two captures; within the heap exactly the changed pages must be reported
+	size_t heapChanges = 0;
+	bool wrong = false;
+	start = std::chrono::steady_clock::now();
+	size_t changed = SnapshotFile::Diff(before, after, [&](uintptr_t address, size_t length) {
+		for (uintptr_t page = address; page < address + length; page += kPageSize) {
+			if (page >= heapBegin && page < heapEnd) {
+				++heapChanges;
+				wrong |= (page - heapBegin) / kPageSize % kChangeStride != 0;
+			}
+		}
+		return true;
+	});
+	printf("%-24s %8.2f GB/s, %zu KiB changed\n", "diff", 2 * captured / Seconds(start) / 1e9, changed / 1024);
+	if (wrong || heapChanges != (pageCount + kChangeStride - 1) / kChangeStride) {
+		fprintf(stderr, "Diff reported %zu heap pages, expected %zu\n", heapChanges, (pageCount + kChangeStride - 1) / kChangeStride);
+		status = 1;
+	}
+
+	reopened.Close();
+	before.Close();
+	after.Close();
+	remove(beforePath.c_str());
+	remove(afterPath.c_str());
+	free(heap);
+	return status;
+}
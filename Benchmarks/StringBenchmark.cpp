@@ -0,0 +1,249 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+#include "ChildTarget.h"
+#include "Memory.h"
+
+// Entities whose names are read every tick
+static const size_t kEntityCount = 2000;
+
+// Ticks measured per method
+static const size_t kTicks = 20;
+
+// Size of the buffer searched for text, and how often the text is planted in it
+static const size_t kHaystackSize = 64 << 20;
+static const size_t kPlanted = 64;
+
+// The text planted in the haystack, in mixed case and both encodings
+static const char* kNeedle = "SecretPlayerName";
+
+// Allocations made by this process, counted by the replaced operator new
+static std::atomic<size_t> allocations{ 0 };
+
+void* operator new(size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* pointer = std::malloc(size ? size : 1)) {
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+	std::free(pointer);
+}
+
+// An entity of the target, with its name stored in both encodings
+struct Entity {
+	uint8_t padding[0x40];
+	char name[32];
+	char16_t wideName[32];
+};
+
+/**
+ * @brief ReadString as it was before the chunked reads: allocate, clear and read maxLength bytes.
+ */
+static std::string ReadStringAllocating(HANDLE process, uintptr_t address, size_t maxLength = 100) {
+	char* buffer = new char[maxLength];
+	std::memset(buffer, 0, maxLength);
+	Platform::ReadMemory(process, address, buffer, maxLength);
+	std::string result(buffer);
+	delete[] buffer;
+	return result;
+}
+
+/**
+ * @brief Byte by byte search for the needle in both encodings, ignoring case (the scalar reference).
+ */
+static size_t CountScalar(const uint8_t* data, size_t size) {
+	size_t length = std::strlen(kNeedle), count = 0;
+	for (size_t offset = 0; offset < size; ++offset) {
+		for (size_t width = 1; width <= 2; ++width) {
+			if (offset + length * width > size) {
+				continue;
+			}
+			size_t i = 0;
+			while (i < length && std::tolower(data[offset + i * width]) == std::tolower((uint8_t)kNeedle[i]) && (width == 1 || data[offset + i * width + 1] == 0)) {
+				++i;
+			}
+			count += i == length;
+		}
+	}
+	return count;
+}
+
+int main() {
+	// Entities with their names, allocated before fork
+	std::vector<Entity*> entities(kEntityCount);
+	for (size_t i = 0; i < kEntityCount; ++i) {
+		entities[i] = new Entity();
+		std::string name = "Entity_" + std::to_string(i);
+		std::memcpy(entities[i]->name, name.c_str(), name.size() + 1);
+		for (size_t j = 0; j <= name.size(); ++j) {
+			entities[i]->wideName[j] = (char16_t)name[j];
+		}
+	}
+
+	// A name ending right before an unmapped page
+	long pageSize = sysconf(_SC_PAGESIZE);
+	uint8_t* pages = (uint8_t*)mmap(nullptr, pageSize * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	munmap(pages + pageSize, pageSize);
+	char* edge = (char*)pages + pageSize - 9;
+	std::memcpy(edge, "EdgeName", 9);
+
+	// Random bytes with the needle planted in varying case, every other copy as UTF-16
+	std::mt19937_64 random(42);
+	std::vector<uint8_t> haystack(kHaystackSize);
+	for (uint8_t& value : haystack) {
+		value = (uint8_t)random();
+	}
+	size_t length = std::strlen(kNeedle);
+	std::vector<uintptr_t> planted;
+	for (size_t i = 0; i < kPlanted; ++i) {
+		size_t offset = (i + 1) * (kHaystackSize / (kPlanted + 1)) + i;
+		bool wide = i % 2 == 1;
+		for (size_t j = 0; j < length; ++j) {
+			char character = (i + j) % 3 == 0 ? (char)std::toupper(kNeedle[j]) : (char)std::tolower(kNeedle[j]);
+			if (wide) {
+				haystack[offset + j * 2] = (uint8_t)character;
+				haystack[offset + j * 2 + 1] = 0;
+			}
+			else {
+				haystack[offset + j] = (uint8_t)character;
+			}
+		}
+		planted.push_back((uintptr_t)haystack.data() + offset);
+	}
+
+	// Target process: keep everything alive until the parent is done
+	ChildTarget target;
+	if (!target.Start()) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	int status = 0;
+	HANDLE process = Platform::OpenProcessHandle(target.GetProcessID());
+	std::vector<std::string> expected(kEntityCount);
+	for (size_t i = 0; i < kEntityCount; ++i) {
+		expected[i] = entities[i]->name;
+	}
+
+	// Names the old way: one allocation and one 100 byte read per name
+	size_t before = allocations.load();
+	auto start = std::chrono::steady_clock::now();
+	size_t wrong = 0;
+	for (size_t tick = 0; tick < kTicks; ++tick) {
+		for (size_t i = 0; i < kEntityCount; ++i) {
+			wrong += ReadStringAllocating(process, (uintptr_t)entities[i]->name) != expected[i];
+		}
+	}
+	double oldSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / kTicks;
+	size_t oldAllocations = (allocations.load() - before) / kTicks;
+
+	// Names into a caller's buffer, in both encodings
+	char name[100];
+	char16_t wideName[100];
+
+	// One read first, so per-thread state such as the instrumentation counters exists before counting
+	memory.ReadString((uintptr_t)entities[0]->name, name, sizeof(name));
+	before = allocations.load();
+	start = std::chrono::steady_clock::now();
+	for (size_t tick = 0; tick < kTicks; ++tick) {
+		for (size_t i = 0; i < kEntityCount; ++i) {
+			size_t nameLength = memory.ReadString((uintptr_t)entities[i]->name, name, sizeof(name));
+			wrong += nameLength != expected[i].size() || std::memcmp(name, expected[i].c_str(), nameLength + 1) != 0;
+		}
+	}
+	double newSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / kTicks;
+	for (size_t i = 0; i < kEntityCount; ++i) {
+		size_t wideLength = memory.ReadWideString((uintptr_t)entities[i]->wideName, wideName, 100);
+		bool same = wideLength == expected[i].size();
+		for (size_t j = 0; same && j < wideLength; ++j) {
+			same = wideName[j] == (char16_t)expected[i][j];
+		}
+		wrong += !same;
+	}
+	size_t newAllocations = allocations.load() - before;
+
+	printf("%zu names per tick:\n", kEntityCount);
+	printf("%-18s %10.1f us %8zu allocations\n", "allocating", oldSeconds * 1e6, oldAllocations);
+	printf("%-18s %10.1f us %8zu allocations\n", "caller's buffer", newSeconds * 1e6, newAllocations);
+	if (wrong || newAllocations) {
+		fprintf(stderr, "%zu names were read wrong, %zu allocations\n", wrong, newAllocations);
+		status = 1;
+	}
+
+	// A string ending before an unmapped page is read up to its terminator
+	std::string edgeName = memory.ReadString((uintptr_t)edge);
+	printf("name before an unmapped page: \"%s\" (allocating read: \"%s\")\n", edgeName.c_str(), ReadStringAllocating(process, (uintptr_t)edge).c_str());
+	if (edgeName != "EdgeName") {
+		fprintf(stderr, "The name before the unmapped page was not read\n");
+		status = 1;
+	}
+
+	// Search the haystack in the target for the needle, ignoring case
+	StringSearchOptions options;
+	options.ignoreCase = true;
+	std::vector<MemoryRegion> haystackRegion(1);
+	haystackRegion[0].base = (uintptr_t)haystack.data();
+	haystackRegion[0].size = haystack.size();
+	start = std::chrono::steady_clock::now();
+	std::vector<StringMatch> matches = memory.FindStrings(haystackRegion, kNeedle, options);
+	double searchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	bool found = matches.size() == planted.size();
+	for (size_t i = 0; found && i < planted.size(); ++i) {
+		found = matches[i].address == planted[i] && matches[i].encoding == (i % 2 ? StringEncoding::UTF16 : StringEncoding::ASCII);
+	}
+
+	// The same search on the local copy, vectorized and byte by byte
+	StringSearch search(kNeedle, options);
+	std::vector<StringMatch> local;
+	start = std::chrono::steady_clock::now();
+	search.Find(haystack.data(), haystack.size(), haystack.size(), 0, local);
+	double vectorSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	start = std::chrono::steady_clock::now();
+	size_t scalarCount = CountScalar(haystack.data(), haystack.size());
+	double scalarSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("search of %zu MiB for \"%s\" ignoring case, ASCII and UTF-16 (%s):\n", kHaystackSize >> 20, kNeedle, GetSimdLevelName(GetSimdLevel()));
+	printf("%-18s %10.2f GB/s %6zu matches\n", "target", haystack.size() / searchSeconds / 1e9, matches.size());
+	printf("%-18s %10.2f GB/s %6zu matches\n", "local, vectorized", haystack.size() / vectorSeconds / 1e9, local.size());
+	printf("%-18s %10.2f GB/s %6zu matches (%.1fx)\n", "local, scalar", haystack.size() / scalarSeconds / 1e9, scalarCount, scalarSeconds / vectorSeconds);
+	if (!found || local.size() != planted.size() || scalarCount != planted.size()) {
+		fprintf(stderr, "The search did not find exactly the planted strings\n");
+		status = 1;
+	}
+
+	// Every readable region of the target holds at least the planted strings
+	matches = memory.FindStrings(kNeedle, options);
+	size_t inHaystack = 0;
+	for (const StringMatch& match : matches) {
+		inHaystack += match.address >= (uintptr_t)haystack.data() && match.address < (uintptr_t)haystack.data() + haystack.size();
+	}
+	printf("whole process: %zu matches, %zu in the haystack\n", matches.size(), inHaystack);
+	if (inHaystack != planted.size()) {
+		fprintf(stderr, "The whole process search missed planted strings\n");
+		status = 1;
+	}
+
+	Platform::CloseProcessHandle(process);
+	target.Stop();
+	return status;
+}
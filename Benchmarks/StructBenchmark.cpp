@@ -0,0 +1,164 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "ChildTarget.h"
+#include "Memory.h"
+#include "RemoteStruct.h"
+
+// Entities in the target's entity list
+static const size_t kEntityCount = 64;
+
+// Ticks measured per method
+static const size_t kTicks = 1000;
+
+// The target's own structures, laid out like those of a game
+struct Vector3 {
+	float x, y, z;
+};
+
+struct Weapon {
+	uint32_t id;
+	uint8_t padding0[0x40];
+	int32_t ammo;
+	int32_t clip;
+};
+
+struct Entity {
+	uint8_t padding0[0x28];
+	Vector3 position;
+	uint8_t padding1[0xB8];
+	int32_t health;
+	uint8_t padding2[0x284];
+	Weapon* weapon;
+	int32_t team;
+	uint8_t padding3[0x800];
+};
+
+// The entity list, a static array of pointers to entities on the heap
+static Entity* entityList[kEntityCount];
+
+// The same structures as the tool declares them
+struct WeaponID : RemoteField<offsetof(Weapon, id), uint32_t> {};
+struct WeaponAmmo : RemoteField<offsetof(Weapon, ammo), int32_t> {};
+struct WeaponLayout : RemoteLayout<WeaponID, WeaponAmmo> {};
+
+struct EntityPosition : RemoteField<offsetof(Entity, position), Vector3> {};
+struct EntityHealth : RemoteField<offsetof(Entity, health), int32_t> {};
+struct EntityWeapon : RemotePointer<offsetof(Entity, weapon), WeaponLayout> {};
+struct EntityTeam : RemoteField<offsetof(Entity, team), int32_t> {};
+struct EntityLayout : RemoteLayout<EntityPosition, EntityHealth, EntityWeapon, EntityTeam> {};
+
+// Position and health share a range, the weapon pointer and the team another; the padding between is never read
+static_assert(EntityLayout::kRangeCount == 2, "Unexpected entity ranges");
+static_assert(EntityLayout::kBufferSize == offsetof(Entity, health) + 4 - offsetof(Entity, position) + 12, "Unexpected entity buffer size");
+static_assert(WeaponLayout::kRangeCount == 1, "Unexpected weapon ranges");
+
+// What a tick collects about an entity
+struct EntityState {
+	Vector3 position;
+	int32_t health;
+	int32_t team;
+	uint32_t weaponID;
+	int32_t ammo;
+};
+
+/**
+ * @brief Returns true if the state matches what the child stored for entity i.
+ */
+static bool IsExpected(const EntityState& state, size_t i) {
+	return state.position.x == (float)i && state.position.y == (float)(2 * i) && state.position.z == (float)(3 * i) &&
+		state.health == (int32_t)(100 + i) && state.team == (int32_t)(i % 2) && state.weaponID == (uint32_t)(1000 + i) && state.ammo == (int32_t)(30 + i);
+}
+
+int main() {
+	// Entities and weapons allocated one by one before fork, so they are scattered over the heap
+	for (size_t i = 0; i < kEntityCount; ++i) {
+		Entity* entity = new Entity();
+		entity->position = { (float)i, (float)(2 * i), (float)(3 * i) };
+		entity->health = (int32_t)(100 + i);
+		entity->team = (int32_t)(i % 2);
+		entity->weapon = new Weapon();
+		entity->weapon->id = (uint32_t)(1000 + i);
+		entity->weapon->ammo = (int32_t)(30 + i);
+		entityList[i] = entity;
+	}
+
+	// Target process: keep the entities alive until the parent is done
+	ChildTarget target;
+	if (!target.Start()) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	int status = 0;
+	std::vector<EntityState> states(kEntityCount);
+	uintptr_t list = (uintptr_t)entityList;
+
+	// Field by field: one read per pointer and per field
+	auto start = std::chrono::steady_clock::now();
+	for (size_t tick = 0; tick < kTicks; ++tick) {
+		for (size_t i = 0; i < kEntityCount; ++i) {
+			uintptr_t entity = memory.Read<uintptr_t>(list + i * sizeof(uintptr_t));
+			uintptr_t weapon = memory.Read<uintptr_t>(entity + offsetof(Entity, weapon));
+			states[i].position = memory.Read<Vector3>(entity + offsetof(Entity, position));
+			states[i].health = memory.Read<int32_t>(entity + offsetof(Entity, health));
+			states[i].team = memory.Read<int32_t>(entity + offsetof(Entity, team));
+			states[i].weaponID = memory.Read<uint32_t>(weapon + offsetof(Weapon, id));
+			states[i].ammo = memory.Read<int32_t>(weapon + offsetof(Weapon, ammo));
+		}
+	}
+	double fieldSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / kTicks;
+
+	for (size_t i = 0; i < kEntityCount; ++i) {
+		if (!IsExpected(states[i], i)) {
+			fprintf(stderr, "Field by field read wrong values for entity %zu\n", i);
+			status = 1;
+		}
+	}
+
+	// Whole structures: the list, the entities and their weapons, one read each
+	RemoteArray<EntityLayout> entities;
+	RemoteArray<WeaponLayout> weapons;
+	std::vector<uintptr_t> addresses(kEntityCount);
+	start = std::chrono::steady_clock::now();
+	for (size_t tick = 0; tick < kTicks; ++tick) {
+		memory.ReadMemory(list, addresses.data(), kEntityCount * sizeof(uintptr_t));
+		entities.Read(memory, addresses);
+		weapons.Follow<EntityWeapon>(memory, entities);
+		for (size_t i = 0; i < kEntityCount; ++i) {
+			states[i].position = entities[i].Get<EntityPosition>();
+			states[i].health = entities[i].Get<EntityHealth>();
+			states[i].team = entities[i].Get<EntityTeam>();
+			states[i].weaponID = weapons[i].Get<WeaponID>();
+			states[i].ammo = weapons[i].Get<WeaponAmmo>();
+		}
+	}
+	double structSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / kTicks;
+
+	for (size_t i = 0; i < kEntityCount; ++i) {
+		if (!entities[i].IsValid() || !weapons[i].IsValid() || !IsExpected(states[i], i)) {
+			fprintf(stderr, "Struct read wrong values for entity %zu\n", i);
+			status = 1;
+		}
+	}
+
+	// A single object through RemoteObject
+	RemoteObject<EntityLayout> single;
+	if (!single.Read(memory, addresses[5]) || single.Get<EntityHealth>() != 105) {
+		fprintf(stderr, "Single object read failed\n");
+		status = 1;
+	}
+
+	printf("%zu entities with weapons, per tick:\n", kEntityCount);
+	printf("%-16s %6zu reads %10.1f us\n", "field by field", kEntityCount * 7, fieldSeconds * 1e6);
+	printf("%-16s %6d reads %10.1f us (%.1fx)\n", "whole structs", 3, structSeconds * 1e6, fieldSeconds / structSeconds);
+
+	target.Stop();
+	return status;
+}
@@ -0,0 +1,144 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "ChildTarget.h"
+#include "Watcher.h"
+
+// Largest watch list measured
+static const size_t kMaxValues = 16384;
+
+// Every this many values is changed by the child when told to
+static const size_t kChangeStride = 10;
+
+// Value the frozen entry is kept at, and the value the child keeps overwriting it with
+static const int kFrozenValue = 999;
+static const int kDamagedValue = 5;
+
+// Values the watcher reads; the static pointer leads to the frozen value like a game's player pointer
+static int values[kMaxValues];
+static int* player = nullptr;
+
+int main(int argc, char** argv) {
+	// Ticks per second of the timed runs, configurable from the command line
+	double rate = argc > 1 ? std::strtod(argv[1], nullptr) : 1000.0;
+
+	player = new int[64]();
+	player[0x10] = kFrozenValue;
+
+	// Target process: change every tenth value and damage the player on every command
+	ChildTarget target;
+	bool started = target.Start([&](char) {
+		for (size_t i = 0; i < kMaxValues; i += kChangeStride) {
+			values[i] += 1;
+		}
+		player[0x10] = kDamagedValue;
+	});
+	if (!started) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	int status = 0;
+
+	// Manual ticks: every change must produce exactly one event and the player must be restored
+	{
+		Watcher watcher(memory);
+		for (size_t i = 0; i < kMaxValues; ++i) {
+			watcher.Watch<int>((uintptr_t)&values[i]);
+		}
+		PointerPath path((uintptr_t)&player - memory.GetModuleBaseAddress(), { 0x10 * sizeof(int) });
+		size_t frozen = watcher.Freeze<int>(path, kFrozenValue);
+		watcher.Tick();
+
+		target.Command(1);
+		watcher.Tick();
+
+		size_t changes = 0, playerEvents = 0;
+		bool wrong = false;
+		WatchEvent event;
+		while (watcher.PollEvent(event)) {
+			if (event.id == frozen) {
+				++playerEvents;
+				wrong |= event.GetOldValue<int>() != kFrozenValue || event.GetNewValue<int>() != kDamagedValue;
+				continue;
+			}
+			++changes;
+			size_t index = (int*)event.address - values;
+			wrong |= index % kChangeStride != 0 || event.GetNewValue<int>() != event.GetOldValue<int>() + 1;
+		}
+
+		size_t expected = (kMaxValues + kChangeStride - 1) / kChangeStride;
+		if (wrong || changes != expected || playerEvents != 1 || memory.Read<int>((uintptr_t)&player[0x10]) != kFrozenValue) {
+			fprintf(stderr, "%zu change events (expected %zu), %zu player events, player at %d\n", changes, expected,
+				playerEvents, memory.Read<int>((uintptr_t)&player[0x10]));
+			status = 1;
+		}
+
+		// Once removed, the player is no longer restored
+		watcher.Remove(frozen);
+		target.Command(1);
+		watcher.Tick();
+		if (watcher.GetCount() != kMaxValues || memory.Read<int>((uintptr_t)&player[0x10]) != kDamagedValue) {
+			fprintf(stderr, "The removed entry was still frozen\n");
+			status = 1;
+		}
+	}
+
+	// Timed runs: the tick cost grows with the bytes read, the jitter stays flat
+	printf("rate %.0f Hz\n", rate);
+	printf("%8s %8s %8s %12s %12s %12s %12s %10s\n", "values", "ticks", "missed", "avg tick us", "max tick us", "avg late us", "max late us", "events");
+	for (size_t count : { (size_t)16, (size_t)256, (size_t)4096, kMaxValues }) {
+		WatchOptions options;
+		options.rate = rate;
+		Watcher watcher(memory, options);
+		for (size_t i = 0; i < count; ++i) {
+			watcher.Watch<int>((uintptr_t)&values[i]);
+		}
+
+		// A consumer draining the queue while the watcher runs, and the child changing values meanwhile
+		std::atomic<bool> consuming{ true };
+		std::atomic<size_t> consumed{ 0 };
+		std::thread consumer([&] {
+			WatchEvent event;
+			while (consuming) {
+				while (watcher.PollEvent(event)) {
+					++consumed;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			while (watcher.PollEvent(event)) {
+				++consumed;
+			}
+		});
+
+		watcher.Start();
+		for (int i = 0; i < 10; ++i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			target.Command(1);
+		}
+		watcher.Stop();
+		consuming = false;
+		consumer.join();
+
+		WatchStatistics statistics = watcher.GetStatistics();
+		printf("%8zu %8zu %8zu %12.1f %12.1f %12.1f %12.1f %10zu\n", count, statistics.tickCount, statistics.missedTicks,
+			statistics.GetAverageTickSeconds() * 1e6, statistics.maxTickSeconds * 1e6,
+			statistics.GetAverageLateSeconds() * 1e6, statistics.maxLateSeconds * 1e6, statistics.eventCount);
+
+		if (consumed != statistics.eventCount || statistics.failedReads) {
+			fprintf(stderr, "Consumed %zu of %zu events, %zu failed reads\n", consumed.load(), statistics.eventCount, statistics.failedReads);
+			status = 1;
+		}
+	}
+
+	target.Stop();
+	delete[] player;
+	return status;
+}
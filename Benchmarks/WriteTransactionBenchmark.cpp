@@ -0,0 +1,177 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+#include <vector>
+#include "ChildTarget.h"
+#include "WriteTransaction.h"
+
+// Objects patched by the benchmark, the distance between them, and the bytes of code patched
+static const size_t kObjects = 64;
+static const size_t kObjectStride = 256;
+static const size_t kCodeSize = 16;
+
+// Patch and unpatch cycles measured
+static const int kIterations = 2000;
+
+// The fields patched in every object: three neighbouring ones and one further away
+struct PatchedObject {
+	int32_t health;
+	int32_t armor;
+	int32_t padding[2];
+	float speed;
+	uint8_t gap[0x80 - 0x14];
+	int32_t ammo;
+};
+
+// Checks every patched field of the target against the original or the patched values
+static bool Matches(Memory& memory, uint8_t* objects, uint8_t* code, bool patched) {
+	for (size_t i = 0; i < kObjects; ++i) {
+		uintptr_t object = (uintptr_t)(objects + i * kObjectStride);
+		int32_t health = memory.Read<int32_t>(object + offsetof(PatchedObject, health));
+		int32_t armor = memory.Read<int32_t>(object + offsetof(PatchedObject, armor));
+		float speed = memory.Read<float>(object + offsetof(PatchedObject, speed));
+		int32_t ammo = memory.Read<int32_t>(object + offsetof(PatchedObject, ammo));
+		if (patched ? (health != 1000 || armor != 100 || speed != 2.0f || ammo != 999)
+			: (health != (int32_t)i || armor != (int32_t)i * 2 || speed != 1.0f || ammo != 30)) {
+			return false;
+		}
+	}
+
+	uint8_t bytes[kCodeSize];
+	if (!memory.ReadMemory((uintptr_t)code, bytes, kCodeSize)) {
+		return false;
+	}
+	for (uint8_t value : bytes) {
+		if (value != (patched ? 0x90 : 0xCC)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main() {
+	// Objects with known values, a read-only executable page standing in for code, and a page that
+	// no write can reach: shared and read-only, so even /proc/<pid>/mem refuses it
+	uint8_t* objects = (uint8_t*)mmap(nullptr, kObjects * kObjectStride, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	uint8_t* code = (uint8_t*)mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	uint8_t* locked = (uint8_t*)mmap(nullptr, 4096, PROT_READ, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (objects == MAP_FAILED || code == MAP_FAILED || locked == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+
+	for (size_t i = 0; i < kObjects; ++i) {
+		PatchedObject* object = (PatchedObject*)(objects + i * kObjectStride);
+		object->health = (int32_t)i;
+		object->armor = (int32_t)i * 2;
+		object->speed = 1.0f;
+		object->ammo = 30;
+	}
+	std::memset(code, 0xCC, 4096);
+	mprotect(code, 4096, PROT_READ | PROT_EXEC);
+
+	// Target process: keep the mappings alive until the parent is done
+	ChildTarget target;
+	if (!target.Start()) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	// Four fields of every object and a run of NOPs over the code
+	WriteTransaction patch(memory);
+	uint8_t nops[kCodeSize];
+	std::memset(nops, 0x90, sizeof(nops));
+	for (size_t i = 0; i < kObjects; ++i) {
+		uintptr_t object = (uintptr_t)(objects + i * kObjectStride);
+		patch.Write<int32_t>(object + offsetof(PatchedObject, health), 1000);
+		patch.Write<int32_t>(object + offsetof(PatchedObject, armor), 100);
+		patch.Write<float>(object + offsetof(PatchedObject, speed), 2.0f);
+		patch.Write<int32_t>(object + offsetof(PatchedObject, ammo), 999);
+	}
+	patch.WriteMemory((uintptr_t)code, nops, sizeof(nops));
+	printf("%zu writes in %zu spans\n", patch.GetWriteCount(), patch.GetSpanCount());
+
+	int status = 0;
+	if (!patch.Commit() || !Matches(memory, objects, code, true)) {
+		fprintf(stderr, "Commit did not apply every write\n");
+		status = 1;
+	}
+	if (!patch.Rollback() || !Matches(memory, objects, code, false)) {
+		fprintf(stderr, "Rollback did not restore every write\n");
+		status = 1;
+	}
+
+	// A transaction with one write that cannot be applied must leave the target untouched
+	WriteTransaction failing(memory);
+	for (size_t i = 0; i < kObjects; ++i) {
+		failing.Write<int32_t>((uintptr_t)(objects + i * kObjectStride) + offsetof(PatchedObject, health), 1000);
+	}
+	failing.Write<int32_t>((uintptr_t)locked, 1);
+	if (failing.Commit() || failing.IsCommitted() || !Matches(memory, objects, code, false) || failing.GetStatistics().unrestoredSpans) {
+		fprintf(stderr, "A failed commit left the target modified\n");
+		status = 1;
+	}
+
+	// So must one with an address that cannot even be read
+	WriteTransaction unreadable(memory);
+	unreadable.Write<int32_t>((uintptr_t)(objects + offsetof(PatchedObject, health)), 1000);
+	unreadable.Write<int32_t>(0, 1);
+	if (unreadable.Commit() || !Matches(memory, objects, code, false)) {
+		fprintf(stderr, "A commit with an unreadable address wrote to the target\n");
+		status = 1;
+	}
+
+	// Patching and unpatching one value at a time: read the original, write the value, write the original back
+	std::vector<uintptr_t> addresses;
+	std::vector<int32_t> originals(kObjects * 4);
+	for (size_t i = 0; i < kObjects; ++i) {
+		uintptr_t object = (uintptr_t)(objects + i * kObjectStride);
+		addresses.push_back(object + offsetof(PatchedObject, health));
+		addresses.push_back(object + offsetof(PatchedObject, armor));
+		addresses.push_back(object + offsetof(PatchedObject, speed));
+		addresses.push_back(object + offsetof(PatchedObject, ammo));
+	}
+	uint8_t savedCode[kCodeSize];
+	auto start = std::chrono::steady_clock::now();
+	for (int iteration = 0; iteration < kIterations; ++iteration) {
+		for (size_t i = 0; i < addresses.size(); ++i) {
+			originals[i] = memory.Read<int32_t>(addresses[i]);
+			memory.Write<int32_t>(addresses[i], 1000);
+		}
+		memory.ReadMemory((uintptr_t)code, savedCode, kCodeSize);
+		memory.WriteMemory((uintptr_t)code, nops, kCodeSize);
+
+		for (size_t i = 0; i < addresses.size(); ++i) {
+			memory.Write<int32_t>(addresses[i], originals[i]);
+		}
+		memory.WriteMemory((uintptr_t)code, savedCode, kCodeSize);
+	}
+	double singleNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kIterations;
+
+	// The same patch as a transaction: one batched read and one batched write to commit, one batched write to roll back
+	start = std::chrono::steady_clock::now();
+	for (int iteration = 0; iteration < kIterations; ++iteration) {
+		if (!patch.Commit() || !patch.Rollback()) {
+			status = 1;
+		}
+	}
+	double transactionNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kIterations;
+
+	if (!Matches(memory, objects, code, false)) {
+		fprintf(stderr, "The timed patches did not leave the original values behind\n");
+		status = 1;
+	}
+
+	printf("%24s %14s\n", "patch and unpatch", "ns");
+	printf("%24s %14.0f\n", "one value at a time", singleNs);
+	printf("%24s %14.0f\n", "WriteTransaction", transactionNs);
+	printf("speedup %.1fx, %zu batches\n", singleNs / transactionNs, patch.GetStatistics().batches);
+
+	target.Stop();
+	return status;
+}
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "ChildTarget.h"
+#include "Memory.h"
+
+// Bytes of fake code searched, followed by the globals it refers to
+static const size_t kCodeSize = 48 << 20;
+static const size_t kDataSize = 1 << 20;
+
+// Globals and references planted to each of them
+static const size_t kGlobals = 40;
+static const size_t kReferencesPerGlobal = 25;
+
+// A global the benchmark's own code refers to
+static volatile int counter = 0;
+
+/**
+ * @brief Writes the global, so the compiled code of this benchmark refers to it.
+ */
+__attribute__((noinline)) static void Count() {
+	counter = counter + 1;
+}
+
+// A planted instruction and where its operand goes
+struct Encoding {
+	const char* name;
+	uint8_t bytes[16];
+	size_t length;
+	size_t operand;
+	XrefKind kind;
+};
+
+// x64 encodings; RIP-relative operands are filled in relative to the end of the instruction
+static const Encoding kEncodings64[] = {
+	{ "mov rax, [rip]", { 0x48, 0x8B, 0x05 }, 7, 3, XrefKind::RipRelative },
+	{ "lea rcx, [rip]", { 0x48, 0x8D, 0x0D }, 7, 3, XrefKind::RipRelative },
+	{ "cmp [rip], imm8", { 0x83, 0x3D, 0, 0, 0, 0, 0x05 }, 7, 2, XrefKind::RipRelative },
+	{ "mov [rip], imm32", { 0xC7, 0x05, 0, 0, 0, 0, 0x64, 0, 0, 0 }, 10, 2, XrefKind::RipRelative },
+	{ "movss xmm0, [rip]", { 0xF3, 0x0F, 0x10, 0x05 }, 8, 4, XrefKind::RipRelative },
+	{ "movzx eax, [rip]", { 0x0F, 0xB6, 0x05 }, 7, 3, XrefKind::RipRelative },
+	{ "cmp word [rip], imm16", { 0x66, 0x81, 0x3D, 0, 0, 0, 0, 0x10, 0x27 }, 9, 3, XrefKind::RipRelative },
+	{ "movabs rax, imm64", { 0x48, 0xB8 }, 10, 2, XrefKind::Absolute64 },
+};
+
+// 32-bit x86 encodings of absolute references
+static const Encoding kEncodings32[] = {
+	{ "mov ecx, [abs]", { 0x8B, 0x0D }, 6, 2, XrefKind::Absolute32 },
+	{ "mov eax, [moffs]", { 0xA1 }, 5, 1, XrefKind::Absolute32 },
+	{ "push imm32", { 0x68 }, 5, 1, XrefKind::Absolute32 },
+	{ "mov [abs], imm32", { 0xC7, 0x05, 0, 0, 0, 0, 0x64, 0, 0, 0 }, 10, 2, XrefKind::Absolute32 },
+	{ "mov eax, [eax*4+abs]", { 0x8B, 0x04, 0x85 }, 7, 3, XrefKind::Absolute32 },
+	{ "mov esi, imm32", { 0xBE }, 5, 1, XrefKind::Absolute32 },
+};
+
+/**
+ * @brief Plants references to every target in a buffer of random bytes and returns them as expected references.
+ */
+template <size_t N>
+static std::vector<CodeReference> Plant(uint8_t* code, uintptr_t base, const std::vector<uintptr_t>& targets, const Encoding (&encodings)[N], std::mt19937& random) {
+	std::vector<CodeReference> planted;
+	size_t slots = targets.size() * kReferencesPerGlobal;
+	size_t stride = kCodeSize / (slots + 1);
+	for (size_t i = 0; i < slots; ++i) {
+		const Encoding& encoding = encodings[i % N];
+		uintptr_t target = targets[(i / N + i) % targets.size()];
+		size_t offset = (i + 1) * stride + random() % (stride / 2);
+
+		// A nop before the instruction keeps random bytes from looking like its prefixes
+		uint8_t* at = code + offset;
+		at[-1] = 0x90;
+		std::memcpy(at, encoding.bytes, encoding.length);
+		if (encoding.kind == XrefKind::RipRelative) {
+			int32_t displacement = (int32_t)(target - (base + offset + encoding.length));
+			std::memcpy(at + encoding.operand, &displacement, sizeof(displacement));
+		}
+		else if (encoding.kind == XrefKind::Absolute64) {
+			uint64_t value = target;
+			std::memcpy(at + encoding.operand, &value, sizeof(value));
+		}
+		else {
+			uint32_t value = (uint32_t)target;
+			std::memcpy(at + encoding.operand, &value, sizeof(value));
+		}
+
+		CodeReference reference;
+		reference.address = base + offset;
+		reference.target = target;
+		reference.value = target;
+		reference.length = (uint8_t)encoding.length;
+		reference.kind = encoding.kind;
+		planted.push_back(reference);
+	}
+	return planted;
+}
+
+/**
+ * @brief Counts the planted references found with the right start, length and kind, and the references found besides them.
+ */
+static size_t Compare(const std::vector<CodeReference>& planted, std::vector<CodeReference> found, size_t& extra) {
+	std::sort(found.begin(), found.end(), [](const CodeReference& left, const CodeReference& right) { return left.address < right.address; });
+	size_t matched = 0;
+	for (const CodeReference& expected : planted) {
+		auto at = std::lower_bound(found.begin(), found.end(), expected.address, [](const CodeReference& reference, uintptr_t address) { return reference.address < address; });
+		matched += at != found.end() && at->address == expected.address && at->target == expected.target && at->length == expected.length && at->kind == expected.kind;
+	}
+	extra = found.size() - matched;
+	return matched;
+}
+
+int main() {
+	// Random bytes standing in for code, with the globals after them within reach of disp32
+	std::mt19937 random(11);
+	std::vector<uint8_t> image(kCodeSize + kDataSize);
+	for (uint8_t& value : image) {
+		value = (uint8_t)random();
+	}
+	uintptr_t base = (uintptr_t)image.data();
+
+	std::vector<uintptr_t> globals, globals32;
+	for (size_t i = 0; i < kGlobals; ++i) {
+		globals.push_back(base + kCodeSize + i * 0x100);
+		globals32.push_back(0x00500000 + i * 0x100);
+	}
+
+	// x64 code referring to the globals after it, and 32-bit code referring to globals of a fake image at 0x400000
+	std::vector<CodeReference> planted64 = Plant(image.data(), base, globals, kEncodings64, random);
+	std::vector<uint8_t> image32(kCodeSize);
+	for (uint8_t& value : image32) {
+		value = (uint8_t)random();
+	}
+	std::vector<CodeReference> planted32 = Plant(image32.data(), (uintptr_t)image32.data(), globals32, kEncodings32, random);
+
+	// Target process: keep the code alive until the parent is done
+	ChildTarget target;
+	if (!target.Start([] { Count(); }, [](char) {})) {
+		return 1;
+	}
+
+	Memory& memory = target.Attach();
+	if (!memory.isAttached()) {
+		return 1;
+	}
+
+	int status = 0;
+	printf("%zu MiB of code, %zu globals, %zu references each (%s)\n", kCodeSize >> 20, kGlobals, kReferencesPerGlobal, GetSimdLevelName(GetSimdLevel()));
+	printf("%-8s %10s %10s %10s %10s\n", "mode", "planted", "found", "extra", "ms");
+
+	std::vector<MemoryRegion> code(1);
+	code[0].base = base;
+	code[0].size = kCodeSize;
+	code[0].executable = true;
+	auto start = std::chrono::steady_clock::now();
+	std::vector<CodeReference> found = Memory::FindReferences(memory, code, globals);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	size_t extra = 0;
+	size_t matched = Compare(planted64, found, extra);
+	printf("%-8s %10zu %10zu %10zu %10.1f\n", "x64", planted64.size(), matched, extra, seconds * 1e3);
+	if (matched != planted64.size()) {
+		fprintf(stderr, "Found %zu of %zu x64 references\n", matched, planted64.size());
+		status = 1;
+	}
+
+	XrefOptions options;
+	options.x64 = false;
+	code[0].base = (uintptr_t)image32.data();
+	start = std::chrono::steady_clock::now();
+	found = Memory::FindReferences(memory, code, globals32, options);
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	matched = Compare(planted32, found, extra);
+	printf("%-8s %10zu %10zu %10zu %10.1f\n", "x86", planted32.size(), matched, extra, seconds * 1e3);
+	if (matched != planted32.size()) {
+		fprintf(stderr, "Found %zu of %zu x86 references\n", matched, planted32.size());
+		status = 1;
+	}
+
+	// The benchmark's own compiled code refers to its global
+	found = memory.FindReferences({ (uintptr_t)&counter });
+	printf("references to a global in the main module: %zu\n", found.size());
+	if (found.empty()) {
+		fprintf(stderr, "No reference to the global was found in the main module\n");
+		status = 1;
+	}
+
+	target.Stop();
+	return status;
+}
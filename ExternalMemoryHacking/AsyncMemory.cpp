@@ -0,0 +1,255 @@
+#include "AsyncMemory.h"
+
+#include <algorithm>
+#include <iterator>
+
+AsyncMemory::AsyncMemory(Memory& memory, const AsyncOptions& options) : memory(memory), options(options) {
+	this->options.maxBatch = std::max<size_t>(this->options.maxBatch, 1);
+	this->thread = std::thread(&AsyncMemory::Run, this);
+}
+
+AsyncMemory::~AsyncMemory() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->wake.notify_all();
+	this->thread.join();
+}
+
+void AsyncMemory::Submit(Request&& request) {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (!this->stopping) {
+			// The thread only sleeps on an empty queue or, during the batch delay, on one short of a full batch
+			++this->statistics.submitted;
+			this->queue.push_back(std::move(request));
+			if (this->queue.size() == 1 || this->queue.size() == this->options.maxBatch) {
+				this->wake.notify_one();
+			}
+			return;
+		}
+		++this->statistics.cancelled;
+	}
+
+	// Requests arriving while the destructor runs are never handed to the thread
+	Drop(request, AsyncStatus::Cancelled);
+}
+
+void AsyncMemory::Submit(std::vector<Request>& requests) {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (!this->stopping) {
+			size_t queued = this->queue.size();
+			this->statistics.submitted += requests.size();
+			this->queue.insert(this->queue.end(), std::make_move_iterator(requests.begin()), std::make_move_iterator(requests.end()));
+			if (queued == 0 || (queued < this->options.maxBatch && this->queue.size() >= this->options.maxBatch)) {
+				this->wake.notify_one();
+			}
+			return;
+		}
+		this->statistics.cancelled += requests.size();
+	}
+
+	for (Request& request : requests) {
+		Drop(request, AsyncStatus::Cancelled);
+	}
+}
+
+void AsyncMemory::Drop(Request& request, AsyncStatus status) {
+	if (request.readCallback) {
+		request.readCallback(status, nullptr, 0);
+	}
+	else if (request.writeCallback) {
+		request.writeCallback(status);
+	}
+}
+
+void AsyncMemory::SubmitRun(size_t first, size_t last, AsyncStatistics& counts) {
+	// Drop the requests that went stale while they waited, right before the others are submitted
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	bool write = this->requests[first].write;
+	size_t total = 0;
+	this->batch.clear();
+	for (size_t i = first; i < last; ++i) {
+		Request& request = this->requests[i];
+		if (request.token.IsCancelled()) {
+			Drop(request, AsyncStatus::Cancelled);
+			++counts.cancelled;
+			request.dropped = true;
+			continue;
+		}
+		if (request.deadline <= now) {
+			Drop(request, AsyncStatus::Expired);
+			++counts.expired;
+			request.dropped = true;
+			continue;
+		}
+
+		BatchEntry entry;
+		entry.address = request.address;
+		entry.size = request.size;
+		entry.buffer = write ? (request.heapData ? request.heapData.get() : request.inlineData) : (void*)total;
+		this->batch.push_back(entry);
+		total += request.size;
+	}
+	if (this->batch.empty()) {
+		return;
+	}
+
+	// Reads land in one buffer shared by the run; the offsets become pointers once it has its final size
+	if (write) {
+		this->memory.WriteBatch(this->batch);
+	}
+	else {
+		this->readData.resize(std::max<size_t>(total, 1));
+		for (BatchEntry& entry : this->batch) {
+			entry.buffer = this->readData.data() + (uintptr_t)entry.buffer;
+		}
+		this->memory.ReadBatch(this->batch);
+	}
+	++counts.batches;
+	counts.largestBatch = std::max(counts.largestBatch, this->batch.size());
+
+	// The entries are in request order, skipping the dropped requests
+	const BatchEntry* entry = this->batch.data();
+	for (size_t i = first; i < last; ++i) {
+		Request& request = this->requests[i];
+		if (request.dropped) {
+			continue;
+		}
+		AsyncStatus status = entry->success ? AsyncStatus::Completed : AsyncStatus::Failed;
+		if (write) {
+			if (request.writeCallback) {
+				request.writeCallback(status);
+			}
+		}
+		else if (request.readCallback) {
+			request.readCallback(status, entry->success ? (const uint8_t*)entry->buffer : nullptr, entry->success ? entry->size : 0);
+		}
+		if (entry->success) {
+			++counts.completed;
+		}
+		else {
+			++counts.failed;
+		}
+		++entry;
+	}
+}
+
+void AsyncMemory::Run() {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	for (;;) {
+		this->wake.wait(lock, [this] { return this->stopping || !this->queue.empty(); });
+
+		// Give other threads a moment to add to a small batch, unless the wait would gain nothing
+		if (!this->stopping && this->options.batchDelay.count() > 0 && this->queue.size() < this->options.maxBatch) {
+			std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + this->options.batchDelay;
+			this->wake.wait_until(lock, deadline, [this] { return this->stopping || this->queue.size() >= this->options.maxBatch; });
+		}
+
+		// Once stopping, whatever is still queued is cancelled rather than submitted
+		if (this->stopping) {
+			std::vector<Request> remaining = std::move(this->queue);
+			this->queue.clear();
+			this->statistics.cancelled += remaining.size();
+			lock.unlock();
+			for (Request& request : remaining) {
+				Drop(request, AsyncStatus::Cancelled);
+			}
+			return;
+		}
+
+		// Take the oldest requests, at most one batch of them
+		this->requests.clear();
+		if (this->queue.size() <= this->options.maxBatch) {
+			this->requests.swap(this->queue);
+		}
+		else {
+			auto end = this->queue.begin() + this->options.maxBatch;
+			this->requests.assign(std::make_move_iterator(this->queue.begin()), std::make_move_iterator(end));
+			this->queue.erase(this->queue.begin(), end);
+		}
+		lock.unlock();
+
+		// Submit every run of consecutive reads or writes as one batch, keeping the order of the queue
+		AsyncStatistics counts;
+		for (size_t first = 0, last = 0; first < this->requests.size(); first = last) {
+			for (last = first + 1; last < this->requests.size() && this->requests[last].write == this->requests[first].write; ++last) {
+			}
+			this->SubmitRun(first, last, counts);
+		}
+		this->requests.clear();
+
+		lock.lock();
+		this->statistics.completed += counts.completed;
+		this->statistics.failed += counts.failed;
+		this->statistics.cancelled += counts.cancelled;
+		this->statistics.expired += counts.expired;
+		this->statistics.batches += counts.batches;
+		this->statistics.largestBatch = std::max(this->statistics.largestBatch, counts.largestBatch);
+	}
+}
+
+void AsyncMemory::ReadMemory(uintptr_t address, size_t size, ReadCallback callback, const AsyncRequestOptions& options) {
+	Request request;
+	request.address = address;
+	request.size = size;
+	request.deadline = options.deadline;
+	request.token = options.token;
+	request.readCallback = std::move(callback);
+	this->Submit(std::move(request));
+}
+
+void AsyncMemory::WriteMemory(uintptr_t address, const void* buffer, size_t size, WriteCallback callback, const AsyncRequestOptions& options) {
+	Request request;
+	request.address = address;
+	request.size = size;
+	request.write = true;
+	request.deadline = options.deadline;
+	request.token = options.token;
+	request.writeCallback = std::move(callback);
+
+	// The bytes are copied now, so the caller's buffer may change or go away before the write runs
+	uint8_t* data = request.inlineData;
+	if (size > kInlineSize) {
+		request.heapData.reset(new uint8_t[size]);
+		data = request.heapData.get();
+	}
+	// An empty write may come with a null buffer, which memcpy must not be given
+	if (size) {
+		std::memcpy(data, buffer, size);
+	}
+	this->Submit(std::move(request));
+}
+
+std::future<AsyncValue<std::vector<uint8_t>>> AsyncMemory::ReadMemory(uintptr_t address, size_t size, const AsyncRequestOptions& options) {
+	std::shared_ptr<std::promise<AsyncValue<std::vector<uint8_t>>>> promise = std::make_shared<std::promise<AsyncValue<std::vector<uint8_t>>>>();
+	std::future<AsyncValue<std::vector<uint8_t>>> future = promise->get_future();
+	this->ReadMemory(address, size, [promise](AsyncStatus status, const uint8_t* data, size_t size) {
+		AsyncValue<std::vector<uint8_t>> result;
+		result.status = status;
+		if (status == AsyncStatus::Completed) {
+			result.value.assign(data, data + size);
+		}
+		promise->set_value(std::move(result));
+	}, options);
+	return future;
+}
+
+std::future<AsyncStatus> AsyncMemory::WriteMemory(uintptr_t address, const void* buffer, size_t size, const AsyncRequestOptions& options) {
+	std::shared_ptr<std::promise<AsyncStatus>> promise = std::make_shared<std::promise<AsyncStatus>>();
+	std::future<AsyncStatus> future = promise->get_future();
+	this->WriteMemory(address, buffer, size, [promise](AsyncStatus status) { promise->set_value(status); }, options);
+	return future;
+}
+
+size_t AsyncMemory::GetQueuedCount() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->queue.size();
+}
+
+AsyncStatistics AsyncMemory::GetStatistics() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->statistics;
+}
@@ -0,0 +1,332 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "Memory.h"
+
+/**
+ * @brief How an asynchronous request ended.
+ */
+enum class AsyncStatus : uint8_t {
+	Completed, // Every byte was transferred
+	Failed,    // The target rejected the transfer, e.g. an unmapped address
+	Cancelled, // The request's token was cancelled, or the AsyncMemory was destroyed, before it was submitted
+	Expired    // The deadline passed before the request was submitted
+};
+
+/**
+ * @brief A flag shared by a group of requests that drops those not yet submitted once set.
+ *
+ * Copies share the flag. A default-constructed token is never cancelled; Create makes one that can be:
+ *
+ *     CancellationToken frame = CancellationToken::Create();
+ *     ... submit this frame's reads with frame ...
+ *     frame.Cancel(); // at the start of the next frame, drop what is still queued
+ */
+class CancellationToken {
+private:
+	std::shared_ptr<std::atomic<bool>> cancelled;
+
+public:
+	/**
+	 * @brief Creates a token that is not cancelled yet.
+	 */
+	static CancellationToken Create() {
+		CancellationToken token;
+		token.cancelled = std::make_shared<std::atomic<bool>>(false);
+		return token;
+	}
+
+	/**
+	 * @brief Cancels every request holding this token that was not submitted yet. Safe to call from any thread.
+	 */
+	void Cancel() {
+		if (this->cancelled) {
+			this->cancelled->store(true, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * @brief Returns true once Cancel was called on this token or a copy of it.
+	 */
+	bool IsCancelled() const {
+		return this->cancelled && this->cancelled->load(std::memory_order_relaxed);
+	}
+};
+
+/**
+ * @brief When a request is dropped instead of submitted.
+ */
+struct AsyncRequestOptions {
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(); // Expire if not submitted by then
+	CancellationToken token;                                                                        // Cancel if this token is cancelled first
+};
+
+/**
+ * @brief The result of an asynchronous read of a value.
+ */
+template <typename T>
+struct AsyncValue {
+	AsyncStatus status = AsyncStatus::Failed;
+	T value = T(); // Valid if status is Completed
+
+	/**
+	 * @brief Returns true if the value was read.
+	 */
+	bool Succeeded() const {
+		return this->status == AsyncStatus::Completed;
+	}
+};
+
+/**
+ * @brief Settings of an AsyncMemory.
+ */
+struct AsyncOptions {
+	size_t maxBatch = 1024;                                       // Most requests submitted with one batch
+	std::chrono::microseconds batchDelay = std::chrono::microseconds(0); // Time an idle thread waits for more requests before submitting
+};
+
+/**
+ * @brief Numbers describing the requests of an AsyncMemory since it was created.
+ */
+struct AsyncStatistics {
+	size_t submitted = 0;    // Requests handed to the thread
+	size_t completed = 0;    // Requests that transferred every byte
+	size_t failed = 0;       // Requests the target rejected
+	size_t cancelled = 0;    // Requests dropped because their token was cancelled
+	size_t expired = 0;      // Requests dropped because their deadline passed
+	size_t batches = 0;      // ReadBatch and WriteBatch calls made
+	size_t largestBatch = 0; // Most requests handled by one batch call
+
+	/**
+	 * @brief Returns the average number of requests per batch call.
+	 */
+	double GetAverageBatch() const {
+		return this->batches ? (double)(this->completed + this->failed) / this->batches : 0;
+	}
+};
+
+/**
+ * @brief Reads and writes of a Memory instance that do not block the calling thread.
+ *
+ * Requests are taken from any thread and queued for a dedicated I/O thread, which submits
+ * the requests that queued up while it was busy together: consecutive reads as one ReadBatch
+ * and consecutive writes as one WriteBatch, so on Linux a frame's worth of reads costs one
+ * process_vm_readv call. Requests are submitted in the order they were queued, so a read
+ * queued after a write sees the written value.
+ *
+ * Results come back as futures, or through a callback run on the I/O thread:
+ *
+ *     AsyncMemory async(memory);
+ *     std::future<AsyncValue<int>> health = async.Read<int>(player + 0xEC);
+ *     ... render the frame ...
+ *     AsyncValue<int> result = health.get();
+ *
+ * Every request may carry a deadline and a CancellationToken. Both are checked right before a
+ * batch is submitted, so requests that went stale while a large transfer ran are dropped with
+ * AsyncStatus::Expired or Cancelled instead of being read. Destroying the AsyncMemory cancels the
+ * requests still queued and joins the thread.
+ */
+class AsyncMemory {
+public:
+	// Called on the I/O thread when a read ends; data holds the bytes read if status is Completed
+	using ReadCallback = std::function<void(AsyncStatus status, const uint8_t* data, size_t size)>;
+
+	// Called on the I/O thread when a write ends
+	using WriteCallback = std::function<void(AsyncStatus status)>;
+
+private:
+	// Largest write kept inside its request instead of in a separate allocation
+	static const size_t kInlineSize = 16;
+
+	// One queued read or write
+	struct Request {
+		uintptr_t address = 0;
+		size_t size = 0;
+		bool write = false;
+		bool dropped = false; // Set when the request is cancelled or expired instead of submitted
+		std::chrono::steady_clock::time_point deadline;
+		CancellationToken token;
+		uint8_t inlineData[kInlineSize] = {};  // Bytes of a small write
+		std::unique_ptr<uint8_t[]> heapData;  // Bytes of a larger write
+		ReadCallback readCallback;
+		WriteCallback writeCallback;
+	};
+
+	// Memory instance attached to the target process
+	Memory& memory;
+
+	AsyncOptions options;
+
+	// Requests waiting for the thread, and the state of the thread; guarded by mutex
+	std::vector<Request> queue;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+	AsyncStatistics statistics;
+
+	// Reused by every batch: the requests taken from the queue, the batch elements and the bytes read
+	std::vector<Request> requests;
+	std::vector<BatchEntry> batch;
+	std::vector<uint8_t> readData;
+
+	std::thread thread;
+
+	// Queues a request and wakes the thread
+	void Submit(Request&& request);
+
+	// Queues a group of requests under one lock, so no other request lands between them
+	void Submit(std::vector<Request>& requests);
+
+	// Submits requests [first, last), all reads or all writes, as one batch and completes them
+	void SubmitRun(size_t first, size_t last, AsyncStatistics& counts);
+
+	// Completes a request that was not submitted
+	static void Drop(Request& request, AsyncStatus status);
+
+	// Main loop of the I/O thread
+	void Run();
+
+public:
+	/**
+	 * @brief Starts the I/O thread.
+	 *
+	 * @param memory The attached Memory instance, which must outlive this object.
+	 * @param options Settings of the batching.
+	 */
+	explicit AsyncMemory(Memory& memory, const AsyncOptions& options = AsyncOptions());
+
+	/**
+	 * @brief Cancels the queued requests and joins the I/O thread.
+	 */
+	~AsyncMemory();
+
+	AsyncMemory(const AsyncMemory&) = delete;
+	AsyncMemory& operator=(const AsyncMemory&) = delete;
+
+	/**
+	 * @brief Queues a read whose bytes are passed to a callback on the I/O thread.
+	 *
+	 * The callback should return quickly, since the next batch waits for it. A request made
+	 * while the AsyncMemory is being destroyed is cancelled on the calling thread instead.
+	 *
+	 * @param callback May be empty if the bytes do not matter.
+	 */
+	void ReadMemory(uintptr_t address, size_t size, ReadCallback callback, const AsyncRequestOptions& options = AsyncRequestOptions());
+
+	/**
+	 * @brief Queues a write of a copy of buffer, whose outcome is passed to a callback on the I/O thread.
+	 *
+	 * @param callback May be empty if the outcome does not matter.
+	 */
+	void WriteMemory(uintptr_t address, const void* buffer, size_t size, WriteCallback callback, const AsyncRequestOptions& options = AsyncRequestOptions());
+
+	/**
+	 * @brief Queues a read of bytes.
+	 *
+	 * @return A future of the bytes read, empty unless the status is Completed.
+	 */
+	std::future<AsyncValue<std::vector<uint8_t>>> ReadMemory(uintptr_t address, size_t size, const AsyncRequestOptions& options = AsyncRequestOptions());
+
+	/**
+	 * @brief Queues a write of a copy of buffer.
+	 */
+	std::future<AsyncStatus> WriteMemory(uintptr_t address, const void* buffer, size_t size, const AsyncRequestOptions& options = AsyncRequestOptions());
+
+	/**
+	 * @brief Queues a read of a value of type T.
+	 */
+	template <typename T>
+	std::future<AsyncValue<T>> Read(uintptr_t address, const AsyncRequestOptions& options = AsyncRequestOptions()) {
+		static_assert(std::is_trivially_copyable<T>::value, "Values read asynchronously must be trivially copyable");
+		std::shared_ptr<std::promise<AsyncValue<T>>> promise = std::make_shared<std::promise<AsyncValue<T>>>();
+		std::future<AsyncValue<T>> future = promise->get_future();
+		this->ReadMemory(address, sizeof(T), [promise](AsyncStatus status, const uint8_t* data, size_t) {
+			AsyncValue<T> result;
+			result.status = status;
+			if (status == AsyncStatus::Completed) {
+				std::memcpy(&result.value, data, sizeof(T));
+			}
+			promise->set_value(result);
+		}, options);
+		return future;
+	}
+
+	/**
+	 * @brief Queues a read of a value of type T at every address, completed by a single future.
+	 *
+	 * Cheaper than one future per value when a frame reads many values, since a future costs
+	 * about as much as the batched read of a value. The reads are queued as one group, so they
+	 * are submitted together unless the group is larger than AsyncOptions::maxBatch.
+	 *
+	 * @return A future of one value per address, in the order of the addresses.
+	 */
+	template <typename T>
+	std::future<std::vector<AsyncValue<T>>> Read(const std::vector<uintptr_t>& addresses, const AsyncRequestOptions& options = AsyncRequestOptions()) {
+		static_assert(std::is_trivially_copyable<T>::value, "Values read asynchronously must be trivially copyable");
+
+		// The values are filled in on the I/O thread, and the last read to end completes the future
+		struct Group {
+			std::promise<std::vector<AsyncValue<T>>> promise;
+			std::vector<AsyncValue<T>> values;
+			std::atomic<size_t> remaining{ 0 };
+		};
+		std::shared_ptr<Group> group = std::make_shared<Group>();
+		std::future<std::vector<AsyncValue<T>>> future = group->promise.get_future();
+		if (addresses.empty()) {
+			group->promise.set_value(std::move(group->values));
+			return future;
+		}
+
+		group->values.resize(addresses.size());
+		group->remaining = addresses.size();
+		std::vector<Request> requests(addresses.size());
+		for (size_t i = 0; i < addresses.size(); ++i) {
+			requests[i].address = addresses[i];
+			requests[i].size = sizeof(T);
+			requests[i].deadline = options.deadline;
+			requests[i].token = options.token;
+			requests[i].readCallback = [group, i](AsyncStatus status, const uint8_t* data, size_t) {
+				group->values[i].status = status;
+				if (status == AsyncStatus::Completed) {
+					std::memcpy(&group->values[i].value, data, sizeof(T));
+				}
+				if (group->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					group->promise.set_value(std::move(group->values));
+				}
+			};
+		}
+		this->Submit(requests);
+		return future;
+	}
+
+	/**
+	 * @brief Queues a write of a value of type T.
+	 */
+	template <typename T>
+	std::future<AsyncStatus> Write(uintptr_t address, const T& value, const AsyncRequestOptions& options = AsyncRequestOptions()) {
+		static_assert(std::is_trivially_copyable<T>::value, "Values written asynchronously must be trivially copyable");
+		return this->WriteMemory(address, &value, sizeof(T), options);
+	}
+
+	/**
+	 * @brief Returns the number of requests queued and not yet taken by the I/O thread.
+	 */
+	size_t GetQueuedCount();
+
+	/**
+	 * @brief Returns the numbers describing the requests so far.
+	 */
+	AsyncStatistics GetStatistics();
+};
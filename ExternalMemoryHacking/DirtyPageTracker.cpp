@@ -0,0 +1,70 @@
+#include "DirtyPageTracker.h"
+
+#include <algorithm>
+
+DirtyPageTracker::DirtyPageTracker(HANDLE process) : process(process) {
+}
+
+void DirtyPageTracker::Attach(HANDLE process) {
+	this->process = process;
+	this->tracking = false;
+	this->signature = 0;
+}
+
+bool DirtyPageTracker::Reset() {
+	// The signature is taken first, so a mapping change during the clear is noticed by the next query
+	this->signature = Platform::QueryModuleSignature(this->process);
+	this->tracking = this->signature && Platform::ClearDirtyPages(this->process);
+	return this->tracking;
+}
+
+bool DirtyPageTracker::IsTracking() const {
+	return this->tracking && Platform::QueryModuleSignature(this->process) == this->signature;
+}
+
+bool DirtyPageTracker::QueryPages(uintptr_t address, size_t pageCount, uint64_t* bitmap) const {
+	if (this->tracking && Platform::QueryDirtyPages(this->process, address, pageCount, bitmap)) {
+		return true;
+	}
+
+	// Without precise bits every page has to be read again
+	std::fill(bitmap, bitmap + (pageCount + 63) / 64, ~0ull);
+	return false;
+}
+
+std::vector<MemoryRegion> DirtyPageTracker::GetDirtyRanges(const std::vector<MemoryRegion>& regions) const {
+	if (!this->IsTracking()) {
+		return regions;
+	}
+
+	std::vector<MemoryRegion> ranges;
+	std::vector<uint64_t> bitmap;
+
+	for (const MemoryRegion& region : regions) {
+		uintptr_t first = region.base / kPageSize * kPageSize;
+		uintptr_t end = region.base + region.size;
+		size_t pageCount = (size_t)((end - first + kPageSize - 1) / kPageSize);
+		bitmap.resize((pageCount + 63) / 64);
+		this->QueryPages(first, pageCount, bitmap.data());
+
+		// Merge runs of dirty pages into one range each
+		for (size_t page = 0; page < pageCount; ++page) {
+			if (!(bitmap[page / 64] >> (page % 64) & 1)) {
+				continue;
+			}
+
+			uintptr_t start = std::max<uintptr_t>(first + page * kPageSize, region.base);
+			while (page + 1 < pageCount && bitmap[(page + 1) / 64] >> ((page + 1) % 64) & 1) {
+				++page;
+			}
+			uintptr_t stop = std::min<uintptr_t>(first + (page + 1) * kPageSize, end);
+
+			MemoryRegion range = region;
+			range.base = start;
+			range.size = (size_t)(stop - start);
+			ranges.push_back(range);
+		}
+	}
+
+	return ranges;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Platform.h"
+
+/**
+ * @brief Finds the pages a target process wrote since a point in time, so rescans can skip the others.
+ *
+ * Reset clears the kernel's soft-dirty bit of every page of the process (/proc/<pid>/clear_refs on
+ * Linux). From then on the kernel sets the bit of every page the process writes to, and QueryPages
+ * reads the bits back from /proc/<pid>/pagemap. A clean page still holds exactly the bytes it held
+ * at the last Reset, so values read before it do not have to be read again.
+ *
+ * Whenever precise tracking is not possible, every page is reported as dirty and callers fall back
+ * to a full read: on Windows, on kernels without soft-dirty support, before the first successful
+ * Reset, and once the mappings of the process changed since the last Reset (pages of an unmapped
+ * range would otherwise look clean).
+ *
+ * Writes are caught from the moment Reset returns. Callers that query, then Reset, then read miss
+ * the writes landing between the query and the Reset; suspend the target for exact results.
+ */
+class DirtyPageTracker {
+public:
+	// Size and alignment of a tracked page
+	static const size_t kPageSize = 0x1000;
+
+private:
+	// Process whose pages are tracked
+	HANDLE process = nullptr;
+
+	// Set by a successful Reset; until then every page counts as dirty
+	bool tracking = false;
+
+	// Signature of the mappings at the last Reset
+	uint64_t signature = 0;
+
+public:
+	/**
+	 * @brief Creates a tracker for a process. Pages count as dirty until the first Reset.
+	 *
+	 * @param process Handle to the target process, or nullptr for a tracker that reports everything as dirty.
+	 */
+	explicit DirtyPageTracker(HANDLE process = nullptr);
+
+	/**
+	 * @brief Switches the tracker to another process and stops tracking until the next Reset.
+	 */
+	void Attach(HANDLE process);
+
+	/**
+	 * @brief Marks every page as clean, so later queries report the pages written after this call.
+	 *
+	 * @return True if tracking is active, false if it is unavailable (every page then stays dirty).
+	 */
+	bool Reset();
+
+	/**
+	 * @brief Returns true if a Reset succeeded and the mappings of the process did not change since.
+	 *
+	 * Compares a hash of the mappings (Platform::QueryModuleSignature), so the result is worth
+	 * caching for one pass instead of asking before every query.
+	 */
+	bool IsTracking() const;
+
+	/**
+	 * @brief Finds the dirty pages of a range.
+	 *
+	 * Does not check whether the mappings changed; call IsTracking once before a pass.
+	 *
+	 * @param address The address of the first page (rounded down to a page).
+	 * @param pageCount The number of pages to query.
+	 * @param bitmap Receives one bit per page, set for dirty pages, in (pageCount + 63) / 64 words.
+	 * @return True if the bits are precise, false if every page was reported as dirty.
+	 */
+	bool QueryPages(uintptr_t address, size_t pageCount, uint64_t* bitmap) const;
+
+	/**
+	 * @brief Lists the dirty parts of a set of regions.
+	 *
+	 * Runs of neighbouring dirty pages are merged and clipped to their region. Without precise
+	 * tracking the regions are returned unchanged.
+	 *
+	 * @param regions The regions to check, e.g. from Memory::GetRegions.
+	 * @return The dirty ranges in the order of the regions.
+	 */
+	std::vector<MemoryRegion> GetDirtyRanges(const std::vector<MemoryRegion>& regions) const;
+};
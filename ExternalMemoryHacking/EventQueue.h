@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+/**
+ * @brief Bounded lock-free queue for passing small records between threads.
+ *
+ * Every cell carries a sequence number that tells producers and consumers whether it is free or
+ * holds a record of the current lap, so TryPush and TryPop never block and never allocate. Any
+ * number of threads may push and pop at the same time; with a single producer, such as one
+ * Watcher, it behaves as an SPSC ring, and several producers sharing one queue make it MPSC.
+ * The producer and consumer counters sit on separate cache lines so both sides do not contend.
+ */
+template <typename T>
+class EventQueue {
+	static_assert(std::is_trivially_copyable<T>::value, "EventQueue records must be trivially copyable");
+
+private:
+	// Size of a cache line, used to keep the counters apart
+	static const size_t kCacheLine = 64;
+
+	// One slot of the ring
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	// The ring, its size being a power of two
+	std::unique_ptr<Cell[]> cells;
+	size_t mask = 0;
+
+	// Next position to push to and to pop from
+	alignas(kCacheLine) std::atomic<size_t> tail{ 0 };
+	alignas(kCacheLine) std::atomic<size_t> head{ 0 };
+
+public:
+	/**
+	 * @brief Creates a queue.
+	 *
+	 * @param capacity The number of records the queue holds, rounded up to a power of two.
+	 */
+	explicit EventQueue(size_t capacity = 4096) {
+		size_t size = 2;
+		while (size < capacity) {
+			size <<= 1;
+		}
+
+		this->cells.reset(new Cell[size]);
+		this->mask = size - 1;
+		for (size_t i = 0; i < size; ++i) {
+			this->cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	EventQueue(const EventQueue&) = delete;
+	EventQueue& operator=(const EventQueue&) = delete;
+
+	/**
+	 * @brief Appends a record.
+	 *
+	 * @return True if the record was queued, false if the queue is full.
+	 */
+	bool TryPush(const T& value) {
+		size_t position = this->tail.load(std::memory_order_relaxed);
+		for (;;) {
+			Cell& cell = this->cells[position & this->mask];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+			if (difference == 0) {
+				// The cell is free in this lap; claim it unless another producer was faster
+				if (this->tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					cell.value = value;
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0) {
+				// The consumer has not freed the cell of the previous lap yet
+				return false;
+			}
+			else {
+				position = this->tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/**
+	 * @brief Removes the oldest record.
+	 *
+	 * @param value Receives the record.
+	 * @return True if a record was removed, false if the queue is empty.
+	 */
+	bool TryPop(T& value) {
+		size_t position = this->head.load(std::memory_order_relaxed);
+		for (;;) {
+			Cell& cell = this->cells[position & this->mask];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+
+			if (difference == 0) {
+				// The cell holds a record of this lap; take it unless another consumer was faster
+				if (this->head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					value = cell.value;
+					cell.sequence.store(position + this->mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0) {
+				// The producer has not filled the cell yet
+				return false;
+			}
+			else {
+				position = this->head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/**
+	 * @brief Returns the number of records the queue holds when full.
+	 */
+	size_t GetCapacity() const {
+		return this->mask + 1;
+	}
+
+	/**
+	 * @brief Returns the number of queued records. Only exact while no other thread uses the queue.
+	 */
+	size_t GetSize() const {
+		size_t tail = this->tail.load(std::memory_order_acquire);
+		size_t head = this->head.load(std::memory_order_acquire);
+		return tail > head ? tail - head : 0;
+	}
+};
@@ -0,0 +1,260 @@
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+	// Names of the probes, in the order of the enum
+	const char* const kProbeNames[(size_t)Probe::Count] = { "read", "write", "readString", "addressHop", "regionEnumeration", "snapshotCapture" };
+
+	// Calls per timed call unless SetSampleInterval changes it
+	const uint32_t kDefaultSampleInterval = 64;
+
+	// Shortest interval the tick rate is measured over
+	const std::chrono::milliseconds kMinCalibration(10);
+
+	// Counters of every thread that recorded, and the totals Reset subtracts
+	struct Registry {
+		std::mutex mutex;
+
+		// Counters of every thread that ever recorded; those of finished threads are reused by new ones
+		std::vector<Instrumentation::ThreadCounters*> counters;
+		std::vector<Instrumentation::ThreadCounters*> unused;
+		size_t threads = 0;
+
+		// Totals at the last Reset
+		InstrumentationReport baseline;
+
+		// Clock readings the tick rate is measured from
+		uint64_t startTicks = 0;
+		std::chrono::steady_clock::time_point startTime;
+	};
+
+	// The registry is never destroyed, since threads may still finish after main returns
+	Registry& GetRegistry() {
+		static Registry* registry = new Registry();
+		return *registry;
+	}
+
+	// Gives the counters of a finishing thread to the next thread that registers
+	struct ThreadRelease {
+		Instrumentation::ThreadCounters* counters = nullptr;
+
+		~ThreadRelease() {
+			if (this->counters) {
+				Registry& registry = GetRegistry();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				registry.unused.push_back(this->counters);
+			}
+		}
+	};
+
+	thread_local ThreadRelease threadRelease;
+
+	// Adds the counters of one thread to a probe's totals
+	void Add(ProbeStatistics& total, const Instrumentation::Counters& counters) {
+		total.calls += counters.calls.load(std::memory_order_relaxed);
+		total.failures += counters.failures.load(std::memory_order_relaxed);
+		total.bytes += counters.bytes.load(std::memory_order_relaxed);
+		total.timed += counters.timed.load(std::memory_order_relaxed);
+		total.ticks += counters.ticks.load(std::memory_order_relaxed);
+		for (size_t i = 0; i < ProbeStatistics::kBuckets; ++i) {
+			total.histogram[i] += counters.histogram[i].load(std::memory_order_relaxed);
+		}
+	}
+
+#ifdef MEMORYHACKING_INSTRUMENTATION
+	// Subtracts the totals at the last Reset from a probe's totals
+	void Subtract(ProbeStatistics& total, const ProbeStatistics& baseline) {
+		total.calls -= baseline.calls;
+		total.failures -= baseline.failures;
+		total.bytes -= baseline.bytes;
+		total.timed -= baseline.timed;
+		total.ticks -= baseline.ticks;
+		for (size_t i = 0; i < ProbeStatistics::kBuckets; ++i) {
+			total.histogram[i] -= baseline.histogram[i];
+		}
+	}
+#endif
+
+	// Sums the counters of every thread; the registry must be locked
+	InstrumentationReport Sum(const Registry& registry) {
+		InstrumentationReport report;
+		report.threads = registry.threads;
+		for (const Instrumentation::ThreadCounters* counters : registry.counters) {
+			for (size_t probe = 0; probe < (size_t)Probe::Count; ++probe) {
+				Add(report.probes[probe], counters->probes[probe]);
+			}
+		}
+		return report;
+	}
+
+	// Returns the width of a histogram bucket in ticks
+	uint64_t GetBucketWidth(size_t bucket) {
+		return bucket < ((size_t)1 << ProbeStatistics::kSubBucketBits) ? 1 : ProbeStatistics::GetBucketStart(bucket) >> ProbeStatistics::kSubBucketBits;
+	}
+
+	// Appends formatted text to a string
+	template <typename... Arguments>
+	void Append(std::string& text, const char* format, Arguments... arguments) {
+		char buffer[256];
+		int length = std::snprintf(buffer, sizeof(buffer), format, arguments...);
+		text.append(buffer, length > 0 ? std::min<size_t>(length, sizeof(buffer) - 1) : 0);
+	}
+}
+
+thread_local Instrumentation::ThreadCounters* Instrumentation::threadCounters = nullptr;
+thread_local uint32_t Instrumentation::sampleCounter = 0;
+std::atomic<uint32_t> Instrumentation::sampleMask(kDefaultSampleInterval - 1);
+
+const char* GetProbeName(Probe probe) {
+	return (size_t)probe < (size_t)Probe::Count ? kProbeNames[(size_t)probe] : "unknown";
+}
+
+uint64_t ProbeStatistics::GetBucketStart(size_t bucket) {
+	if (bucket < ((size_t)1 << kSubBucketBits)) {
+		return bucket;
+	}
+
+	// The inverse of GetBucket: the highest bit and the sub-bucket bits below it
+	size_t exponent = (bucket >> kSubBucketBits) + kSubBucketBits - 1;
+	uint64_t mantissa = ((uint64_t)1 << kSubBucketBits) | (bucket & (((size_t)1 << kSubBucketBits) - 1));
+	return mantissa << (exponent - kSubBucketBits);
+}
+
+double ProbeStatistics::GetMeanNanoseconds(double ticksPerNanosecond) const {
+	return this->timed ? this->ticks / ticksPerNanosecond / this->timed : 0;
+}
+
+double ProbeStatistics::GetPercentileNanoseconds(double percentile, double ticksPerNanosecond) const {
+	if (!this->timed) {
+		return 0;
+	}
+
+	// The middle of the bucket holding the call at the percentile
+	double rank = percentile / 100 * this->timed;
+	uint64_t seen = 0;
+	size_t last = 0;
+	for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+		if (!this->histogram[bucket]) {
+			continue;
+		}
+
+		seen += this->histogram[bucket];
+		last = bucket;
+		if (seen >= rank) {
+			break;
+		}
+	}
+	return (GetBucketStart(last) + GetBucketWidth(last) / 2.0) / ticksPerNanosecond;
+}
+
+std::string InstrumentationReport::ToText() const {
+	std::string text;
+	Append(text, "%-18s %12s %10s %14s %10s %10s %10s %10s\n", "probe", "calls", "failures", "bytes", "mean ns", "p50 ns", "p99 ns", "max ns");
+	for (size_t i = 0; i < (size_t)Probe::Count; ++i) {
+		const ProbeStatistics& probe = this->probes[i];
+		if (!probe.calls) {
+			continue;
+		}
+
+		Append(text, "%-18s %12llu %10llu %14llu %10.1f %10.1f %10.1f %10.1f\n", kProbeNames[i],
+			(unsigned long long)probe.calls, (unsigned long long)probe.failures, (unsigned long long)probe.bytes,
+			probe.GetMeanNanoseconds(this->ticksPerNanosecond), probe.GetPercentileNanoseconds(50, this->ticksPerNanosecond),
+			probe.GetPercentileNanoseconds(99, this->ticksPerNanosecond), probe.GetPercentileNanoseconds(100, this->ticksPerNanosecond));
+	}
+	return text;
+}
+
+std::string InstrumentationReport::ToJson() const {
+	std::string text;
+	Append(text, "{\"enabled\": %s, \"threads\": %zu, \"sampleInterval\": %zu, \"ticksPerNanosecond\": %.6g, \"probes\": {",
+		Instrumentation::IsEnabled() ? "true" : "false", this->threads, Instrumentation::GetSampleInterval(), this->ticksPerNanosecond);
+	for (size_t i = 0; i < (size_t)Probe::Count; ++i) {
+		const ProbeStatistics& probe = this->probes[i];
+		Append(text, "%s\"%s\": {\"calls\": %llu, \"failures\": %llu, \"bytes\": %llu, \"timed\": %llu, ", i ? ", " : "", kProbeNames[i],
+			(unsigned long long)probe.calls, (unsigned long long)probe.failures, (unsigned long long)probe.bytes, (unsigned long long)probe.timed);
+		Append(text, "\"meanNanoseconds\": %.6g, \"p50Nanoseconds\": %.6g, \"p90Nanoseconds\": %.6g, \"p99Nanoseconds\": %.6g, \"maxNanoseconds\": %.6g}",
+			probe.GetMeanNanoseconds(this->ticksPerNanosecond), probe.GetPercentileNanoseconds(50, this->ticksPerNanosecond),
+			probe.GetPercentileNanoseconds(90, this->ticksPerNanosecond), probe.GetPercentileNanoseconds(99, this->ticksPerNanosecond),
+			probe.GetPercentileNanoseconds(100, this->ticksPerNanosecond));
+	}
+	text += "}}";
+	return text;
+}
+
+Instrumentation::ThreadCounters* Instrumentation::Register() {
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	++registry.threads;
+
+#ifdef MEMORYHACKING_INSTRUMENTATION
+	// The tick rate is measured from the first call on
+	if (!registry.startTicks) {
+		registry.startTicks = GetTicks();
+		registry.startTime = std::chrono::steady_clock::now();
+	}
+#endif
+
+	// Reuse the counters of a finished thread; they keep counting where it stopped
+	ThreadCounters* counters = nullptr;
+	if (!registry.unused.empty()) {
+		counters = registry.unused.back();
+		registry.unused.pop_back();
+	}
+	else {
+		counters = new ThreadCounters();
+		registry.counters.push_back(counters);
+	}
+
+	threadRelease.counters = counters;
+	return counters;
+}
+
+InstrumentationReport Instrumentation::Collect() {
+	InstrumentationReport report;
+#ifdef MEMORYHACKING_INSTRUMENTATION
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	report = Sum(registry);
+	for (size_t probe = 0; probe < (size_t)Probe::Count; ++probe) {
+		Subtract(report.probes[probe], registry.baseline.probes[probe]);
+	}
+
+	// Measure the tick rate against the steady clock over the whole time since the first call (or this one)
+	if (!registry.startTicks) {
+		registry.startTicks = GetTicks();
+		registry.startTime = std::chrono::steady_clock::now();
+	}
+	auto elapsed = std::chrono::steady_clock::now() - registry.startTime;
+	if (elapsed < kMinCalibration) {
+		std::this_thread::sleep_for(kMinCalibration - elapsed);
+	}
+	uint64_t ticks = GetTicks() - registry.startTicks;
+	elapsed = std::chrono::steady_clock::now() - registry.startTime;
+	report.ticksPerNanosecond = ticks / (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+#endif
+	return report;
+}
+
+void Instrumentation::SetSampleInterval(size_t interval) {
+	uint32_t rounded = 1;
+	while (rounded < interval && rounded < 0x80000000u) {
+		rounded <<= 1;
+	}
+	sampleMask.store(rounded - 1, std::memory_order_relaxed);
+}
+
+size_t Instrumentation::GetSampleInterval() {
+	return (size_t)sampleMask.load(std::memory_order_relaxed) + 1;
+}
+
+void Instrumentation::Reset() {
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.baseline = Sum(registry);
+}
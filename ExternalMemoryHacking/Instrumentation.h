@@ -0,0 +1,265 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * @brief The hot paths of Memory that record calls when instrumentation is enabled.
+ */
+enum class Probe : uint8_t {
+	Read,              // ReadMemory, Read<T>, TryRead<T> and TryReadMemory
+	Write,             // WriteMemory, Write<T> and WriteString
+	ReadString,        // ReadString and ReadWideString
+	AddressHop,        // One pointer read of GetAddress or TryGetAddress
+	RegionEnumeration, // GetRegions and RegionTable refreshes, which scans and snapshots start with
+	SnapshotCapture,   // Snapshot::Capture
+	Count
+};
+
+/**
+ * @brief Returns the name of a probe as used in the text and JSON reports, e.g. "read".
+ */
+const char* GetProbeName(Probe probe);
+
+/**
+ * @brief Calls, failures, bytes and latencies recorded by one probe on all threads.
+ *
+ * Latencies are kept in a log-linear histogram like HdrHistogram: 8 buckets per power of two,
+ * so every bucket is at most 12.5% wide and percentiles are within that of the exact value.
+ * Calls, failures and bytes count every call; latencies only the sampled ones, see
+ * Instrumentation::SetSampleInterval.
+ */
+struct ProbeStatistics {
+	// Buckets per power of two, as a number of bits, and the number of buckets covering 64-bit values
+	static const size_t kSubBucketBits = 3;
+	static const size_t kBuckets = (64 - kSubBucketBits + 1) << kSubBucketBits;
+
+	uint64_t calls = 0;                // Calls recorded
+	uint64_t failures = 0;             // Calls that returned an error
+	uint64_t bytes = 0;                // Bytes moved by the calls that succeeded
+	uint64_t timed = 0;                // Calls whose latency was sampled
+	uint64_t ticks = 0;                // Time spent in the sampled calls, in clock ticks
+	uint64_t histogram[kBuckets] = {}; // Sampled calls per latency bucket in ticks, see GetBucket
+
+	/**
+	 * @brief Returns the histogram bucket a latency in ticks falls into.
+	 */
+	static size_t GetBucket(uint64_t ticks) {
+		if (ticks < ((uint64_t)1 << kSubBucketBits)) {
+			return (size_t)ticks;
+		}
+
+		// Position of the highest set bit
+#ifdef _MSC_VER
+		unsigned long exponent;
+		if (_BitScanReverse(&exponent, (unsigned long)(ticks >> 32))) {
+			exponent += 32;
+		}
+		else {
+			_BitScanReverse(&exponent, (unsigned long)ticks);
+		}
+#else
+		size_t exponent = 63 - __builtin_clzll(ticks);
+#endif
+		size_t subBucket = (size_t)(ticks >> (exponent - kSubBucketBits)) & (((size_t)1 << kSubBucketBits) - 1);
+		return ((exponent - kSubBucketBits + 1) << kSubBucketBits) + subBucket;
+	}
+
+	/**
+	 * @brief Returns the lowest latency in ticks that falls into a bucket.
+	 */
+	static uint64_t GetBucketStart(size_t bucket);
+
+	/**
+	 * @brief Returns the mean latency of a sampled call in nanoseconds, 0 if none was sampled.
+	 *
+	 * @param ticksPerNanosecond The rate the ticks were counted at, see InstrumentationReport.
+	 */
+	double GetMeanNanoseconds(double ticksPerNanosecond) const;
+
+	/**
+	 * @brief Returns the latency in nanoseconds below which a share of the calls completed.
+	 *
+	 * @param percentile The share of calls between 0 and 100, e.g. 99 for the 99th percentile.
+	 * @param ticksPerNanosecond The rate the histogram ticks were counted at, see InstrumentationReport.
+	 */
+	double GetPercentileNanoseconds(double percentile, double ticksPerNanosecond) const;
+};
+
+/**
+ * @brief The statistics of every probe, merged across threads by Instrumentation::Collect.
+ */
+struct InstrumentationReport {
+	ProbeStatistics probes[(size_t)Probe::Count];
+	double ticksPerNanosecond = 1; // Rate of the clock the histograms were counted with
+	size_t threads = 0;            // Threads that recorded since the process started
+
+	/**
+	 * @brief Returns the statistics of one probe.
+	 */
+	const ProbeStatistics& Get(Probe probe) const {
+		return this->probes[(size_t)probe];
+	}
+
+	/**
+	 * @brief Formats the probes that were called as a table with one line per probe.
+	 */
+	std::string ToText() const;
+
+	/**
+	 * @brief Formats every probe as a JSON object keyed by probe name.
+	 */
+	std::string ToJson() const;
+};
+
+/**
+ * @brief Opt-in counters of the hot paths of Memory, compiled out unless MEMORYHACKING_INSTRUMENTATION is defined.
+ *
+ * Configure with -DMEMORYHACKING_INSTRUMENTATION=ON to turn it on. Every thread then records into
+ * counters of its own, registered on its first call, so recording takes no lock and no atomic
+ * read-modify-write: a probe bumps three counters with relaxed stores, a few nanoseconds per call.
+ * Reading the time stamp counter costs more than that (about 20 ns under some hypervisors), so
+ * only one call in every sample interval (64 by default) is timed and added to the histogram.
+ * Collect merges the counters of the running threads with those left by finished threads, and
+ * converts the ticks to nanoseconds against the steady clock.
+ *
+ * Without the definition the MEMORY_PROBE macros expand to nothing, and Collect returns an
+ * empty report, so code using the report builds either way.
+ */
+class Instrumentation {
+public:
+	// Per-thread counters of one probe, written only by their thread
+	struct Counters {
+		std::atomic<uint64_t> calls;
+		std::atomic<uint64_t> failures;
+		std::atomic<uint64_t> bytes;
+		std::atomic<uint64_t> timed;
+		std::atomic<uint64_t> ticks;
+		std::atomic<uint64_t> histogram[ProbeStatistics::kBuckets];
+	};
+
+	// Per-thread counters of every probe
+	struct ThreadCounters {
+		Counters probes[(size_t)Probe::Count];
+	};
+
+	/**
+	 * @brief Returns true if the library was built with instrumentation.
+	 */
+	static constexpr bool IsEnabled() {
+#ifdef MEMORYHACKING_INSTRUMENTATION
+		return true;
+#else
+		return false;
+#endif
+	}
+
+#ifdef MEMORYHACKING_INSTRUMENTATION
+	/**
+	 * @brief Returns the current time in ticks of the fastest clock available (the time stamp counter on x86).
+	 */
+	static uint64_t GetTicks() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+
+	/**
+	 * @brief Starts a call: returns the current ticks if the call is sampled, 0 otherwise.
+	 */
+	static uint64_t Start() {
+		return ++sampleCounter & sampleMask.load(std::memory_order_relaxed) ? 0 : GetTicks();
+	}
+
+	/**
+	 * @brief Records one call of a probe on the calling thread.
+	 *
+	 * @param probe The probe that was called.
+	 * @param start The value Start returned when the call started.
+	 * @param succeeded Whether the call succeeded.
+	 * @param bytes The bytes the call moved, only counted if it succeeded.
+	 */
+	static void Record(Probe probe, uint64_t start, bool succeeded, size_t bytes) {
+		uint64_t ticks = start ? GetTicks() - start : 0;
+
+		// Each thread has its own counters, registered on its first call
+		if (!threadCounters) {
+			threadCounters = Register();
+		}
+
+		Counters& probeCounters = threadCounters->probes[(size_t)probe];
+		Bump(probeCounters.calls, 1);
+		Bump(probeCounters.failures, !succeeded);
+		Bump(probeCounters.bytes, succeeded ? bytes : 0);
+		if (start) {
+			Bump(probeCounters.timed, 1);
+			Bump(probeCounters.ticks, ticks);
+			Bump(probeCounters.histogram[ProbeStatistics::GetBucket(ticks)], 1);
+		}
+	}
+#endif
+
+	/**
+	 * @brief Merges the counters of every thread into one report.
+	 *
+	 * Threads may keep recording while the report is collected; their calls then land in this
+	 * report or the next one.
+	 */
+	static InstrumentationReport Collect();
+
+	/**
+	 * @brief Starts counting from zero; later reports only include calls recorded after this.
+	 */
+	static void Reset();
+
+	/**
+	 * @brief Sets how often calls are timed: one call in every interval calls, on each thread.
+	 *
+	 * @param interval The number of calls per timed call, rounded up to a power of two; 1 times every call.
+	 */
+	static void SetSampleInterval(size_t interval);
+
+	/**
+	 * @brief Returns the number of calls per timed call.
+	 */
+	static size_t GetSampleInterval();
+
+private:
+	// Counters of the calling thread, nullptr until its first call
+	static thread_local ThreadCounters* threadCounters;
+
+	// Calls started on the calling thread, and the sample interval minus one
+	static thread_local uint32_t sampleCounter;
+	static std::atomic<uint32_t> sampleMask;
+
+	// Adds to a counter only its own thread writes, so no atomic read-modify-write is needed
+	static void Bump(std::atomic<uint64_t>& counter, uint64_t value) {
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	// Allocates the counters of the calling thread and registers them for Collect
+	static ThreadCounters* Register();
+};
+
+#ifdef MEMORYHACKING_INSTRUMENTATION
+// Starts a call: declares a local holding its start ticks, or 0 if it is not timed
+#define MEMORY_PROBE_START(name) const uint64_t name = Instrumentation::Start()
+
+// Records a call started with MEMORY_PROBE_START; the arguments are not evaluated when instrumentation is off
+#define MEMORY_PROBE_END(name, probe, succeeded, bytes) Instrumentation::Record(probe, name, succeeded, bytes)
+#else
+#define MEMORY_PROBE_START(name) ((void)0)
+#define MEMORY_PROBE_END(name, probe, succeeded, bytes) ((void)0)
+#endif
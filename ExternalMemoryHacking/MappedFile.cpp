@@ -0,0 +1,184 @@
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+	this->Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path) {
+	this->Close();
+
+	this->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER fileSize;
+	if (this->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->file, &fileSize)) {
+		this->Close();
+		return false;
+	}
+
+	// An empty file cannot be mapped, but is still a valid file
+	this->size = (size_t)fileSize.QuadPart;
+	if (this->size) {
+		this->mapping = CreateFileMappingA(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		this->data = this->mapping ? (const uint8_t*)MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!this->data) {
+			this->Close();
+			return false;
+		}
+	}
+
+	this->opened = true;
+	return true;
+}
+
+bool MappedFile::Create(const std::string& path, size_t size) {
+	this->Close();
+
+	// Creating the mapping with a size extends the new file to that size
+	this->file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (this->file == INVALID_HANDLE_VALUE || !size) {
+		this->Close();
+		return false;
+	}
+
+	this->mapping = CreateFileMappingA(this->file, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+	this->data = this->mapping ? (const uint8_t*)MapViewOfFile(this->mapping, FILE_MAP_WRITE, 0, 0, 0) : nullptr;
+	if (!this->data) {
+		this->Close();
+		return false;
+	}
+
+	this->size = size;
+	this->opened = true;
+	this->writable = true;
+	return true;
+}
+
+void MappedFile::Flush() {
+	if (this->writable) {
+		FlushViewOfFile(this->data, 0);
+	}
+}
+
+void MappedFile::Close() {
+	if (this->data) {
+		UnmapViewOfFile(this->data);
+	}
+	if (this->mapping) {
+		CloseHandle(this->mapping);
+	}
+	if (this->file != INVALID_HANDLE_VALUE) {
+		CloseHandle(this->file);
+	}
+
+	this->data = nullptr;
+	this->mapping = nullptr;
+	this->file = INVALID_HANDLE_VALUE;
+	this->size = 0;
+	this->opened = false;
+	this->writable = false;
+}
+
+void MappedFile::AdviseSequential() {
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path) {
+	this->Close();
+
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat status;
+	if (fd < 0 || fstat(fd, &status) != 0) {
+		if (fd >= 0) {
+			close(fd);
+		}
+		return false;
+	}
+
+	// An empty file cannot be mapped, but is still a valid file; the mapping outlives the descriptor
+	this->size = (size_t)status.st_size;
+	if (this->size) {
+		void* mapping = mmap(nullptr, this->size, PROT_READ, MAP_SHARED, fd, 0);
+		if (mapping == MAP_FAILED) {
+			close(fd);
+			this->size = 0;
+			return false;
+		}
+		this->data = (const uint8_t*)mapping;
+	}
+
+	close(fd);
+	this->opened = true;
+	return true;
+}
+
+bool MappedFile::Create(const std::string& path, size_t size) {
+	this->Close();
+
+	int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+
+	// The file is extended without writing, so its blocks are only allocated once they are written
+	void* mapping = size && ftruncate(fd, (off_t)size) == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+
+	this->data = (const uint8_t*)mapping;
+	this->size = size;
+	this->opened = true;
+	this->writable = true;
+	return true;
+}
+
+void MappedFile::Flush() {
+	if (this->writable) {
+		msync((void*)this->data, this->size, MS_ASYNC);
+	}
+}
+
+void MappedFile::Close() {
+	if (this->data) {
+		munmap((void*)this->data, this->size);
+	}
+
+	this->data = nullptr;
+	this->size = 0;
+	this->opened = false;
+	this->writable = false;
+}
+
+void MappedFile::AdviseSequential() {
+	if (this->data) {
+		madvise((void*)this->data, this->size, MADV_SEQUENTIAL);
+	}
+}
+
+#endif
+
+bool MappedFile::IsOpen() const {
+	return this->opened;
+}
+
+const uint8_t* MappedFile::GetData() const {
+	return this->data;
+}
+
+uint8_t* MappedFile::GetWritableData() {
+	return this->writable ? (uint8_t*)this->data : nullptr;
+}
+
+size_t MappedFile::GetSize() const {
+	return this->size;
+}
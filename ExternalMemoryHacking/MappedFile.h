@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Platform.h"
+
+/**
+ * @brief A file mapped into the address space of this process.
+ *
+ * Uses mmap on Linux and CreateFileMapping/MapViewOfFile on Windows. The pages are loaded by the
+ * operating system on first access, so even files larger than RAM can be opened. Open maps an
+ * existing file read-only; Create makes a new file of a fixed size and maps it for writing.
+ */
+class MappedFile {
+private:
+	// First byte of the mapping, nullptr while closed or for an empty file
+	const uint8_t* data = nullptr;
+
+	// Size of the file in bytes
+	size_t size = 0;
+
+	// Set while a file is open, including empty ones
+	bool opened = false;
+
+	// Set if the file was created with Create and may be written through the mapping
+	bool writable = false;
+
+#ifdef _WIN32
+	// File and mapping handles kept until Close
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#endif
+
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/**
+	 * @brief Maps a whole file, closing the one mapped before.
+	 *
+	 * @param path The path of the file.
+	 * @return True if the file was mapped, false otherwise.
+	 */
+	bool Open(const std::string& path);
+
+	/**
+	 * @brief Creates a file of a fixed size and maps it for writing, closing the one mapped before.
+	 *
+	 * An existing file is overwritten. The new file reads as zeros until it is written.
+	 *
+	 * @param path The path of the file.
+	 * @param size The size of the file in bytes, which must not be 0.
+	 * @return True if the file was created and mapped, false otherwise.
+	 */
+	bool Create(const std::string& path, size_t size);
+
+	/**
+	 * @brief Starts writing the changes made through GetWritableData back to disk without waiting for them.
+	 */
+	void Flush();
+
+	/**
+	 * @brief Unmaps the file. Pointers into it become invalid.
+	 */
+	void Close();
+
+	/**
+	 * @brief Tells the operating system the file will be read front to back, so it reads ahead further.
+	 *
+	 * Only a hint; does nothing on Windows or while no file is mapped.
+	 */
+	void AdviseSequential();
+
+	/**
+	 * @brief Returns true while a file is mapped.
+	 */
+	bool IsOpen() const;
+
+	/**
+	 * @brief Returns the first byte of the file, or nullptr if it is empty or not open.
+	 */
+	const uint8_t* GetData() const;
+
+	/**
+	 * @brief Returns the first byte of a file mapped by Create, or nullptr if it was opened read-only.
+	 */
+	uint8_t* GetWritableData();
+
+	/**
+	 * @brief Returns the size of the file in bytes.
+	 */
+	size_t GetSize() const;
+};
@@ -1,96 +1,195 @@
 #include "Memory.h"
 
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	// Regions are searched for patterns in blocks of this many bytes
+	const size_t kPatternBlockSize = 16 << 20;
+
+	// Builds the set that resolves all patterns in one pass
+	PatternSet MakePatternSet(const std::vector<Pattern>& patterns) {
+		PatternSet set;
+		for (const Pattern& pattern : patterns) {
+			set.Add(pattern);
+		}
+		return set;
+	}
+
+	// Keeps the first match of every pattern, 0 for patterns without a match
+	std::vector<uintptr_t> FirstMatches(const std::vector<std::vector<uintptr_t>>& matches) {
+		std::vector<uintptr_t> addresses(matches.size(), 0);
+		for (size_t i = 0; i < matches.size(); ++i) {
+			if (!matches[i].empty()) {
+				addresses[i] = matches[i].front();
+			}
+		}
+		return addresses;
+	}
+
+	// Searches regions block by block; read(address, buffer, size, &bytesRead) returns the block's data
+	template <typename Read>
+	std::vector<uintptr_t> SearchRegions(const std::vector<MemoryRegion>& regions, const std::vector<Pattern>& patterns, const Read& read) {
+		PatternSet set = MakePatternSet(patterns);
+		std::vector<std::vector<uintptr_t>> matches(patterns.size());
+
+		// Consecutive blocks overlap so patterns crossing a block boundary are still found
+		size_t overlap = set.GetLongest() ? set.GetLongest() - 1 : 0;
+		std::vector<uint8_t> buffer;
+
+		for (const MemoryRegion& region : regions) {
+			for (size_t offset = 0; offset < region.size; offset += kPatternBlockSize) {
+				size_t limit = std::min(kPatternBlockSize, region.size - offset);
+				size_t readSize = std::min(limit + overlap, region.size - offset);
+				if (buffer.size() < readSize) {
+					buffer.resize(readSize);
+				}
+
+				// Search whatever prefix of the block could be read
+				size_t bytesRead = 0;
+				const uint8_t* data = read(region.base + offset, buffer.data(), readSize, &bytesRead);
+				if (bytesRead > 0 && set.Find(data, bytesRead, std::min(limit, bytesRead), region.base + offset, matches)) {
+					// Every pattern has been found, the remaining regions need not be read
+					return FirstMatches(matches);
+				}
+			}
+		}
+
+		return FirstMatches(matches);
+	}
+
+	// Code is searched for references in blocks of this many bytes
+	const size_t kReferenceBlockSize = 16 << 20;
+
+	// Regions are searched for strings in blocks of this many bytes
+	const size_t kStringBlockSize = 16 << 20;
+
+	// Strings are read in chunks that never cross one of these boundaries, so an unmapped page only cuts a string short
+	const size_t kStringChunkBoundary = 0x1000;
+
+	// Reads a null-terminated string chunk by chunk into buffer and returns its length
+	template <typename Char, typename Read>
+	size_t ReadTerminated(uintptr_t address, Char* buffer, size_t size, const Read& read) {
+		if (size == 0) {
+			return 0;
+		}
+
+		MEMORY_PROBE_START(start);
+		[[maybe_unused]] bool failed = false;
+		size_t length = 0;
+		while (length < size - 1) {
+			uintptr_t at = address + length * sizeof(Char);
+
+			// Read up to the next boundary in whole characters; a character split by the boundary is read on its own
+			size_t bytes = std::min((size - 1 - length) * sizeof(Char), kStringChunkBoundary - (at & (kStringChunkBoundary - 1)));
+			bytes -= bytes % sizeof(Char);
+			if (bytes == 0) {
+				bytes = sizeof(Char);
+			}
+
+			if (!read(at, buffer + length, bytes)) {
+				failed = true;
+				break;
+			}
+
+			size_t count = bytes / sizeof(Char);
+			if (const Char* terminator = std::char_traits<Char>::find(buffer + length, count, Char())) {
+				length = terminator - buffer;
+				break;
+			}
+			length += count;
+		}
+
+		buffer[length] = Char();
+		MEMORY_PROBE_END(start, Probe::ReadString, !failed, length * sizeof(Char));
+		return length;
+	}
+
+	// Buffer of the strings returned by value, kept per thread and grown to the longest string read
+	template <typename Char>
+	Char* GetStringBuffer(size_t size) {
+		thread_local std::vector<Char> buffer;
+		if (buffer.size() < size) {
+			buffer.resize(size);
+		}
+		return buffer.data();
+	}
+
+	// Searches every region for a string in overlapping blocks, reading them with read(address, buffer, size, bytesRead)
+	template <typename Read>
+	std::vector<StringMatch> SearchStrings(const std::vector<MemoryRegion>& regions, const std::string& text, const StringSearchOptions& options, const Read& read) {
+		StringSearch search(text, options);
+		std::vector<StringMatch> matches;
+		if (!search.IsValid()) {
+			return matches;
+		}
+
+		// Consecutive blocks overlap so strings crossing a block boundary are still found
+		size_t overlap = search.GetLongest() - 1;
+		std::vector<uint8_t> buffer;
+
+		for (const MemoryRegion& region : regions) {
+			for (size_t offset = 0; offset < region.size; offset += kStringBlockSize) {
+				size_t limit = std::min(kStringBlockSize, region.size - offset);
+				size_t readSize = std::min(limit + overlap, region.size - offset);
+				if (buffer.size() < readSize) {
+					buffer.resize(readSize);
+				}
+
+				size_t bytesRead = 0;
+				const uint8_t* data = read(region.base + offset, buffer.data(), readSize, &bytesRead);
+				if (bytesRead > 0 && search.Find(data, bytesRead, std::min(limit, bytesRead), region.base + offset, matches)) {
+					return matches;
+				}
+			}
+		}
+
+		return matches;
+	}
+}
+
 Memory::Memory(const std::wstring processName) {
 	// Attempt to attach to the process using the provided name.
 	// This will initialize processID, process handle, and module base address if successful.
 	this->attachProcess(processName);
 }
 
+Memory::Memory(DWORD processID) {
+	// Attempt to attach to the process with the provided ID.
+	this->attachProcess(processID);
+}
+
 Memory::~Memory() {
 	// Check if the process handle is valid (not nullptr)
 	if (process) {
 		// Close the handle to the process to release system resources
-		CloseHandle(process);
+		Platform::CloseProcessHandle(process);
 	}
 }
 
 DWORD Memory::GetProcessID(const wchar_t* processName) {
-	// Process ID to return, default 0 (not found)
-	DWORD processID = 0;
-
-	// Take a snapshot of all processes in the system
-	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-
-	if (hSnap != INVALID_HANDLE_VALUE) {
-		PROCESSENTRY32 processEntry;
-		processEntry.dwSize = sizeof(processEntry); // Set the size before using the structure
-
-		// Get the first process in the snapshot
-		if (Process32First(hSnap, &processEntry)) {
-			do {
-				// Compare the process name (case-insensitive)
-				if (!_wcsicmp(processEntry.szExeFile, processName)) {
-					processID = processEntry.th32ProcessID; // Found, store the process ID
-					break; // Exit loop since we found the process
-				}
-			} while (Process32Next(hSnap, &processEntry)); // Move to next process
-		}
-	}
-
-	// Release the snapshot handle
-	CloseHandle(hSnap);
-
-	// Return the found process ID (or 0 if not found)
-	return processID;
+	// Find the first running process with this executable name (0 if not found)
+	return Platform::FindProcessID(processName);
 }
 
 uintptr_t Memory::GetModuleBaseAddress(DWORD processID, const wchar_t* moduleName) {
-	// Variable to store the base address of the module, default is 0 (not found)
-	uintptr_t moduleBaseAddress = 0;
-
-	// Take a snapshot of all modules in the specified process
-	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPMODULE | TH32CS_SNAPMODULE32, processID);
-	if (hSnap != INVALID_HANDLE_VALUE) {
-		MODULEENTRY32 modEntry;
-		modEntry.dwSize = sizeof(modEntry); // Set the size before using the structure
-
-		// Get the first module in the snapshot
-		if (Module32First(hSnap, &modEntry)) {
-			do {
-				// Compare the module name (case-insensitive)
-				if (!_wcsicmp(modEntry.szModule, moduleName)) {
-					// Found the module, store its base address
-					moduleBaseAddress = (uintptr_t)modEntry.modBaseAddr;
-					break; // Exit loop since we found the module
-				}
-			} while (Module32Next(hSnap, &modEntry)); // Move to next module
-		}
-	}
-
-	// Release the snapshot handle
-	CloseHandle(hSnap);
-
-	// Return the found module base address (or 0 if not found)
-	return moduleBaseAddress;
+	// Find the lowest address the module is loaded at (0 if not found)
+	return Platform::FindModuleBaseAddress(processID, moduleName);
 }
 
 MODULEINFO Memory::GetModuleInfo(HANDLE process, HMODULE hModule) {
-    // Structure to hold module information (base address, size, entry point, etc.)
-    MODULEINFO moduleInfo;
-
-    // Query the module information from the target process.
-    // The function fills the moduleInfo structure with relevant data.
-    GetModuleInformation(process, hModule, &moduleInfo, sizeof(moduleInfo));
-
-    // Return the filled MODULEINFO structure.
-    return moduleInfo;
+	// Query the module's base address, image size and entry point from the target process.
+	return Platform::QueryModuleInfo(process, hModule);
 }
 
-uintptr_t Memory::GetAddress(HANDLE process, uintptr_t address, std::vector<unsigned int> offsets) {
+uintptr_t Memory::GetAddress(HANDLE process, uintptr_t address, const std::vector<unsigned int>& offsets) {
 	// Iterate through each offset in the vector
 	for (unsigned int i = 0; i < offsets.size(); ++i) {
 		// Read the memory at the current address into 'address' variable.
-		if (!ReadProcessMemory(process, (BYTE*)address, &address, sizeof(address), 0)) {
+		MEMORY_PROBE_START(start);
+		bool read = Platform::ReadMemory(process, address, &address, sizeof(address));
+		MEMORY_PROBE_END(start, Probe::AddressHop, read, sizeof(address));
+		if (!read) {
 			return 0; // If it fails, return 0 to indicate error.
 		}
 
@@ -102,41 +201,237 @@ uintptr_t Memory::GetAddress(HANDLE process, uintptr_t address, std::vector<unsi
 	return address;
 }
 
-std::string Memory::ReadString(HANDLE process, uintptr_t address, SIZE_T maxLength) {
-	// Allocate a buffer to hold the string data read from the process memory
-	char* buffer = new char[maxLength];
+uintptr_t Memory::GetAddress(HANDLE process, uintptr_t moduleBase, const PointerPath& path) {
+	if (!path.IsValid()) {
+		return 0;
+	}
+
+	// Follow the chain one pointer read per offset, as the offsets overload does
+	uintptr_t address = moduleBase + path.GetBase();
+	for (size_t i = 0; i < path.GetDepth(); ++i) {
+		MEMORY_PROBE_START(start);
+		bool read = Platform::ReadMemory(process, address, &address, sizeof(address));
+		MEMORY_PROBE_END(start, Probe::AddressHop, read, sizeof(address));
+		if (!read) {
+			return 0;
+		}
+		address += path.GetOffset(i);
+	}
 
-	// Initialize the buffer to zero to avoid garbage data
-	ZeroMemory(buffer, maxLength);
+	return address;
+}
 
-	// Read maxLength bytes from the resolved address in the target process
-	// If the read fails, buffer will remain zeroed, resulting in an empty string
-	ReadProcessMemory(process, (LPCVOID)address, buffer, maxLength, NULL);
+bool Memory::GetAddresses(HANDLE process, uintptr_t moduleBase, PointerResolver& resolver, std::vector<uintptr_t>& addresses) {
+	// The resolver reads every level of its trie with one batch
+	return resolver.Resolve(process, moduleBase, addresses);
+}
+
+std::string Memory::ReadString(HANDLE process, uintptr_t address, SIZE_T maxLength) {
+	// Read into the buffer of this thread and copy only the characters up to the terminator
+	char* buffer = GetStringBuffer<char>(maxLength + 1);
+	return std::string(buffer, Memory::ReadString(process, address, buffer, maxLength + 1));
+}
 
-	// Construct a std::string from the buffer (will stop at the first null terminator)
-	std::string result(buffer);
+size_t Memory::ReadString(HANDLE process, uintptr_t address, char* buffer, size_t size) {
+	return ReadTerminated(address, buffer, size, [process](uintptr_t at, void* chunk, size_t bytes) {
+		return Platform::ReadMemory(process, at, chunk, bytes);
+	});
+}
 
-	// Free the allocated buffer to prevent memory leaks
-	delete[] buffer;
+std::u16string Memory::ReadWideString(HANDLE process, uintptr_t address, SIZE_T maxLength) {
+	char16_t* buffer = GetStringBuffer<char16_t>(maxLength + 1);
+	return std::u16string(buffer, Memory::ReadWideString(process, address, buffer, maxLength + 1));
+}
 
-	// Return the string read from the process memory
-	return result;
+size_t Memory::ReadWideString(HANDLE process, uintptr_t address, char16_t* buffer, size_t size) {
+	return ReadTerminated(address, buffer, size, [process](uintptr_t at, void* chunk, size_t bytes) {
+		return Platform::ReadMemory(process, at, chunk, bytes);
+	});
 }
 
 bool Memory::WriteString(HANDLE process, uintptr_t address, const std::string value) {
 	// Write the string value (including null terminator) to the resolved address in the target process.
-	return WriteProcessMemory(process, (LPVOID)address, value.c_str(), value.length() + 1, NULL);
+	return Memory::WriteMemory(process, address, value.c_str(), value.length() + 1);
+}
+
+bool Memory::ReadMemory(HANDLE process, uintptr_t address, void* buffer, size_t size, size_t* bytesRead) {
+	// Copy the raw bytes through the platform layer
+	MEMORY_PROBE_START(start);
+	bool read = Platform::ReadMemory(process, address, buffer, size, bytesRead);
+	MEMORY_PROBE_END(start, Probe::Read, read, size);
+	return read;
+}
+
+bool Memory::WriteMemory(HANDLE process, uintptr_t address, const void* buffer, size_t size) {
+	// Copy the raw bytes through the platform layer
+	MEMORY_PROBE_START(start);
+	bool written = Platform::WriteMemory(process, address, buffer, size);
+	MEMORY_PROBE_END(start, Probe::Write, written, size);
+	return written;
+}
+
+std::vector<MemoryRegion> Memory::GetRegions(HANDLE process) {
+	// Query the readable regions of the target process through the platform layer
+	MEMORY_PROBE_START(start);
+	std::vector<MemoryRegion> regions = Platform::EnumerateRegions(process);
+	MEMORY_PROBE_END(start, Probe::RegionEnumeration, !regions.empty(), 0);
+	return regions;
+}
+
+std::vector<ModuleEntry> Memory::GetModules(HANDLE process) {
+	// Query the loaded modules of the target process through the platform layer
+	return Platform::EnumerateModules(process);
+}
+
+bool Memory::ReadBatch(HANDLE process, std::vector<BatchEntry>& entries) {
+	// Submit all entries at once; the platform layer sets the success flag of every entry
+	return Platform::ReadBatch(process, entries.data(), entries.size()) == entries.size();
+}
+
+bool Memory::WriteBatch(HANDLE process, std::vector<BatchEntry>& entries) {
+	// Submit all entries at once; the platform layer sets the success flag of every entry
+	return Platform::WriteBatch(process, entries.data(), entries.size()) == entries.size();
+}
+
+uintptr_t Memory::FindPattern(HANDLE process, uintptr_t address, size_t size, const Pattern& pattern) {
+	// A single pattern is a set of one
+	return Memory::FindPatterns(process, address, size, std::vector<Pattern>{ pattern }).front();
+}
+
+std::vector<uintptr_t> Memory::FindPatterns(HANDLE process, uintptr_t address, size_t size, const std::vector<Pattern>& patterns) {
+	PatternSet set = MakePatternSet(patterns);
+	std::vector<std::vector<uintptr_t>> matches(patterns.size());
+
+	// Copy the whole range with one read
+	std::vector<uint8_t> image(size);
+	if (!Platform::ReadMemory(process, address, image.data(), size)) {
+		// The range has unreadable pages (such as gaps between module segments), so copy
+		// only the readable regions inside it and leave the rest zeroed
+		std::fill(image.begin(), image.end(), 0);
+		for (const MemoryRegion& region : Platform::EnumerateRegions(process)) {
+			uintptr_t start = std::max(region.base, address);
+			uintptr_t end = std::min(region.base + region.size, address + size);
+			if (start < end) {
+				Platform::ReadMemory(process, start, image.data() + (start - address), (size_t)(end - start));
+			}
+		}
+	}
+
+	// Resolve every pattern in one pass over the copy
+	set.Find(image.data(), size, size, address, matches);
+	return FirstMatches(matches);
+}
+
+std::vector<uintptr_t> Memory::FindPatterns(HANDLE process, const std::vector<MemoryRegion>& regions, const std::vector<Pattern>& patterns) {
+	return SearchRegions(regions, patterns, [process](uintptr_t address, uint8_t* buffer, size_t size, size_t* bytesRead) {
+		Platform::ReadMemory(process, address, buffer, size, bytesRead);
+		return (const uint8_t*)buffer;
+	});
+}
+
+std::vector<uintptr_t> Memory::FindPatterns(MemoryReader& reader, const std::vector<MemoryRegion>& regions, const std::vector<Pattern>& patterns) {
+	return SearchRegions(regions, patterns, [&reader](uintptr_t address, uint8_t* buffer, size_t size, size_t* bytesRead) {
+		// A mapped capture is searched in place
+		if (const uint8_t* view = reader.GetView(address, size)) {
+			*bytesRead = size;
+			return view;
+		}
+		reader.ReadMemory(address, buffer, size, bytesRead);
+		return (const uint8_t*)buffer;
+	});
+}
+
+std::vector<CodeReference> Memory::FindReferences(MemoryReader& reader, const std::vector<MemoryRegion>& regions, const std::vector<uintptr_t>& targets, const XrefOptions& options) {
+	XrefFinder finder(targets, options);
+	std::vector<CodeReference> references;
+	std::vector<uint8_t> buffer;
+
+	for (const MemoryRegion& region : regions) {
+		uintptr_t end = region.base + region.size;
+		for (uintptr_t address = region.base; address < end; address += kReferenceBlockSize) {
+			// Read a little before and after the block, so instructions around its edges are decoded whole
+			uintptr_t from = std::max(region.base, address - std::min<uintptr_t>(address, XrefFinder::kLookBehind));
+			uintptr_t limit = std::min<uintptr_t>(address + kReferenceBlockSize, end);
+			uintptr_t to = std::min<uintptr_t>(limit + XrefFinder::kLookAhead, end);
+			size_t readSize = (size_t)(to - from);
+			if (buffer.size() < readSize) {
+				buffer.resize(readSize);
+			}
+
+			size_t bytesRead = readSize;
+			const uint8_t* data = reader.GetView(from, readSize);
+			if (!data) {
+				bytesRead = 0;
+				reader.ReadMemory(from, buffer.data(), readSize, &bytesRead);
+				data = buffer.data();
+			}
+
+			if (bytesRead > address - from) {
+				finder.Find(data, bytesRead, (size_t)(address - from), std::min((size_t)(limit - from), bytesRead), from, references);
+			}
+		}
+	}
+
+	return references;
+}
+
+std::vector<StringMatch> Memory::FindStrings(HANDLE process, const std::vector<MemoryRegion>& regions, const std::string& text, const StringSearchOptions& options) {
+	return SearchStrings(regions, text, options, [process](uintptr_t address, uint8_t* buffer, size_t size, size_t* bytesRead) {
+		Platform::ReadMemory(process, address, buffer, size, bytesRead);
+		return (const uint8_t*)buffer;
+	});
+}
+
+std::vector<StringMatch> Memory::FindStrings(MemoryReader& reader, const std::vector<MemoryRegion>& regions, const std::string& text, const StringSearchOptions& options) {
+	return SearchStrings(regions, text, options, [&reader](uintptr_t address, uint8_t* buffer, size_t size, size_t* bytesRead) {
+		// A mapped capture is searched in place
+		if (const uint8_t* view = reader.GetView(address, size)) {
+			*bytesRead = size;
+			return view;
+		}
+		reader.ReadMemory(address, buffer, size, bytesRead);
+		return (const uint8_t*)buffer;
+	});
 }
 
 void Memory::attachProcess(const std::wstring processName) {
 	// Store the process name as a std::wstring
 	this->processName = processName;
 
-	// Store a pointer to the wide string representation of the process name
-	this->processNameW = processName.c_str();
+	// Store a pointer to the wide string representation of the stored process name
+	this->processNameW = this->processName.c_str();
 
 	// Get the process ID of the target process by its name
-	this->processID = Memory::GetProcessID(this->processNameW);
+	this->openProcess(Memory::GetProcessID(this->processNameW));
+}
+
+void Memory::attachProcess(DWORD processID) {
+	// Look up the executable name of the process, which is also the name of its main module
+	this->processName = Platform::FindProcessName(processID);
+
+	// Store a pointer to the wide string representation of the stored process name
+	this->processNameW = this->processName.c_str();
+
+	// An empty name means there is no process with this ID
+	this->openProcess(this->processName.empty() ? 0 : processID);
+}
+
+void Memory::openProcess(DWORD processID) {
+	// Release the handle of a previous attach before attaching again
+	if (this->process) {
+		Platform::CloseProcessHandle(this->process);
+		this->process = nullptr;
+	}
+
+	this->attachStatus = false;
+	this->processID = processID;
+
+	// Cached pages and modules belong to the previous process
+	if (this->cache) {
+		this->cache->Clear();
+	}
+	this->moduleMap.Reset(nullptr);
+	this->regionTable.Reset(nullptr);
 
 	if (this->processID == 0) {
 		// If process ID is 0, it means the process was not found
@@ -144,8 +439,8 @@ void Memory::attachProcess(const std::wstring processName) {
 		return; // Exit the function early
 	}
 
-	// Open a handle to the process with all access rights
-	this->process = OpenProcess(PROCESS_ALL_ACCESS, FALSE, this->processID);
+	// Open a handle to the process with read and write access
+	this->process = Platform::OpenProcessHandle(this->processID);
 
 	if (!this->process) {
 		// If the process handle is invalid, set an error message
@@ -165,18 +460,27 @@ void Memory::attachProcess(const std::wstring processName) {
 		this->errorMessage = "Module base address not found for process: " + this->GetProcessName();
 
 		// Close the process handle to clean up resources
-		CloseHandle(this->process);
+		Platform::CloseProcessHandle(this->process);
 
 		// Reset process handle to nullptr
 		this->process = nullptr;
 
 		// Reset process ID to 0
 		this->processID = 0;
+
+		return; // Exit the function early
 	}
 
 	// Get information about the main module of the process
 	this->moduleInfo = Memory::GetModuleInfo(this->process, (HMODULE)this->moduleBaseAddress);
 
+	// Modules and regions are enumerated on first use
+	this->moduleMap.Reset(this->process);
+	this->regionTable.Reset(this->process);
+
+	// Clear the error of a previous failed attempt
+	this->errorMessage.clear();
+
 	// Set attach status to true if everything is successful
 	this->attachStatus = true;
 }
@@ -216,23 +520,296 @@ uintptr_t Memory::GetModuleBaseAddress() {
 	return this->moduleBaseAddress;
 }
 
+uintptr_t Memory::GetModuleBaseAddress(const std::wstring& moduleName) {
+	// Serve the name from the map, refreshing it once in case the module was loaded since
+	uintptr_t base = this->GetModuleMap().GetBaseAddress(moduleName);
+	if (!base && this->moduleMap.Refresh()) {
+		base = this->moduleMap.GetBaseAddress(moduleName);
+	}
+	return base;
+}
+
+ModuleMap& Memory::GetModuleMap() {
+	// Enumerate the modules the first time the map is used after attaching
+	if (this->attachStatus && this->moduleMap.GetModules().empty()) {
+		this->moduleMap.Refresh();
+	}
+	return this->moduleMap;
+}
+
+RegionTable& Memory::GetRegionTable() {
+	return this->regionTable;
+}
+
 MODULEINFO Memory::GetModuleInfo() {
     // Return the cached moduleInfo for the attached process.
     return this->moduleInfo;
 }
 
-uintptr_t Memory::GetAddress(uintptr_t address, std::vector<unsigned int> offsets) {
-	// Resolve the final address by following the pointer chain starting from (moduleBaseAddress + address)
-	return Memory::GetAddress(this->process, this->moduleBaseAddress + address, offsets);
+uintptr_t Memory::GetAddress(uintptr_t address, const std::vector<unsigned int>& offsets) {
+	// Without a cache, the static GetAddress function follows the chain directly
+	if (!this->cache) {
+		return Memory::GetAddress(this->process, this->moduleBaseAddress + address, offsets);
+	}
+
+	// Follow the pointer chain starting from (moduleBaseAddress + address) through the page cache
+	address += this->moduleBaseAddress;
+	for (unsigned int offset : offsets) {
+		MEMORY_PROBE_START(start);
+		bool read = this->ReadUnprobed(address, &address, sizeof(address));
+		MEMORY_PROBE_END(start, Probe::AddressHop, read, sizeof(address));
+		if (!read) {
+			return 0; // If a read fails, return 0 to indicate error.
+		}
+		address += offset;
+	}
+
+	return address;
+}
+
+uintptr_t Memory::GetAddress(const PointerPath& path) {
+	// Without a cache, the static GetAddress function follows the path directly
+	if (!this->cache) {
+		return Memory::GetAddress(this->process, this->moduleBaseAddress, path);
+	}
+
+	if (!path.IsValid()) {
+		return 0;
+	}
+
+	// Follow the path starting from (moduleBaseAddress + base) through the page cache
+	uintptr_t address = this->moduleBaseAddress + path.GetBase();
+	for (size_t i = 0; i < path.GetDepth(); ++i) {
+		MEMORY_PROBE_START(start);
+		bool read = this->ReadUnprobed(address, &address, sizeof(address));
+		MEMORY_PROBE_END(start, Probe::AddressHop, read, sizeof(address));
+		if (!read) {
+			return 0;
+		}
+		address += path.GetOffset(i);
+	}
+
+	return address;
+}
+
+std::optional<uintptr_t> Memory::TryGetAddress(uintptr_t address, const std::vector<unsigned int>& offsets) {
+	// Follow the pointer chain starting from (moduleBaseAddress + address), skipping hops the target has not mapped
+	address += this->moduleBaseAddress;
+	for (unsigned int offset : offsets) {
+		MEMORY_PROBE_START(start);
+		bool read = this->ReadChecked(address, &address, sizeof(address));
+		MEMORY_PROBE_END(start, Probe::AddressHop, read, sizeof(address));
+		if (!read) {
+			return std::nullopt;
+		}
+		address += offset;
+	}
+
+	return address;
+}
+
+std::optional<uintptr_t> Memory::TryGetAddress(const PointerPath& path) {
+	if (!path.IsValid()) {
+		return std::nullopt;
+	}
+
+	uintptr_t address = this->moduleBaseAddress + path.GetBase();
+	for (size_t i = 0; i < path.GetDepth(); ++i) {
+		MEMORY_PROBE_START(start);
+		bool read = this->ReadChecked(address, &address, sizeof(address));
+		MEMORY_PROBE_END(start, Probe::AddressHop, read, sizeof(address));
+		if (!read) {
+			return std::nullopt;
+		}
+		address += path.GetOffset(i);
+	}
+
+	return address;
+}
+
+bool Memory::GetAddresses(PointerResolver& resolver, std::vector<uintptr_t>& addresses) {
+	// Delegate to the static GetAddresses function using the process handle and module base of this instance.
+	return Memory::GetAddresses(this->process, this->moduleBaseAddress, resolver, addresses);
 }
 
 std::string Memory::ReadString(uintptr_t address, SIZE_T maxLength) {
-	// Call the static ReadString function, passing the process handle, address, and maxLength
-	return Memory::ReadString(this->process, address, maxLength);
+	char* buffer = GetStringBuffer<char>(maxLength + 1);
+	return std::string(buffer, this->ReadString(address, buffer, maxLength + 1));
+}
+
+size_t Memory::ReadString(uintptr_t address, char* buffer, size_t size) {
+	// Read the chunks through ReadMemory, which serves them from the page cache if it is enabled
+	return ReadTerminated(address, buffer, size, [this](uintptr_t at, void* chunk, size_t bytes) {
+		return this->ReadUnprobed(at, chunk, bytes);
+	});
+}
+
+std::u16string Memory::ReadWideString(uintptr_t address, SIZE_T maxLength) {
+	char16_t* buffer = GetStringBuffer<char16_t>(maxLength + 1);
+	return std::u16string(buffer, this->ReadWideString(address, buffer, maxLength + 1));
+}
+
+size_t Memory::ReadWideString(uintptr_t address, char16_t* buffer, size_t size) {
+	return ReadTerminated(address, buffer, size, [this](uintptr_t at, void* chunk, size_t bytes) {
+		return this->ReadUnprobed(at, chunk, bytes);
+	});
 }
 
 bool Memory::WriteString(uintptr_t address, const std::string value) {
-	// Delegate the write operation to the static WriteString function,
-	// using the process handle stored in this instance.
-	return Memory::WriteString(this->process, address, value);
+	// Write the string including its null terminator, keeping the page cache up to date
+	return this->WriteMemory(address, value.c_str(), value.length() + 1);
+}
+
+bool Memory::ReadUnprobed(uintptr_t address, void* buffer, size_t size, size_t* bytesRead) {
+	// Serve the read from the page cache if it is enabled
+	if (this->cache) {
+		return this->cache->Read(this->process, address, buffer, size, bytesRead);
+	}
+
+	return Platform::ReadMemory(this->process, address, buffer, size, bytesRead);
+}
+
+bool Memory::ReadChecked(uintptr_t address, void* buffer, size_t size) {
+	// Reads outside the readable regions would fail, so they are not sent to the target
+	if (!this->regionTable.Check(address, size)) {
+		return false;
+	}
+
+	// The table allowed the read, so a failure means the region went away since its last refresh
+	if (!this->ReadUnprobed(address, buffer, size)) {
+		this->regionTable.MarkStale();
+		return false;
+	}
+	return true;
+}
+
+bool Memory::ReadMemory(uintptr_t address, void* buffer, size_t size, size_t* bytesRead) {
+	MEMORY_PROBE_START(start);
+	bool read = this->ReadUnprobed(address, buffer, size, bytesRead);
+	MEMORY_PROBE_END(start, Probe::Read, read, size);
+	return read;
+}
+
+bool Memory::TryReadMemory(uintptr_t address, void* buffer, size_t size) {
+	MEMORY_PROBE_START(start);
+	bool read = this->ReadChecked(address, buffer, size);
+	MEMORY_PROBE_END(start, Probe::Read, read, size);
+	return read;
+}
+
+bool Memory::WriteMemory(uintptr_t address, const void* buffer, size_t size) {
+	// Write through to the target, then patch the cached copy so later reads see the new bytes
+	MEMORY_PROBE_START(start);
+	bool written = Platform::WriteMemory(this->process, address, buffer, size);
+	MEMORY_PROBE_END(start, Probe::Write, written, size);
+	if (written && this->cache) {
+		this->cache->Update(address, buffer, size);
+	}
+
+	return written;
+}
+
+void Memory::EnableCache(size_t maxPages) {
+	// Start with an empty cache holding at most maxPages pages
+	this->cache.reset(new PageCache(maxPages));
+}
+
+void Memory::DisableCache() {
+	// Free the cached pages; reads go straight to the target again
+	this->cache.reset();
+}
+
+bool Memory::IsCacheEnabled() {
+	return this->cache != nullptr;
+}
+
+void Memory::BeginFrame() {
+	// Invalidate every cached page by starting a new generation
+	if (this->cache) {
+		this->cache->BeginFrame();
+	}
+}
+
+PageCacheStatistics Memory::GetCacheStatistics() {
+	return this->cache ? this->cache->GetStatistics() : PageCacheStatistics();
+}
+
+std::vector<MemoryRegion> Memory::GetRegions() {
+	// Delegate to the static GetRegions function using the process handle stored in this instance.
+	return Memory::GetRegions(this->process);
+}
+
+std::vector<ModuleEntry> Memory::GetModules() {
+	// Delegate to the static GetModules function using the process handle stored in this instance.
+	return Memory::GetModules(this->process);
+}
+
+bool Memory::ReadBatch(std::vector<BatchEntry>& entries) {
+	// Delegate to the static ReadBatch function using the process handle stored in this instance.
+	return Memory::ReadBatch(this->process, entries);
+}
+
+bool Memory::WriteBatch(std::vector<BatchEntry>& entries) {
+	// Delegate to the static WriteBatch function using the process handle stored in this instance.
+	bool written = Memory::WriteBatch(this->process, entries);
+
+	// Patch the cached copy of every entry that was written
+	if (this->cache) {
+		for (const BatchEntry& entry : entries) {
+			if (entry.success) {
+				this->cache->Update(entry.address, entry.buffer, entry.size);
+			}
+		}
+	}
+
+	return written;
+}
+
+uintptr_t Memory::FindPattern(const Pattern& pattern) {
+	// Search the main module range reported by moduleInfo
+	return Memory::FindPattern(this->process, (uintptr_t)this->moduleInfo.lpBaseOfDll, this->moduleInfo.SizeOfImage, pattern);
+}
+
+std::vector<uintptr_t> Memory::FindPatterns(const std::vector<Pattern>& patterns) {
+	// Search the main module range reported by moduleInfo, reading it once for all patterns
+	return Memory::FindPatterns(this->process, (uintptr_t)this->moduleInfo.lpBaseOfDll, this->moduleInfo.SizeOfImage, patterns);
+}
+
+std::vector<uintptr_t> Memory::FindPatterns(const std::vector<MemoryRegion>& regions, const std::vector<Pattern>& patterns) {
+	// Delegate to the static FindPatterns function using the process handle stored in this instance.
+	return Memory::FindPatterns(this->process, regions, patterns);
+}
+
+std::vector<StringMatch> Memory::FindStrings(const std::string& text, const StringSearchOptions& options) {
+	// Search every readable region, bypassing the page cache like the other region searches
+	return Memory::FindStrings(this->process, this->GetRegions(), text, options);
+}
+
+std::vector<CodeReference> Memory::FindReferences(const std::vector<uintptr_t>& targets, const XrefOptions& options) {
+	// Collect the executable sections of the main module from the module map
+	ModuleMap& map = this->GetModuleMap();
+	std::vector<MemoryRegion> code;
+	for (size_t i = 0; i < map.GetModules().size(); ++i) {
+		if (map.GetModules()[i].base != this->moduleBaseAddress) {
+			continue;
+		}
+
+		for (const ModuleSection& section : map.GetSections(i)) {
+			if (section.executable) {
+				MemoryRegion region;
+				region.base = section.base;
+				region.size = section.size;
+				region.executable = true;
+				region.image = true;
+				code.push_back(region);
+			}
+		}
+	}
+
+	return Memory::FindReferences(*this, code, targets, options);
+}
+
+std::vector<StringMatch> Memory::FindStrings(const std::vector<MemoryRegion>& regions, const std::string& text, const StringSearchOptions& options) {
+	// Delegate to the static FindStrings function using the process handle stored in this instance.
+	return Memory::FindStrings(this->process, regions, text, options);
 }
@@ -1,12 +1,22 @@
 #pragma once
 
 #include <iostream>
-#include <Windows.h>
-#include <TlHelp32.h>
-#include <Psapi.h>
+#include <memory>
+#include <optional>
+#include <string>
 #include <vector>
-
-class Memory {
+#include "Instrumentation.h"
+#include "MemoryReader.h"
+#include "ModuleMap.h"
+#include "PageCache.h"
+#include "Pattern.h"
+#include "PointerPath.h"
+#include "Platform.h"
+#include "RegionTable.h"
+#include "StringSearch.h"
+#include "XrefFinder.h"
+
+class Memory : public MemoryReader {
 private:
 	// Stores the name of the target process (e.g., L"notepad.exe")
 	std::wstring processName;
@@ -24,7 +34,7 @@ private:
 	uintptr_t moduleBaseAddress = 0;
 
 	// Stores information about the main module of the process
-	MODULEINFO moduleInfo; 
+	MODULEINFO moduleInfo = {};
 
 	// Error message to store any issues encountered during operations
 	std::string errorMessage;
@@ -32,6 +42,31 @@ private:
 	// Indicates whether the Memory object has successfully attached to a process
 	bool attachStatus = false;
 
+	// Optional page cache used by the member read functions, see EnableCache
+	std::unique_ptr<PageCache> cache;
+
+	// Modules and regions of the attached process, enumerated on first use
+	ModuleMap moduleMap;
+
+	// Readable regions of the attached process, checked by TryRead and TryGetAddress before reading
+	RegionTable regionTable;
+
+	/**
+	 * @brief Opens a process by ID and initializes the handle and main module members.
+	 *
+	 * Shared by both attachProcess overloads once processName has been stored.
+	 * Sets errorMessage and leaves attachStatus false if any step fails.
+	 *
+	 * @param processID The ID of the process to open, 0 if it was not found.
+	 */
+	void openProcess(DWORD processID);
+
+	// Reads through the page cache if it is enabled, without recording a probe
+	bool ReadUnprobed(uintptr_t address, void* buffer, size_t size, size_t* bytesRead = nullptr);
+
+	// Checks the region table, then reads like ReadUnprobed
+	bool ReadChecked(uintptr_t address, void* buffer, size_t size);
+
 public:
 	/**
 	 * @brief Constructs a Memory object and attempts to attach to the specified process.
@@ -44,6 +79,19 @@ public:
 	 */
 	Memory(const std::wstring processName);
 
+	/**
+	 * @brief Constructs a Memory object and attempts to attach to the process with the given ID.
+	 *
+	 * Use this constructor when several processes share the same executable name and the
+	 * first match returned by GetProcessID is not the right one.
+	 *
+	 * @param processID The ID of the process to attach to.
+	 */
+	Memory(DWORD processID);
+
+	Memory(const Memory&) = delete;
+	Memory& operator=(const Memory&) = delete;
+
 	/**
 	 * @brief Destructor for the Memory class.
 	 *
@@ -55,9 +103,9 @@ public:
 	/**
 	 * @brief Retrieves the process ID of a running process by its executable name.
 	 *
-	 * This method takes a snapshot of all processes in the system and iterates through them,
-	 * comparing each process's executable name (case-insensitive) to the provided name.
-	 * If a match is found, the corresponding process ID is returned.
+	 * This method takes a snapshot of all processes in the system (ToolHelp on Windows, /proc on Linux)
+	 * and iterates through them, comparing each process's executable name (case-insensitive) to the
+	 * provided name. If a match is found, the corresponding process ID is returned.
 	 * If no match is found, returns 0.
 	 *
 	 * @param processName The name of the process executable (e.g., L"notepad.exe").
@@ -68,8 +116,9 @@ public:
 	/**
 	* @brief Retrieves the base address of a module within a specified process.
 	*
-	* This method takes a snapshot of all modules loaded in the process identified by processID,
-	* then iterates through them to find a module whose name matches the provided moduleName
+	* This method takes a snapshot of all modules loaded in the process identified by processID
+	* (ToolHelp on Windows, /proc/<pid>/maps on Linux), then iterates through them to find a module
+	* whose name matches the provided moduleName
 	* (case-insensitive). If found, it returns the base address of the module. If not found,
 	* returns 0.
 	*
@@ -84,7 +133,7 @@ public:
 	 *
 	 * This function fills a MODULEINFO structure with details about the specified module
 	 * in the target process, such as its base address, size, and entry point.
-	 * It uses the GetModuleInformation API to query the information.
+	 * It uses GetModuleInformation on Windows and the module's mappings and ELF header on Linux.
 	 *
 	 * @param process Handle to the target process.
 	 * @param hModule Handle to the module within the process.
@@ -104,28 +153,86 @@ public:
 	* @param offsets A vector of offsets to follow in the pointer chain.
 	* @return The final resolved address, or 0 if any memory read fails.
 	*/
-	static uintptr_t GetAddress(HANDLE process, uintptr_t address, std::vector<unsigned int> offsets);
+	static uintptr_t GetAddress(HANDLE process, uintptr_t address, const std::vector<unsigned int>& offsets);
 
 	/**
-	 * @brief Reads a string from the memory of a remote process.
+	 * @brief Resolves a PointerPath in a remote process.
 	 *
-	 * This function allocates a buffer of size maxLength, initializes it to zero,
-	 * and reads up to maxLength bytes from the specified address in the target process.
-	 * It then constructs a std::string from the buffer, stopping at the first null terminator.
-	 * The buffer is freed before returning the result.
+	 * Same as the offsets overload, but the path holds its offsets in a fixed array, so a path
+	 * declared constexpr is resolved without any allocation.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param moduleBase The address the base of the path is relative to.
+	 * @param path The pointer path to follow.
+	 * @return The final resolved address, or 0 if the path is invalid or any memory read fails.
+	 */
+	static uintptr_t GetAddress(HANDLE process, uintptr_t moduleBase, const PointerPath& path);
+
+	/**
+	 * @brief Resolves many pointer paths in a remote process with one batched read per level.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param moduleBase The address the bases of the paths are relative to.
+	 * @param resolver The paths to resolve, merged by their shared prefixes.
+	 * @param addresses Receives the final address of every path by index, 0 where a read failed.
+	 * @return True if every path was resolved, false if at least one read failed.
+	 */
+	static bool GetAddresses(HANDLE process, uintptr_t moduleBase, PointerResolver& resolver, std::vector<uintptr_t>& addresses);
+
+	/**
+	 * @brief Reads a null-terminated string from the memory of a remote process.
+	 *
+	 * The string is read in chunks that never cross a 4 KiB page boundary, stopping at the first
+	 * chunk holding the terminator, so a short string costs one small read and a string that ends
+	 * just before an unmapped page is still read. The chunks go to a buffer kept per thread, so
+	 * only a string too long for the small string optimization allocates.
 	 *
 	 * @param process Handle to the target process with read access.
 	 * @param address The address in the remote process to read the string from.
 	 * @param maxLength The maximum number of bytes to read (default: 100).
-	 * @return The string read from the process memory (may be empty if read fails).
+	 * @return The string read up to its terminator, maxLength or the first unreadable page.
 	 */
 	static std::string ReadString(HANDLE process, uintptr_t address, SIZE_T maxLength = 100);
 
+	/**
+	 * @brief Reads a null-terminated string from the memory of a remote process into a caller's buffer.
+	 *
+	 * Reads like the std::string overload but never allocates, for reading many names per frame.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param address The address in the remote process to read the string from.
+	 * @param buffer Receives the string and a terminator.
+	 * @param size The size of buffer in characters, terminator included; at most size - 1 are read.
+	 * @return The length of the string in buffer.
+	 */
+	static size_t ReadString(HANDLE process, uintptr_t address, char* buffer, size_t size);
+
+	/**
+	 * @brief Reads a null-terminated UTF-16 string from the memory of a remote process.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param address The address in the remote process to read the string from.
+	 * @param maxLength The maximum number of characters to read (default: 100).
+	 * @return The string read up to its terminator, maxLength or the first unreadable page.
+	 */
+	static std::u16string ReadWideString(HANDLE process, uintptr_t address, SIZE_T maxLength = 100);
+
+	/**
+	 * @brief Reads a null-terminated UTF-16 string from the memory of a remote process into a caller's buffer.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param address The address in the remote process to read the string from.
+	 * @param buffer Receives the string and a terminator.
+	 * @param size The size of buffer in characters, terminator included; at most size - 1 are read.
+	 * @return The length of the string in buffer.
+	 */
+	static size_t ReadWideString(HANDLE process, uintptr_t address, char16_t* buffer, size_t size);
+
 	/**
 	 * @brief Writes a string to the memory of a remote process.
 	 *
 	 * This function writes the contents of a std::string (including the null terminator)
-	 * to the specified address in the target process's memory. It uses WriteProcessMemory
+	 * to the specified address in the target process's memory. It uses Platform::WriteMemory
 	 * to perform the write operation. The function returns true if the write succeeds,
 	 * or false if it fails.
 	 *
@@ -136,6 +243,177 @@ public:
 	 */
 	static bool WriteString(HANDLE process, uintptr_t address, const std::string value);
 
+	/**
+	 * @brief Reads a block of raw bytes from the memory of a remote process.
+	 *
+	 * This is the untyped counterpart of Read<T>, used for bulk transfers such as scanning.
+	 * If the range crosses an unreadable page the read fails, but bytesRead still reports
+	 * how many bytes at the start of the range were copied.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param address The address in the remote process to read from.
+	 * @param buffer The local buffer receiving the data.
+	 * @param size The number of bytes to read.
+	 * @param bytesRead Optional output for the number of bytes actually copied.
+	 * @return True if all bytes were read, false otherwise.
+	 */
+	static bool ReadMemory(HANDLE process, uintptr_t address, void* buffer, size_t size, size_t* bytesRead = nullptr);
+
+	/**
+	 * @brief Writes a block of raw bytes to the memory of a remote process.
+	 *
+	 * This is the untyped counterpart of Write<T>.
+	 *
+	 * @param process Handle to the target process with write access.
+	 * @param address The address in the remote process to write to.
+	 * @param buffer The local data to write.
+	 * @param size The number of bytes to write.
+	 * @return True if all bytes were written, false otherwise.
+	 */
+	static bool WriteMemory(HANDLE process, uintptr_t address, const void* buffer, size_t size);
+
+	/**
+	 * @brief Lists the committed, readable memory regions of a remote process.
+	 *
+	 * This method queries the address space with VirtualQueryEx on Windows and /proc/<pid>/maps
+	 * on Linux. Guard pages and inaccessible pages are left out.
+	 *
+	 * @param process Handle to the target process with query access.
+	 * @return The readable regions in ascending address order.
+	 */
+	static std::vector<MemoryRegion> GetRegions(HANDLE process);
+
+	/**
+	 * @brief Lists the modules loaded in a remote process.
+	 *
+	 * @param process Handle to the target process with query access.
+	 * @return The modules in ascending address order.
+	 */
+	static std::vector<ModuleEntry> GetModules(HANDLE process);
+
+	/**
+	 * @brief Reads many values from the memory of a remote process with as few system calls as possible.
+	 *
+	 * Each BatchEntry describes one (address, size, destination) read. On Linux the whole batch is
+	 * submitted as vectored process_vm_readv calls (up to IOV_MAX entries per call), so reading a few
+	 * hundred fields costs one system call instead of one per field. After the call, the success flag
+	 * of every entry tells whether that entry was read.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param entries The entries to read into their buffers.
+	 * @return True if every entry was read, false if at least one failed.
+	 */
+	static bool ReadBatch(HANDLE process, std::vector<BatchEntry>& entries);
+
+	/**
+	 * @brief Writes many values to the memory of a remote process with as few system calls as possible.
+	 *
+	 * Each BatchEntry describes one (address, size, source) write. On Linux the whole batch is
+	 * submitted as vectored process_vm_writev calls, and entries that fail there are retried one by one.
+	 * After the call, the success flag of every entry tells whether that entry was written.
+	 *
+	 * @param process Handle to the target process with write access.
+	 * @param entries The entries to write from their buffers.
+	 * @return True if every entry was written, false if at least one failed.
+	 */
+	static bool WriteBatch(HANDLE process, std::vector<BatchEntry>& entries);
+
+	/**
+	 * @brief Finds the first occurrence of a byte pattern in a range of a remote process.
+	 *
+	 * The range is copied with one bulk read and searched locally. If the range contains pages
+	 * that cannot be read, only its readable regions are copied and the rest is left zeroed.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param address The first address of the range, e.g. the module base.
+	 * @param size The size of the range in bytes, e.g. MODULEINFO::SizeOfImage.
+	 * @param pattern The pattern to find, e.g. Pattern("8B 0D ?? ?? ?? ?? 85 C9").
+	 * @return The address of the first match, or 0 if the pattern was not found or is invalid.
+	 */
+	static uintptr_t FindPattern(HANDLE process, uintptr_t address, size_t size, const Pattern& pattern);
+
+	/**
+	 * @brief Finds the first occurrence of many byte patterns in a range of a remote process.
+	 *
+	 * The range is copied once, and all patterns are resolved in a single pass over the copy
+	 * (see PatternSet), so resolving hundreds of signatures at attach time takes milliseconds.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param address The first address of the range, e.g. the module base.
+	 * @param size The size of the range in bytes, e.g. MODULEINFO::SizeOfImage.
+	 * @param patterns The patterns to find.
+	 * @return The address of the first match of every pattern, in the order of patterns (0 if not found).
+	 */
+	static std::vector<uintptr_t> FindPatterns(HANDLE process, uintptr_t address, size_t size, const std::vector<Pattern>& patterns);
+
+	/**
+	 * @brief Finds the first occurrence of many byte patterns in a list of regions of a remote process.
+	 *
+	 * Large regions are copied in blocks of 16 MiB that overlap by the length of the longest
+	 * pattern. The search stops as soon as every pattern has been found.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param regions The regions to search in ascending address order, e.g. from GetRegions.
+	 * @param patterns The patterns to find.
+	 * @return The address of the first match of every pattern, in the order of patterns (0 if not found).
+	 */
+	static std::vector<uintptr_t> FindPatterns(HANDLE process, const std::vector<MemoryRegion>& regions, const std::vector<Pattern>& patterns);
+
+	/**
+	 * @brief Finds the first occurrence of many byte patterns in a list of regions of any memory reader.
+	 *
+	 * Works like the HANDLE overload, but reads through a MemoryReader, so a SnapshotFile can be
+	 * searched offline. Memory the reader can hand out in place is searched without a copy.
+	 *
+	 * @param reader The memory to search, e.g. a Memory instance or a SnapshotFile.
+	 * @param regions The regions to search in ascending address order, e.g. from reader.GetRegions().
+	 * @param patterns The patterns to find.
+	 * @return The address of the first match of every pattern, in the order of patterns (0 if not found).
+	 */
+	static std::vector<uintptr_t> FindPatterns(MemoryReader& reader, const std::vector<MemoryRegion>& regions, const std::vector<Pattern>& patterns);
+
+	/**
+	 * @brief Finds a piece of text stored as ASCII or UTF-16 in a list of regions of a remote process.
+	 *
+	 * Regions are copied in blocks of 16 MiB and every block is searched with one vectorized
+	 * pass (see StringSearch), optionally ignoring case.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param regions The regions to search in ascending address order, e.g. from GetRegions.
+	 * @param text The text to find.
+	 * @param options The encodings to search, whether case is ignored and how many matches to collect.
+	 * @return The matches in ascending address order.
+	 */
+	static std::vector<StringMatch> FindStrings(HANDLE process, const std::vector<MemoryRegion>& regions, const std::string& text, const StringSearchOptions& options = StringSearchOptions());
+
+	/**
+	 * @brief Finds a piece of text stored as ASCII or UTF-16 in a list of regions of any memory reader.
+	 *
+	 * Works like the HANDLE overload, but reads through a MemoryReader, so a SnapshotFile can be
+	 * searched offline.
+	 *
+	 * @param reader The memory to search, e.g. a Memory instance or a SnapshotFile.
+	 * @param regions The regions to search in ascending address order, e.g. from reader.GetRegions().
+	 * @param text The text to find.
+	 * @param options The encodings to search, whether case is ignored and how many matches to collect.
+	 * @return The matches in ascending address order.
+	 */
+	static std::vector<StringMatch> FindStrings(MemoryReader& reader, const std::vector<MemoryRegion>& regions, const std::string& text, const StringSearchOptions& options = StringSearchOptions());
+
+	/**
+	 * @brief Finds the instructions in a list of code regions that refer to any of a set of addresses.
+	 *
+	 * Regions are read in blocks of 16 MiB that overlap by the few bytes an instruction can reach
+	 * past its operand, and every block is searched by an XrefFinder.
+	 *
+	 * @param reader The memory to search, e.g. a Memory instance or a SnapshotFile.
+	 * @param regions The code to search, e.g. the executable sections of a module.
+	 * @param targets The addresses to find references to, such as static globals.
+	 * @param options The instruction set and the kinds of references to find.
+	 * @return The references, region by region.
+	 */
+	static std::vector<CodeReference> FindReferences(MemoryReader& reader, const std::vector<MemoryRegion>& regions, const std::vector<uintptr_t>& targets, const XrefOptions& options = XrefOptions());
+
 	/**
 	 * @brief Attaches to a process by its name and initializes relevant members.
 	 *
@@ -151,6 +429,16 @@ public:
 	 */
 	void attachProcess(const std::wstring processName);
 
+	/**
+	 * @brief Attaches to a process by its ID and initializes relevant members.
+	 *
+	 * The process name is looked up from the ID and used to find the main module,
+	 * then the same steps as attachProcess(processName) are performed.
+	 *
+	 * @param processID The ID of the process to attach to.
+	 */
+	void attachProcess(DWORD processID);
+
 	/**
 	 * @brief Checks if the Memory instance is currently attached to a process.
 	 *
@@ -224,6 +512,36 @@ public:
 	 */
 	uintptr_t GetModuleBaseAddress();
 
+	/**
+	 * @brief Returns the base address of any module loaded in the attached process.
+	 *
+	 * Unlike the static overload, this looks the name up in the module map instead of taking
+	 * a new snapshot. The map is refreshed only if the name is not found, so modules loaded
+	 * after the first call are still found.
+	 *
+	 * @param moduleName The name of the module to find (case-insensitive), e.g. L"kernel32.dll".
+	 * @return The base address of the module if found, otherwise 0.
+	 */
+	uintptr_t GetModuleBaseAddress(const std::wstring& moduleName);
+
+	/**
+	 * @brief Returns the module map of the attached process, enumerating it on the first call.
+	 *
+	 * Call Refresh on the map to pick up modules loaded or unloaded since then.
+	 *
+	 * @return The module map, empty if no process is attached.
+	 */
+	ModuleMap& GetModuleMap();
+
+	/**
+	 * @brief Returns the region table TryRead, TryReadMemory and TryGetAddress check addresses against.
+	 *
+	 * Its statistics count the reads that were skipped because they could not succeed.
+	 *
+	 * @return The region table, empty if no process is attached.
+	 */
+	RegionTable& GetRegionTable();
+
 	/**
 	 * @brief Retrieves information about the main module of the attached process.
 	 *
@@ -247,21 +565,89 @@ public:
 	 * @param offsets A vector of offsets to follow in the pointer chain.
 	 * @return The final resolved address, or 0 if any memory read fails.
 	 */
-	uintptr_t GetAddress(uintptr_t address, std::vector<unsigned int> offsets);
+	uintptr_t GetAddress(uintptr_t address, const std::vector<unsigned int>& offsets);
+
+	/**
+	 * @brief Resolves a PointerPath in the target process, relative to the module base address.
+	 *
+	 * @param path The pointer path to follow.
+	 * @return The final resolved address, or 0 if the path is invalid or any memory read fails.
+	 */
+	uintptr_t GetAddress(const PointerPath& path);
+
+	/**
+	 * @brief Resolves a multi-level pointer like GetAddress, checking every hop against the region table first.
+	 *
+	 * A hop landing on null, kernel space or a freed region ends the chain without a syscall,
+	 * see TryReadMemory. Reads go through the page cache if it is enabled.
+	 *
+	 * @param address The base address (relative to the module base) where the pointer chain starts.
+	 * @param offsets A vector of offsets to follow in the pointer chain.
+	 * @return The final resolved address, or std::nullopt if any hop is unreadable.
+	 */
+	std::optional<uintptr_t> TryGetAddress(uintptr_t address, const std::vector<unsigned int>& offsets);
+
+	/**
+	 * @brief Resolves a PointerPath like GetAddress, checking every hop against the region table first.
+	 *
+	 * @param path The pointer path to follow.
+	 * @return The final resolved address, or std::nullopt if the path is invalid or any hop is unreadable.
+	 */
+	std::optional<uintptr_t> TryGetAddress(const PointerPath& path);
 
 	/**
-	 * @brief Reads a string from the memory of the target process at the specified address.
+	 * @brief Resolves many pointer paths in the target process, relative to the module base address.
 	 *
-	 * This method calls the static ReadString function, passing the process handle
-	 * associated with this Memory instance, the target address, and the maximum length
-	 * of the string to read. It returns the string read from the process memory.
+	 * This method calls the static GetAddresses function with the process handle and module base
+	 * address of this instance. The batched reads bypass the page cache, see EnableCache.
+	 *
+	 * @param resolver The paths to resolve, merged by their shared prefixes.
+	 * @param addresses Receives the final address of every path by index, 0 where a read failed.
+	 * @return True if every path was resolved, false if at least one read failed.
+	 */
+	bool GetAddresses(PointerResolver& resolver, std::vector<uintptr_t>& addresses);
+
+	/**
+	 * @brief Reads a null-terminated string from the memory of the target process at the specified address.
+	 *
+	 * This method reads like the static ReadString function, in page-bounded chunks that stop
+	 * at the terminator, going through the page cache if it is enabled.
 	 *
 	 * @param address The address in the target process to read the string from.
 	 * @param maxLength The maximum number of bytes to read (default: 100).
-	 * @return The string read from the process memory (may be empty if read fails).
+	 * @return The string read up to its terminator, maxLength or the first unreadable page.
 	 */
 	std::string ReadString(uintptr_t address, SIZE_T maxLength = 100);
 
+	/**
+	 * @brief Reads a null-terminated string from the target process into a caller's buffer without allocating.
+	 *
+	 * @param address The address in the target process to read the string from.
+	 * @param buffer Receives the string and a terminator.
+	 * @param size The size of buffer in characters, terminator included; at most size - 1 are read.
+	 * @return The length of the string in buffer.
+	 */
+	size_t ReadString(uintptr_t address, char* buffer, size_t size);
+
+	/**
+	 * @brief Reads a null-terminated UTF-16 string from the memory of the target process.
+	 *
+	 * @param address The address in the target process to read the string from.
+	 * @param maxLength The maximum number of characters to read (default: 100).
+	 * @return The string read up to its terminator, maxLength or the first unreadable page.
+	 */
+	std::u16string ReadWideString(uintptr_t address, SIZE_T maxLength = 100);
+
+	/**
+	 * @brief Reads a null-terminated UTF-16 string from the target process into a caller's buffer without allocating.
+	 *
+	 * @param address The address in the target process to read the string from.
+	 * @param buffer Receives the string and a terminator.
+	 * @param size The size of buffer in characters, terminator included; at most size - 1 are read.
+	 * @return The length of the string in buffer.
+	 */
+	size_t ReadWideString(uintptr_t address, char16_t* buffer, size_t size);
+
 	/**
 	 * @brief Writes a string to the memory of the target process at the specified address.
 	 *
@@ -275,10 +661,203 @@ public:
 	 */
 	bool WriteString(uintptr_t address, const std::string value);
 
+	/**
+	 * @brief Reads a block of raw bytes from the memory of the target process.
+	 *
+	 * This method calls the static ReadMemory function with the process handle associated
+	 * with this Memory instance.
+	 *
+	 * @param address The address in the target process to read from.
+	 * @param buffer The local buffer receiving the data.
+	 * @param size The number of bytes to read.
+	 * @param bytesRead Optional output for the number of bytes actually copied.
+	 * @return True if all bytes were read, false otherwise.
+	 */
+	bool ReadMemory(uintptr_t address, void* buffer, size_t size, size_t* bytesRead = nullptr) override;
+
+	/**
+	 * @brief Reads a block of raw bytes after checking the address against the region table.
+	 *
+	 * Addresses outside the readable regions of the target fail without a syscall. The table is
+	 * enumerated on first use and refreshed lazily when a check misses or a read it allowed
+	 * fails, see RegionTable. The read itself goes through ReadMemory and the page cache.
+	 *
+	 * @param address The address in the target process to read from.
+	 * @param buffer The local buffer receiving the data.
+	 * @param size The number of bytes to read.
+	 * @return True if all bytes were read, false otherwise.
+	 */
+	bool TryReadMemory(uintptr_t address, void* buffer, size_t size);
+
+	/**
+	 * @brief Writes a block of raw bytes to the memory of the target process.
+	 *
+	 * This method calls the static WriteMemory function with the process handle associated
+	 * with this Memory instance, and updates the page cache if it is enabled.
+	 *
+	 * @param address The address in the target process to write to.
+	 * @param buffer The local data to write.
+	 * @param size The number of bytes to write.
+	 * @return True if all bytes were written, false otherwise.
+	 */
+	bool WriteMemory(uintptr_t address, const void* buffer, size_t size);
+
+	/**
+	 * @brief Turns on the page cache for the member read functions.
+	 *
+	 * Once enabled, Read<T>, ReadString, ReadMemory and GetAddress copy whole 4 KiB pages on
+	 * first touch and serve later reads of those pages from local memory until BeginFrame is
+	 * called. Write<T>, WriteString, WriteMemory and WriteBatch write through to the target and
+	 * update the cached pages. Reads larger than PageCache::kMaxCachedRead (such as the blocks
+	 * of a Scanner) and ReadBatch always go to the target. Enabling the cache again replaces it
+	 * with an empty one.
+	 *
+	 * @param maxPages The maximum number of pages to hold, evicting the least recently used page beyond it.
+	 */
+	void EnableCache(size_t maxPages = 1024);
+
+	/**
+	 * @brief Turns off the page cache and frees its pages.
+	 */
+	void DisableCache();
+
+	/**
+	 * @brief Returns true if the page cache is enabled.
+	 */
+	bool IsCacheEnabled();
+
+	/**
+	 * @brief Starts a new frame, which invalidates every cached page.
+	 *
+	 * Call this once per frame or tick, before reading the state of the target. It only bumps
+	 * a generation number, so it costs nothing; pages are copied again on their next use.
+	 * Does nothing if the cache is disabled.
+	 */
+	void BeginFrame();
+
+	/**
+	 * @brief Returns the hit, miss and eviction counters of the page cache (all 0 if disabled).
+	 */
+	PageCacheStatistics GetCacheStatistics();
+
+	/**
+	 * @brief Lists the committed, readable memory regions of the target process.
+	 *
+	 * This method calls the static GetRegions function with the process handle associated
+	 * with this Memory instance.
+	 *
+	 * @return The readable regions in ascending address order.
+	 */
+	std::vector<MemoryRegion> GetRegions() override;
+
+	/**
+	 * @brief Lists the modules loaded in the target process.
+	 *
+	 * This method calls the static GetModules function with the process handle associated
+	 * with this Memory instance.
+	 *
+	 * @return The modules in ascending address order.
+	 */
+	std::vector<ModuleEntry> GetModules() override;
+
+	/**
+	 * @brief Reads many values from the memory of the target process in one batch.
+	 *
+	 * This method calls the static ReadBatch function with the process handle associated
+	 * with this Memory instance.
+	 *
+	 * @param entries The entries to read into their buffers.
+	 * @return True if every entry was read, false if at least one failed.
+	 */
+	bool ReadBatch(std::vector<BatchEntry>& entries) override;
+
+	/**
+	 * @brief Writes many values to the memory of the target process in one batch.
+	 *
+	 * This method calls the static WriteBatch function with the process handle associated
+	 * with this Memory instance.
+	 *
+	 * @param entries The entries to write from their buffers.
+	 * @return True if every entry was written, false if at least one failed.
+	 */
+	bool WriteBatch(std::vector<BatchEntry>& entries);
+
+	/**
+	 * @brief Finds the first occurrence of a byte pattern in the main module of the target process.
+	 *
+	 * This method calls the static FindPattern function with the module range taken from
+	 * moduleInfo (lpBaseOfDll and SizeOfImage).
+	 *
+	 * @param pattern The pattern to find, e.g. "8B 0D ?? ?? ?? ?? 85 C9".
+	 * @return The address of the first match, or 0 if the pattern was not found or is invalid.
+	 */
+	uintptr_t FindPattern(const Pattern& pattern);
+
+	/**
+	 * @brief Finds the first occurrence of many byte patterns in the main module of the target process.
+	 *
+	 * This method calls the static FindPatterns function with the module range taken from
+	 * moduleInfo, so the module is read once for all patterns.
+	 *
+	 * @param patterns The patterns to find.
+	 * @return The address of the first match of every pattern, in the order of patterns (0 if not found).
+	 */
+	std::vector<uintptr_t> FindPatterns(const std::vector<Pattern>& patterns);
+
+	/**
+	 * @brief Finds the first occurrence of many byte patterns in a list of regions of the target process.
+	 *
+	 * This method calls the static FindPatterns function with the process handle associated
+	 * with this Memory instance.
+	 *
+	 * @param regions The regions to search in ascending address order, e.g. from GetRegions.
+	 * @param patterns The patterns to find.
+	 * @return The address of the first match of every pattern, in the order of patterns (0 if not found).
+	 */
+	std::vector<uintptr_t> FindPatterns(const std::vector<MemoryRegion>& regions, const std::vector<Pattern>& patterns);
+
+	/**
+	 * @brief Finds a piece of text stored as ASCII or UTF-16 in every readable region of the target process.
+	 *
+	 * This method calls the static FindStrings function with the process handle associated
+	 * with this Memory instance and the regions from GetRegions.
+	 *
+	 * @param text The text to find.
+	 * @param options The encodings to search, whether case is ignored and how many matches to collect.
+	 * @return The matches in ascending address order.
+	 */
+	std::vector<StringMatch> FindStrings(const std::string& text, const StringSearchOptions& options = StringSearchOptions());
+
+	/**
+	 * @brief Finds a piece of text stored as ASCII or UTF-16 in a list of regions of the target process.
+	 *
+	 * This method calls the static FindStrings function with the process handle associated
+	 * with this Memory instance.
+	 *
+	 * @param regions The regions to search in ascending address order, e.g. from GetRegions.
+	 * @param text The text to find.
+	 * @param options The encodings to search, whether case is ignored and how many matches to collect.
+	 * @return The matches in ascending address order.
+	 */
+	std::vector<StringMatch> FindStrings(const std::vector<MemoryRegion>& regions, const std::string& text, const StringSearchOptions& options = StringSearchOptions());
+
+	/**
+	 * @brief Finds the instructions in the main module of the target process that refer to any of a set of addresses.
+	 *
+	 * This method calls the static FindReferences function with the executable sections of the
+	 * main module, taken from the module map (the PE section table on Windows).
+	 *
+	 * @param targets The addresses to find references to, e.g. GetModuleBaseAddress() + 0x17E0A8.
+	 * @param options The instruction set and the kinds of references to find.
+	 * @return The references, section by section.
+	 */
+	std::vector<CodeReference> FindReferences(const std::vector<uintptr_t>& targets, const XrefOptions& options = XrefOptions());
+
 	/**
 	 * @brief Reads a value of type T from the specified address in the target process's memory.
 	 *
-	 * This template function attempts to read memory from a remote process at the given address.
+	 * This template function attempts to read memory from a remote process at the given address
+	 * through the platform layer (ReadProcessMemory on Windows, process_vm_readv on Linux).
 	 * If the read operation fails, it returns 0 (which may not be suitable for all types).
 	 *
 	 * @tparam T The type of value to read (e.g., int, float, struct).
@@ -291,7 +870,7 @@ public:
 		T value; // Variable to store the read value
 
 		// Attempt to read memory from the target process at the specified address
-		ReadProcessMemory(process, (LPCVOID)address, &value, sizeof(T), NULL);
+		Memory::ReadMemory(process, address, &value, sizeof(T));
 
 		// Return the value read from memory
 		return value;
@@ -301,7 +880,7 @@ public:
 	* @brief Reads a value of type T from the specified address in the target process's memory.
 	*
 	* This member function attempts to read memory from the process associated with this Memory instance
-	* at the given address. It uses the Windows API ReadProcessMemory to perform the read operation.
+	* at the given address. It uses ReadMemory, so the read is served from the page cache if it is enabled.
 	* If the read operation fails, the returned value will be uninitialized.
 	*
 	* @tparam T The type of value to read (e.g., int, float, struct).
@@ -312,13 +891,33 @@ public:
 	T Read(uintptr_t address) {
 		T value; // Variable to store the value read from memory
 
-		// Attempt to read memory from the target process at the specified address.
-		ReadProcessMemory(process, (LPCVOID)address, &value, sizeof(T), NULL);
+		// Attempt to read memory from the target process (or the page cache) at the specified address.
+		this->ReadMemory(address, &value, sizeof(T));
 
 		// Return the value read from memory.
 		return value;
 	}
 
+	/**
+	 * @brief Reads a value of type T, or nothing if the address is not readable.
+	 *
+	 * Unlike Read, a failed read cannot be mistaken for a value, and addresses outside the
+	 * readable regions of the target (null, kernel space, freed memory) fail without a syscall.
+	 * See TryReadMemory.
+	 *
+	 * @tparam T The type of value to read (e.g., int, float, struct).
+	 * @param address The memory address to read from in the target process.
+	 * @return The value read from memory, or std::nullopt if the read fails.
+	 */
+	template <typename T>
+	std::optional<T> TryRead(uintptr_t address) {
+		T value;
+		if (!this->TryReadMemory(address, &value, sizeof(T))) {
+			return std::nullopt;
+		}
+		return value;
+	}
+
 	/**
 	 * @brief Writes a value of type T to the specified address in the target process's memory.
 	 *
@@ -334,14 +933,14 @@ public:
 	template <typename T>
 	static bool Write(HANDLE process, uintptr_t address, T value) {
 		// Write the value to the target process's memory at the specified address
-		return WriteProcessMemory(process, (LPVOID)address, &value, sizeof(T), NULL);
+		return Memory::WriteMemory(process, address, &value, sizeof(T));
 	}
 
 	/**
 	* @brief Writes a value of type T to the specified address in the target process's memory.
 	*
 	* This member function attempts to write the provided value to the process associated with this Memory instance
-	* at the given address. It uses the Windows API WriteProcessMemory to perform the write operation.
+	* at the given address. It uses WriteMemory, which also updates the page cache if it is enabled.
 	* The function returns true if the write operation succeeds, or false if it fails.
 	*
 	* @tparam T The type of value to write (e.g., int, float, struct).
@@ -352,6 +951,6 @@ public:
 	template <typename T>
 	bool Write(uintptr_t address, T value) {
 		// Write the value to the target process's memory at the specified address.
-		return WriteProcessMemory(process, (LPVOID)address, &value, sizeof(T), NULL);
+		return this->WriteMemory(address, &value, sizeof(T));
 	}
 };
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Platform.h"
+
+/**
+ * @brief Read access to the memory of a process, either running or captured to disk.
+ *
+ * Memory implements it for a live process and SnapshotFile for a capture, so Scanner,
+ * PointerScanner and Memory::FindPatterns run against either one without changes.
+ */
+class MemoryReader {
+public:
+	virtual ~MemoryReader() = default;
+
+	/**
+	 * @brief Copies memory into a local buffer.
+	 *
+	 * @param address The address to read from.
+	 * @param buffer The local buffer receiving the data.
+	 * @param size The number of bytes to read.
+	 * @param bytesRead Optional output for the number of bytes of the prefix that were copied.
+	 * @return True if all bytes were read, false otherwise.
+	 */
+	virtual bool ReadMemory(uintptr_t address, void* buffer, size_t size, size_t* bytesRead = nullptr) = 0;
+
+	/**
+	 * @brief Reads many independent ranges, updating the success flag of every entry.
+	 *
+	 * @return True if every entry was read, false if at least one failed.
+	 */
+	virtual bool ReadBatch(std::vector<BatchEntry>& entries) = 0;
+
+	/**
+	 * @brief Lists the readable regions in ascending address order.
+	 */
+	virtual std::vector<MemoryRegion> GetRegions() = 0;
+
+	/**
+	 * @brief Lists the modules in ascending address order.
+	 */
+	virtual std::vector<ModuleEntry> GetModules() = 0;
+
+	/**
+	 * @brief Returns the memory at an address without copying it, if it is directly addressable.
+	 *
+	 * A live process always returns nullptr; a mapped capture returns a pointer into the mapping
+	 * when the whole range lies in one region.
+	 *
+	 * @param address The address of the first byte.
+	 * @param size The number of bytes that must be addressable.
+	 * @return A pointer to size bytes, or nullptr if the range has to be read with ReadMemory.
+	 */
+	virtual const uint8_t* GetView(uintptr_t /*address*/, size_t /*size*/) {
+		return nullptr;
+	}
+};
@@ -0,0 +1,266 @@
+#include "ModuleMap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+
+namespace {
+	// Bytes read from the start of a module to find its PE headers
+	const size_t kHeaderSize = 0x1000;
+
+	// Size of one IMAGE_SECTION_HEADER, and the flags of its Characteristics field used here
+	const size_t kSectionHeaderSize = 40;
+	const uint32_t kSectionExecute = 0x20000000;
+	const uint32_t kSectionWrite = 0x80000000;
+
+	// Reads a little-endian value from a header buffer
+	template <typename T>
+	T Load(const uint8_t* data) {
+		T value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	// Lowercases a module name for the name table
+	std::wstring Lower(const std::wstring& name) {
+		std::wstring result(name);
+		for (wchar_t& c : result) {
+			c = (wchar_t)std::towlower(c);
+		}
+		return result;
+	}
+
+	// Writes value as uppercase hex without leading zeros, returns the number of digits
+	size_t FormatHex(uintptr_t value, char* digits) {
+		static const char kDigits[] = "0123456789ABCDEF";
+		char reversed[2 * sizeof(uintptr_t)];
+		size_t count = 0;
+		do {
+			reversed[count++] = kDigits[value & 0xF];
+			value >>= 4;
+		} while (value);
+
+		for (size_t i = 0; i < count; ++i) {
+			digits[i] = reversed[count - 1 - i];
+		}
+		return count;
+	}
+}
+
+ModuleMap::ModuleMap(HANDLE process) : process(process) {
+}
+
+void ModuleMap::Reset(HANDLE process) {
+	this->process = process;
+	this->modules.clear();
+	this->narrowNames.clear();
+	this->sections.clear();
+	this->regions.clear();
+	this->signature = 0;
+	this->BuildIndex();
+	++this->generation;
+}
+
+std::vector<ModuleSection> ModuleMap::ReadSections(const ModuleEntry& module) const {
+	std::vector<ModuleSection> result;
+
+	// PE images describe their sections in the section table after the NT headers
+	uint8_t header[kHeaderSize];
+	if (module.size >= kHeaderSize && Platform::ReadMemory(this->process, module.base, header, kHeaderSize) &&
+		Load<uint16_t>(header) == 0x5A4D) {
+		// e_lfanew comes from the target, so the check must not overflow for a garbage offset
+		size_t ntOffset = Load<uint32_t>(header + 0x3C);
+		if (ntOffset <= kHeaderSize - 24 && Load<uint32_t>(header + ntOffset) == 0x00004550) {
+			size_t count = Load<uint16_t>(header + ntOffset + 6);
+			size_t table = ntOffset + 24 + Load<uint16_t>(header + ntOffset + 20);
+
+			for (size_t i = 0; i < count && table + (i + 1) * kSectionHeaderSize <= kHeaderSize; ++i) {
+				const uint8_t* entry = header + table + i * kSectionHeaderSize;
+				uint32_t virtualSize = Load<uint32_t>(entry + 8);
+				uint32_t characteristics = Load<uint32_t>(entry + 36);
+
+				ModuleSection section;
+				section.name.assign((const char*)entry, strnlen((const char*)entry, 8));
+				section.base = module.base + Load<uint32_t>(entry + 12);
+				section.size = virtualSize ? virtualSize : Load<uint32_t>(entry + 16);
+				section.writable = (characteristics & kSectionWrite) != 0;
+				section.executable = (characteristics & kSectionExecute) != 0;
+				result.push_back(section);
+			}
+
+			return result;
+		}
+	}
+
+	// Other modules are split along their mappings, named after their protection
+	for (const MemoryRegion& region : this->regions) {
+		if (region.base < module.base || region.base >= module.base + module.size) {
+			continue;
+		}
+
+		ModuleSection section;
+		section.name = std::string("r") + (region.writable ? "w" : "-") + (region.executable ? "x" : "-");
+		section.base = region.base;
+		section.size = (size_t)std::min<uintptr_t>(region.size, module.base + module.size - region.base);
+		section.writable = region.writable;
+		section.executable = region.executable;
+		result.push_back(section);
+	}
+
+	return result;
+}
+
+void ModuleMap::BuildIndex() {
+	this->names.clear();
+	this->moduleStarts.clear();
+	this->moduleEnds.clear();
+	this->sectionIntervals.clear();
+
+	for (size_t i = 0; i < this->modules.size(); ++i) {
+		const ModuleEntry& module = this->modules[i];
+
+		// The first module of a name wins, as with GetModuleBaseAddress
+		this->names.emplace(Lower(module.name), i);
+		this->moduleStarts.push_back(module.base);
+		this->moduleEnds.push_back(module.base + module.size);
+
+		for (size_t j = 0; j < this->sections[i].size(); ++j) {
+			SectionInterval interval;
+			interval.start = this->sections[i][j].base;
+			interval.end = this->sections[i][j].base + this->sections[i][j].size;
+			interval.module = (uint32_t)i;
+			interval.section = (uint32_t)j;
+			this->sectionIntervals.push_back(interval);
+		}
+	}
+
+	std::sort(this->sectionIntervals.begin(), this->sectionIntervals.end(),
+		[](const SectionInterval& left, const SectionInterval& right) { return left.start < right.start; });
+}
+
+bool ModuleMap::Refresh() {
+	// Nothing to do while the module list is the same as last time
+	uint64_t signature = Platform::QueryModuleSignature(this->process);
+	if (signature && signature == this->signature) {
+		return false;
+	}
+
+	std::vector<ModuleEntry> modules = Platform::EnumerateModules(this->process);
+	this->regions = Platform::EnumerateRegions(this->process);
+	this->signature = signature;
+
+	// Modules that stayed loaded keep their sections, only new ones have their headers read
+	std::vector<std::vector<ModuleSection>> sections(modules.size());
+	std::vector<std::string> narrowNames(modules.size());
+	size_t previous = 0;
+
+	for (size_t i = 0; i < modules.size(); ++i) {
+		const ModuleEntry& module = modules[i];
+		while (previous < this->modules.size() && this->modules[previous].base < module.base) {
+			++previous;
+		}
+
+		if (previous < this->modules.size() && this->modules[previous].base == module.base &&
+			this->modules[previous].size == module.size && this->modules[previous].name == module.name) {
+			sections[i].swap(this->sections[previous]);
+		} else {
+			sections[i] = this->ReadSections(module);
+		}
+		narrowNames[i].assign(module.name.begin(), module.name.end());
+	}
+
+	this->modules.swap(modules);
+	this->sections.swap(sections);
+	this->narrowNames.swap(narrowNames);
+	this->BuildIndex();
+
+	// The regions may have changed even if the modules did not
+	++this->generation;
+	return true;
+}
+
+uint64_t ModuleMap::GetGeneration() const {
+	return this->generation;
+}
+
+const ModuleEntry* ModuleMap::Find(const std::wstring& name) const {
+	auto found = this->names.find(Lower(name));
+	return found == this->names.end() ? nullptr : &this->modules[found->second];
+}
+
+uintptr_t ModuleMap::GetBaseAddress(const std::wstring& name) const {
+	const ModuleEntry* module = this->Find(name);
+	return module ? module->base : 0;
+}
+
+const ModuleEntry* ModuleMap::FindByAddress(uintptr_t address) const {
+	// Last module starting at or below the address
+	size_t index = std::upper_bound(this->moduleStarts.begin(), this->moduleStarts.end(), address) - this->moduleStarts.begin();
+	if (index == 0 || address >= this->moduleEnds[index - 1]) {
+		return nullptr;
+	}
+	return &this->modules[index - 1];
+}
+
+bool ModuleMap::Lookup(uintptr_t address, ModuleLocation& location) const {
+	location = ModuleLocation();
+
+	location.module = this->FindByAddress(address);
+	if (!location.module) {
+		return false;
+	}
+	location.offset = address - location.module->base;
+
+	// Last section starting at or below the address
+	auto section = std::upper_bound(this->sectionIntervals.begin(), this->sectionIntervals.end(), address,
+		[](uintptr_t value, const SectionInterval& interval) { return value < interval.start; });
+	if (section != this->sectionIntervals.begin() && address < (--section)->end) {
+		location.section = &this->sections[section->module][section->section];
+	}
+
+	return true;
+}
+
+size_t ModuleMap::Symbolize(uintptr_t address, char* buffer, size_t size) const {
+	if (!size) {
+		return 0;
+	}
+
+	// Assemble the text in a local buffer that always fits, then copy what fits into the caller's
+	char text[512];
+	size_t length = 0;
+
+	const ModuleEntry* module = this->FindByAddress(address);
+	if (module) {
+		const std::string& name = this->narrowNames[module - this->modules.data()];
+		length = std::min(name.size(), sizeof(text) - 2 * sizeof(uintptr_t) - 1);
+		std::memcpy(text, name.data(), length);
+		text[length++] = '+';
+		length += FormatHex(address - module->base, text + length);
+	} else {
+		length = FormatHex(address, text);
+	}
+
+	length = std::min(length, size - 1);
+	std::memcpy(buffer, text, length);
+	buffer[length] = '\0';
+	return length;
+}
+
+std::string ModuleMap::Symbolize(uintptr_t address) const {
+	char buffer[512];
+	size_t length = this->Symbolize(address, buffer, sizeof(buffer));
+	return std::string(buffer, length);
+}
+
+const std::vector<ModuleEntry>& ModuleMap::GetModules() const {
+	return this->modules;
+}
+
+const std::vector<ModuleSection>& ModuleMap::GetSections(size_t module) const {
+	return this->sections[module];
+}
+
+const std::vector<MemoryRegion>& ModuleMap::GetRegions() const {
+	return this->regions;
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Platform.h"
+
+/**
+ * @brief A section of a module, such as .text or .data.
+ *
+ * PE images (Windows modules, also under Wine) are split along their section table. Other
+ * modules, such as ELF libraries, are split along their mappings, which are named after their
+ * protection ("r-x", "rw-", "r--").
+ */
+struct ModuleSection {
+	std::string name;        // Section name, e.g. ".text"
+	uintptr_t base = 0;      // First address of the section
+	size_t size = 0;         // Size of the section in bytes
+	bool writable = false;   // The section can be written
+	bool executable = false; // The section can be executed
+};
+
+/**
+ * @brief Where an address lies within the modules of a ModuleMap.
+ */
+struct ModuleLocation {
+	const ModuleEntry* module = nullptr;    // Module containing the address, nullptr if none
+	const ModuleSection* section = nullptr; // Section containing the address, nullptr if none (e.g. headers)
+	uintptr_t offset = 0;                   // Distance from the module base
+};
+
+/**
+ * @brief The modules, sections and regions of a target process, enumerated once and looked up quickly.
+ *
+ * Enumerating modules takes a ToolHelp snapshot on Windows and parses /proc/<pid>/maps on Linux,
+ * which costs far more than a lookup should. The map enumerates everything once: names are
+ * looked up in a hash map, and addresses with a binary search over sorted interval tables, so
+ * symbolizing an address as "module+offset" takes nanoseconds.
+ *
+ * Refresh first compares a cheap signature of the module list (the module handle list on Windows,
+ * a hash of /proc/<pid>/maps on Linux) and only rebuilds when it changed. Modules that stayed
+ * loaded keep their parsed sections, so only newly loaded modules have their headers read.
+ * GetGeneration tells callers whether anything changed since they last looked.
+ *
+ * Lookups are safe from several threads, but Refresh must not run at the same time as them.
+ */
+class ModuleMap {
+private:
+	// One entry of the flat section table used for address lookups
+	struct SectionInterval {
+		uintptr_t start = 0;
+		uintptr_t end = 0;
+		uint32_t module = 0;
+		uint32_t section = 0;
+	};
+
+	// Process the map describes
+	HANDLE process = nullptr;
+
+	// Loaded modules in ascending address order
+	std::vector<ModuleEntry> modules;
+
+	// Module names as narrow strings, for symbolizing
+	std::vector<std::string> narrowNames;
+
+	// Sections of every module, by module index
+	std::vector<std::vector<ModuleSection>> sections;
+
+	// Module bases and ends in ascending order, searched by address
+	std::vector<uintptr_t> moduleStarts;
+	std::vector<uintptr_t> moduleEnds;
+
+	// Sections of all modules in ascending address order
+	std::vector<SectionInterval> sectionIntervals;
+
+	// Module index by lowercase name
+	std::unordered_map<std::wstring, size_t> names;
+
+	// Readable regions of the process
+	std::vector<MemoryRegion> regions;
+
+	// Signature of the module list the map was built from
+	uint64_t signature = 0;
+
+	// Incremented every time the contents change
+	uint64_t generation = 0;
+
+	// Reads the section table of a PE image, or splits other modules along their regions
+	std::vector<ModuleSection> ReadSections(const ModuleEntry& module) const;
+
+	// Rebuilds the lookup tables from modules and sections
+	void BuildIndex();
+
+public:
+	/**
+	 * @brief Creates a map for a process. Nothing is enumerated before the first Refresh.
+	 *
+	 * @param process Handle to the target process, or nullptr for an empty map.
+	 */
+	explicit ModuleMap(HANDLE process = nullptr);
+
+	/**
+	 * @brief Switches the map to another process and empties it.
+	 */
+	void Reset(HANDLE process);
+
+	/**
+	 * @brief Brings the map up to date if the modules of the process changed.
+	 *
+	 * @return True if the contents changed (and GetGeneration was incremented), false otherwise.
+	 */
+	bool Refresh();
+
+	/**
+	 * @brief Returns a number that changes every time Refresh or Reset changes the contents.
+	 */
+	uint64_t GetGeneration() const;
+
+	/**
+	 * @brief Finds a module by name.
+	 *
+	 * @param name The module file name (case-insensitive), e.g. L"kernel32.dll".
+	 * @return The module, or nullptr if no module has that name.
+	 */
+	const ModuleEntry* Find(const std::wstring& name) const;
+
+	/**
+	 * @brief Returns the base address of a module, or 0 if no module has that name.
+	 */
+	uintptr_t GetBaseAddress(const std::wstring& name) const;
+
+	/**
+	 * @brief Finds the module containing an address.
+	 *
+	 * @return The module, or nullptr if the address is outside every module.
+	 */
+	const ModuleEntry* FindByAddress(uintptr_t address) const;
+
+	/**
+	 * @brief Finds the module and section containing an address.
+	 *
+	 * @param address The address to look up.
+	 * @param location Receives the module, section and offset from the module base.
+	 * @return True if the address is inside a module, false otherwise.
+	 */
+	bool Lookup(uintptr_t address, ModuleLocation& location) const;
+
+	/**
+	 * @brief Formats an address as "module+offset" (e.g. "ac_client.exe+17E0A8"), or as plain hex outside every module.
+	 *
+	 * This overload does not allocate and is meant for symbolizing many addresses.
+	 *
+	 * @param address The address to format.
+	 * @param buffer The buffer receiving the zero-terminated text.
+	 * @param size The size of the buffer; the text is truncated to fit.
+	 * @return The length of the text, without the terminator.
+	 */
+	size_t Symbolize(uintptr_t address, char* buffer, size_t size) const;
+
+	/**
+	 * @brief Formats an address as "module+offset", or as plain hex outside every module.
+	 */
+	std::string Symbolize(uintptr_t address) const;
+
+	/**
+	 * @brief Returns the modules in ascending address order.
+	 */
+	const std::vector<ModuleEntry>& GetModules() const;
+
+	/**
+	 * @brief Returns the sections of a module, by its index in GetModules.
+	 */
+	const std::vector<ModuleSection>& GetSections(size_t module) const;
+
+	/**
+	 * @brief Returns the readable regions of the process at the last Refresh.
+	 */
+	const std::vector<MemoryRegion>& GetRegions() const;
+};
@@ -0,0 +1,132 @@
+#include "PageCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+PageCache::PageCache(size_t maxPages) : maxPages(std::max<size_t>(maxPages, 1)) {
+}
+
+const PageCache::Page* PageCache::Fetch(HANDLE process, uintptr_t address) {
+	auto found = this->index.find(address);
+
+	if (found != this->index.end()) {
+		// Move the page to the front of the use order
+		this->pages.splice(this->pages.begin(), this->pages, found->second);
+
+		if (found->second->generation == this->generation) {
+			++this->statistics.hits;
+			return &*found->second;
+		}
+	} else {
+		// Take a new page while below the limit, otherwise reuse the least recently used one
+		if (this->pages.size() < this->maxPages) {
+			this->pages.emplace_front();
+		} else {
+			this->index.erase(this->pages.back().address);
+			this->pages.splice(this->pages.begin(), this->pages, std::prev(this->pages.end()));
+			++this->statistics.evictions;
+		}
+
+		this->pages.front().address = address;
+		found = this->index.emplace(address, this->pages.begin()).first;
+	}
+
+	// The page is new or stale, copy it from the target
+	++this->statistics.misses;
+	Page& page = *found->second;
+	if (!Platform::ReadMemory(process, address, page.data, kPageSize)) {
+		// Unreadable pages are not cached
+		this->pages.erase(found->second);
+		this->index.erase(found);
+		return nullptr;
+	}
+
+	page.generation = this->generation;
+	return &page;
+}
+
+bool PageCache::Read(HANDLE process, uintptr_t address, void* buffer, size_t size, size_t* bytesRead) {
+	// Large reads would only push out the small fields the cache is for
+	if (size > kMaxCachedRead) {
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			++this->statistics.bypassed;
+		}
+		return Platform::ReadMemory(process, address, buffer, size, bytesRead);
+	}
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	size_t copied = 0;
+
+	// Copy the range page by page
+	while (copied < size) {
+		uintptr_t current = address + copied;
+		uintptr_t pageAddress = current & ~(uintptr_t)(kPageSize - 1);
+		size_t offset = (size_t)(current - pageAddress);
+		size_t length = std::min(size - copied, kPageSize - offset);
+
+		const Page* page = this->Fetch(process, pageAddress);
+		if (!page) {
+			break;
+		}
+
+		std::memcpy((uint8_t*)buffer + copied, page->data + offset, length);
+		copied += length;
+	}
+
+	if (bytesRead) {
+		*bytesRead = copied;
+	}
+
+	return copied == size;
+}
+
+void PageCache::Update(uintptr_t address, const void* buffer, size_t size) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	size_t written = 0;
+
+	// Patch every cached page the write touched; pages that are not cached are read fresh later
+	while (written < size) {
+		uintptr_t current = address + written;
+		uintptr_t pageAddress = current & ~(uintptr_t)(kPageSize - 1);
+		size_t offset = (size_t)(current - pageAddress);
+		size_t length = std::min(size - written, kPageSize - offset);
+
+		auto found = this->index.find(pageAddress);
+		if (found != this->index.end()) {
+			std::memcpy(found->second->data + offset, (const uint8_t*)buffer + written, length);
+		}
+
+		written += length;
+	}
+}
+
+void PageCache::BeginFrame() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	// Every page copied before this point is now stale
+	++this->generation;
+}
+
+void PageCache::Clear() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->index.clear();
+	this->pages.clear();
+}
+
+uint64_t PageCache::GetGeneration() const {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->generation;
+}
+
+PageCacheStatistics PageCache::GetStatistics() const {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	PageCacheStatistics statistics = this->statistics;
+	statistics.pages = this->pages.size();
+	return statistics;
+}
+
+void PageCache::ResetStatistics() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->statistics = PageCacheStatistics();
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "Platform.h"
+
+/**
+ * @brief Counters of a PageCache since it was created or its statistics were reset.
+ */
+struct PageCacheStatistics {
+	size_t hits = 0;      // Page lookups served from local memory
+	size_t misses = 0;    // Pages copied from the target process, including stale ones
+	size_t evictions = 0; // Pages dropped to stay within the page limit
+	size_t bypassed = 0;  // Reads too large to be cached, sent straight to the target
+	size_t pages = 0;     // Pages currently held
+
+	/**
+	 * @brief Returns the share of page lookups that were hits, between 0 and 1.
+	 */
+	double GetHitRate() const {
+		return this->hits + this->misses ? (double)this->hits / (this->hits + this->misses) : 0;
+	}
+};
+
+/**
+ * @brief A bounded cache of whole 4 KiB pages of a target process.
+ *
+ * Game loops read many small fields that share a few pages. The first read of a page copies
+ * all of it, and every later read of that page is served from local memory until the next
+ * BeginFrame. BeginFrame only bumps a generation number, so invalidating the whole cache costs
+ * nothing; stale pages are copied again on their next use. At most maxPages pages are kept,
+ * and the least recently used page is reused when the limit is reached. Reads larger than
+ * kMaxCachedRead and reads of unreadable pages go straight to the target process.
+ *
+ * The cache is safe to use from several threads, but the pages are only as fresh as the last
+ * BeginFrame, so it is meant for code that reads a consistent view once per frame or tick.
+ */
+class PageCache {
+public:
+	// Size and alignment of a cached page
+	static const size_t kPageSize = 0x1000;
+
+	// Largest read served from the cache; bulk reads such as scans bypass it
+	static const size_t kMaxCachedRead = 4 * kPageSize;
+
+private:
+	// One cached page
+	struct Page {
+		uintptr_t address = 0;   // Page-aligned address in the target process
+		uint64_t generation = 0; // Frame the page was copied in
+		uint8_t data[kPageSize]; // Copy of the page
+	};
+
+	// Pages in use order, most recently used first
+	std::list<Page> pages;
+
+	// Cached pages by address
+	std::unordered_map<uintptr_t, std::list<Page>::iterator> index;
+
+	// Maximum number of pages held
+	size_t maxPages;
+
+	// Current frame; pages copied in an earlier frame are stale
+	uint64_t generation = 1;
+
+	// Counters reported by GetStatistics
+	PageCacheStatistics statistics;
+
+	// Guards all members, since Memory may be shared by several threads
+	mutable std::mutex mutex;
+
+	// Returns the current copy of a page, copying it from the target if needed, or nullptr if it is unreadable
+	const Page* Fetch(HANDLE process, uintptr_t address);
+
+public:
+	/**
+	 * @brief Creates an empty cache.
+	 *
+	 * @param maxPages The maximum number of pages to hold (at least 1), 4 MiB of pages by default.
+	 */
+	explicit PageCache(size_t maxPages = 1024);
+
+	/**
+	 * @brief Reads from the cache, copying missing or stale pages from the target process.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param address The address in the target process to read from.
+	 * @param buffer The local buffer receiving the data.
+	 * @param size The number of bytes to read.
+	 * @param bytesRead Optional output for the number of bytes actually copied.
+	 * @return True if all bytes were read, false otherwise.
+	 */
+	bool Read(HANDLE process, uintptr_t address, void* buffer, size_t size, size_t* bytesRead = nullptr);
+
+	/**
+	 * @brief Applies a successful write to the cached pages it touches, so later reads see it.
+	 *
+	 * @param address The address in the target process that was written.
+	 * @param buffer The data that was written.
+	 * @param size The number of bytes written.
+	 */
+	void Update(uintptr_t address, const void* buffer, size_t size);
+
+	/**
+	 * @brief Starts a new frame, which makes every cached page stale.
+	 */
+	void BeginFrame();
+
+	/**
+	 * @brief Drops every cached page, e.g. after attaching to another process.
+	 */
+	void Clear();
+
+	/**
+	 * @brief Returns the current frame number, incremented by every BeginFrame.
+	 */
+	uint64_t GetGeneration() const;
+
+	/**
+	 * @brief Returns the hit, miss and eviction counters.
+	 */
+	PageCacheStatistics GetStatistics() const;
+
+	/**
+	 * @brief Sets all counters back to 0.
+	 */
+	void ResetStatistics();
+};
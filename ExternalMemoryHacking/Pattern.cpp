@@ -0,0 +1,276 @@
+#include "Pattern.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+	// Without vector instructions, sets of up to this many patterns are searched one by one with Horspool
+	const size_t kHorspoolPatterns = 8;
+
+	// The vector pair prefilter is used while it lets at most 1 in this many byte pairs through
+	const size_t kSelectivePairs = 16;
+
+	// Bytes that are frequent in x86 and x64 code and data, most frequent first
+	const uint8_t kCommonBytes[] = {
+		0x00, 0xFF, 0xCC, 0x48, 0x8B, 0x89, 0x0F, 0x24, 0xE8, 0x4C, 0x85, 0x83, 0x01, 0x44,
+		0x8D, 0x45, 0xC3, 0x74, 0x75, 0x41, 0x49, 0x90, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+		0xC0, 0x02, 0x03, 0xEB, 0x4D, 0xC7, 0x33, 0x3B, 0x50, 0x5D, 0x55, 0xE9, 0xF8, 0xFE
+	};
+
+	// Returns how frequent a byte is expected to be, 0 for bytes not in the common list
+	size_t Frequency(uint8_t value) {
+		const uint8_t* end = kCommonBytes + sizeof(kCommonBytes);
+		const uint8_t* found = std::find(kCommonBytes, end, value);
+		return found == end ? 0 : (size_t)(end - found);
+	}
+
+	// Parses one or two hex digits, returns false for anything else
+	bool ParseHexByte(const std::string& token, uint8_t& value) {
+		if (token.empty() || token.size() > 2) {
+			return false;
+		}
+
+		for (char c : token) {
+			if (!std::isxdigit((unsigned char)c)) {
+				return false;
+			}
+		}
+
+		value = (uint8_t)std::strtoul(token.c_str(), nullptr, 16);
+		return true;
+	}
+}
+
+Pattern::Pattern(const char* text) {
+	// An invalid pattern is left empty, which IsValid reports
+	if (!Pattern::Parse(text, *this)) {
+		this->bytes.clear();
+		this->mask.clear();
+	}
+}
+
+bool Pattern::Parse(const char* text, Pattern& pattern) {
+	pattern.bytes.clear();
+	pattern.mask.clear();
+
+	if (!text) {
+		return false;
+	}
+
+	// Split the text at whitespace and convert every token
+	const char* position = text;
+	while (*position) {
+		if (std::isspace((unsigned char)*position)) {
+			++position;
+			continue;
+		}
+
+		const char* start = position;
+		while (*position && !std::isspace((unsigned char)*position)) {
+			++position;
+		}
+		std::string token(start, position);
+
+		uint8_t value = 0;
+		if (token == "?" || token == "??") {
+			pattern.bytes.push_back(0);
+			pattern.mask.push_back(0);
+		} else if (ParseHexByte(token, value)) {
+			pattern.bytes.push_back(value);
+			pattern.mask.push_back(1);
+		} else {
+			return false;
+		}
+	}
+
+	return pattern.IsValid();
+}
+
+bool Pattern::IsValid() const {
+	// A pattern of only wildcards would match everywhere
+	return std::find(this->mask.begin(), this->mask.end(), 1) != this->mask.end();
+}
+
+bool Pattern::Matches(const uint8_t* data) const {
+	for (size_t i = 0; i < this->bytes.size(); ++i) {
+		if (this->mask[i] && data[i] != this->bytes[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+PatternSet::PatternSet() : pairBitmap(65536 / 64), pairAnchors(256), singleAnchors(256) {
+}
+
+size_t PatternSet::Add(const Pattern& pattern) {
+	size_t index = this->patterns.size();
+	this->patterns.push_back(pattern);
+	this->shifts.emplace_back();
+
+	if (!pattern.IsValid()) {
+		return index;
+	}
+
+	size_t size = pattern.GetSize();
+	this->longest = std::max(this->longest, size);
+
+	// Anchor on the least frequent pair of adjacent fixed bytes, preferring later pairs on ties
+	size_t anchor = 0;
+	size_t best = (size_t)-1;
+	for (size_t i = 0; i + 1 < size; ++i) {
+		if (pattern.mask[i] && pattern.mask[i + 1] && Frequency(pattern.bytes[i]) + Frequency(pattern.bytes[i + 1]) <= best) {
+			best = Frequency(pattern.bytes[i]) + Frequency(pattern.bytes[i + 1]);
+			anchor = i;
+		}
+	}
+
+	Anchor entry;
+	entry.pattern = (uint32_t)index;
+
+	if (best != (size_t)-1) {
+		uint8_t first = pattern.bytes[anchor];
+		uint8_t second = pattern.bytes[anchor + 1];
+		entry.offset = (uint32_t)anchor;
+		this->pairAnchors[first].push_back(entry);
+		++this->pairCount;
+
+		this->pairFirstValues += !this->pairFirst.Contains(first);
+		this->pairSecondValues += !this->pairSecond.Contains(second);
+		this->pairFirst.Add(first);
+		this->pairSecond.Add(second);
+
+		size_t value = first | (size_t)second << 8;
+		this->pairBitmap[value / 64] |= 1ull << (value % 64);
+	} else {
+		// No two fixed bytes are adjacent, so anchor on the least frequent single byte
+		for (size_t i = 0; i < size; ++i) {
+			if (pattern.mask[i] && Frequency(pattern.bytes[i]) <= best) {
+				best = Frequency(pattern.bytes[i]);
+				anchor = i;
+			}
+		}
+
+		entry.offset = (uint32_t)anchor;
+		this->singleAnchors[pattern.bytes[anchor]].push_back(entry);
+		this->singleBytes.Add(pattern.bytes[anchor]);
+		++this->singleCount;
+	}
+
+	// Horspool shifts: a wildcard before the last byte limits every shift to its distance from the end
+	std::vector<uint32_t>& shift = this->shifts.back();
+	size_t maxShift = size;
+	for (size_t i = 0; i + 1 < size; ++i) {
+		if (!pattern.mask[i]) {
+			maxShift = size - 1 - i;
+		}
+	}
+	shift.assign(256, (uint32_t)maxShift);
+	for (size_t i = 0; i + 1 < size; ++i) {
+		if (pattern.mask[i]) {
+			shift[pattern.bytes[i]] = (uint32_t)std::min(maxShift, size - 1 - i);
+		}
+	}
+
+	return index;
+}
+
+size_t PatternSet::GetCount() const {
+	return this->patterns.size();
+}
+
+size_t PatternSet::GetLongest() const {
+	return this->longest;
+}
+
+void PatternSet::FindPairsExact(const uint8_t* data, size_t size, std::vector<uint32_t>& candidates) const {
+	for (size_t position = 0; position + 1 < size; ++position) {
+		size_t value = data[position] | (size_t)data[position + 1] << 8;
+		if ((this->pairBitmap[value / 64] >> (value % 64)) & 1) {
+			candidates.push_back((uint32_t)position);
+		}
+	}
+}
+
+void PatternSet::Verify(const std::vector<uint32_t>& candidates, const std::vector<std::vector<Anchor>>& anchors, const uint8_t* data, size_t size, size_t limit, uintptr_t base, std::vector<std::vector<uintptr_t>>& matches, size_t maxMatches) const {
+	for (uint32_t position : candidates) {
+		for (const Anchor& anchor : anchors[data[position]]) {
+			const Pattern& pattern = this->patterns[anchor.pattern];
+			std::vector<uintptr_t>& found = matches[anchor.pattern];
+
+			// Skip complete patterns and those that would start before the data, at or after the limit or end past the data
+			if (position < anchor.offset || found.size() >= maxMatches) {
+				continue;
+			}
+			size_t start = position - anchor.offset;
+			if (start >= limit || start + pattern.GetSize() > size) {
+				continue;
+			}
+
+			if (pattern.Matches(data + start)) {
+				found.push_back(base + start);
+			}
+		}
+	}
+}
+
+bool PatternSet::FindHorspool(size_t index, const uint8_t* data, size_t size, size_t limit, uintptr_t base, std::vector<std::vector<uintptr_t>>& matches, size_t maxMatches) const {
+	const Pattern& pattern = this->patterns[index];
+	const std::vector<uint32_t>& shift = this->shifts[index];
+	std::vector<uintptr_t>& found = matches[index];
+	size_t length = pattern.GetSize();
+
+	// Slide a window over the data, skipping ahead by the shift of the window's last byte
+	for (size_t start = 0; start < limit && start + length <= size && found.size() < maxMatches;
+		start += shift[data[start + length - 1]]) {
+		if (pattern.Matches(data + start)) {
+			found.push_back(base + start);
+		}
+	}
+
+	return found.size() >= maxMatches;
+}
+
+bool PatternSet::Find(const uint8_t* data, size_t size, size_t limit, uintptr_t base, std::vector<std::vector<uintptr_t>>& matches, size_t maxMatches, SimdLevel level) const {
+	level = std::min(level, GetSimdLevel());
+
+	if (level == SimdLevel::Scalar && this->patterns.size() <= kHorspoolPatterns) {
+		bool complete = true;
+		for (size_t i = 0; i < this->patterns.size(); ++i) {
+			if (this->patterns[i].IsValid() && matches[i].size() < maxMatches) {
+				complete &= this->FindHorspool(i, data, size, limit, base, matches, maxMatches);
+			}
+		}
+		return complete;
+	}
+
+	// One pass over the data finds every position holding the anchor pair of some pattern
+	std::vector<uint32_t> candidates;
+	if (this->pairCount) {
+		// With many patterns the anchor bytes cover most values and the vector prefilter lets
+		// too many pairs through, while the exact bitmap lookup costs the same for any set
+		bool selective = this->pairFirstValues * this->pairSecondValues * kSelectivePairs <= 256 * 256;
+		if (level != SimdLevel::Scalar && selective) {
+			ByteSet::FindPairs(this->pairFirst, this->pairSecond, data, size, candidates, level);
+		} else {
+			this->FindPairsExact(data, size, candidates);
+		}
+		this->Verify(candidates, this->pairAnchors, data, size, limit, base, matches, maxMatches);
+	}
+
+	// A second pass for the patterns anchored on a single byte
+	if (this->singleCount) {
+		candidates.clear();
+		this->singleBytes.Find(data, size, candidates, level);
+		this->Verify(candidates, this->singleAnchors, data, size, limit, base, matches, maxMatches);
+	}
+
+	// Complete once every valid pattern has all the matches it needs
+	for (size_t i = 0; i < this->patterns.size(); ++i) {
+		if (this->patterns[i].IsValid() && matches[i].size() < maxMatches) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ScanKernels.h"
+
+/**
+ * @brief A byte signature with wildcards, written in IDA style such as "8B 0D ?? ?? ?? ?? 85 C9".
+ *
+ * Every token is either a byte in hexadecimal or a wildcard ("?" or "??") that matches any byte.
+ * Signatures survive rebuilds of the target where hardcoded offsets do not, because the
+ * wildcards cover the addresses and displacements that change between builds.
+ */
+struct Pattern {
+	std::vector<uint8_t> bytes; // Expected byte values, 0 at wildcards
+	std::vector<uint8_t> mask;  // 1 where the byte must match, 0 at wildcards
+
+	Pattern() = default;
+
+	/**
+	 * @brief Parses an IDA-style pattern. An invalid pattern is left empty, see IsValid.
+	 *
+	 * @param text The pattern text, e.g. "48 8B 05 ? ? ? ? 48 85 C0".
+	 */
+	Pattern(const char* text);
+
+	/**
+	 * @brief Parses an IDA-style pattern. An invalid pattern is left empty, see IsValid.
+	 */
+	Pattern(const std::string& text) : Pattern(text.c_str()) {
+	}
+
+	/**
+	 * @brief Parses an IDA-style pattern.
+	 *
+	 * @param text The pattern text. Tokens are separated by whitespace.
+	 * @param pattern Receives the parsed bytes and mask.
+	 * @return True if every token was a hex byte or a wildcard and at least one byte is not a wildcard.
+	 */
+	static bool Parse(const char* text, Pattern& pattern);
+
+	/**
+	 * @brief Returns true if the pattern has at least one byte that is not a wildcard.
+	 */
+	bool IsValid() const;
+
+	/**
+	 * @brief Returns the length of the pattern in bytes, wildcards included.
+	 */
+	size_t GetSize() const {
+		return this->bytes.size();
+	}
+
+	/**
+	 * @brief Compares the pattern with GetSize() bytes at data.
+	 */
+	bool Matches(const uint8_t* data) const;
+};
+
+/**
+ * @brief Searches a buffer for many patterns in a single pass.
+ *
+ * Every pattern is anchored on its rarest pair of adjacent fixed bytes, judged by how often
+ * bytes occur in x86 code. A single pass over the buffer yields the few positions holding
+ * any anchor pair, and only those are compared with the patterns anchored there. While the
+ * anchor bytes are few, the pass is a vectorized ByteSet search of the first and second
+ * bytes; once they cover too many byte values it looks every pair up in an exact bitmap of
+ * all anchor pairs instead. Patterns without two adjacent fixed bytes are anchored on a
+ * single byte in a second pass. Small sets on CPUs without SIMD support are searched
+ * pattern by pattern with Horspool skipping instead.
+ */
+class PatternSet {
+private:
+	// A pattern anchored on one or two of its fixed bytes
+	struct Anchor {
+		uint32_t pattern = 0; // Index of the pattern
+		uint32_t offset = 0;  // Position of the (first) anchor byte in the pattern
+	};
+
+	// The patterns in the order they were added
+	std::vector<Pattern> patterns;
+
+	// First and second bytes of every anchor pair, and how many distinct values each holds
+	ByteSet pairFirst;
+	ByteSet pairSecond;
+	size_t pairFirstValues = 0;
+	size_t pairSecondValues = 0;
+
+	// One bit per 16-bit value of every anchor pair (first byte in the low half)
+	std::vector<uint64_t> pairBitmap;
+
+	// Anchor byte of every pattern without two adjacent fixed bytes
+	ByteSet singleBytes;
+
+	// Patterns anchored on each byte value, by pair and by single byte
+	std::vector<std::vector<Anchor>> pairAnchors;
+	std::vector<std::vector<Anchor>> singleAnchors;
+
+	// Number of patterns in pairAnchors and singleAnchors
+	size_t pairCount = 0;
+	size_t singleCount = 0;
+
+	// Horspool shift per pattern and last byte of the current window
+	std::vector<std::vector<uint32_t>> shifts;
+
+	// Length of the longest pattern
+	size_t longest = 0;
+
+	// Scalar pass that appends every position holding an anchor pair, using the exact pair bitmap
+	void FindPairsExact(const uint8_t* data, size_t size, std::vector<uint32_t>& candidates) const;
+
+	// Compares the patterns anchored at every candidate position with the data
+	void Verify(const std::vector<uint32_t>& candidates, const std::vector<std::vector<Anchor>>& anchors, const uint8_t* data, size_t size, size_t limit, uintptr_t base, std::vector<std::vector<uintptr_t>>& matches, size_t maxMatches) const;
+
+	// Horspool search of one pattern, used when no vector instructions are available
+	bool FindHorspool(size_t index, const uint8_t* data, size_t size, size_t limit, uintptr_t base, std::vector<std::vector<uintptr_t>>& matches, size_t maxMatches) const;
+
+public:
+	PatternSet();
+
+	/**
+	 * @brief Adds a pattern to the set.
+	 *
+	 * @param pattern The pattern to add. Invalid patterns are kept so indices line up, but never match.
+	 * @return The index of the pattern, used to look up its matches.
+	 */
+	size_t Add(const Pattern& pattern);
+
+	/**
+	 * @brief Returns the number of patterns in the set.
+	 */
+	size_t GetCount() const;
+
+	/**
+	 * @brief Returns the length of the longest pattern, the overlap needed between two searched blocks.
+	 */
+	size_t GetLongest() const;
+
+	/**
+	 * @brief Searches a local copy of target memory for all patterns.
+	 *
+	 * Only matches that start before limit are reported, so consecutive blocks can overlap
+	 * by GetLongest() - 1 bytes without reporting a match twice. Patterns that already have
+	 * maxMatches matches are not searched any more.
+	 *
+	 * @param data The local copy of the target memory.
+	 * @param size The number of valid bytes in data; must be below 4 GiB.
+	 * @param limit Matches must start below this offset.
+	 * @param base The address of data[0] in the target process.
+	 * @param matches Receives the match addresses per pattern; must hold GetCount() vectors.
+	 * @param maxMatches The number of matches after which a pattern is complete.
+	 * @param level The highest instruction set to use, clamped to what the CPU supports.
+	 * @return True if every pattern is complete, so later blocks need not be searched.
+	 */
+	bool Find(const uint8_t* data, size_t size, size_t limit, uintptr_t base, std::vector<std::vector<uintptr_t>>& matches, size_t maxMatches = 1, SimdLevel level = SimdLevel::AVX2) const;
+};
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+// Keep Windows.h from defining min/max macros that break std::min/std::max
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <TlHelp32.h>
+#include <Psapi.h>
+#else
+// Minimal set of Win32 types used by the public Memory API, so that callers
+// can keep using DWORD, HANDLE and MODULEINFO on every platform.
+typedef uint32_t DWORD;
+typedef size_t SIZE_T;
+typedef uint8_t BYTE;
+typedef void* HANDLE;
+typedef void* HMODULE;
+typedef void* LPVOID;
+
+// Mirrors the layout of the Psapi MODULEINFO structure.
+typedef struct _MODULEINFO {
+	LPVOID lpBaseOfDll; // Lowest mapped address of the module
+	DWORD SizeOfImage;  // Number of bytes spanned by the module's contiguous mappings
+	LPVOID EntryPoint;  // Entry point taken from the module's ELF header
+} MODULEINFO;
+
+/**
+ * @brief Suspends the calling thread for the given number of milliseconds.
+ *
+ * Provided on non-Windows platforms so code written against the Win32 Sleep
+ * function (such as the reconnect loop in main.cpp) builds unchanged.
+ *
+ * @param milliseconds The time to sleep in milliseconds.
+ */
+void Sleep(DWORD milliseconds);
+#endif
+
+/**
+ * @brief One element of a batched read or write.
+ *
+ * For reads, size bytes at address in the target process are copied into buffer.
+ * For writes, size bytes from buffer are copied to address. After the batch has been
+ * submitted, success tells whether this entry was transferred completely.
+ */
+struct BatchEntry {
+	uintptr_t address = 0;  // Address in the target process
+	void* buffer = nullptr; // Local destination (reads) or source (writes)
+	size_t size = 0;        // Number of bytes to transfer
+	bool success = false;   // Set by ReadBatch/WriteBatch
+};
+
+/**
+ * @brief A committed, readable range of the target process's address space.
+ *
+ * Regions come from VirtualQueryEx on Windows and /proc/<pid>/maps on Linux,
+ * in ascending address order.
+ */
+struct MemoryRegion {
+	uintptr_t base = 0;      // First address of the region
+	size_t size = 0;         // Size of the region in bytes
+	bool writable = false;   // Pages can be written by the target
+	bool executable = false; // Pages can be executed by the target
+	bool image = false;      // Pages are mapped from a module or other file
+};
+
+/**
+ * @brief A module (executable or shared library) loaded in the target process.
+ *
+ * Modules come from ToolHelp on Windows and from the file-backed mappings in
+ * /proc/<pid>/maps on Linux, in ascending address order.
+ */
+struct ModuleEntry {
+	std::wstring name;  // File name of the module without its directory
+	uintptr_t base = 0; // Lowest address of the module
+	size_t size = 0;    // Number of bytes from base to the end of the module
+};
+
+/**
+ * @brief Operating system layer underneath the Memory class.
+ *
+ * Every call that touches another process goes through these functions. On Windows they
+ * wrap ToolHelp, OpenProcess and ReadProcessMemory/WriteProcessMemory. On Linux they use
+ * /proc/<pid> for process and module lookups, process_vm_readv/process_vm_writev for memory
+ * transfers, and /proc/<pid>/mem for large reads and writes into read-only pages.
+ */
+namespace Platform {
+	/**
+	 * @brief Finds the process ID of a running process by its executable name.
+	 *
+	 * The comparison is case-insensitive. On Linux the name is matched against the
+	 * process comm name, the executable path and the first command line argument,
+	 * so Wine processes such as L"ac_client.exe" are found as well.
+	 *
+	 * @param processName The name of the process executable (e.g., L"notepad.exe").
+	 * @return The process ID of the first match, otherwise 0.
+	 */
+	DWORD FindProcessID(const wchar_t* processName);
+
+	/**
+	 * @brief Lists the IDs of every running process without opening any of them.
+	 *
+	 * Much cheaper than FindProcessID, which reads the name of every process: EnumProcesses on
+	 * Windows, the numeric entries of /proc on Linux. Tools tracking many processes look up the
+	 * name of new IDs only.
+	 *
+	 * @return The process IDs, in no particular order.
+	 */
+	std::vector<DWORD> EnumerateProcessIDs();
+
+	/**
+	 * @brief Returns the executable name of a running process.
+	 *
+	 * @param processID The ID of the process.
+	 * @return The executable file name without its directory (e.g., L"notepad.exe"), or an empty string if the process does not exist.
+	 */
+	std::wstring FindProcessName(DWORD processID);
+
+	/**
+	 * @brief Finds the base address of a module loaded in a process.
+	 *
+	 * @param processID The ID of the process to search for the module.
+	 * @param moduleName The name of the module to find (case-insensitive).
+	 * @return The lowest address the module is mapped at, otherwise 0.
+	 */
+	uintptr_t FindModuleBaseAddress(DWORD processID, const wchar_t* moduleName);
+
+	/**
+	 * @brief Queries the base address, image size and entry point of a module.
+	 *
+	 * @param process Handle returned by OpenProcessHandle.
+	 * @param module The module base address as an HMODULE.
+	 * @return The filled MODULEINFO structure (zeroed if the module was not found).
+	 */
+	MODULEINFO QueryModuleInfo(HANDLE process, HMODULE module);
+
+	/**
+	 * @brief Opens a handle with read and write access to a process.
+	 *
+	 * @param processID The ID of the process to open.
+	 * @return The process handle, or nullptr if the process could not be opened.
+	 */
+	HANDLE OpenProcessHandle(DWORD processID);
+
+	/**
+	 * @brief Releases a handle returned by OpenProcessHandle.
+	 *
+	 * @param process The handle to close. nullptr is ignored.
+	 */
+	void CloseProcessHandle(HANDLE process);
+
+	/**
+	 * @brief Checks whether a process opened with OpenProcessHandle has exited, without waiting.
+	 *
+	 * On Windows the process handle is signalled. On Linux the handle holds a pidfd (Linux 5.3 and
+	 * later) that becomes readable when the process exits, so a reused process ID is never taken
+	 * for the original process; on older kernels the process state in /proc/<pid>/stat is checked.
+	 * A process that exited but was not reaped by its parent yet counts as exited.
+	 *
+	 * @param process Handle returned by OpenProcessHandle.
+	 * @return True if the process exited or the handle is nullptr.
+	 */
+	bool HasExited(HANDLE process);
+
+	/**
+	 * @brief Copies memory from the target process into a local buffer.
+	 *
+	 * The read succeeds only if all requested bytes were copied. When the range
+	 * crosses an unreadable page, bytesRead still reports how much of the prefix
+	 * was transferred.
+	 *
+	 * @param process Handle to the target process.
+	 * @param address The address in the target process to read from.
+	 * @param buffer The local buffer receiving the data.
+	 * @param size The number of bytes to read.
+	 * @param bytesRead Optional output for the number of bytes actually copied.
+	 * @return True if all bytes were read, false otherwise.
+	 */
+	bool ReadMemory(HANDLE process, uintptr_t address, void* buffer, size_t size, size_t* bytesRead = nullptr);
+
+	/**
+	 * @brief Copies a local buffer into the memory of the target process.
+	 *
+	 * @param process Handle to the target process.
+	 * @param address The address in the target process to write to.
+	 * @param buffer The local data to write.
+	 * @param size The number of bytes to write.
+	 * @return True if all bytes were written, false otherwise.
+	 */
+	bool WriteMemory(HANDLE process, uintptr_t address, const void* buffer, size_t size);
+
+	/**
+	 * @brief Reads many independent ranges from the target process in as few calls as possible.
+	 *
+	 * On Linux the entries are submitted as vectored process_vm_readv calls of up to IOV_MAX
+	 * elements each. A failing entry stops the kernel transfer, so the batch is resumed after it
+	 * and every other entry is still read. On Windows each entry is read with its own
+	 * ReadProcessMemory call.
+	 *
+	 * @param process Handle to the target process.
+	 * @param entries The entries to read. Each entry's success flag is updated.
+	 * @param count The number of entries.
+	 * @return The number of entries that were read completely.
+	 */
+	size_t ReadBatch(HANDLE process, BatchEntry* entries, size_t count);
+
+	/**
+	 * @brief Writes many independent ranges to the target process in as few calls as possible.
+	 *
+	 * Uses vectored process_vm_writev calls on Linux. Entries that cannot be written that way
+	 * (for example into read-only pages) are retried individually with WriteMemory.
+	 *
+	 * @param process Handle to the target process.
+	 * @param entries The entries to write. Each entry's success flag is updated.
+	 * @param count The number of entries.
+	 * @return The number of entries that were written completely.
+	 */
+	size_t WriteBatch(HANDLE process, BatchEntry* entries, size_t count);
+
+	/**
+	 * @brief Lists every committed, readable region of the target process.
+	 *
+	 * Guard pages and no-access pages are skipped on Windows. On Linux, mappings
+	 * without read permission as well as [vvar] and [vsyscall] are skipped.
+	 *
+	 * @param process Handle to the target process.
+	 * @return The readable regions in ascending address order.
+	 */
+	std::vector<MemoryRegion> EnumerateRegions(HANDLE process);
+
+	/**
+	 * @brief Lists every module loaded in the target process.
+	 *
+	 * On Linux a module spans all mappings of its file, plus the anonymous mapping directly
+	 * after them that holds its zero-initialized data (.bss), so static variables are inside it.
+	 *
+	 * @param process Handle to the target process.
+	 * @return The modules in ascending address order.
+	 */
+	std::vector<ModuleEntry> EnumerateModules(HANDLE process);
+
+	/**
+	 * @brief Returns a value that changes whenever modules are loaded or unloaded.
+	 *
+	 * Much cheaper than EnumerateModules: on Windows it hashes the module handle list from
+	 * EnumProcessModulesEx, on Linux the raw text of /proc/<pid>/maps, which also changes
+	 * when other mappings such as the heap grow.
+	 *
+	 * @param process Handle to the target process.
+	 * @return The signature, 0 if it could not be queried.
+	 */
+	uint64_t QueryModuleSignature(HANDLE process);
+
+	/**
+	 * @brief Clears the soft-dirty bit of every page, so QueryDirtyPages reports the pages written after this call.
+	 *
+	 * Linux only: writes "4" to /proc/<pid>/clear_refs. Some kernels accept the request without
+	 * tracking soft-dirty bits (CONFIG_MEM_SOFT_DIRTY disabled), so support is probed once on the
+	 * calling process first. Always fails on Windows.
+	 *
+	 * @param process Handle to the target process.
+	 * @return True if the bits were cleared, false if soft-dirty tracking is unavailable.
+	 */
+	bool ClearDirtyPages(HANDLE process);
+
+	/**
+	 * @brief Finds the pages of a range written since the last ClearDirtyPages.
+	 *
+	 * Linux only: reads the soft-dirty bit (bit 55) of every page from /proc/<pid>/pagemap.
+	 * Pages of mappings created after the last clear are reported as dirty. Always fails on Windows.
+	 *
+	 * @param process Handle to the target process.
+	 * @param address The address of the first page (rounded down to a 4 KiB page).
+	 * @param pageCount The number of pages to query.
+	 * @param bitmap Receives one bit per page, set for dirty pages, in (pageCount + 63) / 64 words.
+	 * @return True if every page was queried, false otherwise (the bitmap is then unspecified).
+	 */
+	bool QueryDirtyPages(HANDLE process, uintptr_t address, size_t pageCount, uint64_t* bitmap);
+}
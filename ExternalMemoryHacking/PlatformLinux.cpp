@@ -0,0 +1,653 @@
+#include "Platform.h"
+
+#ifndef _WIN32
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <fstream>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <string>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+	// Reads at or above this size go through /proc/<pid>/mem instead of process_vm_readv
+	const size_t kLargeReadThreshold = 1 << 20;
+
+	// Maximum number of iovec elements accepted by one process_vm_readv/process_vm_writev call
+	const size_t kMaxBatchEntries = IOV_MAX;
+
+	// Size of a page as reported by /proc/<pid>/pagemap
+	const size_t kPageSize = 0x1000;
+
+	// Bit of a pagemap entry set for pages written since the soft-dirty bits were last cleared
+	const uint64_t kSoftDirtyBit = 1ull << 55;
+
+	// pidfd_open has the same number on every architecture, but older C libraries do not name it
+#ifdef SYS_pidfd_open
+	const long kPidfdOpen = SYS_pidfd_open;
+#else
+	const long kPidfdOpen = 434;
+#endif
+
+	// State behind a HANDLE on Linux: the process ID and open /proc/<pid>/mem and /proc/<pid>/pagemap descriptors
+	struct LinuxProcess {
+		pid_t pid;
+		int memFd;
+		int pagemapFd; // -1 if the pagemap could not be opened
+		int pidFd;     // -1 if the kernel has no pidfd_open
+	};
+
+	LinuxProcess* ToProcess(HANDLE process) {
+		return static_cast<LinuxProcess*>(process);
+	}
+
+	// Converts a wide process or module name to a narrow string (names are expected to be ASCII)
+	std::string Narrow(const wchar_t* value) {
+		std::string result;
+		for (; value && *value; ++value) {
+			result.push_back(static_cast<char>(*value));
+		}
+		return result;
+	}
+
+	// Returns the part of a path after the last '/' or '\' (Wine paths use backslashes)
+	std::string BaseName(const std::string& path) {
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? path : path.substr(slash + 1);
+	}
+
+	bool EqualsIgnoreCase(const std::string& left, const std::string& right) {
+		return left.size() == right.size() && std::equal(left.begin(), left.end(), right.begin(),
+			[](char a, char b) { return std::tolower((unsigned char)a) == std::tolower((unsigned char)b); });
+	}
+
+	// Parsed line of /proc/<pid>/maps
+	struct MapsEntry {
+		uintptr_t start;
+		uintptr_t end;
+		char permissions[5];
+		std::string path;
+	};
+
+	// Parses one line of /proc/<pid>/maps, returning false for malformed lines
+	bool ParseMapsLine(const std::string& line, MapsEntry& entry) {
+		unsigned long long start = 0, end = 0;
+		int pathOffset = -1;
+
+		if (sscanf(line.c_str(), "%llx-%llx %4s %*s %*s %*s %n", &start, &end, entry.permissions, &pathOffset) < 3) {
+			return false;
+		}
+
+		entry.start = (uintptr_t)start;
+		entry.end = (uintptr_t)end;
+		entry.path = pathOffset > 0 && (size_t)pathOffset < line.size() ? line.substr(pathOffset) : std::string();
+		return true;
+	}
+
+	// Reads a whole virtual file from /proc, which reports a size of zero to stat
+	std::string ReadProcFile(const std::string& path) {
+		std::ifstream file(path, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	// Checks whether a /proc/<pid> entry belongs to a process with the given name
+	bool ProcessMatches(const std::string& pid, const std::string& name) {
+		// comm is truncated to 15 characters by the kernel, longer names are matched through exe and cmdline
+		std::string comm = ReadProcFile("/proc/" + pid + "/comm");
+		if (!comm.empty() && comm.back() == '\n') {
+			comm.pop_back();
+		}
+		if (EqualsIgnoreCase(comm, name)) {
+			return true;
+		}
+
+		// Resolve the executable path (fails for processes of other users without privileges)
+		char exePath[4096];
+		ssize_t length = readlink(("/proc/" + pid + "/exe").c_str(), exePath, sizeof(exePath) - 1);
+		if (length > 0) {
+			exePath[length] = '\0';
+			if (EqualsIgnoreCase(BaseName(exePath), name)) {
+				return true;
+			}
+		}
+
+		// The first command line argument covers interpreters and Wine ("C:\...\ac_client.exe")
+		std::string cmdline = ReadProcFile("/proc/" + pid + "/cmdline");
+		std::string argument0 = cmdline.substr(0, cmdline.find('\0'));
+		return !argument0.empty() && EqualsIgnoreCase(BaseName(argument0), name);
+	}
+
+	// Reads from /proc/<pid>/mem, which handles large transfers with a single descriptor
+	size_t ReadProcMem(int memFd, uintptr_t address, void* buffer, size_t size) {
+		size_t total = 0;
+		while (total < size) {
+			ssize_t result = pread(memFd, (char*)buffer + total, size - total, (off_t)(address + total));
+			if (result <= 0) {
+				if (result < 0 && errno == EINTR) {
+					continue;
+				}
+				break;
+			}
+			total += (size_t)result;
+		}
+		return total;
+	}
+
+	// Reads with process_vm_readv, continuing after partial transfers; sets fallback when the call is unavailable
+	size_t ReadVm(pid_t pid, uintptr_t address, void* buffer, size_t size, bool& fallback) {
+		size_t total = 0;
+		while (total < size) {
+			iovec local = { (char*)buffer + total, size - total };
+			iovec remote = { (void*)(address + total), size - total };
+			ssize_t result = process_vm_readv(pid, &local, 1, &remote, 1, 0);
+			if (result <= 0) {
+				fallback = result < 0 && (errno == ENOSYS || errno == EPERM);
+				break;
+			}
+			total += (size_t)result;
+		}
+		return total;
+	}
+
+	// Submits a batch as vectored process_vm_readv/process_vm_writev calls of up to kMaxBatchEntries elements.
+	// The kernel stops at the first element it cannot transfer, so that element is marked as failed and the
+	// batch is resumed right after it. Returns false if the syscall itself is unusable for this process.
+	bool TransferBatch(pid_t pid, BatchEntry* entries, size_t count, bool write) {
+		iovec local[kMaxBatchEntries];
+		iovec remote[kMaxBatchEntries];
+
+		size_t index = 0;
+		while (index < count) {
+			// Fill the iovec arrays with the next chunk of entries
+			size_t chunk = std::min(count - index, kMaxBatchEntries);
+			for (size_t i = 0; i < chunk; ++i) {
+				local[i] = { entries[index + i].buffer, entries[index + i].size };
+				remote[i] = { (void*)entries[index + i].address, entries[index + i].size };
+			}
+
+			ssize_t result = write
+				? process_vm_writev(pid, local, chunk, remote, chunk, 0)
+				: process_vm_readv(pid, local, chunk, remote, chunk, 0);
+
+			if (result < 0 && (errno == ENOSYS || errno == EPERM || errno == ESRCH)) {
+				return false;
+			}
+
+			// Every entry fully covered by the transferred byte count succeeded
+			size_t transferred = result > 0 ? (size_t)result : 0;
+			size_t end = index + chunk;
+			for (; index < end && entries[index].size <= transferred; ++index) {
+				entries[index].success = true;
+				transferred -= entries[index].size;
+			}
+
+			// The entry the kernel stopped at failed; continue with the one after it
+			if (index < end) {
+				entries[index].success = false;
+				++index;
+			}
+		}
+
+		return true;
+	}
+
+	// Writes "4" (clear soft-dirty bits) to /proc/<pid>/clear_refs
+	bool WriteClearRefs(const std::string& pid) {
+		int fd = open(("/proc/" + pid + "/clear_refs").c_str(), O_WRONLY | O_CLOEXEC);
+		if (fd < 0) {
+			return false;
+		}
+		bool written = write(fd, "4", 1) == 1;
+		close(fd);
+		return written;
+	}
+
+	// Checks once whether the kernel sets soft-dirty bits, by clearing them in this process and writing a page
+	bool SoftDirtySupported() {
+		static const bool supported = [] {
+			static volatile uint8_t page[2 * kPageSize];
+			volatile uint8_t* probe = page + (kPageSize - (uintptr_t)page % kPageSize) % kPageSize;
+			probe[0] = 1;
+			if (!WriteClearRefs("self")) {
+				return false;
+			}
+			probe[0] = 2;
+
+			int fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+			if (fd < 0) {
+				return false;
+			}
+			uint64_t entry = 0;
+			bool read = pread(fd, &entry, sizeof(entry), (off_t)((uintptr_t)probe / kPageSize * sizeof(entry))) == sizeof(entry);
+			close(fd);
+			return read && (entry & kSoftDirtyBit) != 0;
+		}();
+		return supported;
+	}
+}
+
+void Sleep(DWORD milliseconds) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+}
+
+DWORD Platform::FindProcessID(const wchar_t* processName) {
+	std::string name = Narrow(processName);
+
+	// Every numeric directory in /proc is a running process
+	DIR* proc = opendir("/proc");
+	if (!proc) {
+		return 0;
+	}
+
+	DWORD processID = 0;
+	while (dirent* entry = readdir(proc)) {
+		if (!std::isdigit((unsigned char)entry->d_name[0])) {
+			continue;
+		}
+
+		if (ProcessMatches(entry->d_name, name)) {
+			processID = (DWORD)std::strtoul(entry->d_name, nullptr, 10);
+			break;
+		}
+	}
+
+	closedir(proc);
+	return processID;
+}
+
+std::vector<DWORD> Platform::EnumerateProcessIDs() {
+	std::vector<DWORD> processIDs;
+
+	// Every numeric directory in /proc is a running process; nothing inside them is opened
+	DIR* proc = opendir("/proc");
+	if (!proc) {
+		return processIDs;
+	}
+
+	while (dirent* entry = readdir(proc)) {
+		if (std::isdigit((unsigned char)entry->d_name[0])) {
+			processIDs.push_back((DWORD)std::strtoul(entry->d_name, nullptr, 10));
+		}
+	}
+
+	closedir(proc);
+	return processIDs;
+}
+
+std::wstring Platform::FindProcessName(DWORD processID) {
+	std::string pid = std::to_string(processID);
+	std::string name;
+
+	// The executable file name is also the name of the main module in /proc/<pid>/maps
+	char exePath[4096];
+	ssize_t length = readlink(("/proc/" + pid + "/exe").c_str(), exePath, sizeof(exePath) - 1);
+	if (length > 0) {
+		exePath[length] = '\0';
+		name = BaseName(exePath);
+	} else {
+		// Without access to exe fall back to the (possibly truncated) comm name
+		name = ReadProcFile("/proc/" + pid + "/comm");
+		if (!name.empty() && name.back() == '\n') {
+			name.pop_back();
+		}
+	}
+
+	return std::wstring(name.begin(), name.end());
+}
+
+uintptr_t Platform::FindModuleBaseAddress(DWORD processID, const wchar_t* moduleName) {
+	std::string name = Narrow(moduleName);
+	std::ifstream maps("/proc/" + std::to_string(processID) + "/maps");
+
+	// Mappings are listed in ascending address order, so the first match is the module base
+	std::string line;
+	MapsEntry entry;
+	while (std::getline(maps, line)) {
+		if (ParseMapsLine(line, entry) && !entry.path.empty() && EqualsIgnoreCase(BaseName(entry.path), name)) {
+			return entry.start;
+		}
+	}
+
+	return 0;
+}
+
+MODULEINFO Platform::QueryModuleInfo(HANDLE process, HMODULE module) {
+	MODULEINFO moduleInfo = {};
+	if (!process) {
+		return moduleInfo;
+	}
+
+	uintptr_t base = (uintptr_t)module;
+	std::ifstream maps("/proc/" + std::to_string(ToProcess(process)->pid) + "/maps");
+
+	// The image spans the mappings backed by the same file that follow the one at the base address
+	// without a gap; a later mapping of the same file is not part of it
+	std::string line, path;
+	uintptr_t end = 0;
+	MapsEntry entry;
+	while (std::getline(maps, line)) {
+		if (!ParseMapsLine(line, entry)) {
+			continue;
+		}
+		if (entry.start == base) {
+			path = entry.path;
+			end = entry.end;
+		} else if (end && !path.empty() && entry.path == path && entry.start == end) {
+			end = entry.end;
+		} else if (end) {
+			break;
+		}
+	}
+
+	if (!end) {
+		return moduleInfo;
+	}
+
+	moduleInfo.lpBaseOfDll = (LPVOID)base;
+	moduleInfo.SizeOfImage = (DWORD)std::min<uintptr_t>(end - base, UINT32_MAX);
+
+	// Position-independent images store the entry point relative to the load address
+	Elf64_Ehdr header;
+	if (ReadMemory(process, base, &header, sizeof(header)) && !memcmp(header.e_ident, ELFMAG, SELFMAG)) {
+		uintptr_t entryPoint = header.e_ident[EI_CLASS] == ELFCLASS32 ? ((Elf32_Ehdr*)&header)->e_entry : header.e_entry;
+		moduleInfo.EntryPoint = (LPVOID)(header.e_type == ET_DYN ? base + entryPoint : entryPoint);
+	}
+
+	return moduleInfo;
+}
+
+HANDLE Platform::OpenProcessHandle(DWORD processID) {
+	std::string memPath = "/proc/" + std::to_string(processID) + "/mem";
+
+	// Prefer a writable descriptor; fall back to read-only when writes are not permitted
+	int memFd = open(memPath.c_str(), O_RDWR | O_CLOEXEC);
+	if (memFd < 0) {
+		memFd = open(memPath.c_str(), O_RDONLY | O_CLOEXEC);
+	}
+
+	// Without /proc/<pid>/mem the process either does not exist or cannot be accessed
+	if (memFd < 0) {
+		return nullptr;
+	}
+
+	// The pagemap is only needed for dirty-page tracking, so the handle is still usable without it
+	int pagemapFd = open(("/proc/" + std::to_string(processID) + "/pagemap").c_str(), O_RDONLY | O_CLOEXEC);
+
+	// A pidfd reports the exit of this very process, even after its ID has been reused
+	int pidFd = (int)syscall(kPidfdOpen, (pid_t)processID, 0);
+
+	return new LinuxProcess{ (pid_t)processID, memFd, pagemapFd, pidFd < 0 ? -1 : pidFd };
+}
+
+void Platform::CloseProcessHandle(HANDLE process) {
+	if (LinuxProcess* linuxProcess = ToProcess(process)) {
+		close(linuxProcess->memFd);
+		if (linuxProcess->pagemapFd >= 0) {
+			close(linuxProcess->pagemapFd);
+		}
+		if (linuxProcess->pidFd >= 0) {
+			close(linuxProcess->pidFd);
+		}
+		delete linuxProcess;
+	}
+}
+
+bool Platform::HasExited(HANDLE process) {
+	LinuxProcess* linuxProcess = ToProcess(process);
+	if (!linuxProcess) {
+		return true;
+	}
+
+	// The pidfd becomes readable when the process exits
+	if (linuxProcess->pidFd >= 0) {
+		pollfd descriptor = { linuxProcess->pidFd, POLLIN, 0 };
+		return poll(&descriptor, 1, 0) > 0;
+	}
+
+	if (kill(linuxProcess->pid, 0) < 0 && errno == ESRCH) {
+		return true;
+	}
+
+	// Zombies still accept signals; the state follows the command name, which may contain spaces and parentheses
+	std::string stat = ReadProcFile("/proc/" + std::to_string(linuxProcess->pid) + "/stat");
+	size_t name = stat.rfind(')');
+	return name == std::string::npos || name + 2 >= stat.size() || stat[name + 2] == 'Z' || stat[name + 2] == 'X';
+}
+
+bool Platform::ReadMemory(HANDLE process, uintptr_t address, void* buffer, size_t size, size_t* bytesRead) {
+	LinuxProcess* linuxProcess = ToProcess(process);
+	size_t transferred = 0;
+
+	if (linuxProcess && size) {
+		bool fallback = size >= kLargeReadThreshold;
+
+		// Small reads use a single process_vm_readv; large ones or a blocked syscall use /proc/<pid>/mem
+		if (!fallback) {
+			transferred = ReadVm(linuxProcess->pid, address, buffer, size, fallback);
+		}
+		if (fallback) {
+			transferred = ReadProcMem(linuxProcess->memFd, address, buffer, size);
+		}
+	}
+
+	if (bytesRead) {
+		*bytesRead = transferred;
+	}
+
+	return linuxProcess && transferred == size;
+}
+
+bool Platform::WriteMemory(HANDLE process, uintptr_t address, const void* buffer, size_t size) {
+	LinuxProcess* linuxProcess = ToProcess(process);
+	if (!linuxProcess) {
+		return false;
+	}
+
+	iovec local = { const_cast<void*>(buffer), size };
+	iovec remote = { (void*)address, size };
+	if (process_vm_writev(linuxProcess->pid, &local, 1, &remote, 1, 0) == (ssize_t)size) {
+		return true;
+	}
+
+	// process_vm_writev honours page protection; /proc/<pid>/mem can also patch read-only pages such as code
+	size_t total = 0;
+	while (total < size) {
+		ssize_t result = pwrite(linuxProcess->memFd, (const char*)buffer + total, size - total, (off_t)(address + total));
+		if (result <= 0) {
+			if (result < 0 && errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		total += (size_t)result;
+	}
+
+	return true;
+}
+
+size_t Platform::ReadBatch(HANDLE process, BatchEntry* entries, size_t count) {
+	LinuxProcess* linuxProcess = ToProcess(process);
+	for (size_t i = 0; i < count; ++i) {
+		entries[i].success = false;
+	}
+
+	if (!linuxProcess) {
+		return 0;
+	}
+
+	// When process_vm_readv is unavailable, read each entry through /proc/<pid>/mem instead
+	if (!TransferBatch(linuxProcess->pid, entries, count, false)) {
+		for (size_t i = 0; i < count; ++i) {
+			entries[i].success = ReadProcMem(linuxProcess->memFd, entries[i].address, entries[i].buffer, entries[i].size) == entries[i].size;
+		}
+	}
+
+	size_t succeeded = 0;
+	for (size_t i = 0; i < count; ++i) {
+		succeeded += entries[i].success;
+	}
+	return succeeded;
+}
+
+size_t Platform::WriteBatch(HANDLE process, BatchEntry* entries, size_t count) {
+	LinuxProcess* linuxProcess = ToProcess(process);
+	for (size_t i = 0; i < count; ++i) {
+		entries[i].success = false;
+	}
+
+	if (!linuxProcess) {
+		return 0;
+	}
+
+	TransferBatch(linuxProcess->pid, entries, count, true);
+
+	// Entries rejected by process_vm_writev (read-only pages, or no syscall at all) are retried one by one
+	size_t succeeded = 0;
+	for (size_t i = 0; i < count; ++i) {
+		if (!entries[i].success) {
+			entries[i].success = WriteMemory(process, entries[i].address, entries[i].buffer, entries[i].size);
+		}
+		succeeded += entries[i].success;
+	}
+	return succeeded;
+}
+
+std::vector<MemoryRegion> Platform::EnumerateRegions(HANDLE process) {
+	std::vector<MemoryRegion> regions;
+	if (!process) {
+		return regions;
+	}
+
+	std::ifstream maps("/proc/" + std::to_string(ToProcess(process)->pid) + "/maps");
+	std::string line;
+	MapsEntry entry;
+
+	while (std::getline(maps, line)) {
+		// Skip unreadable mappings and kernel pages that cannot be read through process_vm_readv
+		if (!ParseMapsLine(line, entry) || entry.permissions[0] != 'r' || !entry.path.compare(0, 5, "[vvar") || entry.path == "[vsyscall]") {
+			continue;
+		}
+
+		MemoryRegion region;
+		region.base = entry.start;
+		region.size = entry.end - entry.start;
+		region.writable = entry.permissions[1] == 'w';
+		region.executable = entry.permissions[2] == 'x';
+		region.image = !entry.path.empty() && entry.path[0] != '[';
+		regions.push_back(region);
+	}
+
+	return regions;
+}
+
+std::vector<ModuleEntry> Platform::EnumerateModules(HANDLE process) {
+	std::vector<ModuleEntry> modules;
+	if (!process) {
+		return modules;
+	}
+
+	std::ifstream maps("/proc/" + std::to_string(ToProcess(process)->pid) + "/maps");
+	std::string line, path;
+	MapsEntry entry;
+
+	while (std::getline(maps, line)) {
+		if (!ParseMapsLine(line, entry)) {
+			continue;
+		}
+
+		bool file = !entry.path.empty() && entry.path[0] != '[';
+		if (file && entry.path == path && !modules.empty()) {
+			// Another mapping of the module before, such as its data segment
+			modules.back().size = entry.end - modules.back().base;
+		} else if (file) {
+			std::string name = BaseName(entry.path);
+			ModuleEntry module;
+			module.name.assign(name.begin(), name.end());
+			module.base = entry.start;
+			module.size = entry.end - entry.start;
+			modules.push_back(module);
+			path = entry.path;
+		} else if (entry.path.empty() && !path.empty() && modules.back().base + modules.back().size == entry.start) {
+			// The anonymous mapping right after a module is its .bss
+			modules.back().size = entry.end - modules.back().base;
+			path.clear();
+		} else {
+			path.clear();
+		}
+	}
+
+	return modules;
+}
+
+uint64_t Platform::QueryModuleSignature(HANDLE process) {
+	if (!process) {
+		return 0;
+	}
+
+	int fd = open(("/proc/" + std::to_string(ToProcess(process)->pid) + "/maps").c_str(), O_RDONLY);
+	if (fd < 0) {
+		return 0;
+	}
+
+	// FNV-1a over the raw text, without parsing any line
+	uint64_t hash = 14695981039346656037ull;
+	char buffer[16384];
+	ssize_t length;
+	while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+		for (ssize_t i = 0; i < length; ++i) {
+			hash = (hash ^ (uint8_t)buffer[i]) * 1099511628211ull;
+		}
+	}
+
+	close(fd);
+	return hash;
+}
+
+bool Platform::ClearDirtyPages(HANDLE process) {
+	if (!process || ToProcess(process)->pagemapFd < 0 || !SoftDirtySupported()) {
+		return false;
+	}
+	return WriteClearRefs(std::to_string(ToProcess(process)->pid));
+}
+
+bool Platform::QueryDirtyPages(HANDLE process, uintptr_t address, size_t pageCount, uint64_t* bitmap) {
+	if (!process || ToProcess(process)->pagemapFd < 0 || !SoftDirtySupported()) {
+		return false;
+	}
+
+	std::fill(bitmap, bitmap + (pageCount + 63) / 64, 0);
+
+	// The pagemap holds one 64-bit entry per page, read a few thousand at a time
+	uint64_t entries[4096];
+	size_t firstPage = address / kPageSize;
+	for (size_t done = 0; done < pageCount;) {
+		size_t count = std::min(pageCount - done, sizeof(entries) / sizeof(entries[0]));
+		size_t bytes = ReadProcMem(ToProcess(process)->pagemapFd, (firstPage + done) * sizeof(uint64_t), entries, count * sizeof(uint64_t));
+		if (bytes != count * sizeof(uint64_t)) {
+			return false;
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			if (entries[i] & kSoftDirtyBit) {
+				bitmap[(done + i) / 64] |= 1ull << ((done + i) % 64);
+			}
+		}
+		done += count;
+	}
+
+	return true;
+}
+
+#endif
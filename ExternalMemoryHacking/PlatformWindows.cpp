@@ -0,0 +1,261 @@
+#include "Platform.h"
+
+#ifdef _WIN32
+
+#include <algorithm>
+
+DWORD Platform::FindProcessID(const wchar_t* processName) {
+	// Process ID to return, default 0 (not found)
+	DWORD processID = 0;
+
+	// Take a snapshot of all processes in the system
+	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+
+	if (hSnap != INVALID_HANDLE_VALUE) {
+		PROCESSENTRY32 processEntry;
+		processEntry.dwSize = sizeof(processEntry); // Set the size before using the structure
+
+		// Get the first process in the snapshot
+		if (Process32First(hSnap, &processEntry)) {
+			do {
+				// Compare the process name (case-insensitive)
+				if (!_wcsicmp(processEntry.szExeFile, processName)) {
+					processID = processEntry.th32ProcessID; // Found, store the process ID
+					break; // Exit loop since we found the process
+				}
+			} while (Process32Next(hSnap, &processEntry)); // Move to next process
+		}
+
+		// Release the snapshot handle
+		CloseHandle(hSnap);
+	}
+
+	// Return the found process ID (or 0 if not found)
+	return processID;
+}
+
+std::vector<DWORD> Platform::EnumerateProcessIDs() {
+	std::vector<DWORD> processIDs(1024);
+
+	// EnumProcesses cannot report the total, so grow the buffer until the list no longer fills it
+	for (;;) {
+		DWORD bytes = 0;
+		if (!EnumProcesses(processIDs.data(), (DWORD)(processIDs.size() * sizeof(DWORD)), &bytes)) {
+			return std::vector<DWORD>();
+		}
+
+		if (bytes < processIDs.size() * sizeof(DWORD)) {
+			processIDs.resize(bytes / sizeof(DWORD));
+			return processIDs;
+		}
+		processIDs.resize(processIDs.size() * 2);
+	}
+}
+
+std::wstring Platform::FindProcessName(DWORD processID) {
+	std::wstring processName;
+
+	// Query the full image path with the least privileged access right that allows it
+	HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processID);
+	if (process) {
+		wchar_t path[MAX_PATH];
+		DWORD length = MAX_PATH;
+		if (QueryFullProcessImageNameW(process, 0, path, &length)) {
+			// Keep only the file name, which is also the name of the main module
+			processName.assign(path, length);
+			size_t slash = processName.find_last_of(L"\\/");
+			if (slash != std::wstring::npos) {
+				processName.erase(0, slash + 1);
+			}
+		}
+		CloseHandle(process);
+	}
+
+	return processName;
+}
+
+uintptr_t Platform::FindModuleBaseAddress(DWORD processID, const wchar_t* moduleName) {
+	// Variable to store the base address of the module, default is 0 (not found)
+	uintptr_t moduleBaseAddress = 0;
+
+	// Take a snapshot of all modules in the specified process
+	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPMODULE | TH32CS_SNAPMODULE32, processID);
+	if (hSnap != INVALID_HANDLE_VALUE) {
+		MODULEENTRY32 modEntry;
+		modEntry.dwSize = sizeof(modEntry); // Set the size before using the structure
+
+		// Get the first module in the snapshot
+		if (Module32First(hSnap, &modEntry)) {
+			do {
+				// Compare the module name (case-insensitive)
+				if (!_wcsicmp(modEntry.szModule, moduleName)) {
+					// Found the module, store its base address
+					moduleBaseAddress = (uintptr_t)modEntry.modBaseAddr;
+					break; // Exit loop since we found the module
+				}
+			} while (Module32Next(hSnap, &modEntry)); // Move to next module
+		}
+
+		// Release the snapshot handle
+		CloseHandle(hSnap);
+	}
+
+	// Return the found module base address (or 0 if not found)
+	return moduleBaseAddress;
+}
+
+MODULEINFO Platform::QueryModuleInfo(HANDLE process, HMODULE module) {
+	// Structure to hold module information, zeroed in case the query fails
+	MODULEINFO moduleInfo = {};
+
+	// Query the module information from the target process.
+	GetModuleInformation(process, module, &moduleInfo, sizeof(moduleInfo));
+
+	return moduleInfo;
+}
+
+HANDLE Platform::OpenProcessHandle(DWORD processID) {
+	// Open a handle to the process with all access rights
+	return OpenProcess(PROCESS_ALL_ACCESS, FALSE, processID);
+}
+
+void Platform::CloseProcessHandle(HANDLE process) {
+	// Close the handle if it is valid
+	if (process) {
+		CloseHandle(process);
+	}
+}
+
+bool Platform::HasExited(HANDLE process) {
+	// A process handle is signalled once the process has terminated
+	return !process || WaitForSingleObject(process, 0) == WAIT_OBJECT_0;
+}
+
+bool Platform::ReadMemory(HANDLE process, uintptr_t address, void* buffer, size_t size, size_t* bytesRead) {
+	SIZE_T transferred = 0;
+
+	// ReadProcessMemory fails with ERROR_PARTIAL_COPY but still reports the copied prefix
+	BOOL result = ReadProcessMemory(process, (LPCVOID)address, buffer, size, &transferred);
+
+	if (bytesRead) {
+		*bytesRead = transferred;
+	}
+
+	return result && transferred == size;
+}
+
+bool Platform::WriteMemory(HANDLE process, uintptr_t address, const void* buffer, size_t size) {
+	// Write the buffer to the target process's memory at the specified address
+	return WriteProcessMemory(process, (LPVOID)address, buffer, size, NULL);
+}
+
+size_t Platform::ReadBatch(HANDLE process, BatchEntry* entries, size_t count) {
+	size_t succeeded = 0;
+
+	// Windows has no vectored cross-process read, so every entry is its own call
+	for (size_t i = 0; i < count; ++i) {
+		entries[i].success = ReadMemory(process, entries[i].address, entries[i].buffer, entries[i].size);
+		succeeded += entries[i].success;
+	}
+
+	return succeeded;
+}
+
+size_t Platform::WriteBatch(HANDLE process, BatchEntry* entries, size_t count) {
+	size_t succeeded = 0;
+
+	// Windows has no vectored cross-process write, so every entry is its own call
+	for (size_t i = 0; i < count; ++i) {
+		entries[i].success = WriteMemory(process, entries[i].address, entries[i].buffer, entries[i].size);
+		succeeded += entries[i].success;
+	}
+
+	return succeeded;
+}
+
+std::vector<MemoryRegion> Platform::EnumerateRegions(HANDLE process) {
+	std::vector<MemoryRegion> regions;
+	MEMORY_BASIC_INFORMATION info;
+	uintptr_t address = 0;
+
+	// Walk the address space region by region until VirtualQueryEx runs past the last one
+	while (VirtualQueryEx(process, (LPCVOID)address, &info, sizeof(info)) == sizeof(info)) {
+		DWORD protect = info.Protect & 0xFF;
+		bool readable = protect != PAGE_NOACCESS && protect != PAGE_EXECUTE;
+
+		if (info.State == MEM_COMMIT && readable && !(info.Protect & PAGE_GUARD)) {
+			MemoryRegion region;
+			region.base = (uintptr_t)info.BaseAddress;
+			region.size = info.RegionSize;
+			region.writable = (protect & (PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) != 0;
+			region.executable = (protect & (PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) != 0;
+			region.image = info.Type == MEM_IMAGE || info.Type == MEM_MAPPED;
+			regions.push_back(region);
+		}
+
+		// Stop when the next address would wrap around
+		uintptr_t next = (uintptr_t)info.BaseAddress + info.RegionSize;
+		if (next <= address) {
+			break;
+		}
+		address = next;
+	}
+
+	return regions;
+}
+
+std::vector<ModuleEntry> Platform::EnumerateModules(HANDLE process) {
+	std::vector<ModuleEntry> modules;
+
+	// Take a snapshot of all modules in the process behind the handle
+	HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPMODULE | TH32CS_SNAPMODULE32, GetProcessId(process));
+	if (hSnap != INVALID_HANDLE_VALUE) {
+		MODULEENTRY32 modEntry;
+		modEntry.dwSize = sizeof(modEntry); // Set the size before using the structure
+
+		if (Module32First(hSnap, &modEntry)) {
+			do {
+				ModuleEntry module;
+				module.name = modEntry.szModule;
+				module.base = (uintptr_t)modEntry.modBaseAddr;
+				module.size = modEntry.modBaseSize;
+				modules.push_back(module);
+			} while (Module32Next(hSnap, &modEntry));
+		}
+
+		// Release the snapshot handle
+		CloseHandle(hSnap);
+	}
+
+	// ToolHelp lists modules in load order
+	std::sort(modules.begin(), modules.end(), [](const ModuleEntry& left, const ModuleEntry& right) { return left.base < right.base; });
+	return modules;
+}
+
+uint64_t Platform::QueryModuleSignature(HANDLE process) {
+	// Only the module handles are listed, which is much cheaper than a ToolHelp snapshot
+	HMODULE handles[1024];
+	DWORD needed = 0;
+	if (!EnumProcessModulesEx(process, handles, sizeof(handles), &needed, LIST_MODULES_ALL)) {
+		return 0;
+	}
+
+	// FNV-1a over the handle list and its length
+	uint64_t hash = 14695981039346656037ull;
+	size_t count = std::min<size_t>(needed / sizeof(HMODULE), sizeof(handles) / sizeof(HMODULE));
+	for (size_t i = 0; i < count; ++i) {
+		hash = (hash ^ (uint64_t)(uintptr_t)handles[i]) * 1099511628211ull;
+	}
+	return (hash ^ needed) * 1099511628211ull;
+}
+
+bool Platform::ClearDirtyPages(HANDLE process) {
+	// Windows only tracks writes for the calling process (GetWriteWatch), so callers read everything
+	return false;
+}
+
+bool Platform::QueryDirtyPages(HANDLE process, uintptr_t address, size_t pageCount, uint64_t* bitmap) {
+	return false;
+}
+
+#endif
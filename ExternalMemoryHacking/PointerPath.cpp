@@ -0,0 +1,165 @@
+#include "PointerPath.h"
+
+uint32_t PointerResolver::AddNode(uint32_t parent, size_t depth, uintptr_t offset) {
+	uint32_t index = (uint32_t)this->nodes.size();
+
+	Node node;
+	node.parent = parent;
+	node.offset = offset;
+	this->nodes.push_back(node);
+
+	if (this->levels.size() <= depth) {
+		this->levels.resize(depth + 1);
+	}
+	this->levels[depth].push_back(index);
+
+	return index;
+}
+
+size_t PointerResolver::Add(const PointerPath& path) {
+	size_t index = this->leaves.size();
+
+	if (!path.IsValid()) {
+		this->leaves.push_back(kInvalidPath);
+		return index;
+	}
+
+	// Find or create the root of the base
+	auto root = this->roots.find(path.GetBase());
+	if (root == this->roots.end()) {
+		root = this->roots.emplace(path.GetBase(), this->AddNode(0, 0, path.GetBase())).first;
+	}
+	uint32_t current = root->second;
+
+	// Walk down the trie, sharing every node with the paths added before
+	for (size_t depth = 0; depth < path.GetDepth(); ++depth) {
+		this->nodes[current].interior = true;
+
+		uint64_t key = (uint64_t)current << 32 | path.GetOffset(depth);
+		auto child = this->children.find(key);
+		if (child == this->children.end()) {
+			child = this->children.emplace(key, this->AddNode(current, depth + 1, path.GetOffset(depth))).first;
+		}
+		current = child->second;
+	}
+
+	this->leaves.push_back(current);
+	return index;
+}
+
+size_t PointerResolver::GetCount() const {
+	return this->leaves.size();
+}
+
+size_t PointerResolver::GetLinkCount() const {
+	size_t count = 0;
+	for (const Node& node : this->nodes) {
+		count += node.interior;
+	}
+	return count;
+}
+
+size_t PointerResolver::GetLastReadCount() const {
+	return this->lastReads;
+}
+
+void PointerResolver::SetLinkCaching(bool enabled) {
+	this->caching = enabled;
+	++this->generation;
+}
+
+void PointerResolver::BeginFrame() {
+	// Every link read before this point is now stale
+	++this->generation;
+}
+
+void PointerResolver::Clear() {
+	this->nodes.clear();
+	this->levels.clear();
+	this->roots.clear();
+	this->children.clear();
+	this->leaves.clear();
+}
+
+bool PointerResolver::Resolve(HANDLE process, uintptr_t moduleBase, std::vector<uintptr_t>& addresses) {
+	// Cached links were read relative to the old module base
+	if (moduleBase != this->lastModuleBase) {
+		this->lastModuleBase = moduleBase;
+		++this->generation;
+	}
+	this->lastReads = 0;
+
+	for (size_t depth = 0; depth < this->levels.size(); ++depth) {
+		// Compute the address of every node at this level from its parent's pointer
+		for (uint32_t index : this->levels[depth]) {
+			Node& node = this->nodes[index];
+			if (depth == 0) {
+				node.address = moduleBase + node.offset;
+				node.resolved = true;
+			} else {
+				const Node& parent = this->nodes[node.parent];
+				node.resolved = parent.resolved && parent.linked;
+				node.address = node.resolved ? parent.pointer + node.offset : 0;
+			}
+		}
+
+		// Read the pointer of every interior node at this level in one batch
+		this->batch.clear();
+		this->batchNodes.clear();
+		for (uint32_t index : this->levels[depth]) {
+			Node& node = this->nodes[index];
+			if (!node.interior) {
+				continue;
+			}
+
+			node.linked = false;
+			if (!node.resolved) {
+				continue;
+			}
+
+			// A link cached in this frame from the same address is still good
+			if (this->caching && node.generation == this->generation && node.linkedFrom == node.address) {
+				node.linked = true;
+				continue;
+			}
+
+			BatchEntry entry;
+			entry.address = node.address;
+			entry.buffer = &node.pointer;
+			entry.size = sizeof(node.pointer);
+			this->batch.push_back(entry);
+			this->batchNodes.push_back(index);
+		}
+
+		if (this->batch.empty()) {
+			continue;
+		}
+
+		Platform::ReadBatch(process, this->batch.data(), this->batch.size());
+		this->lastReads += this->batch.size();
+
+		for (size_t i = 0; i < this->batch.size(); ++i) {
+			Node& node = this->nodes[this->batchNodes[i]];
+			node.linked = this->batch[i].success;
+
+			// Only links that were read are kept for later calls in this frame
+			if (node.linked) {
+				node.linkedFrom = node.address;
+				node.generation = this->generation;
+			}
+		}
+	}
+
+	// Report the address of every path's last node
+	addresses.assign(this->leaves.size(), 0);
+	bool resolved = true;
+	for (size_t i = 0; i < this->leaves.size(); ++i) {
+		if (this->leaves[i] != kInvalidPath && this->nodes[this->leaves[i]].resolved) {
+			addresses[i] = this->nodes[this->leaves[i]].address;
+		} else {
+			resolved = false;
+		}
+	}
+
+	return resolved;
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <unordered_map>
+#include <vector>
+#include "Platform.h"
+
+/**
+ * @brief A multi-level pointer chain, such as the base address and offsets passed to Memory::GetAddress.
+ *
+ * Resolving the path starts at (module base + base). For every offset, the pointer stored at the
+ * current address is read and the offset is added to it. The offsets are kept in a fixed array,
+ * so paths can be constexpr and resolving one never allocates:
+ *
+ *     constexpr PointerPath playerHealth(0x17E0A8, { 0xEC });
+ */
+class PointerPath {
+public:
+	// Longest chain a path can hold
+	static constexpr size_t kMaxDepth = 16;
+
+private:
+	// Address of the first pointer, relative to the module base given when resolving
+	uintptr_t base = 0;
+
+	// Offsets added after every pointer read
+	unsigned int offsets[kMaxDepth] = {};
+
+	// Number of offsets in use
+	size_t depth = 0;
+
+	// False if the path was built with more than kMaxDepth offsets
+	bool valid = true;
+
+public:
+	constexpr PointerPath() = default;
+
+	/**
+	 * @brief Creates a path from a base address and a list of offsets.
+	 *
+	 * @param base The address of the first pointer, relative to the module base.
+	 * @param offsets The offsets to follow, at most kMaxDepth of them.
+	 */
+	constexpr PointerPath(uintptr_t base, std::initializer_list<unsigned int> offsets) : base(base) {
+		for (unsigned int offset : offsets) {
+			this->Push(offset);
+		}
+	}
+
+	/**
+	 * @brief Creates a path from a base address and a vector of offsets, e.g. one built at runtime.
+	 */
+	PointerPath(uintptr_t base, const std::vector<unsigned int>& offsets) : base(base) {
+		for (unsigned int offset : offsets) {
+			this->Push(offset);
+		}
+	}
+
+	/**
+	 * @brief Appends an offset to the end of the path. Past kMaxDepth the path becomes invalid.
+	 */
+	constexpr void Push(unsigned int offset) {
+		if (this->depth == kMaxDepth) {
+			this->valid = false;
+			return;
+		}
+		this->offsets[this->depth++] = offset;
+	}
+
+	/**
+	 * @brief Returns the address of the first pointer, relative to the module base.
+	 */
+	constexpr uintptr_t GetBase() const {
+		return this->base;
+	}
+
+	/**
+	 * @brief Returns the number of offsets, which is the number of pointers read when resolving.
+	 */
+	constexpr size_t GetDepth() const {
+		return this->depth;
+	}
+
+	/**
+	 * @brief Returns the offset at the given level.
+	 */
+	constexpr unsigned int GetOffset(size_t index) const {
+		return this->offsets[index];
+	}
+
+	/**
+	 * @brief Returns false if more than kMaxDepth offsets were given.
+	 */
+	constexpr bool IsValid() const {
+		return this->valid;
+	}
+};
+
+/**
+ * @brief Resolves many pointer paths together, one batched read per level.
+ *
+ * The added paths are merged into a trie: paths with the same base share a root, and paths
+ * that continue with the same offset share the next node, so a prefix such as a player list
+ * is read once no matter how many paths start with it. Resolve walks the trie level by level
+ * and reads the pointer of every node at a level with a single ReadBatch call, so resolving
+ * hundreds of paths of depth 3 costs 3 batched reads.
+ *
+ * With link caching enabled, the pointers read at intermediate nodes are kept until the next
+ * BeginFrame, and later Resolve calls only read the links that are missing.
+ */
+class PointerResolver {
+private:
+	// Leaf index of a path that can not be resolved
+	static constexpr uint32_t kInvalidPath = 0xFFFFFFFF;
+
+	// One node of the trie, the address reached after a prefix of a path
+	struct Node {
+		uint32_t parent = 0;       // Index of the parent node, unused for roots
+		uintptr_t offset = 0;      // Offset added to the parent's pointer, or the base for roots
+		uintptr_t address = 0;     // Address of the node after the last Resolve
+		uintptr_t pointer = 0;     // Pointer read at address, valid if linked is set
+		uintptr_t linkedFrom = 0;  // Address the pointer was read from
+		uint64_t generation = 0;   // Frame the pointer was read in
+		bool resolved = false;     // The address of the node is known
+		bool linked = false;       // The pointer at address was read
+		bool interior = false;     // The node has children, so its pointer is needed
+	};
+
+	// All nodes; parents always come before their children
+	std::vector<Node> nodes;
+
+	// Node indices per depth, depth 0 holding the roots
+	std::vector<std::vector<uint32_t>> levels;
+
+	// Root node of every base
+	std::unordered_map<uintptr_t, uint32_t> roots;
+
+	// Child node of every (parent index << 32 | offset) pair
+	std::unordered_map<uint64_t, uint32_t> children;
+
+	// Node at the end of every path by path index, kInvalidPath for invalid paths
+	std::vector<uint32_t> leaves;
+
+	// Reused entries of the batched reads, and the node each entry reads into
+	std::vector<BatchEntry> batch;
+	std::vector<uint32_t> batchNodes;
+
+	// Keep intermediate links until BeginFrame
+	bool caching = false;
+
+	// Current frame; links read in an earlier frame are stale
+	uint64_t generation = 1;
+
+	// Module base used in the last Resolve
+	uintptr_t lastModuleBase = 0;
+
+	// Number of pointers read by the last Resolve
+	size_t lastReads = 0;
+
+	// Appends a node at the given depth and returns its index
+	uint32_t AddNode(uint32_t parent, size_t depth, uintptr_t offset);
+
+public:
+	/**
+	 * @brief Adds a path to the trie.
+	 *
+	 * @param path The path to resolve. Invalid paths are kept so indices line up, but always resolve to 0.
+	 * @return The index of the path, used to look up its address.
+	 */
+	size_t Add(const PointerPath& path);
+
+	/**
+	 * @brief Returns the number of paths added.
+	 */
+	size_t GetCount() const;
+
+	/**
+	 * @brief Returns the number of distinct pointers a Resolve reads without link caching.
+	 */
+	size_t GetLinkCount() const;
+
+	/**
+	 * @brief Returns the number of pointers read by the last Resolve.
+	 */
+	size_t GetLastReadCount() const;
+
+	/**
+	 * @brief Keeps the pointers read at intermediate nodes until the next BeginFrame.
+	 *
+	 * Only use it for links that do not change within a frame, such as a player list pointer.
+	 * The final addresses are still recomputed on every Resolve.
+	 *
+	 * @param enabled True to cache links, false to read every link on every Resolve.
+	 */
+	void SetLinkCaching(bool enabled);
+
+	/**
+	 * @brief Starts a new frame, which makes every cached link stale.
+	 */
+	void BeginFrame();
+
+	/**
+	 * @brief Removes every path.
+	 */
+	void Clear();
+
+	/**
+	 * @brief Resolves every path.
+	 *
+	 * @param process Handle to the target process with read access.
+	 * @param moduleBase The address every path base is relative to.
+	 * @param addresses Receives the final address of every path by index, 0 where a read failed.
+	 * @return True if every path was resolved, false if at least one read failed.
+	 */
+	bool Resolve(HANDLE process, uintptr_t moduleBase, std::vector<uintptr_t>& addresses);
+};
@@ -0,0 +1,425 @@
+#include "PointerScanner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+namespace {
+	// Identifies a pointer scan file, followed by the format version
+	const char kFileMagic[4] = { 'M', 'H', 'P', 'S' };
+	const uint32_t kFileVersion = 1;
+
+	// Bytes a worker collects before writing them to the result file
+	const size_t kFlushSize = 1 << 20;
+
+	// Chains per worker the first levels are expanded to before the depth first search starts
+	const size_t kChainsPerThread = 64;
+
+	// Appends a value to a byte buffer in native byte order
+	template <typename T>
+	void Put(std::vector<uint8_t>& buffer, T value) {
+		const uint8_t* bytes = (const uint8_t*)&value;
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+	}
+
+	// Reads a value written by Put, returning false at the end of the file
+	template <typename T>
+	bool Get(FILE* file, T& value) {
+		return fread(&value, sizeof(value), 1, file) == 1;
+	}
+
+	// The result file shared by all workers
+	struct PointerScanFile {
+		FILE* file = nullptr;            // Open result file
+		std::mutex mutex;                // Serializes the writes of the workers
+		std::atomic<size_t> count{ 0 };  // Paths added so far
+		std::atomic<bool> full{ false }; // Set when the result limit is reached or writing failed
+		bool failed = false;             // Writing to the file failed
+	};
+}
+
+struct PointerScanner::ResultWriter {
+	PointerScanFile* shared = nullptr;
+	size_t maxResults = 0;
+	std::vector<uint8_t> buffer;
+
+	// Writes the collected records to the file
+	void Flush() {
+		if (this->buffer.empty()) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(this->shared->mutex);
+		if (fwrite(this->buffer.data(), 1, this->buffer.size(), this->shared->file) != this->buffer.size()) {
+			this->shared->failed = true;
+			this->shared->full = true;
+		}
+		this->buffer.clear();
+	}
+
+	// Adds a path, given by its static pointer and the chain it completes
+	void Add(uint32_t module, uintptr_t offset, const Chain& chain) {
+		// Stop every worker once the result limit is reached
+		size_t index = this->shared->count.fetch_add(1, std::memory_order_relaxed);
+		if (this->maxResults && index >= this->maxResults) {
+			this->shared->count.fetch_sub(1, std::memory_order_relaxed);
+			this->shared->full = true;
+			return;
+		}
+
+		// The chain holds its offsets last first, the file in GetAddress order
+		Put<uint32_t>(this->buffer, module);
+		Put<uint32_t>(this->buffer, (uint32_t)chain.depth);
+		Put<uint64_t>(this->buffer, offset);
+		for (size_t i = chain.depth; i-- > 0;) {
+			Put<uint32_t>(this->buffer, chain.offsets[i]);
+		}
+
+		if (this->buffer.size() >= kFlushSize) {
+			this->Flush();
+		}
+	}
+};
+
+PointerScanner::PointerScanner(MemoryReader& memory, const PointerScanOptions& options)
+	: memory(memory), options(options), scanner(memory, [&]() {
+		ScanOptions scanOptions;
+		scanOptions.threadCount = options.threadCount;
+		scanOptions.pool = options.pool;
+		return scanOptions;
+	}()) {
+	// Paths must fit into a PointerPath, and pointers are at least byte aligned
+	this->options.maxDepth = std::min(std::max<size_t>(this->options.maxDepth, 1), PointerPath::kMaxDepth);
+	this->options.alignment = std::max<size_t>(this->options.alignment, 1);
+}
+
+int PointerScanner::FindModule(uintptr_t address) const {
+	// Last module starting at or below the address
+	auto found = std::upper_bound(this->modules.begin(), this->modules.end(), address,
+		[](uintptr_t value, const ModuleEntry& module) { return value < module.base; });
+	if (found == this->modules.begin()) {
+		return -1;
+	}
+
+	--found;
+	return address - found->base < found->size ? (int)(found - this->modules.begin()) : -1;
+}
+
+template <typename Visit>
+void PointerScanner::ForEachReferrer(uintptr_t address, const Visit& visit) const {
+	uintptr_t low = address > this->options.maxOffset ? address - this->options.maxOffset : 0;
+
+	// First bucket that can hold values at or above low
+	auto bucket = std::partition_point(this->buckets.begin(), this->buckets.end(),
+		[low](const Bucket& candidate) { return candidate.end <= low; });
+
+	for (; bucket != this->buckets.end() && bucket->start <= address; ++bucket) {
+		auto pointer = std::lower_bound(bucket->pointers.begin(), bucket->pointers.end(), low,
+			[](const Pointer& candidate, uintptr_t value) { return candidate.value < value; });
+
+		for (; pointer != bucket->pointers.end() && pointer->value <= address; ++pointer) {
+			visit(*pointer);
+		}
+	}
+}
+
+bool PointerScanner::BuildIndex() {
+	auto start = std::chrono::steady_clock::now();
+
+	this->buckets.clear();
+	this->statistics = PointerScanStatistics();
+	this->modules = this->memory.GetModules();
+
+	std::vector<MemoryRegion> regions = this->memory.GetRegions();
+	std::vector<ScanChunk> chunks = this->scanner.SplitRegions(regions);
+	if (chunks.empty()) {
+		this->errorMessage = "The target has no readable regions";
+		return false;
+	}
+
+	// One bucket per chunk of readable memory, so the sort is spread evenly over the workers
+	this->buckets.resize(chunks.size());
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		this->buckets[i].start = chunks[i].address;
+		this->buckets[i].end = chunks[i].address + chunks[i].size;
+	}
+	uintptr_t lowest = this->buckets.front().start;
+	uintptr_t highest = this->buckets.back().end;
+
+	// Every worker collects its pointers per bucket, so no locking is needed while reading
+	size_t threadCount = this->scanner.GetThreadCount();
+	std::vector<std::vector<std::vector<Pointer>>> pieces(threadCount, std::vector<std::vector<Pointer>>(this->buckets.size()));
+	std::vector<size_t> lastBucket(threadCount, 0);
+	size_t maxPointers = this->options.memoryBudget / sizeof(Pointer);
+	size_t alignment = this->options.alignment;
+	std::atomic<size_t> pointerCount{ 0 };
+
+	this->statistics.bytesScanned = this->scanner.ScanChunks(chunks, sizeof(uintptr_t) - 1, [&](const ScanBlock& block) {
+		// Stop collecting once the budget is exceeded
+		if (pointerCount.load(std::memory_order_relaxed) > maxPointers) {
+			return;
+		}
+
+		std::vector<std::vector<Pointer>>& workerPieces = pieces[block.worker];
+		size_t& current = lastBucket[block.worker];
+		size_t found = 0;
+
+		for (size_t offset = (alignment - block.address % alignment) % alignment;
+			offset < block.limit && offset + sizeof(uintptr_t) <= block.size; offset += alignment) {
+			uintptr_t value;
+			std::memcpy(&value, block.data + offset, sizeof(value));
+
+			// Most values are not pointers at all
+			if (value < lowest || value >= highest) {
+				continue;
+			}
+
+			// Pointers tend to refer to the same bucket as the one before, so check that first
+			if (value < this->buckets[current].start || value >= this->buckets[current].end) {
+				auto bucket = std::upper_bound(this->buckets.begin(), this->buckets.end(), value,
+					[](uintptr_t candidate, const Bucket& entry) { return candidate < entry.start; }) - 1;
+				if (value >= bucket->end) {
+					continue; // Between two regions
+				}
+				current = (size_t)(bucket - this->buckets.begin());
+			}
+
+			Pointer pointer;
+			pointer.value = value;
+			pointer.address = block.address + offset;
+			workerPieces[current].push_back(pointer);
+			++found;
+		}
+
+		pointerCount.fetch_add(found, std::memory_order_relaxed);
+	});
+
+	if (pointerCount.load() > maxPointers) {
+		this->buckets.clear();
+		this->errorMessage = "The pointer index needs more than the memory budget of " +
+			std::to_string(this->options.memoryBudget >> 20) + " MiB";
+		return false;
+	}
+
+	// Join the pieces of every bucket and sort them by value, freeing the pieces on the way
+	this->scanner.GetThreadPool().Run(this->buckets.size(), [&](size_t index, size_t) {
+		std::vector<Pointer>& pointers = this->buckets[index].pointers;
+
+		size_t count = 0;
+		for (size_t worker = 0; worker < threadCount; ++worker) {
+			count += pieces[worker][index].size();
+		}
+		pointers.reserve(count);
+
+		for (size_t worker = 0; worker < threadCount; ++worker) {
+			pointers.insert(pointers.end(), pieces[worker][index].begin(), pieces[worker][index].end());
+			std::vector<Pointer>().swap(pieces[worker][index]);
+		}
+
+		std::sort(pointers.begin(), pointers.end(), [](const Pointer& left, const Pointer& right) {
+			return left.value < right.value || (left.value == right.value && left.address < right.address);
+		});
+	});
+
+	// Empty buckets only slow down lookups
+	this->buckets.erase(std::remove_if(this->buckets.begin(), this->buckets.end(),
+		[](const Bucket& bucket) { return bucket.pointers.empty(); }), this->buckets.end());
+
+	this->statistics.regionCount = regions.size();
+	this->statistics.pointerCount = pointerCount.load();
+	this->statistics.indexBytes = this->statistics.pointerCount * sizeof(Pointer) + this->buckets.size() * sizeof(Bucket);
+	this->statistics.indexSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+void PointerScanner::Search(Chain& chain, ResultWriter& writer) const {
+	uintptr_t address = chain.address;
+	size_t depth = chain.depth;
+
+	this->ForEachReferrer(address, [&](const Pointer& pointer) {
+		if (writer.shared->full) {
+			return;
+		}
+
+		chain.offsets[depth] = (unsigned int)(address - pointer.value);
+		chain.depth = depth + 1;
+
+		// A pointer inside a module is a static base and ends the path
+		int module = this->FindModule(pointer.address);
+		if (module >= 0) {
+			writer.Add((uint32_t)module, pointer.address - this->modules[module].base, chain);
+		} else if (chain.depth < this->options.maxDepth) {
+			chain.address = pointer.address;
+			this->Search(chain, writer);
+		}
+	});
+
+	chain.address = address;
+	chain.depth = depth;
+}
+
+bool PointerScanner::Scan(uintptr_t target, const std::string& path) {
+	auto start = std::chrono::steady_clock::now();
+	this->statistics.pathCount = 0;
+
+	if (this->buckets.empty()) {
+		this->errorMessage = "BuildIndex must succeed before Scan";
+		return false;
+	}
+
+	PointerScanFile shared;
+	shared.file = fopen(path.c_str(), "wb");
+	if (!shared.file) {
+		this->errorMessage = "Failed to create " + path;
+		return false;
+	}
+
+	// Header: format, settings and the module table the results refer to
+	std::vector<uint8_t> header(kFileMagic, kFileMagic + sizeof(kFileMagic));
+	Put<uint32_t>(header, kFileVersion);
+	Put<uint64_t>(header, target);
+	Put<uint32_t>(header, (uint32_t)this->options.maxDepth);
+	Put<uint32_t>(header, (uint32_t)this->options.maxOffset);
+	Put<uint32_t>(header, (uint32_t)this->modules.size());
+	for (const ModuleEntry& module : this->modules) {
+		Put<uint64_t>(header, module.base);
+		Put<uint64_t>(header, module.size);
+		Put<uint32_t>(header, (uint32_t)module.name.size());
+		for (wchar_t c : module.name) {
+			Put<uint16_t>(header, (uint16_t)c);
+		}
+	}
+	shared.failed = fwrite(header.data(), 1, header.size(), shared.file) != header.size();
+
+	size_t threadCount = this->scanner.GetThreadCount();
+	std::vector<ResultWriter> writers(threadCount);
+	for (ResultWriter& writer : writers) {
+		writer.shared = &shared;
+		writer.maxResults = this->options.maxResults;
+	}
+
+	// Expand the first levels breadth first until every worker has enough chains to search
+	std::vector<Chain> chains(1);
+	chains[0].address = target;
+	while (!chains.empty() && chains.size() < threadCount * kChainsPerThread && chains.front().depth + 1 < this->options.maxDepth) {
+		std::vector<Chain> next;
+		for (const Chain& chain : chains) {
+			this->ForEachReferrer(chain.address, [&](const Pointer& pointer) {
+				Chain extended = chain;
+				extended.offsets[chain.depth] = (unsigned int)(chain.address - pointer.value);
+				extended.depth = chain.depth + 1;
+
+				int module = this->FindModule(pointer.address);
+				if (module >= 0) {
+					writers[0].Add((uint32_t)module, pointer.address - this->modules[module].base, extended);
+				} else {
+					extended.address = pointer.address;
+					next.push_back(extended);
+				}
+			});
+		}
+		chains.swap(next);
+	}
+
+	// Search the remaining levels depth first, one chain per task
+	this->scanner.GetThreadPool().Run(chains.size(), [&](size_t index, size_t worker) {
+		if (!shared.full) {
+			Chain chain = chains[index];
+			this->Search(chain, writers[worker]);
+		}
+	});
+
+	for (ResultWriter& writer : writers) {
+		writer.Flush();
+	}
+	shared.failed |= fclose(shared.file) != 0;
+
+	this->statistics.pathCount = shared.count.load();
+	this->statistics.scanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (shared.failed) {
+		this->errorMessage = "Failed to write " + path;
+		return false;
+	}
+	return true;
+}
+
+bool PointerScanner::ReadResults(const std::string& path, PointerScanHeader& header, const std::function<bool(const PointerScanResult&)>& visitor) {
+	std::unique_ptr<FILE, int (*)(FILE*)> file(fopen(path.c_str(), "rb"), fclose);
+	if (!file) {
+		return false;
+	}
+
+	char magic[sizeof(kFileMagic)];
+	uint32_t version = 0, maxDepth = 0, maxOffset = 0, moduleCount = 0;
+	uint64_t target = 0;
+	if (fread(magic, sizeof(magic), 1, file.get()) != 1 || std::memcmp(magic, kFileMagic, sizeof(magic)) ||
+		!Get(file.get(), version) || version != kFileVersion || !Get(file.get(), target) ||
+		!Get(file.get(), maxDepth) || !Get(file.get(), maxOffset) || !Get(file.get(), moduleCount)) {
+		return false;
+	}
+
+	header.target = (uintptr_t)target;
+	header.maxDepth = maxDepth;
+	header.maxOffset = maxOffset;
+	header.modules.assign(moduleCount, ModuleEntry());
+	for (ModuleEntry& module : header.modules) {
+		uint64_t base = 0, size = 0;
+		uint32_t length = 0;
+		if (!Get(file.get(), base) || !Get(file.get(), size) || !Get(file.get(), length)) {
+			return false;
+		}
+		module.base = (uintptr_t)base;
+		module.size = (size_t)size;
+		for (uint32_t i = 0; i < length; ++i) {
+			uint16_t c = 0;
+			if (!Get(file.get(), c)) {
+				return false;
+			}
+			module.name.push_back((wchar_t)c);
+		}
+	}
+
+	// Records follow until the end of the file
+	PointerScanResult result;
+	uint32_t module = 0, depth = 0;
+	uint64_t offset = 0;
+	while (Get(file.get(), module)) {
+		if (!Get(file.get(), depth) || !Get(file.get(), offset) || depth > PointerPath::kMaxDepth || module >= moduleCount) {
+			return false;
+		}
+
+		result.module = module;
+		result.offset = (uintptr_t)offset;
+		result.offsets.resize(depth);
+		for (unsigned int& value : result.offsets) {
+			uint32_t read = 0;
+			if (!Get(file.get(), read)) {
+				return false;
+			}
+			value = read;
+		}
+
+		if (!visitor(result)) {
+			break;
+		}
+	}
+
+	return true;
+}
+
+const std::vector<ModuleEntry>& PointerScanner::GetModules() const {
+	return this->modules;
+}
+
+const PointerScanStatistics& PointerScanner::GetStatistics() const {
+	return this->statistics;
+}
+
+std::string PointerScanner::GetErrorMessage() const {
+	return this->errorMessage;
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Memory.h"
+#include "PointerPath.h"
+#include "Scanner.h"
+
+/**
+ * @brief Settings of a PointerScanner.
+ */
+struct PointerScanOptions {
+	size_t maxDepth = 5;                    // Most pointer reads in a path, at most PointerPath::kMaxDepth
+	size_t maxOffset = 0x1000;              // Largest offset added to a pointer at any level
+	size_t alignment = sizeof(uintptr_t);   // Distance between candidate pointer addresses
+	size_t maxResults = 0;                  // Stop after this many paths, 0 for no limit
+	size_t memoryBudget = (size_t)1 << 30;  // Bytes the reverse pointer index may use
+	size_t threadCount = 0;                 // Number of worker threads, 0 uses one per hardware thread
+	ThreadPool* pool = nullptr;             // Workers shared with other scanners (threadCount is then ignored), nullptr starts its own
+};
+
+/**
+ * @brief Numbers describing the index and the last search of a PointerScanner.
+ */
+struct PointerScanStatistics {
+	size_t regionCount = 0;  // Regions read to build the index
+	size_t bytesScanned = 0; // Bytes copied from the target process
+	size_t pointerCount = 0; // Aligned values that point into a readable region
+	size_t indexBytes = 0;   // Memory used by the index
+	double indexSeconds = 0; // Wall clock time of BuildIndex
+	size_t pathCount = 0;    // Paths written by the last Scan
+	double scanSeconds = 0;  // Wall clock time of the last Scan
+};
+
+/**
+ * @brief One pointer path read back from a pointer scan file.
+ */
+struct PointerScanResult {
+	uint32_t module = 0;               // Index of the module holding the first pointer, see PointerScanHeader
+	uintptr_t offset = 0;              // Address of the first pointer relative to the module base
+	std::vector<unsigned int> offsets; // Offsets in the order Memory::GetAddress applies them
+
+	/**
+	 * @brief Returns the result as a path relative to its module base.
+	 */
+	PointerPath ToPath() const {
+		return PointerPath(this->offset, this->offsets);
+	}
+};
+
+/**
+ * @brief The settings and module table at the start of a pointer scan file.
+ */
+struct PointerScanHeader {
+	uintptr_t target = 0;             // Address the paths lead to
+	size_t maxDepth = 0;              // Depth limit of the scan
+	size_t maxOffset = 0;             // Offset limit of the scan
+	std::vector<ModuleEntry> modules; // Modules of the target at scan time, by index
+};
+
+/**
+ * @brief Finds static pointer paths that lead to an address, for use with GetAddress or PointerPath.
+ *
+ * BuildIndex reads every readable region once and keeps every aligned value that points into a
+ * readable region as a (value, address) pair. The pairs are bucketed by value, one bucket per
+ * piece of the region the value points into, and sorted, so the pointers referring to any
+ * address range are found with a binary search. Only the index is kept, not the memory itself,
+ * and building it fails instead of exceeding the memory budget.
+ *
+ * Scan then searches backwards from the target: every pointer whose value lies at most
+ * maxOffset below the current address is a possible last link. Pointers stored inside a module
+ * end a path, which is written to the result file relative to that module; the others are
+ * searched again, up to maxDepth levels. The first levels are expanded until there is enough
+ * work for every thread, then each thread searches its share depth first and streams the paths
+ * it finds to disk through its own buffer, so the results never have to fit in memory.
+ *
+ * A path found this way is valid for the current state of the target; scanning again after
+ * restarting the target and keeping only the paths found both times leaves the stable ones.
+ */
+class PointerScanner {
+private:
+	// A value in the target that points into a readable region, and where it is stored
+	struct Pointer {
+		uintptr_t value = 0;
+		uintptr_t address = 0;
+	};
+
+	// The pointers whose values lie in [start, end), sorted by value
+	struct Bucket {
+		uintptr_t start = 0;
+		uintptr_t end = 0;
+		std::vector<Pointer> pointers;
+	};
+
+	// A partial path: the address reached so far and the offsets from it to the target, last offset first
+	struct Chain {
+		uintptr_t address = 0;
+		size_t depth = 0;
+		unsigned int offsets[PointerPath::kMaxDepth] = {};
+	};
+
+	// Memory instance attached to the target process, or a capture of one
+	MemoryReader& memory;
+
+	// Settings of the scanner
+	PointerScanOptions options;
+
+	// Reads the regions and provides the worker threads
+	Scanner scanner;
+
+	// The reverse pointer index, in ascending value order
+	std::vector<Bucket> buckets;
+
+	// Modules of the target when the index was built, in ascending address order
+	std::vector<ModuleEntry> modules;
+
+	// Numbers of the index and the last scan
+	PointerScanStatistics statistics;
+
+	// Error message of the last failed BuildIndex or Scan
+	std::string errorMessage;
+
+	// Buffered output of one worker, defined in PointerScanner.cpp
+	struct ResultWriter;
+
+	// Returns the index of the module containing address, or -1 for non-static addresses
+	int FindModule(uintptr_t address) const;
+
+	// Extends a chain by every pointer referring to its address, writing the static ones and searching the others depth first
+	void Search(Chain& chain, ResultWriter& writer) const;
+
+	// Calls visit for every pointer whose value is in [address - maxOffset, address], defined in PointerScanner.cpp
+	template <typename Visit>
+	void ForEachReferrer(uintptr_t address, const Visit& visit) const;
+
+public:
+	/**
+	 * @brief Creates a pointer scanner for the process attached to memory.
+	 *
+	 * @param memory The Memory instance (or SnapshotFile) used for all reads. It must outlive the scanner.
+	 * @param options Settings of the index and every scan.
+	 */
+	PointerScanner(MemoryReader& memory, const PointerScanOptions& options = PointerScanOptions());
+
+	/**
+	 * @brief Reads all readable memory of the target and builds the reverse pointer index.
+	 *
+	 * Replaces any earlier index. Call it again when the target's pointers have changed.
+	 *
+	 * @return True on success, false if the index would exceed the memory budget (see GetErrorMessage).
+	 */
+	bool BuildIndex();
+
+	/**
+	 * @brief Finds the static paths leading to an address and writes them to a file.
+	 *
+	 * @param target The address the paths have to lead to.
+	 * @param path The file receiving the results, read back with ReadResults.
+	 * @return True on success, false if there is no index or the file could not be written.
+	 */
+	bool Scan(uintptr_t target, const std::string& path);
+
+	/**
+	 * @brief Reads a pointer scan file written by Scan.
+	 *
+	 * @param path The file to read.
+	 * @param header Receives the target, settings and module table of the scan.
+	 * @param visitor Called for every path; returning false stops reading.
+	 * @return True if the file is a valid pointer scan file, false otherwise.
+	 */
+	static bool ReadResults(const std::string& path, PointerScanHeader& header, const std::function<bool(const PointerScanResult&)>& visitor);
+
+	/**
+	 * @brief Returns the modules of the target when the index was built.
+	 */
+	const std::vector<ModuleEntry>& GetModules() const;
+
+	/**
+	 * @brief Returns the numbers of the index and the last scan.
+	 */
+	const PointerScanStatistics& GetStatistics() const;
+
+	/**
+	 * @brief Returns the error message of the last failed BuildIndex or Scan.
+	 */
+	std::string GetErrorMessage() const;
+};
@@ -0,0 +1,555 @@
+#include "Recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include "TickSchedule.h"
+
+namespace {
+	// Identifies a recording
+	const char kFileMagic[4] = { 'M', 'H', 'R', 'C' };
+	const uint32_t kFileVersion = 1;
+
+	// The header and the column table are padded to this size
+	const size_t kHeaderAlignment = 0x1000;
+
+	// The first bytes of the file, followed by the column table
+	struct FileHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t blockSize;
+		uint32_t columnCount;
+		double rate;
+		uint64_t startTime;  // Nanoseconds since 1970
+		uint64_t headerSize; // Offset of the first block
+		uint64_t blockCount; // Blocks written, updated after every block
+	};
+
+	// One entry of the column table
+	struct ColumnRecord {
+		uint64_t address;
+		uint32_t size;
+		uint32_t reserved;
+	};
+
+	// The first bytes of every block
+	struct BlockHeader {
+		uint32_t sampleCount;
+		uint32_t used;
+		uint64_t firstTimestamp;
+		uint64_t lastTimestamp;
+	};
+
+	// Longest varint of a 64-bit value
+	const size_t kMaxVarint = 10;
+
+	// Appends a value 7 bits at a time, the high bit marking that more bytes follow
+	uint8_t* PutVarint(uint8_t* out, uint64_t value) {
+		while (value >= 0x80) {
+			*out++ = (uint8_t)value | 0x80;
+			value >>= 7;
+		}
+		*out++ = (uint8_t)value;
+		return out;
+	}
+
+	// Reads a varint written by PutVarint, returning nullptr if it runs past end
+	const uint8_t* GetVarint(const uint8_t* in, const uint8_t* end, uint64_t& value) {
+		value = 0;
+		for (int shift = 0; in < end && shift < 64; shift += 7) {
+			uint8_t byte = *in++;
+			value |= (uint64_t)(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) {
+				return in;
+			}
+		}
+		return nullptr;
+	}
+
+	// Maps small positive and negative differences to small unsigned numbers: 0, -1, 1, -2, ...
+	uint64_t ZigZag(uint64_t difference) {
+		return (difference << 1) ^ (uint64_t)((int64_t)difference >> 63);
+	}
+
+	uint64_t UnZigZag(uint64_t value) {
+		return (value >> 1) ^ ((uint64_t)0 - (value & 1));
+	}
+
+	// Raises an atomic maximum
+	void RaiseMax(std::atomic<double>& maximum, double value) {
+		double current = maximum.load(std::memory_order_relaxed);
+		while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+		}
+	}
+}
+
+Recorder::Recorder(Memory& memory, const RecordOptions& options) : memory(memory), options(options) {
+}
+
+Recorder::~Recorder() {
+	this->Stop();
+}
+
+size_t Recorder::AddColumn(uintptr_t address, size_t size) {
+	if (this->running || size == 0 || size > sizeof(uint64_t)) {
+		return (size_t)-1;
+	}
+
+	RecordColumn column;
+	column.address = address;
+	column.size = size;
+	this->columns.push_back(column);
+	return this->columns.size() - 1;
+}
+
+const std::vector<RecordColumn>& Recorder::GetColumns() const {
+	return this->columns;
+}
+
+bool Recorder::Start(const std::string& path) {
+	if (this->running) {
+		this->errorMessage = "A recording is already running";
+		return false;
+	}
+	if (this->options.rate <= 0 || this->options.blockCount < 2) {
+		this->errorMessage = "Invalid recorder options";
+		return false;
+	}
+
+	// Every block must hold at least one sample of the worst case size
+	size_t bitmapSize = (this->columns.size() + 7) / 8;
+	size_t maxSample = kMaxVarint + bitmapSize + this->columns.size() * kMaxVarint;
+	this->options.blockSize = std::max(this->options.blockSize, sizeof(BlockHeader) + maxSample);
+	this->headerSize = (sizeof(FileHeader) + this->columns.size() * sizeof(ColumnRecord) + kHeaderAlignment - 1) / kHeaderAlignment * kHeaderAlignment;
+
+	size_t fileSize = std::max(this->options.maxFileSize, this->headerSize + this->options.blockSize);
+	if (!this->file.Create(path, fileSize)) {
+		this->errorMessage = "Failed to create " + path;
+		return false;
+	}
+	this->path = path;
+
+	FileHeader header = {};
+	std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+	header.version = kFileVersion;
+	header.blockSize = (uint32_t)this->options.blockSize;
+	header.columnCount = (uint32_t)this->columns.size();
+	header.rate = this->options.rate;
+	header.startTime = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	header.headerSize = this->headerSize;
+	std::memcpy(this->file.GetWritableData(), &header, sizeof(header));
+	for (size_t i = 0; i < this->columns.size(); ++i) {
+		ColumnRecord record = { this->columns[i].address, (uint32_t)this->columns[i].size, 0 };
+		std::memcpy(this->file.GetWritableData() + sizeof(header) + i * sizeof(record), &record, sizeof(record));
+	}
+
+	// Everything the sampler touches is allocated here, before the first sample
+	this->blocks.clear();
+	this->blocks.resize(this->options.blockCount);
+	this->freeBlocks.reset(new EventQueue<uint32_t>(this->options.blockCount));
+	this->fullBlocks.reset(new EventQueue<uint32_t>(this->options.blockCount));
+	for (uint32_t i = 0; i < (uint32_t)this->blocks.size(); ++i) {
+		this->blocks[i].data.reset(new uint8_t[this->options.blockSize]);
+		this->freeBlocks->TryPush(i);
+	}
+
+	// Merge the columns into spans in address order; the addresses are fixed, so this is done once
+	std::vector<size_t> columnIndices(this->columns.size());
+	for (size_t i = 0; i < this->columns.size(); ++i) {
+		columnIndices[i] = i;
+	}
+	this->spans.Build(columnIndices, [this](size_t index) { return std::make_pair(this->columns[index].address, this->columns[index].size); });
+
+	this->current.assign(this->columns.size(), 0);
+	this->previous.assign(this->columns.size(), 0);
+	this->blockIndex = (size_t)-1;
+	this->blocksWritten = 0;
+
+	this->sampleCount = 0;
+	this->missedTicks = 0;
+	this->droppedSamples = 0;
+	this->failedReads = 0;
+	this->writtenBlocks = 0;
+	this->maxSampleSeconds = 0;
+	this->maxLateSeconds = 0;
+
+	this->stopping = false;
+	this->samplerDone = false;
+	this->running = true;
+	this->writer = std::thread(&Recorder::RunWriter, this);
+	this->sampler = std::thread(&Recorder::RunSampler, this);
+	return true;
+}
+
+bool Recorder::Stop() {
+	if (!this->running) {
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->wake.notify_all();
+	this->sampler.join();
+
+	// The sampler submitted its last block before leaving, so the writer can drain the queue and exit
+	{
+		std::lock_guard<std::mutex> lock(this->writerMutex);
+		this->samplerDone = true;
+	}
+	this->writerWake.notify_one();
+	this->writer.join();
+	this->running = false;
+
+	// Cut the preallocated space that was not used
+	this->file.Flush();
+	this->file.Close();
+	std::error_code error;
+	std::filesystem::resize_file(this->path, this->headerSize + this->blocksWritten * this->options.blockSize, error);
+	if (error) {
+		this->errorMessage = "Failed to truncate " + this->path;
+		return false;
+	}
+	return true;
+}
+
+bool Recorder::IsRecording() const {
+	return this->running;
+}
+
+RecordStatistics Recorder::GetStatistics() const {
+	RecordStatistics statistics;
+	statistics.sampleCount = this->sampleCount;
+	statistics.missedTicks = this->missedTicks;
+	statistics.droppedSamples = this->droppedSamples;
+	statistics.failedReads = this->failedReads;
+	statistics.blockCount = this->writtenBlocks;
+	statistics.fileSize = this->headerSize + statistics.blockCount * this->options.blockSize;
+	statistics.maxSampleSeconds = this->maxSampleSeconds;
+	statistics.maxLateSeconds = this->maxLateSeconds;
+	return statistics;
+}
+
+const std::string& Recorder::GetErrorMessage() const {
+	return this->errorMessage;
+}
+
+void Recorder::RunSampler() {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	TickSchedule schedule(this->options.rate);
+	TickSchedule::Clock::time_point begin = schedule.GetDeadline();
+	while (schedule.Wait(lock, this->wake, [this] { return this->stopping; })) {
+		TickSchedule::Clock::time_point start = TickSchedule::Clock::now();
+		RaiseMax(this->maxLateSeconds, std::chrono::duration<double>(start - schedule.GetDeadline()).count());
+
+		this->Sample((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(start - begin).count());
+		RaiseMax(this->maxSampleSeconds, std::chrono::duration<double>(TickSchedule::Clock::now() - start).count());
+		this->missedTicks += schedule.Advance();
+	}
+
+	if (this->blockIndex != (size_t)-1) {
+		this->SubmitBlock();
+	}
+}
+
+void Recorder::Sample(uint64_t timestamp) {
+	size_t bitmapSize = (this->columns.size() + 7) / 8;
+	size_t maxSample = kMaxVarint + bitmapSize + this->columns.size() * kMaxVarint;
+
+	// Hand over a block that might not fit this sample and open a new one
+	if (this->blockIndex != (size_t)-1 && this->blocks[this->blockIndex].used + maxSample > this->options.blockSize) {
+		this->SubmitBlock();
+	}
+	if (this->blockIndex == (size_t)-1) {
+		uint32_t index = 0;
+		if (!this->freeBlocks->TryPop(index)) {
+			++this->droppedSamples;
+			return;
+		}
+
+		Block& block = this->blocks[index];
+		block.used = sizeof(BlockHeader);
+		block.sampleCount = 0;
+		block.firstTimestamp = timestamp;
+		block.lastTimestamp = timestamp;
+		this->blockIndex = index;
+	}
+
+	// A column that cannot be read keeps its last value
+	this->spans.Read(this->memory);
+	const std::vector<size_t>& order = this->spans.GetOrder();
+	for (size_t i = 0; i < this->spans.GetSpanCount(); ++i) {
+		const SpanBatch::Span& span = this->spans.GetSpan(i);
+		for (size_t j = span.first; j < span.last; ++j) {
+			size_t index = order[j];
+			if (!this->spans.IsRead(i)) {
+				this->current[index] = this->previous[index];
+				++this->failedReads;
+				continue;
+			}
+
+			const RecordColumn& column = this->columns[index];
+			uint64_t value = 0;
+			std::memcpy(&value, this->spans.GetBytes(i, column.address), column.size);
+			this->current[index] = value;
+		}
+	}
+
+	// The first sample of a block is encoded against zero, so blocks decode on their own
+	Block& block = this->blocks[this->blockIndex];
+	bool keyframe = block.sampleCount == 0;
+	uint8_t* out = PutVarint(block.data.get() + block.used, timestamp - block.lastTimestamp);
+	uint8_t* bitmap = out;
+	std::memset(bitmap, 0, bitmapSize);
+	out += bitmapSize;
+	for (size_t i = 0; i < this->current.size(); ++i) {
+		uint64_t reference = keyframe ? 0 : this->previous[i];
+		if (this->current[i] != reference) {
+			bitmap[i / 8] |= (uint8_t)(1 << (i % 8));
+			out = PutVarint(out, ZigZag(this->current[i] - reference));
+		}
+	}
+
+	block.used = out - block.data.get();
+	block.lastTimestamp = timestamp;
+	++block.sampleCount;
+	std::copy(this->current.begin(), this->current.end(), this->previous.begin());
+	++this->sampleCount;
+}
+
+void Recorder::SubmitBlock() {
+	Block& block = this->blocks[this->blockIndex];
+	BlockHeader header = { block.sampleCount, (uint32_t)block.used, block.firstTimestamp, block.lastTimestamp };
+	std::memcpy(block.data.get(), &header, sizeof(header));
+
+	// The full queue holds every block, so this cannot fail
+	this->fullBlocks->TryPush((uint32_t)this->blockIndex);
+	this->blockIndex = (size_t)-1;
+
+	// The writer holds its mutex only while it checks the queue, so this lock never waits on a write; taking it
+	// means the writer either has not checked yet or already sleeps, so the wake-up cannot be lost
+	{
+		std::lock_guard<std::mutex> lock(this->writerMutex);
+	}
+	this->writerWake.notify_one();
+}
+
+void Recorder::RunWriter() {
+	std::unique_lock<std::mutex> lock(this->writerMutex);
+	for (;;) {
+		// samplerDone is set after the last block was queued, so an empty queue then means the end
+		uint32_t index = 0;
+		bool popped = false;
+		this->writerWake.wait(lock, [&] { return (popped = this->fullBlocks->TryPop(index)) || this->samplerDone; });
+		if (!popped) {
+			return;
+		}
+
+		// The sampler may queue further blocks meanwhile, and never waits for this write
+		lock.unlock();
+		this->WriteBlock(index);
+		this->freeBlocks->TryPush(index);
+		lock.lock();
+	}
+}
+
+void Recorder::WriteBlock(uint32_t index) {
+	const Block& block = this->blocks[index];
+	size_t offset = this->headerSize + this->blocksWritten * this->options.blockSize;
+	if (offset + this->options.blockSize > this->file.GetSize()) {
+		this->droppedSamples += block.sampleCount;
+		return;
+	}
+
+	// The rest of the block stays zero from the preallocation; the count in the header follows the data
+	uint8_t* data = this->file.GetWritableData();
+	std::memcpy(data + offset, block.data.get(), block.used);
+	++this->blocksWritten;
+	uint64_t blockCount = this->blocksWritten;
+	std::memcpy(data + offsetof(FileHeader, blockCount), &blockCount, sizeof(blockCount));
+	this->writtenBlocks = this->blocksWritten;
+}
+
+bool RecordingReader::Open(const std::string& path) {
+	this->Close();
+
+	if (!this->file.Open(path)) {
+		this->errorMessage = "Failed to open " + path;
+		return false;
+	}
+
+	const uint8_t* data = this->file.GetData();
+	size_t size = this->file.GetSize();
+	FileHeader header = {};
+	if (size >= sizeof(header)) {
+		std::memcpy(&header, data, sizeof(header));
+	}
+	if (size < sizeof(header) || std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 || header.version != kFileVersion) {
+		this->Close();
+		this->errorMessage = path + " is not a recording";
+		return false;
+	}
+
+	// A recording that was not stopped may be longer than its block count says, but never shorter
+	if (header.headerSize < sizeof(header) + (uint64_t)header.columnCount * sizeof(ColumnRecord) || header.headerSize > size ||
+		header.blockSize < sizeof(BlockHeader) || header.blockCount > (size - header.headerSize) / header.blockSize) {
+		this->Close();
+		this->errorMessage = path + " is truncated";
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header.columnCount; ++i) {
+		ColumnRecord record;
+		std::memcpy(&record, data + sizeof(header) + i * sizeof(record), sizeof(record));
+		RecordColumn column;
+		column.address = (uintptr_t)record.address;
+		column.size = record.size;
+		this->columns.push_back(column);
+	}
+
+	for (uint64_t i = 0; i < header.blockCount; ++i) {
+		BlockInfo info;
+		BlockHeader blockHeader;
+		info.data = data + header.headerSize + i * header.blockSize;
+		std::memcpy(&blockHeader, info.data, sizeof(blockHeader));
+		if (blockHeader.used > header.blockSize || blockHeader.used < sizeof(BlockHeader)) {
+			this->Close();
+			this->errorMessage = path + " has a corrupt block";
+			return false;
+		}
+
+		info.used = blockHeader.used;
+		info.sampleCount = blockHeader.sampleCount;
+		info.firstTimestamp = blockHeader.firstTimestamp;
+		info.lastTimestamp = blockHeader.lastTimestamp;
+		this->blocks.push_back(info);
+		this->totalSamples += info.sampleCount;
+	}
+
+	this->rate = header.rate;
+	this->startTime = header.startTime;
+	this->values.assign(this->columns.size(), 0);
+	if (!this->blocks.empty()) {
+		this->EnterBlock(0);
+	}
+	return true;
+}
+
+void RecordingReader::Close() {
+	this->file.Close();
+	this->columns.clear();
+	this->blocks.clear();
+	this->values.clear();
+	this->rate = 0;
+	this->startTime = 0;
+	this->totalSamples = 0;
+	this->block = 0;
+	this->position = 0;
+	this->remaining = 0;
+	this->timestamp = 0;
+}
+
+const std::vector<RecordColumn>& RecordingReader::GetColumns() const {
+	return this->columns;
+}
+
+double RecordingReader::GetRate() const {
+	return this->rate;
+}
+
+uint64_t RecordingReader::GetStartTime() const {
+	return this->startTime;
+}
+
+size_t RecordingReader::GetSampleCount() const {
+	return this->totalSamples;
+}
+
+void RecordingReader::EnterBlock(size_t index) {
+	const BlockInfo& info = this->blocks[index];
+	this->block = index;
+	this->position = sizeof(BlockHeader);
+	this->remaining = info.sampleCount;
+	this->timestamp = info.firstTimestamp;
+}
+
+bool RecordingReader::Next() {
+	while (this->remaining == 0) {
+		if (this->block + 1 >= this->blocks.size()) {
+			return false;
+		}
+		this->EnterBlock(this->block + 1);
+	}
+
+	// The first sample of a block is relative to zero
+	const BlockInfo& info = this->blocks[this->block];
+	if (this->position == sizeof(BlockHeader)) {
+		std::fill(this->values.begin(), this->values.end(), 0);
+	}
+
+	const uint8_t* in = info.data + this->position;
+	const uint8_t* end = info.data + info.used;
+	size_t bitmapSize = (this->columns.size() + 7) / 8;
+	uint64_t delta = 0;
+	in = GetVarint(in, end, delta);
+	if (!in || (size_t)(end - in) < bitmapSize) {
+		this->errorMessage = "Corrupt sample in block " + std::to_string(this->block);
+		this->remaining = 0;
+		return false;
+	}
+	this->timestamp += delta;
+
+	const uint8_t* bitmap = in;
+	in += bitmapSize;
+	for (size_t i = 0; i < this->columns.size(); ++i) {
+		if (!(bitmap[i / 8] & (1 << (i % 8)))) {
+			continue;
+		}
+		in = GetVarint(in, end, delta);
+		if (!in) {
+			this->errorMessage = "Corrupt sample in block " + std::to_string(this->block);
+			this->remaining = 0;
+			return false;
+		}
+		this->values[i] += UnZigZag(delta);
+	}
+
+	this->position = in - info.data;
+	--this->remaining;
+	return true;
+}
+
+bool RecordingReader::Seek(uint64_t timestamp) {
+	// The first block that ends at or after the time holds the sample
+	auto found = std::lower_bound(this->blocks.begin(), this->blocks.end(), timestamp, [](const BlockInfo& info, uint64_t value) {
+		return info.lastTimestamp < value;
+	});
+	if (found == this->blocks.end()) {
+		if (!this->blocks.empty()) {
+			this->EnterBlock(this->blocks.size() - 1);
+			this->remaining = 0;
+		}
+		return false;
+	}
+
+	this->EnterBlock(found - this->blocks.begin());
+	while (this->Next()) {
+		if (this->timestamp >= timestamp) {
+			return true;
+		}
+	}
+	return false;
+}
+
+uint64_t RecordingReader::GetTimestamp() const {
+	return this->timestamp;
+}
+
+uint64_t RecordingReader::GetRawValue(size_t column) const {
+	return this->values[column];
+}
+
+const std::string& RecordingReader::GetErrorMessage() const {
+	return this->errorMessage;
+}
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "EventQueue.h"
+#include "MappedFile.h"
+#include "Memory.h"
+#include "SpanBatch.h"
+
+/**
+ * @brief Settings of a Recorder.
+ */
+struct RecordOptions {
+	double rate = 1000.0;                   // Samples per second
+	size_t blockSize = 0x10000;             // Bytes per block of the file, enlarged if one sample might not fit
+	size_t blockCount = 64;                 // Blocks kept in memory between the sampler and the writer
+	size_t maxFileSize = (size_t)1 << 30;   // Size the file is preallocated to; further samples are dropped once it is full
+};
+
+/**
+ * @brief Numbers describing a recording.
+ */
+struct RecordStatistics {
+	size_t sampleCount = 0;      // Samples taken
+	size_t missedTicks = 0;      // Samples skipped because a sample or the scheduler ran late
+	size_t droppedSamples = 0;   // Samples lost because no block was free or the file was full
+	size_t failedReads = 0;      // Column values that could not be read, summed over all samples
+	size_t blockCount = 0;       // Blocks written to the file
+	size_t fileSize = 0;         // Bytes of the file in use
+	double maxSampleSeconds = 0; // Longest time spent taking and encoding a sample
+	double maxLateSeconds = 0;   // Largest delay between the scheduled and the actual time of a sample
+};
+
+/**
+ * @brief One recorded column: the address sampled and the size of its value.
+ */
+struct RecordColumn {
+	uintptr_t address = 0;
+	size_t size = 0;
+};
+
+/**
+ * @brief Samples a fixed set of addresses at a high rate and streams them to a compact file.
+ *
+ * Columns are added before Start and may be up to 8 bytes. Every sample reads all columns with
+ * one ReadBatch call, columns lying close together sharing one element of it (see SpanBatch),
+ * and is encoded as the time since the previous sample, a bitmap of the columns that changed
+ * and the zigzag varint difference of every changed column, so an unchanged column costs one
+ * bit. Samples are appended to fixed-size blocks whose first sample is encoded against zero, so
+ * every block can be decoded on its own and RecordingReader seeks by time with a binary search
+ * over the block headers.
+ *
+ * The sampling thread fills blocks from a pool allocated by Start and hands full blocks to a
+ * writer thread through lock-free EventQueues, so it never touches the file, never allocates and
+ * never waits for a block to be written; handing over a block only wakes the sleeping writer.
+ * The writer copies the blocks into the preallocated, memory-mapped file. If it falls so far
+ * behind that no block is free, samples are dropped and counted instead.
+ *
+ * File layout: a header holding the settings and the column table, padded to a page, followed
+ * by the blocks. Each block starts with its sample count, its used bytes and the timestamps of
+ * its first and last sample. Stop shrinks the file to the blocks written.
+ */
+class Recorder {
+private:
+	// A block being filled by the sampler or waiting for the writer
+	struct Block {
+		std::unique_ptr<uint8_t[]> data;
+		size_t used = 0;
+		uint32_t sampleCount = 0;
+		uint64_t firstTimestamp = 0;
+		uint64_t lastTimestamp = 0;
+	};
+
+	// Memory instance attached to the target process
+	Memory& memory;
+
+	// Settings given at construction; blockSize is adjusted by Start
+	RecordOptions options;
+
+	// Columns to sample
+	std::vector<RecordColumn> columns;
+
+	// Output file and where the next block goes
+	MappedFile file;
+	std::string path;
+	size_t headerSize = 0;
+	size_t blocksWritten = 0;
+
+	// Block pool and the queues passing block indices between the threads
+	std::vector<Block> blocks;
+	std::unique_ptr<EventQueue<uint32_t>> freeBlocks;
+	std::unique_ptr<EventQueue<uint32_t>> fullBlocks;
+
+	// Sampler state: the spans the columns are read with, the values of the current and the previous sample and the open block
+	SpanBatch spans;
+	std::vector<uint64_t> current;
+	std::vector<uint64_t> previous;
+	size_t blockIndex = (size_t)-1;
+
+	// Threads and their stop flags; the mutex only wakes the sampler for Stop
+	std::thread sampler;
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+	bool running = false;
+
+	// Wakes the writer when a block is queued or the sampler is done; writerMutex guards samplerDone
+	std::mutex writerMutex;
+	std::condition_variable writerWake;
+	bool samplerDone = false;
+
+	// Counters updated by the threads while recording
+	std::atomic<size_t> sampleCount{ 0 };
+	std::atomic<size_t> missedTicks{ 0 };
+	std::atomic<size_t> droppedSamples{ 0 };
+	std::atomic<size_t> failedReads{ 0 };
+	std::atomic<size_t> writtenBlocks{ 0 };
+	std::atomic<double> maxSampleSeconds{ 0 };
+	std::atomic<double> maxLateSeconds{ 0 };
+
+	// Description of the last error
+	std::string errorMessage;
+
+	// Takes and encodes one sample
+	void Sample(uint64_t timestamp);
+
+	// Hands the open block to the writer
+	void SubmitBlock();
+
+	// Main loops of the two threads
+	void RunSampler();
+	void RunWriter();
+
+	// Copies a full block into the file
+	void WriteBlock(uint32_t index);
+
+public:
+	/**
+	 * @brief Creates a recorder for a target process.
+	 *
+	 * @param memory The Memory instance attached to the target, which must outlive the recorder.
+	 * @param options Settings of the recorder.
+	 */
+	explicit Recorder(Memory& memory, const RecordOptions& options = RecordOptions());
+
+	/**
+	 * @brief Stops a running recording.
+	 */
+	~Recorder();
+
+	Recorder(const Recorder&) = delete;
+	Recorder& operator=(const Recorder&) = delete;
+
+	/**
+	 * @brief Adds a column. Columns cannot be added while recording.
+	 *
+	 * @param address The address to sample.
+	 * @param size The size of the value, 1 to 8 bytes.
+	 * @return The index of the column, or (size_t)-1 if the size is invalid or a recording runs.
+	 */
+	size_t AddColumn(uintptr_t address, size_t size);
+
+	/**
+	 * @brief Adds a column sampling a value of type T.
+	 */
+	template <typename T>
+	size_t AddColumn(uintptr_t address) {
+		static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= sizeof(uint64_t), "Recorded values must be trivially copyable and at most 8 bytes");
+		return this->AddColumn(address, sizeof(T));
+	}
+
+	/**
+	 * @brief Returns the columns in the order they were added.
+	 */
+	const std::vector<RecordColumn>& GetColumns() const;
+
+	/**
+	 * @brief Creates the file and starts sampling.
+	 *
+	 * @param path The file to record to; an existing file is overwritten.
+	 * @return True if the recording started, false if the file could not be created or one already runs.
+	 */
+	bool Start(const std::string& path);
+
+	/**
+	 * @brief Stops sampling, writes the remaining blocks and closes the file.
+	 *
+	 * @return True if the file was completed, false if it could not be finished.
+	 */
+	bool Stop();
+
+	/**
+	 * @brief Returns true while recording.
+	 */
+	bool IsRecording() const;
+
+	/**
+	 * @brief Returns the numbers of the current or last recording.
+	 */
+	RecordStatistics GetStatistics() const;
+
+	/**
+	 * @brief Returns a description of the last error.
+	 */
+	const std::string& GetErrorMessage() const;
+};
+
+/**
+ * @brief Reads a file written by Recorder, sample by sample.
+ *
+ * The file is mapped, so opening it is immediate and Seek only decodes the block it lands in.
+ */
+class RecordingReader {
+private:
+	// Location and time range of one block
+	struct BlockInfo {
+		const uint8_t* data = nullptr;
+		size_t used = 0;
+		uint32_t sampleCount = 0;
+		uint64_t firstTimestamp = 0;
+		uint64_t lastTimestamp = 0;
+	};
+
+	MappedFile file;
+	std::vector<RecordColumn> columns;
+	std::vector<BlockInfo> blocks;
+	double rate = 0;
+	uint64_t startTime = 0;
+	size_t totalSamples = 0;
+
+	// Decoder position: the block, the byte in it and the samples left in it
+	size_t block = 0;
+	size_t position = 0;
+	uint32_t remaining = 0;
+
+	// The sample decoded last
+	uint64_t timestamp = 0;
+	std::vector<uint64_t> values;
+
+	// Description of the last error
+	std::string errorMessage;
+
+	// Positions the decoder at the start of a block
+	void EnterBlock(size_t index);
+
+public:
+	/**
+	 * @brief Opens a recording and positions it before its first sample.
+	 *
+	 * @param path The path of the file.
+	 * @return True if the file is a valid recording, false otherwise.
+	 */
+	bool Open(const std::string& path);
+
+	/**
+	 * @brief Closes the recording.
+	 */
+	void Close();
+
+	/**
+	 * @brief Returns the recorded columns.
+	 */
+	const std::vector<RecordColumn>& GetColumns() const;
+
+	/**
+	 * @brief Returns the sample rate the recording was made with.
+	 */
+	double GetRate() const;
+
+	/**
+	 * @brief Returns the start of the recording in nanoseconds since 1970.
+	 */
+	uint64_t GetStartTime() const;
+
+	/**
+	 * @brief Returns the number of samples in the file.
+	 */
+	size_t GetSampleCount() const;
+
+	/**
+	 * @brief Decodes the next sample.
+	 *
+	 * @return True if a sample was decoded, false at the end of the recording or on a corrupt block.
+	 */
+	bool Next();
+
+	/**
+	 * @brief Decodes the first sample taken at or after a point in time, making it the current sample.
+	 *
+	 * @param timestamp Nanoseconds since the start of the recording.
+	 * @return True if such a sample exists, false if the recording ends before it.
+	 */
+	bool Seek(uint64_t timestamp);
+
+	/**
+	 * @brief Returns the time of the current sample in nanoseconds since the start of the recording.
+	 */
+	uint64_t GetTimestamp() const;
+
+	/**
+	 * @brief Returns the raw value of a column in the current sample, zero-extended to 64 bits.
+	 */
+	uint64_t GetRawValue(size_t column) const;
+
+	/**
+	 * @brief Returns the value of a column in the current sample as the type it was recorded as.
+	 */
+	template <typename T>
+	T GetValue(size_t column) const {
+		T value;
+		uint64_t raw = this->GetRawValue(column);
+		std::memcpy(&value, &raw, sizeof(T));
+		return value;
+	}
+
+	/**
+	 * @brief Returns a description of the last error.
+	 */
+	const std::string& GetErrorMessage() const;
+};
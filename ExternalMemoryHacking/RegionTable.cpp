@@ -0,0 +1,113 @@
+#include "RegionTable.h"
+
+#include <algorithm>
+#include "Instrumentation.h"
+
+RegionTable::RegionTable(HANDLE process, std::chrono::milliseconds refreshInterval) : process(process), refreshInterval(refreshInterval) {
+}
+
+void RegionTable::Reset(HANDLE process) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->process = process;
+	this->intervals.clear();
+	this->stale = true;
+	this->refreshed = false;
+	this->statistics.intervals = 0;
+}
+
+void RegionTable::SetRefreshInterval(std::chrono::milliseconds refreshInterval) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->refreshInterval = refreshInterval;
+}
+
+bool RegionTable::Contains(uintptr_t address, size_t size) const {
+	// The last interval starting at or before the address is the only one that can hold it
+	auto next = std::upper_bound(this->intervals.begin(), this->intervals.end(), address,
+		[](uintptr_t value, const Interval& interval) { return value < interval.start; });
+	if (next == this->intervals.begin()) {
+		return false;
+	}
+
+	const Interval& interval = *(next - 1);
+	return address < interval.end && size <= interval.end - address;
+}
+
+bool RegionTable::RefreshIfDue() {
+	auto now = std::chrono::steady_clock::now();
+	if (this->refreshed && now - this->lastRefresh < this->refreshInterval) {
+		return false;
+	}
+
+	MEMORY_PROBE_START(start);
+	std::vector<MemoryRegion> regions = this->process ? Platform::EnumerateRegions(this->process) : std::vector<MemoryRegion>();
+	MEMORY_PROBE_END(start, Probe::RegionEnumeration, !regions.empty(), 0);
+
+	// Merge adjacent regions, so reads spanning two mappings with different protections pass
+	this->intervals.clear();
+	for (const MemoryRegion& region : regions) {
+		if (!this->intervals.empty() && this->intervals.back().end == region.base) {
+			this->intervals.back().end += region.size;
+		}
+		else {
+			Interval interval;
+			interval.start = region.base;
+			interval.end = region.base + region.size;
+			this->intervals.push_back(interval);
+		}
+	}
+
+	this->stale = false;
+	this->refreshed = true;
+	this->lastRefresh = now;
+	++this->statistics.refreshes;
+	this->statistics.intervals = this->intervals.size();
+	return true;
+}
+
+bool RegionTable::Refresh() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->refreshed = false;
+	this->RefreshIfDue();
+	return !this->intervals.empty();
+}
+
+bool RegionTable::Check(uintptr_t address, size_t size) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	++this->statistics.checks;
+
+	// Null, small integers and kernel addresses never become readable, so they need no lookup
+	if (address < kLowestAddress || address > kHighestAddress || size > kHighestAddress - address + 1) {
+		++this->statistics.avoided;
+		return false;
+	}
+
+	if (this->stale) {
+		this->RefreshIfDue();
+	}
+
+	// On a miss the target may have mapped the region since the last refresh
+	if (this->Contains(address, size) || (this->RefreshIfDue() && this->Contains(address, size))) {
+		return true;
+	}
+
+	++this->statistics.avoided;
+	return false;
+}
+
+void RegionTable::MarkStale() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->stale = true;
+	++this->statistics.staleReads;
+}
+
+RegionTableStatistics RegionTable::GetStatistics() const {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->statistics;
+}
+
+void RegionTable::ResetStatistics() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	size_t intervals = this->statistics.intervals;
+	this->statistics = RegionTableStatistics();
+	this->statistics.intervals = intervals;
+}
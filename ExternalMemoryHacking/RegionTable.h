@@ -0,0 +1,141 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "Platform.h"
+
+/**
+ * @brief Counters of a RegionTable since it was created or its statistics were reset.
+ */
+struct RegionTableStatistics {
+	size_t checks = 0;      // Addresses checked before a read
+	size_t avoided = 0;     // Checks that failed, each one a read syscall that was never made
+	size_t refreshes = 0;   // Times the regions were enumerated again
+	size_t staleReads = 0;  // Reads the table allowed that failed, because the region went away since
+	size_t intervals = 0;   // Readable address ranges currently held
+
+	/**
+	 * @brief Returns the share of checks that saved a syscall, between 0 and 1.
+	 */
+	double GetAvoidedRate() const {
+		return this->checks ? (double)this->avoided / this->checks : 0;
+	}
+};
+
+/**
+ * @brief A sorted table of the readable address ranges of a target process.
+ *
+ * While a target is loading, or after it freed an object, pointer chains run into null,
+ * small integers, kernel-space values and addresses of regions that no longer exist. Each of
+ * those reads still costs a failing syscall. Check answers them from a local copy of the
+ * region list with a binary search instead, so only reads that can succeed reach the target.
+ *
+ * Addresses below kLowestAddress or above kHighestAddress are rejected without a lookup. The
+ * table is enumerated on the first check and refreshed lazily:
+ * - when a check misses, since the target may have mapped the region since the last refresh;
+ * - on the next check after MarkStale, which callers use when a read the table allowed failed.
+ * Refreshes are at least the refresh interval apart, so a chain that keeps failing does not
+ * enumerate the regions on every hop; within that interval a freshly mapped region may be
+ * reported as unreadable.
+ *
+ * The table is safe to use from several threads.
+ */
+class RegionTable {
+public:
+	// Addresses below this are never mapped, which rejects null and small integers without a lookup
+	static const uintptr_t kLowestAddress = 0x10000;
+
+	// Addresses above this are kernel space or not canonical
+	static const uintptr_t kHighestAddress = sizeof(uintptr_t) == 8 ? (uintptr_t)0x00007FFFFFFFFFFF : (uintptr_t)0xFFFFFFFF;
+
+private:
+	// One range of readable addresses, adjacent regions merged
+	struct Interval {
+		uintptr_t start = 0;
+		uintptr_t end = 0;
+	};
+
+	// Process the table describes
+	HANDLE process = nullptr;
+
+	// Readable ranges in ascending address order
+	std::vector<Interval> intervals;
+
+	// Set by MarkStale, cleared by the next refresh
+	bool stale = true;
+
+	// Whether the table was enumerated at least once since Reset
+	bool refreshed = false;
+
+	// Time of the last refresh, and the minimum time between two refreshes
+	std::chrono::steady_clock::time_point lastRefresh;
+	std::chrono::steady_clock::duration refreshInterval;
+
+	// Counters reported by GetStatistics
+	RegionTableStatistics statistics;
+
+	// Guards all members, since Memory may be shared by several threads
+	mutable std::mutex mutex;
+
+	// Returns true if [address, address + size) lies inside one interval
+	bool Contains(uintptr_t address, size_t size) const;
+
+	// Enumerates the regions again if the last refresh is at least the refresh interval ago
+	bool RefreshIfDue();
+
+public:
+	/**
+	 * @brief Creates a table for a process. Nothing is enumerated before the first check.
+	 *
+	 * @param process Handle to the target process, may be nullptr until Reset.
+	 * @param refreshInterval The minimum time between two refreshes, 100 ms by default.
+	 */
+	explicit RegionTable(HANDLE process = nullptr, std::chrono::milliseconds refreshInterval = std::chrono::milliseconds(100));
+
+	/**
+	 * @brief Drops the table and describes another process, e.g. after attaching again.
+	 */
+	void Reset(HANDLE process);
+
+	/**
+	 * @brief Sets the minimum time between two refreshes.
+	 */
+	void SetRefreshInterval(std::chrono::milliseconds refreshInterval);
+
+	/**
+	 * @brief Enumerates the readable regions of the process now, regardless of the refresh interval.
+	 *
+	 * @return True if the process has at least one readable region.
+	 */
+	bool Refresh();
+
+	/**
+	 * @brief Returns true if a read of size bytes at address may succeed.
+	 *
+	 * A miss refreshes the table first if a refresh is due, so a region the target mapped since
+	 * the last refresh is found. A false result means the read would fail and can be skipped.
+	 *
+	 * @param address The first address to read.
+	 * @param size The number of bytes to read.
+	 * @return True if the whole range is in readable regions, false otherwise.
+	 */
+	bool Check(uintptr_t address, size_t size);
+
+	/**
+	 * @brief Reports that a read the table allowed failed, so the table is refreshed on the next check.
+	 */
+	void MarkStale();
+
+	/**
+	 * @brief Returns the check, avoided syscall and refresh counters.
+	 */
+	RegionTableStatistics GetStatistics() const;
+
+	/**
+	 * @brief Sets all counters back to 0.
+	 */
+	void ResetStatistics();
+};
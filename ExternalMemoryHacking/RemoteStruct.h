@@ -0,0 +1,331 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "MemoryReader.h"
+
+/**
+ * @brief A field of a remote structure: its offset from the start of the object and its type.
+ *
+ * Fields are declared as named types, so they can be used to access the value later:
+ *
+ *     struct Health : RemoteField<0xEC, int> {};
+ *     struct Position : RemoteField<0x28, Vector3> {};
+ */
+template <size_t Offset, typename T>
+struct RemoteField {
+	static_assert(std::is_trivially_copyable<T>::value, "Remote fields must be trivially copyable");
+
+	using Type = T;
+	static constexpr size_t kOffset = Offset;
+	static constexpr size_t kSize = sizeof(T);
+};
+
+/**
+ * @brief A field holding a pointer to another remote structure, followed with RemoteArray::Follow.
+ *
+ *     struct CurrentWeapon : RemotePointer<0x374, Weapon> {};
+ *
+ * The target layout only has to be complete where the pointer is followed, so a layout can
+ * point to itself, as in a linked list.
+ */
+template <size_t Offset, typename Layout>
+struct RemotePointer : RemoteField<Offset, uintptr_t> {
+	using Target = Layout;
+};
+
+/**
+ * @brief A byte range of a remote object that is read as one piece.
+ */
+struct RemoteRange {
+	size_t begin = 0; // First byte, relative to the object
+	size_t end = 0;   // One past the last byte, relative to the object
+	size_t local = 0; // Position of the range in the local buffer of the object
+};
+
+namespace RemoteLayoutDetail {
+	// Fields at most this many bytes apart are read as one range; copying the gap is cheaper than another batch element
+	constexpr size_t kMaxGap = 256;
+
+	// The ranges of a layout with up to N fields
+	template <size_t N>
+	struct Ranges {
+		std::array<RemoteRange, N> ranges = {};
+		size_t count = 0;
+		size_t bufferSize = 0;
+	};
+
+	// Sorts the fields by offset and merges neighbours into as few ranges as possible
+	template <typename... Fields>
+	constexpr Ranges<sizeof...(Fields)> Compute() {
+		Ranges<sizeof...(Fields)> result;
+		std::array<RemoteRange, sizeof...(Fields)> fields = { RemoteRange{ Fields::kOffset, Fields::kOffset + Fields::kSize, 0 }... };
+		for (size_t i = 1; i < fields.size(); ++i) {
+			for (size_t j = i; j > 0 && fields[j].begin < fields[j - 1].begin; --j) {
+				RemoteRange swap = fields[j];
+				fields[j] = fields[j - 1];
+				fields[j - 1] = swap;
+			}
+		}
+
+		for (size_t i = 0; i < fields.size(); ++i) {
+			if (result.count && fields[i].begin <= result.ranges[result.count - 1].end + kMaxGap) {
+				RemoteRange& last = result.ranges[result.count - 1];
+				last.end = fields[i].end > last.end ? fields[i].end : last.end;
+				continue;
+			}
+			result.ranges[result.count++] = fields[i];
+		}
+
+		for (size_t i = 0; i < result.count; ++i) {
+			result.ranges[i].local = result.bufferSize;
+			result.bufferSize += result.ranges[i].end - result.ranges[i].begin;
+		}
+		return result;
+	}
+}
+
+/**
+ * @brief The layout of a remote structure, made of RemoteField and RemotePointer types.
+ *
+ * The covering byte ranges are worked out at compile time: the fields are sorted by offset and
+ * fields close to each other share a range, so an object with a few fields far apart is not
+ * read as one large block, and an object whose fields are close together is read with one copy.
+ *
+ *     struct Player : RemoteLayout<Health, Position, CurrentWeapon> {};
+ */
+template <typename... Fields>
+struct RemoteLayout {
+	static_assert(sizeof...(Fields) > 0, "A remote layout needs at least one field");
+
+private:
+	static constexpr RemoteLayoutDetail::Ranges<sizeof...(Fields)> kRanges = RemoteLayoutDetail::Compute<Fields...>();
+
+public:
+	// Number of ranges read per object
+	static constexpr size_t kRangeCount = kRanges.count;
+
+	// Bytes of the local copy of an object
+	static constexpr size_t kBufferSize = kRanges.bufferSize;
+
+	/**
+	 * @brief Returns true if the field is part of the layout.
+	 */
+	template <typename Field>
+	static constexpr bool Contains() {
+		return (std::is_same<Field, Fields>::value || ...);
+	}
+
+	/**
+	 * @brief Returns a range read for every object.
+	 */
+	static constexpr RemoteRange GetRange(size_t index) {
+		return kRanges.ranges[index];
+	}
+
+	/**
+	 * @brief Returns the position of a field in the local copy of an object.
+	 */
+	template <typename Field>
+	static constexpr size_t GetLocalOffset() {
+		for (size_t i = 0; i < kRanges.count; ++i) {
+			if (Field::kOffset >= kRanges.ranges[i].begin && Field::kOffset + Field::kSize <= kRanges.ranges[i].end) {
+				return kRanges.ranges[i].local + (Field::kOffset - kRanges.ranges[i].begin);
+			}
+		}
+		return 0;
+	}
+};
+
+/**
+ * @brief A local copy of one remote object, holding only the ranges its layout needs.
+ */
+template <typename Layout>
+class RemoteObject {
+private:
+	// Address of the object in the target, 0 if none
+	uintptr_t address = 0;
+
+	// Set if every range was read
+	bool valid = false;
+
+	// The ranges of the object, one after another
+	uint8_t data[Layout::kBufferSize] = {};
+
+	template <typename>
+	friend class RemoteArray;
+
+public:
+	/**
+	 * @brief Reads an object; objects with one range cost one read, others one batch.
+	 *
+	 * For many objects of the same layout, RemoteArray reads them all with one batch.
+	 *
+	 * @param reader The Memory instance or capture to read from.
+	 * @param address The address of the object.
+	 * @return True if the whole object was read, false otherwise.
+	 */
+	bool Read(MemoryReader& reader, uintptr_t address) {
+		this->address = address;
+		if (Layout::kRangeCount == 1) {
+			this->valid = address && reader.ReadMemory(address + Layout::GetRange(0).begin, this->data, Layout::kBufferSize);
+			return this->valid;
+		}
+
+		std::vector<BatchEntry> batch(Layout::kRangeCount);
+		for (size_t i = 0; i < Layout::kRangeCount; ++i) {
+			batch[i].address = address + Layout::GetRange(i).begin;
+			batch[i].buffer = this->data + Layout::GetRange(i).local;
+			batch[i].size = Layout::GetRange(i).end - Layout::GetRange(i).begin;
+		}
+		this->valid = address && reader.ReadBatch(batch);
+		return this->valid;
+	}
+
+	/**
+	 * @brief Returns the value of a field from the local copy.
+	 */
+	template <typename Field>
+	typename Field::Type Get() const {
+		static_assert(Layout::template Contains<Field>(), "The field is not part of this layout");
+		typename Field::Type value;
+		std::memcpy(&value, this->data + Layout::template GetLocalOffset<Field>(), sizeof(value));
+		return value;
+	}
+
+	/**
+	 * @brief Returns the address the object was read from.
+	 */
+	uintptr_t GetAddress() const {
+		return this->address;
+	}
+
+	/**
+	 * @brief Returns true if every field of the object was read.
+	 */
+	bool IsValid() const {
+		return this->valid;
+	}
+};
+
+/**
+ * @brief Many remote objects of one layout, read together with a single ReadBatch call.
+ *
+ * Every object adds Layout::kRangeCount elements to the batch, which the platform layer submits
+ * as one vectored read on Linux, so 64 entities cost one system call instead of one per field.
+ * Follow reads the objects a pointer field of another array points to, so an entity list, the
+ * entities and their weapons take three calls. The objects and the batch are kept between
+ * reads, so reading the same number of objects every tick does not allocate.
+ */
+template <typename Layout>
+class RemoteArray {
+private:
+	std::vector<RemoteObject<Layout>> objects;
+	std::vector<BatchEntry> batch;
+	std::vector<uintptr_t> addresses;
+
+	// Reads an object at every address in addresses, skipping null pointers
+	size_t ReadAddresses(MemoryReader& reader) {
+		this->objects.resize(this->addresses.size());
+		this->batch.clear();
+		for (size_t i = 0; i < this->addresses.size(); ++i) {
+			RemoteObject<Layout>& object = this->objects[i];
+			object.address = this->addresses[i];
+			object.valid = false;
+			if (!object.address) {
+				continue;
+			}
+
+			for (size_t j = 0; j < Layout::kRangeCount; ++j) {
+				BatchEntry entry;
+				entry.address = object.address + Layout::GetRange(j).begin;
+				entry.buffer = object.data + Layout::GetRange(j).local;
+				entry.size = Layout::GetRange(j).end - Layout::GetRange(j).begin;
+				this->batch.push_back(entry);
+			}
+		}
+
+		if (!this->batch.empty()) {
+			reader.ReadBatch(this->batch);
+		}
+
+		// An object is valid if all of its ranges were read; the entries are in object order
+		size_t valid = 0;
+		const BatchEntry* entry = this->batch.data();
+		for (RemoteObject<Layout>& object : this->objects) {
+			if (!object.address) {
+				continue;
+			}
+
+			object.valid = true;
+			for (size_t j = 0; j < Layout::kRangeCount; ++j, ++entry) {
+				object.valid &= entry->success;
+			}
+			valid += object.valid;
+		}
+		return valid;
+	}
+
+public:
+	/**
+	 * @brief Reads the objects at a list of addresses; null addresses give invalid objects.
+	 *
+	 * @return The number of objects read completely.
+	 */
+	size_t Read(MemoryReader& reader, const std::vector<uintptr_t>& addresses) {
+		this->addresses.assign(addresses.begin(), addresses.end());
+		return this->ReadAddresses(reader);
+	}
+
+	/**
+	 * @brief Reads objects stored one after another, such as an inline array of structures.
+	 *
+	 * @param reader The Memory instance or capture to read from.
+	 * @param address The address of the first object.
+	 * @param count The number of objects.
+	 * @param stride The distance between two objects in bytes.
+	 * @return The number of objects read completely.
+	 */
+	size_t ReadContiguous(MemoryReader& reader, uintptr_t address, size_t count, size_t stride) {
+		this->addresses.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			this->addresses[i] = address + i * stride;
+		}
+		return this->ReadAddresses(reader);
+	}
+
+	/**
+	 * @brief Reads the objects a pointer field of another array points to, one object per source.
+	 *
+	 * Sources that are invalid or hold a null pointer give invalid objects, so indices line up.
+	 *
+	 * @return The number of objects read completely.
+	 */
+	template <typename Field, typename Source>
+	size_t Follow(MemoryReader& reader, const RemoteArray<Source>& sources) {
+		static_assert(std::is_same<typename Field::Target, Layout>::value, "The pointer field does not point to this layout");
+		this->addresses.resize(sources.GetCount());
+		for (size_t i = 0; i < sources.GetCount(); ++i) {
+			this->addresses[i] = sources[i].IsValid() ? sources[i].template Get<Field>() : 0;
+		}
+		return this->ReadAddresses(reader);
+	}
+
+	/**
+	 * @brief Returns the number of objects of the last read.
+	 */
+	size_t GetCount() const {
+		return this->objects.size();
+	}
+
+	/**
+	 * @brief Returns an object of the last read.
+	 */
+	const RemoteObject<Layout>& operator[](size_t index) const {
+		return this->objects[index];
+	}
+};
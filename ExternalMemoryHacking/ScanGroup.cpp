@@ -0,0 +1,97 @@
+#include "ScanGroup.h"
+
+#include <algorithm>
+
+namespace {
+	// Pointer values below this address are never valid, which keeps zero and small integers out of the prefilter
+	const uintptr_t kLowestPointer = 0x10000;
+
+	// Integer type the scan kernels use for a pointer of the target
+	typedef std::conditional<sizeof(uintptr_t) == 8, uint64_t, uint32_t>::type PointerValue;
+
+	// Pointers are prefiltered by the range of user space addresses and then looked up in the regions
+	bool MatchesPointer(const ScanGroup::Field& /*field*/, const uint8_t* data) {
+		PointerValue value;
+		std::memcpy(&value, data, sizeof(value));
+		return value >= kLowestPointer;
+	}
+
+	void FindPointers(const ScanGroup::Field& /*field*/, const ScanInput& input, std::vector<uint32_t>& offsets, SimdLevel level) {
+		ScanKernel<PointerValue>::Find(ScanPredicate<PointerValue>::Between((PointerValue)kLowestPointer, ~(PointerValue)0), input, offsets, level);
+	}
+
+	// Returns the region holding an address, or nullptr
+	const MemoryRegion* FindRegion(const std::vector<MemoryRegion>& regions, uintptr_t address) {
+		auto next = std::upper_bound(regions.begin(), regions.end(), address,
+			[](uintptr_t value, const MemoryRegion& region) { return value < region.base; });
+		if (next == regions.begin()) {
+			return nullptr;
+		}
+
+		const MemoryRegion& region = *(next - 1);
+		return address - region.base < region.size ? &region : nullptr;
+	}
+}
+
+void ScanGroup::AddField(const Field& field) {
+	this->fields.push_back(field);
+	this->extent = std::max(this->extent, field.offset + field.size);
+	this->alignment = std::max(this->alignment, field.size);
+
+	// Keep the fields ordered by hit rate, earlier fields first among equals
+	this->order.push_back(this->fields.size() - 1);
+	std::stable_sort(this->order.begin(), this->order.end(),
+		[this](size_t left, size_t right) { return this->fields[left].hitRate < this->fields[right].hitRate; });
+}
+
+ScanGroup& ScanGroup::AddPointer(size_t offset, bool heapOnly) {
+	Field field;
+	field.offset = offset;
+	field.size = sizeof(uintptr_t);
+	field.pointer = true;
+	field.heapOnly = heapOnly;
+	field.hitRate = kPointerHitRate;
+	field.matches = &MatchesPointer;
+	field.find = &FindPointers;
+	this->AddField(field);
+	return *this;
+}
+
+size_t ScanGroup::GetCount() const {
+	return this->fields.size();
+}
+
+const ScanGroup::Field& ScanGroup::GetField(size_t index) const {
+	return this->fields[index];
+}
+
+const ScanGroup::Field& ScanGroup::GetAnchor() const {
+	return this->fields[this->order.front()];
+}
+
+size_t ScanGroup::GetExtent() const {
+	return this->extent;
+}
+
+size_t ScanGroup::GetAlignment() const {
+	return this->alignment;
+}
+
+bool ScanGroup::Matches(const uint8_t* data, const std::vector<MemoryRegion>& regions) const {
+	for (size_t index : this->order) {
+		const Field& field = this->fields[index];
+		if (!field.matches(field, data + field.offset)) {
+			return false;
+		}
+
+		if (field.pointer) {
+			uintptr_t value;
+			std::memcpy(&value, data + field.offset, sizeof(value));
+			const MemoryRegion* region = FindRegion(regions, value);
+			if (!region || (field.heapOnly && (!region->writable || region->image))) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "Platform.h"
+#include "ScanKernels.h"
+
+/**
+ * @brief A set of conditions on the fields of a structure, found together by Scanner::GroupScan.
+ *
+ * Every field is a typed predicate at an offset from the start of the structure, or a pointer
+ * that has to point into a readable region of the target:
+ *
+ *     ScanGroup group;
+ *     group.Add<int32_t>(0x0, 100);                                // health == 100
+ *     group.Add(0x8, ScanPredicate<float>::Between(0.0f, 1.0f));  // 0 <= x <= 1
+ *     group.AddPointer(0x10);                                      // points into the heap
+ *
+ * A single value such as 100 occurs millions of times in a large process, but all fields of a
+ * group rarely hold their values at the right distances by chance, so a group scan returns the
+ * structure itself instead of a candidate list to narrow by hand.
+ *
+ * Each field gets an estimated hit rate, the share of random memory it is expected to match:
+ * equality with a value other than zero is rare, ranges less so, and anything that accepts
+ * zero is assumed to match very often because most memory is zero. The field with the lowest
+ * rate anchors the scan and is searched with the SIMD kernel of its type; the other fields are
+ * checked at each anchor hit, rarest first, so most hits are rejected by the first check.
+ */
+class ScanGroup {
+public:
+	/**
+	 * @brief One condition of a group, with its type erased.
+	 */
+	struct Field {
+		size_t offset = 0;                         // Distance from the start of the structure
+		size_t size = 0;                           // Size of the value in bytes
+		ScanCompare compare = ScanCompare::Equal;  // Comparison of the predicate
+		uint64_t first = 0;                        // Bytes of the predicate's first value
+		uint64_t second = 0;                       // Bytes of the predicate's second value
+		bool pointer = false;                      // Set for pointer fields, checked against the regions
+		bool heapOnly = false;                     // Pointer fields: only writable regions not mapped from a file count
+		double hitRate = 1;                        // Estimated share of random memory the field matches
+
+		// Tests the value at data, and searches a buffer for candidates with the kernel of the field's type
+		bool (*matches)(const Field& field, const uint8_t* data) = nullptr;
+		void (*find)(const Field& field, const ScanInput& input, std::vector<uint32_t>& offsets, SimdLevel level) = nullptr;
+	};
+
+private:
+	// The fields in the order they were added
+	std::vector<Field> fields;
+
+	// Field indices by ascending hit rate; the first is the anchor
+	std::vector<size_t> order;
+
+	// Bytes from the start of the structure to the end of its last field
+	size_t extent = 0;
+
+	// Largest natural alignment of a field
+	size_t alignment = 1;
+
+	// Restores the typed predicate of a field
+	template <typename T>
+	static ScanPredicate<T> GetPredicate(const Field& field) {
+		ScanPredicate<T> predicate;
+		predicate.compare = field.compare;
+		std::memcpy(&predicate.first, &field.first, sizeof(T));
+		std::memcpy(&predicate.second, &field.second, sizeof(T));
+		return predicate;
+	}
+
+	template <typename T>
+	static bool MatchesValue(const Field& field, const uint8_t* data) {
+		T value;
+		std::memcpy(&value, data, sizeof(T));
+		return GetPredicate<T>(field).Matches(value);
+	}
+
+	template <typename T>
+	static void FindValues(const Field& field, const ScanInput& input, std::vector<uint32_t>& offsets, SimdLevel level) {
+		ScanKernel<T>::Find(GetPredicate<T>(field), input, offsets, level);
+	}
+
+	// Returns the estimated share of random memory a predicate matches
+	template <typename T>
+	static double EstimateHitRate(const ScanPredicate<T>& predicate) {
+		if (predicate.Matches(T())) {
+			return kZeroHitRate;
+		}
+
+		if (predicate.compare == ScanCompare::Equal) {
+			return sizeof(T) == 1 ? 1.0 / 256 : kEqualHitRate;
+		}
+
+		if constexpr (std::is_integral<T>::value) {
+			// Every value of a range adds to the rate, as if all of them were as common as a rare exact value
+			double width = (double)predicate.second - (double)predicate.first + 1;
+			double rate = sizeof(T) == 1 ? width / 256 : width * kEqualHitRate;
+			return rate < kRangeHitRate ? rate : kRangeHitRate;
+		}
+		else {
+			return kRangeHitRate;
+		}
+	}
+
+	// Adds a field and keeps the order and the extent up to date
+	void AddField(const Field& field);
+
+public:
+	// Estimated hit rates of fields accepting zero, of equality with another value, of ranges and of pointers
+	static constexpr double kZeroHitRate = 0.3;
+	static constexpr double kEqualHitRate = 1e-5;
+	static constexpr double kRangeHitRate = 0.01;
+	static constexpr double kPointerHitRate = 0.05;
+
+	/**
+	 * @brief Adds a field holding a value that matches a predicate.
+	 *
+	 * @tparam T One of the 8 to 64-bit integers, float or double.
+	 * @param offset The distance of the field from the start of the structure.
+	 * @param predicate The condition the value has to match.
+	 * @return The group, so fields can be chained.
+	 */
+	template <typename T>
+	ScanGroup& Add(size_t offset, const ScanPredicate<T>& predicate) {
+		static_assert(std::is_arithmetic<T>::value && sizeof(T) <= 8, "Group fields support 8 to 64-bit integers, float and double");
+		Field field;
+		field.offset = offset;
+		field.size = sizeof(T);
+		field.compare = predicate.compare;
+		std::memcpy(&field.first, &predicate.first, sizeof(T));
+		std::memcpy(&field.second, &predicate.second, sizeof(T));
+		field.hitRate = EstimateHitRate(predicate);
+		field.matches = &MatchesValue<T>;
+		field.find = &FindValues<T>;
+		this->AddField(field);
+		return *this;
+	}
+
+	/**
+	 * @brief Adds a field holding exactly a value.
+	 */
+	template <typename T>
+	ScanGroup& Add(size_t offset, T value) {
+		return this->Add(offset, ScanPredicate<T>::Equal(value));
+	}
+
+	/**
+	 * @brief Adds a field holding a pointer into a readable region of the target.
+	 *
+	 * @param offset The distance of the field from the start of the structure.
+	 * @param heapOnly If true, the pointer has to point into a writable region that is not mapped
+	 *        from a module or other file, such as the heap.
+	 * @return The group, so fields can be chained.
+	 */
+	ScanGroup& AddPointer(size_t offset, bool heapOnly = true);
+
+	/**
+	 * @brief Returns the number of fields.
+	 */
+	size_t GetCount() const;
+
+	/**
+	 * @brief Returns a field by the index it was added with.
+	 */
+	const Field& GetField(size_t index) const;
+
+	/**
+	 * @brief Returns the field with the lowest estimated hit rate, which the scan searches for.
+	 */
+	const Field& GetAnchor() const;
+
+	/**
+	 * @brief Returns the bytes from the start of the structure to the end of its last field.
+	 */
+	size_t GetExtent() const;
+
+	/**
+	 * @brief Returns the largest natural alignment of a field, the default alignment of structure addresses.
+	 */
+	size_t GetAlignment() const;
+
+	/**
+	 * @brief Tests every field of a local copy of a structure, rarest first.
+	 *
+	 * @param data The copy of the structure; GetExtent() bytes must be readable.
+	 * @param regions The readable regions of the target in ascending address order, for pointer fields.
+	 * @return True if every field matches.
+	 */
+	bool Matches(const uint8_t* data, const std::vector<MemoryRegion>& regions) const;
+};
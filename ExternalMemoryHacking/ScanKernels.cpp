@@ -0,0 +1,172 @@
+#include "ScanKernels.h"
+#include "ScanKernelsSimd.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+	// Candidate bytes handed to a vector kernel per call, which bounds its output to this many offsets
+	const size_t kSliceBytes = 4096;
+
+	SimdLevel DetectSimdLevel() {
+#if defined(_M_X64) || defined(_M_IX86)
+		int info[4];
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		bool sse42 = (info[2] & (1 << 20)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+
+		// AVX state must also be enabled by the operating system (XCR0 bits 1 and 2)
+		bool avx2 = false;
+		if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 6) == 6) {
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		return avx2 ? SimdLevel::AVX2 : sse42 ? SimdLevel::SSE42 : SimdLevel::Scalar;
+#elif defined(__x86_64__) || defined(__i386__)
+		// The GCC/Clang builtins also check that the operating system saves AVX state
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") ? SimdLevel::AVX2
+			: __builtin_cpu_supports("sse4.2") ? SimdLevel::SSE42 : SimdLevel::Scalar;
+#else
+		return SimdLevel::Scalar;
+#endif
+	}
+
+	// Tests the candidates from offset to the end of the input one element at a time
+	template <typename T>
+	void FindScalar(const ScanPredicate<T>& predicate, const ScanInput& input, size_t offset, std::vector<uint32_t>& offsets) {
+		for (; offset < input.limit && offset + sizeof(T) <= input.size; offset += input.stride) {
+			T value;
+			std::memcpy(&value, input.data + offset, sizeof(T));
+			if (predicate.Matches(value)) {
+				offsets.push_back((uint32_t)offset);
+			}
+		}
+	}
+}
+
+SimdLevel GetSimdLevel() {
+	static const SimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+const char* GetSimdLevelName(SimdLevel level) {
+	switch (level) {
+	case SimdLevel::AVX2:
+		return "AVX2";
+	case SimdLevel::SSE42:
+		return "SSE4.2";
+	default:
+		return "Scalar";
+	}
+}
+
+template <typename T>
+void ScanKernel<T>::Find(const ScanPredicate<T>& predicate, const ScanInput& input, std::vector<uint32_t>& offsets, SimdLevel level) {
+	size_t offset = input.first;
+
+#ifdef SCAN_KERNELS_X86
+	level = std::min(level, GetSimdLevel());
+	size_t vectorBytes = level == SimdLevel::AVX2 ? 32 : 16;
+
+	// Vector kernels handle strides that are powers of two up to the vector width
+	bool vectorizable = level != SimdLevel::Scalar && input.stride && !(input.stride & (input.stride - 1)) && input.stride <= vectorBytes;
+
+	if (vectorizable) {
+		uint32_t slice[kSliceBytes];
+
+		for (;;) {
+			// Limit each call to one slice so its output always fits the local array
+			ScanInput sliceInput = input;
+			sliceInput.limit = std::min(input.limit, offset + kSliceBytes);
+
+			size_t start = offset;
+			size_t count = level == SimdLevel::AVX2
+				? ScanKernelsSimd::FindAvx2(predicate, sliceInput, offset, slice)
+				: ScanKernelsSimd::FindSse42(predicate, sliceInput, offset, slice);
+			offsets.insert(offsets.end(), slice, slice + count);
+
+			// Stop once a call could not process a complete window
+			if (offset == start || offset - start < kSliceBytes) {
+				break;
+			}
+		}
+	}
+#else
+	(void)level;
+#endif
+
+	// The remaining candidates near the end of the buffer, or all of them without vector support
+	FindScalar(predicate, input, offset, offsets);
+}
+
+void ByteSet::Find(const uint8_t* data, size_t size, std::vector<uint32_t>& offsets, SimdLevel level) const {
+	// A second set holding every value turns the pair search into a single byte search
+	ByteSet any;
+	std::memset(any.low, 0xFF, sizeof(any.low));
+	std::memset(any.high, 0xFF, sizeof(any.high));
+
+	// The last byte has no successor for the pair search
+	if (size > 0) {
+		ByteSet::FindPairs(*this, any, data, size, offsets, level);
+		if (this->Contains(data[size - 1])) {
+			offsets.push_back((uint32_t)(size - 1));
+		}
+	}
+}
+
+void ByteSet::FindPairs(const ByteSet& first, const ByteSet& second, const uint8_t* data, size_t size, std::vector<uint32_t>& offsets, SimdLevel level) {
+	size_t offset = 0;
+
+#ifdef SCAN_KERNELS_X86
+	level = std::min(level, GetSimdLevel());
+
+	if (level != SimdLevel::Scalar) {
+		uint32_t slice[kSliceBytes];
+
+		for (;;) {
+			// Limit each call to one slice (plus the byte after it) so its output always fits the local array
+			size_t start = offset;
+			size_t sliceEnd = std::min(size, offset + kSliceBytes + 1);
+			size_t count = level == SimdLevel::AVX2
+				? ScanKernelsSimd::FindPairsAvx2(first, second, data, sliceEnd, offset, slice)
+				: ScanKernelsSimd::FindPairsSse42(first, second, data, sliceEnd, offset, slice);
+			offsets.insert(offsets.end(), slice, slice + count);
+
+			// Stop once a call could not process a complete window
+			if (offset == start || offset - start < kSliceBytes) {
+				break;
+			}
+		}
+	}
+#else
+	(void)level;
+#endif
+
+	// The pairs after the last complete window, or all of them without vector support
+	for (; offset + 1 < size; ++offset) {
+		if (first.Contains(data[offset]) && second.Contains(data[offset + 1])) {
+			offsets.push_back((uint32_t)offset);
+		}
+	}
+}
+
+// Value types supported by the scan kernels
+template struct ScanKernel<int8_t>;
+template struct ScanKernel<uint8_t>;
+template struct ScanKernel<int16_t>;
+template struct ScanKernel<uint16_t>;
+template struct ScanKernel<int32_t>;
+template struct ScanKernel<uint32_t>;
+template struct ScanKernel<int64_t>;
+template struct ScanKernel<uint64_t>;
+template struct ScanKernel<float>;
+template struct ScanKernel<double>;
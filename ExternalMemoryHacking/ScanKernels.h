@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Instruction set used by the scan kernels, ordered from slowest to fastest.
+ */
+enum class SimdLevel {
+	Scalar, // One element at a time
+	SSE42,  // 16 byte vectors
+	AVX2    // 32 byte vectors
+};
+
+/**
+ * @brief Returns the best instruction set supported by this CPU and operating system.
+ *
+ * The result is detected once with CPUID and cached.
+ */
+SimdLevel GetSimdLevel();
+
+/**
+ * @brief Returns a printable name for an instruction set ("Scalar", "SSE4.2" or "AVX2").
+ */
+const char* GetSimdLevelName(SimdLevel level);
+
+/**
+ * @brief The comparison applied to every candidate value of a scan.
+ */
+enum class ScanCompare {
+	Equal,   // value == first
+	Between, // first <= value <= second
+	Near     // |value - first| <= second (float and double only)
+};
+
+/**
+ * @brief A typed scan condition such as "equal to 100" or "between 0 and 1".
+ *
+ * Create predicates with the static factory functions. For integer types, Near is
+ * converted into the equivalent Between range.
+ *
+ * @tparam T The type of the value stored in the target process.
+ */
+template <typename T>
+struct ScanPredicate {
+	ScanCompare compare = ScanCompare::Equal;
+	T first = T();  // Value for Equal and Near, lower bound for Between
+	T second = T(); // Upper bound for Between, epsilon for Near
+
+	/**
+	 * @brief Matches values equal to value.
+	 */
+	static ScanPredicate Equal(T value) {
+		ScanPredicate predicate;
+		predicate.first = value;
+		return predicate;
+	}
+
+	/**
+	 * @brief Matches values in the inclusive range [low, high].
+	 */
+	static ScanPredicate Between(T low, T high) {
+		ScanPredicate predicate;
+		predicate.compare = ScanCompare::Between;
+		predicate.first = low;
+		predicate.second = high;
+		return predicate;
+	}
+
+	/**
+	 * @brief Matches values within epsilon of value.
+	 */
+	static ScanPredicate Near(T value, T epsilon) {
+		if constexpr (std::is_floating_point<T>::value) {
+			ScanPredicate predicate;
+			predicate.compare = ScanCompare::Near;
+			predicate.first = value;
+			predicate.second = epsilon;
+			return predicate;
+		} else {
+			// Integers have no rounding error, so clamp value +/- epsilon to the type's range
+			T low = value < std::numeric_limits<T>::min() + epsilon ? std::numeric_limits<T>::min() : T(value - epsilon);
+			T high = value > std::numeric_limits<T>::max() - epsilon ? std::numeric_limits<T>::max() : T(value + epsilon);
+			return Between(low, high);
+		}
+	}
+
+	/**
+	 * @brief Evaluates the predicate for a single value (the scalar reference).
+	 */
+	bool Matches(T value) const {
+		switch (this->compare) {
+		case ScanCompare::Between:
+			return value >= this->first && value <= this->second;
+		case ScanCompare::Near:
+			if constexpr (std::is_floating_point<T>::value) {
+				T difference = value - this->first;
+				return (difference < 0 ? -difference : difference) <= this->second;
+			}
+			return false;
+		default:
+			return value == this->first;
+		}
+	}
+};
+
+/**
+ * @brief Candidate positions inside a local buffer.
+ *
+ * Candidates start at first, first + stride, first + 2 * stride, ... below limit,
+ * and a candidate is only tested when all sizeof(T) of its bytes lie inside size.
+ */
+struct ScanInput {
+	const uint8_t* data = nullptr; // Local copy of target memory
+	size_t size = 0;               // Number of valid bytes in data
+	size_t first = 0;              // Offset of the first candidate
+	size_t limit = 0;              // Candidates must start below this offset
+	size_t stride = 1;             // Distance between two candidates (the scan alignment)
+};
+
+/**
+ * @brief Vectorized comparison kernels for one value type.
+ *
+ * The kernels compare a whole vector of candidates at once, turn the comparison result into
+ * a bit mask of matching byte positions and expand the mask into a compact list of offsets.
+ * Strides that are powers of two up to the vector width are vectorized, which covers the
+ * packed (stride == sizeof(T)) and every-byte (stride 1) cases. Other strides and the last
+ * few candidates of a buffer use the scalar path, which produces identical results.
+ *
+ * @tparam T One of the 8 to 64-bit integers, float or double.
+ */
+template <typename T>
+struct ScanKernel {
+	/**
+	 * @brief Appends the offsets of all matching candidates to offsets, in ascending order.
+	 *
+	 * @param predicate The condition every candidate is tested against.
+	 * @param input The buffer and candidate positions to test.
+	 * @param offsets Receives the offsets (relative to input.data) of matching candidates.
+	 * @param level The highest instruction set to use, clamped to what the CPU supports.
+	 */
+	static void Find(const ScanPredicate<T>& predicate, const ScanInput& input, std::vector<uint32_t>& offsets, SimdLevel level = SimdLevel::AVX2);
+};
+
+/**
+ * @brief A set of byte values that can be searched for in one vectorized pass.
+ *
+ * Membership is stored as two 16-entry tables indexed by the low nibble of a byte, one for
+ * bytes below 0x80 and one for the others. Bit (value >> 4) & 7 of an entry is set when the
+ * byte is in the set. A vector kernel looks up 16 or 32 bytes at once with two byte shuffles,
+ * so the cost of a search does not depend on how many values the set holds. The pattern
+ * scanner uses pairs of sets to find the anchor bytes of many signatures with a single pass.
+ */
+struct ByteSet {
+	uint8_t low[16] = {};  // Members below 0x80, indexed by the low nibble
+	uint8_t high[16] = {}; // Members from 0x80 up, indexed by the low nibble
+
+	/**
+	 * @brief Adds a byte value to the set.
+	 */
+	void Add(uint8_t value) {
+		uint8_t* table = value & 0x80 ? this->high : this->low;
+		table[value & 0x0F] |= (uint8_t)(1 << ((value >> 4) & 7));
+	}
+
+	/**
+	 * @brief Returns true if the byte value is in the set.
+	 */
+	bool Contains(uint8_t value) const {
+		const uint8_t* table = value & 0x80 ? this->high : this->low;
+		return (table[value & 0x0F] >> ((value >> 4) & 7)) & 1;
+	}
+
+	/**
+	 * @brief Appends the offsets of all bytes of data that are in the set, in ascending order.
+	 *
+	 * @param data The buffer to search.
+	 * @param size The number of bytes in data; must be below 4 GiB.
+	 * @param offsets Receives the offsets of the matching bytes.
+	 * @param level The highest instruction set to use, clamped to what the CPU supports.
+	 */
+	void Find(const uint8_t* data, size_t size, std::vector<uint32_t>& offsets, SimdLevel level = SimdLevel::AVX2) const;
+
+	/**
+	 * @brief Appends the offsets of all byte pairs with the first byte in first and the second in second.
+	 *
+	 * Testing two adjacent bytes instead of one cuts the number of candidates a pattern search
+	 * has to verify by roughly the hit rate of the second set.
+	 *
+	 * @param first The set the byte at the offset must be in.
+	 * @param second The set the byte after it must be in.
+	 * @param data The buffer to search.
+	 * @param size The number of bytes in data; must be below 4 GiB.
+	 * @param offsets Receives the offsets of the first byte of every matching pair.
+	 * @param level The highest instruction set to use, clamped to what the CPU supports.
+	 */
+	static void FindPairs(const ByteSet& first, const ByteSet& second, const uint8_t* data, size_t size, std::vector<uint32_t>& offsets, SimdLevel level = SimdLevel::AVX2);
+};
@@ -0,0 +1,201 @@
+// AVX2 scan kernels. Built with AVX2 enabled (-mavx2 on GCC/Clang) and only called
+// after GetSimdLevel() reported AVX2 support.
+
+#include "ScanKernelsSimd.h"
+
+#ifdef SCAN_KERNELS_X86
+
+#include <immintrin.h>
+#include <type_traits>
+
+namespace {
+	// 32 byte vectors
+	struct Avx2 {
+		typedef __m256i Vector;
+		static const size_t kBytes = 32;
+
+		static Vector Load(const uint8_t* data) {
+			return _mm256_loadu_si256((const __m256i*)data);
+		}
+
+		static uint32_t MoveMask(Vector mask) {
+			return (uint32_t)_mm256_movemask_epi8(mask);
+		}
+	};
+
+	// Lane-wise comparisons for one value type; every result lane is all ones for a match
+	template <typename T, typename Enable = void>
+	struct Lanes;
+
+	// Signed and unsigned integers of every width
+	template <typename T>
+	struct Lanes<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+		static __m256i Splat(T value) {
+			if constexpr (sizeof(T) == 1) return _mm256_set1_epi8((char)value);
+			else if constexpr (sizeof(T) == 2) return _mm256_set1_epi16((short)value);
+			else if constexpr (sizeof(T) == 4) return _mm256_set1_epi32((int)value);
+			else return _mm256_set1_epi64x((long long)value);
+		}
+
+		static __m256i Equal(__m256i left, __m256i right) {
+			if constexpr (sizeof(T) == 1) return _mm256_cmpeq_epi8(left, right);
+			else if constexpr (sizeof(T) == 2) return _mm256_cmpeq_epi16(left, right);
+			else if constexpr (sizeof(T) == 4) return _mm256_cmpeq_epi32(left, right);
+			else return _mm256_cmpeq_epi64(left, right);
+		}
+
+		static __m256i Greater(__m256i left, __m256i right) {
+			// AVX2 only compares signed lanes; flipping the sign bit orders unsigned values the same way
+			if constexpr (std::is_unsigned<T>::value) {
+				__m256i bias = Splat((T)((T)1 << (sizeof(T) * 8 - 1)));
+				left = _mm256_xor_si256(left, bias);
+				right = _mm256_xor_si256(right, bias);
+			}
+
+			if constexpr (sizeof(T) == 1) return _mm256_cmpgt_epi8(left, right);
+			else if constexpr (sizeof(T) == 2) return _mm256_cmpgt_epi16(left, right);
+			else if constexpr (sizeof(T) == 4) return _mm256_cmpgt_epi32(left, right);
+			else return _mm256_cmpgt_epi64(left, right);
+		}
+
+		static __m256i Between(__m256i values, __m256i low, __m256i high) {
+			// Inside the range means neither below low nor above high
+			__m256i outside = _mm256_or_si256(Greater(low, values), Greater(values, high));
+			return _mm256_andnot_si256(outside, _mm256_set1_epi8(-1));
+		}
+
+		static __m256i Near(__m256i, __m256i, __m256i) {
+			// ScanPredicate turns Near into Between for integers
+			return _mm256_setzero_si256();
+		}
+	};
+
+	template <>
+	struct Lanes<float> {
+		static __m256i Splat(float value) {
+			return _mm256_castps_si256(_mm256_set1_ps(value));
+		}
+
+		static __m256i Equal(__m256i left, __m256i right) {
+			return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(left), _mm256_castsi256_ps(right), _CMP_EQ_OQ));
+		}
+
+		static __m256i Between(__m256i values, __m256i low, __m256i high) {
+			__m256 floats = _mm256_castsi256_ps(values);
+			__m256 aboveLow = _mm256_cmp_ps(floats, _mm256_castsi256_ps(low), _CMP_GE_OQ);
+			__m256 belowHigh = _mm256_cmp_ps(floats, _mm256_castsi256_ps(high), _CMP_LE_OQ);
+			return _mm256_castps_si256(_mm256_and_ps(aboveLow, belowHigh));
+		}
+
+		static __m256i Near(__m256i values, __m256i value, __m256i epsilon) {
+			// Clearing the sign bit of the difference gives its absolute value
+			__m256 difference = _mm256_sub_ps(_mm256_castsi256_ps(values), _mm256_castsi256_ps(value));
+			__m256 distance = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), difference);
+			return _mm256_castps_si256(_mm256_cmp_ps(distance, _mm256_castsi256_ps(epsilon), _CMP_LE_OQ));
+		}
+	};
+
+	template <>
+	struct Lanes<double> {
+		static __m256i Splat(double value) {
+			return _mm256_castpd_si256(_mm256_set1_pd(value));
+		}
+
+		static __m256i Equal(__m256i left, __m256i right) {
+			return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(left), _mm256_castsi256_pd(right), _CMP_EQ_OQ));
+		}
+
+		static __m256i Between(__m256i values, __m256i low, __m256i high) {
+			__m256d doubles = _mm256_castsi256_pd(values);
+			__m256d aboveLow = _mm256_cmp_pd(doubles, _mm256_castsi256_pd(low), _CMP_GE_OQ);
+			__m256d belowHigh = _mm256_cmp_pd(doubles, _mm256_castsi256_pd(high), _CMP_LE_OQ);
+			return _mm256_castpd_si256(_mm256_and_pd(aboveLow, belowHigh));
+		}
+
+		static __m256i Near(__m256i values, __m256i value, __m256i epsilon) {
+			__m256d difference = _mm256_sub_pd(_mm256_castsi256_pd(values), _mm256_castsi256_pd(value));
+			__m256d distance = _mm256_andnot_pd(_mm256_set1_pd(-0.0), difference);
+			return _mm256_castpd_si256(_mm256_cmp_pd(distance, _mm256_castsi256_pd(epsilon), _CMP_LE_OQ));
+		}
+	};
+}
+
+template <typename T>
+size_t ScanKernelsSimd::FindAvx2(const ScanPredicate<T>& predicate, const ScanInput& input, size_t& offset, uint32_t* out) {
+	typedef Lanes<T> L;
+	__m256i first = L::Splat(predicate.first);
+	__m256i second = L::Splat(predicate.second);
+
+	// Pick the comparison once per call, never per element
+	switch (predicate.compare) {
+	case ScanCompare::Between:
+		return FindWindows<T, Avx2>(input, offset, [&](__m256i values) { return L::Between(values, first, second); }, out);
+	case ScanCompare::Near:
+		return FindWindows<T, Avx2>(input, offset, [&](__m256i values) { return L::Near(values, first, second); }, out);
+	default:
+		return FindWindows<T, Avx2>(input, offset, [&](__m256i values) { return L::Equal(values, first); }, out);
+	}
+}
+
+namespace {
+	// Shuffle tables of one byte set, with the nibble tables repeated in each 128-bit lane
+	struct ByteSetLanes {
+		__m256i low;
+		__m256i high;
+
+		explicit ByteSetLanes(const ByteSet& set)
+			: low(_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set.low))),
+			high(_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set.high))) {
+		}
+
+		// Returns all ones for every byte of values that is in the set
+		__m256i Contains(__m256i values) const {
+			const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+				1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+
+			// A shuffle returns 0 for index bytes with the top bit set, which selects the right table
+			__m256i entries = _mm256_or_si256(_mm256_shuffle_epi8(this->low, values),
+				_mm256_shuffle_epi8(this->high, _mm256_xor_si256(values, _mm256_set1_epi8(-128))));
+
+			// Bit (value >> 4) & 7 of the entry tells whether the byte is a member
+			__m256i select = _mm256_shuffle_epi8(bits, _mm256_and_si256(_mm256_srli_epi16(values, 4), _mm256_set1_epi8(0x07)));
+			__m256i misses = _mm256_cmpeq_epi8(_mm256_and_si256(entries, select), _mm256_setzero_si256());
+			return _mm256_xor_si256(misses, _mm256_set1_epi8(-1));
+		}
+	};
+}
+
+size_t ScanKernelsSimd::FindPairsAvx2(const ByteSet& first, const ByteSet& second, const uint8_t* data, size_t size, size_t& offset, uint32_t* out) {
+	ByteSetLanes firstLanes(first);
+	ByteSetLanes secondLanes(second);
+	size_t count = 0;
+
+	// The second load reads one byte past the window
+	while (offset + Avx2::kBytes + 1 <= size) {
+		__m256i pairs = _mm256_and_si256(firstLanes.Contains(Avx2::Load(data + offset)),
+			secondLanes.Contains(Avx2::Load(data + offset + 1)));
+
+		uint32_t matches = Avx2::MoveMask(pairs);
+		while (matches) {
+			out[count++] = (uint32_t)(offset + CountTrailingZeros(matches));
+			matches &= matches - 1;
+		}
+
+		offset += Avx2::kBytes;
+	}
+
+	return count;
+}
+
+template size_t ScanKernelsSimd::FindAvx2<int8_t>(const ScanPredicate<int8_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindAvx2<uint8_t>(const ScanPredicate<uint8_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindAvx2<int16_t>(const ScanPredicate<int16_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindAvx2<uint16_t>(const ScanPredicate<uint16_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindAvx2<int32_t>(const ScanPredicate<int32_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindAvx2<uint32_t>(const ScanPredicate<uint32_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindAvx2<int64_t>(const ScanPredicate<int64_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindAvx2<uint64_t>(const ScanPredicate<uint64_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindAvx2<float>(const ScanPredicate<float>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindAvx2<double>(const ScanPredicate<double>&, const ScanInput&, size_t&, uint32_t*);
+
+#endif
@@ -0,0 +1,119 @@
+#pragma once
+
+// Shared by the per instruction set kernel files (ScanKernelsAvx2.cpp, ScanKernelsSse42.cpp).
+// Those files are compiled with their instruction set enabled, so every helper here has internal
+// linkage; a shared inline definition could otherwise be merged by the linker and leak vector
+// instructions into code that runs on CPUs without them.
+
+#include <cstddef>
+#include <cstdint>
+#include "ScanKernels.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// The vector kernels are only built for x86 and x64
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SCAN_KERNELS_X86 1
+#endif
+
+namespace ScanKernelsSimd {
+namespace {
+	/**
+	 * @brief Returns the index of the lowest set bit of a non-zero mask.
+	 */
+	inline unsigned CountTrailingZeros(uint32_t mask) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (unsigned)index;
+#else
+		return (unsigned)__builtin_ctz(mask);
+#endif
+	}
+
+	/**
+	 * @brief Returns a mask with every step-th bit set, starting at bit 0, within the first bits bits.
+	 */
+	inline uint32_t EveryNthBit(size_t step, size_t bits) {
+		uint32_t mask = 0;
+		for (size_t bit = 0; bit < bits; bit += step) {
+			mask |= 1u << bit;
+		}
+		return mask;
+	}
+
+	/**
+	 * @brief Vectorized scan loop shared by all instruction sets.
+	 *
+	 * Processes windows of Isa::kBytes candidate bytes starting at offset. For every byte phase
+	 * that can hold a candidate, a vector is loaded at that phase and compared lane by lane. The
+	 * lane results become byte position bits, the phases are combined into one mask per window,
+	 * and the mask is expanded into ascending offsets. The loop stops at the first window that
+	 * is not completely inside the input and leaves offset there for the scalar tail.
+	 *
+	 * @param input The buffer and candidate positions; input.stride must be a power of two <= Isa::kBytes.
+	 * @param offset The first candidate to test, advanced past every tested window.
+	 * @param compare Returns a lane mask (all ones for a match) for one loaded vector.
+	 * @param out Receives the matching offsets; must hold one entry per candidate.
+	 * @return The number of offsets written to out.
+	 */
+	template <typename T, typename Isa, typename Compare>
+	inline size_t FindWindows(const ScanInput& input, size_t& offset, Compare compare, uint32_t* out) {
+		const size_t kBytes = Isa::kBytes;
+		const uint32_t laneBits = EveryNthBit(sizeof(T), kBytes);
+		const uint32_t strideBits = EveryNthBit(input.stride, kBytes);
+		size_t count = 0;
+
+		// Every load of a window ends at most sizeof(T) - 1 bytes after the window
+		while (offset + kBytes <= input.limit && offset + kBytes + sizeof(T) - 1 <= input.size) {
+			uint64_t mask = 0;
+
+			// Strides below the element size need one load per phase; larger strides only phase 0
+			for (size_t phase = 0; phase < sizeof(T); phase += input.stride) {
+				typename Isa::Vector values = Isa::Load(input.data + offset + phase);
+				mask |= (uint64_t)(Isa::MoveMask(compare(values)) & laneBits) << phase;
+			}
+
+			// Bits shifted past the window belong to the next window and are found there again
+			uint32_t matches = (uint32_t)mask & strideBits;
+			while (matches) {
+				out[count++] = (uint32_t)(offset + CountTrailingZeros(matches));
+				matches &= matches - 1;
+			}
+
+			offset += kBytes;
+		}
+
+		return count;
+	}
+}
+
+	/**
+	 * @brief AVX2 kernel entry point, defined in ScanKernelsAvx2.cpp.
+	 */
+	template <typename T>
+	size_t FindAvx2(const ScanPredicate<T>& predicate, const ScanInput& input, size_t& offset, uint32_t* out);
+
+	/**
+	 * @brief SSE4.2 kernel entry point, defined in ScanKernelsSse42.cpp.
+	 */
+	template <typename T>
+	size_t FindSse42(const ScanPredicate<T>& predicate, const ScanInput& input, size_t& offset, uint32_t* out);
+
+	/**
+	 * @brief AVX2 byte pair search, defined in ScanKernelsAvx2.cpp.
+	 *
+	 * Tests 32 byte windows from offset while the window and the byte after it fit below size,
+	 * writes the offsets of pairs with the first byte in first and the next in second to out,
+	 * and leaves offset at the first byte that was not tested. Passing a set with every value
+	 * as second turns this into a single byte search.
+	 */
+	size_t FindPairsAvx2(const ByteSet& first, const ByteSet& second, const uint8_t* data, size_t size, size_t& offset, uint32_t* out);
+
+	/**
+	 * @brief SSE4.2 byte pair search (16 byte windows), defined in ScanKernelsSse42.cpp.
+	 */
+	size_t FindPairsSse42(const ByteSet& first, const ByteSet& second, const uint8_t* data, size_t size, size_t& offset, uint32_t* out);
+}
@@ -0,0 +1,199 @@
+// SSE4.2 scan kernels. Built with SSE4.2 enabled (-msse4.2 on GCC/Clang) and only called
+// after GetSimdLevel() reported SSE4.2 support.
+
+#include "ScanKernelsSimd.h"
+
+#ifdef SCAN_KERNELS_X86
+
+#include <immintrin.h>
+#include <type_traits>
+
+namespace {
+	// 16 byte vectors
+	struct Sse42 {
+		typedef __m128i Vector;
+		static const size_t kBytes = 16;
+
+		static Vector Load(const uint8_t* data) {
+			return _mm_loadu_si128((const __m128i*)data);
+		}
+
+		static uint32_t MoveMask(Vector mask) {
+			return (uint32_t)_mm_movemask_epi8(mask);
+		}
+	};
+
+	// Lane-wise comparisons for one value type; every result lane is all ones for a match
+	template <typename T, typename Enable = void>
+	struct Lanes;
+
+	// Signed and unsigned integers of every width
+	template <typename T>
+	struct Lanes<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+		static __m128i Splat(T value) {
+			if constexpr (sizeof(T) == 1) return _mm_set1_epi8((char)value);
+			else if constexpr (sizeof(T) == 2) return _mm_set1_epi16((short)value);
+			else if constexpr (sizeof(T) == 4) return _mm_set1_epi32((int)value);
+			else return _mm_set1_epi64x((long long)value);
+		}
+
+		static __m128i Equal(__m128i left, __m128i right) {
+			if constexpr (sizeof(T) == 1) return _mm_cmpeq_epi8(left, right);
+			else if constexpr (sizeof(T) == 2) return _mm_cmpeq_epi16(left, right);
+			else if constexpr (sizeof(T) == 4) return _mm_cmpeq_epi32(left, right);
+			else return _mm_cmpeq_epi64(left, right);
+		}
+
+		static __m128i Greater(__m128i left, __m128i right) {
+			// SSE only compares signed lanes; flipping the sign bit orders unsigned values the same way
+			if constexpr (std::is_unsigned<T>::value) {
+				__m128i bias = Splat((T)((T)1 << (sizeof(T) * 8 - 1)));
+				left = _mm_xor_si128(left, bias);
+				right = _mm_xor_si128(right, bias);
+			}
+
+			if constexpr (sizeof(T) == 1) return _mm_cmpgt_epi8(left, right);
+			else if constexpr (sizeof(T) == 2) return _mm_cmpgt_epi16(left, right);
+			else if constexpr (sizeof(T) == 4) return _mm_cmpgt_epi32(left, right);
+			else return _mm_cmpgt_epi64(left, right);
+		}
+
+		static __m128i Between(__m128i values, __m128i low, __m128i high) {
+			// Inside the range means neither below low nor above high
+			__m128i outside = _mm_or_si128(Greater(low, values), Greater(values, high));
+			return _mm_andnot_si128(outside, _mm_set1_epi8(-1));
+		}
+
+		static __m128i Near(__m128i, __m128i, __m128i) {
+			// ScanPredicate turns Near into Between for integers
+			return _mm_setzero_si128();
+		}
+	};
+
+	template <>
+	struct Lanes<float> {
+		static __m128i Splat(float value) {
+			return _mm_castps_si128(_mm_set1_ps(value));
+		}
+
+		static __m128i Equal(__m128i left, __m128i right) {
+			return _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(left), _mm_castsi128_ps(right)));
+		}
+
+		static __m128i Between(__m128i values, __m128i low, __m128i high) {
+			__m128 floats = _mm_castsi128_ps(values);
+			__m128 aboveLow = _mm_cmpge_ps(floats, _mm_castsi128_ps(low));
+			__m128 belowHigh = _mm_cmple_ps(floats, _mm_castsi128_ps(high));
+			return _mm_castps_si128(_mm_and_ps(aboveLow, belowHigh));
+		}
+
+		static __m128i Near(__m128i values, __m128i value, __m128i epsilon) {
+			// Clearing the sign bit of the difference gives its absolute value
+			__m128 difference = _mm_sub_ps(_mm_castsi128_ps(values), _mm_castsi128_ps(value));
+			__m128 distance = _mm_andnot_ps(_mm_set1_ps(-0.0f), difference);
+			return _mm_castps_si128(_mm_cmple_ps(distance, _mm_castsi128_ps(epsilon)));
+		}
+	};
+
+	template <>
+	struct Lanes<double> {
+		static __m128i Splat(double value) {
+			return _mm_castpd_si128(_mm_set1_pd(value));
+		}
+
+		static __m128i Equal(__m128i left, __m128i right) {
+			return _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(left), _mm_castsi128_pd(right)));
+		}
+
+		static __m128i Between(__m128i values, __m128i low, __m128i high) {
+			__m128d doubles = _mm_castsi128_pd(values);
+			__m128d aboveLow = _mm_cmpge_pd(doubles, _mm_castsi128_pd(low));
+			__m128d belowHigh = _mm_cmple_pd(doubles, _mm_castsi128_pd(high));
+			return _mm_castpd_si128(_mm_and_pd(aboveLow, belowHigh));
+		}
+
+		static __m128i Near(__m128i values, __m128i value, __m128i epsilon) {
+			__m128d difference = _mm_sub_pd(_mm_castsi128_pd(values), _mm_castsi128_pd(value));
+			__m128d distance = _mm_andnot_pd(_mm_set1_pd(-0.0), difference);
+			return _mm_castpd_si128(_mm_cmple_pd(distance, _mm_castsi128_pd(epsilon)));
+		}
+	};
+}
+
+template <typename T>
+size_t ScanKernelsSimd::FindSse42(const ScanPredicate<T>& predicate, const ScanInput& input, size_t& offset, uint32_t* out) {
+	typedef Lanes<T> L;
+	__m128i first = L::Splat(predicate.first);
+	__m128i second = L::Splat(predicate.second);
+
+	// Pick the comparison once per call, never per element
+	switch (predicate.compare) {
+	case ScanCompare::Between:
+		return FindWindows<T, Sse42>(input, offset, [&](__m128i values) { return L::Between(values, first, second); }, out);
+	case ScanCompare::Near:
+		return FindWindows<T, Sse42>(input, offset, [&](__m128i values) { return L::Near(values, first, second); }, out);
+	default:
+		return FindWindows<T, Sse42>(input, offset, [&](__m128i values) { return L::Equal(values, first); }, out);
+	}
+}
+
+namespace {
+	// Shuffle tables of one byte set
+	struct ByteSetLanes {
+		__m128i low;
+		__m128i high;
+
+		explicit ByteSetLanes(const ByteSet& set)
+			: low(_mm_loadu_si128((const __m128i*)set.low)), high(_mm_loadu_si128((const __m128i*)set.high)) {
+		}
+
+		// Returns all ones for every byte of values that is in the set
+		__m128i Contains(__m128i values) const {
+			const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+
+			// A shuffle returns 0 for index bytes with the top bit set, which selects the right table
+			__m128i entries = _mm_or_si128(_mm_shuffle_epi8(this->low, values),
+				_mm_shuffle_epi8(this->high, _mm_xor_si128(values, _mm_set1_epi8(-128))));
+
+			// Bit (value >> 4) & 7 of the entry tells whether the byte is a member
+			__m128i select = _mm_shuffle_epi8(bits, _mm_and_si128(_mm_srli_epi16(values, 4), _mm_set1_epi8(0x07)));
+			__m128i misses = _mm_cmpeq_epi8(_mm_and_si128(entries, select), _mm_setzero_si128());
+			return _mm_xor_si128(misses, _mm_set1_epi8(-1));
+		}
+	};
+}
+
+size_t ScanKernelsSimd::FindPairsSse42(const ByteSet& first, const ByteSet& second, const uint8_t* data, size_t size, size_t& offset, uint32_t* out) {
+	ByteSetLanes firstLanes(first);
+	ByteSetLanes secondLanes(second);
+	size_t count = 0;
+
+	// The second load reads one byte past the window
+	while (offset + Sse42::kBytes + 1 <= size) {
+		__m128i pairs = _mm_and_si128(firstLanes.Contains(Sse42::Load(data + offset)),
+			secondLanes.Contains(Sse42::Load(data + offset + 1)));
+
+		uint32_t matches = Sse42::MoveMask(pairs);
+		while (matches) {
+			out[count++] = (uint32_t)(offset + CountTrailingZeros(matches));
+			matches &= matches - 1;
+		}
+
+		offset += Sse42::kBytes;
+	}
+
+	return count;
+}
+
+template size_t ScanKernelsSimd::FindSse42<int8_t>(const ScanPredicate<int8_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindSse42<uint8_t>(const ScanPredicate<uint8_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindSse42<int16_t>(const ScanPredicate<int16_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindSse42<uint16_t>(const ScanPredicate<uint16_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindSse42<int32_t>(const ScanPredicate<int32_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindSse42<uint32_t>(const ScanPredicate<uint32_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindSse42<int64_t>(const ScanPredicate<int64_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindSse42<uint64_t>(const ScanPredicate<uint64_t>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindSse42<float>(const ScanPredicate<float>&, const ScanInput&, size_t&, uint32_t*);
+template size_t ScanKernelsSimd::FindSse42<double>(const ScanPredicate<double>&, const ScanInput&, size_t&, uint32_t*);
+
+#endif
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * @brief The comparisons a next scan can make against the previous value of each result.
+ */
+enum class NextScanCompare {
+	Changed,   // current != previous
+	Unchanged, // current == previous
+	Increased, // current > previous
+	Decreased  // current < previous
+};
+
+class Scanner;
+
+/**
+ * @brief The addresses and previous values found by a scan, stored compactly.
+ *
+ * Results are kept per scan chunk (at most ScanOptions::chunkSize bytes of one region). Each
+ * chunk picks the smaller of two forms and switches automatically as results are added:
+ * - sparse: a sorted vector of 32-bit byte offsets from the chunk base, used when there are few results;
+ * - dense: a bitmap with one bit per aligned slot of the chunk, used when there are many.
+ * Previous values are stored once per result in address order, or as a single value when all
+ * results of a chunk hold the same bytes (which is the common case after an exact scan).
+ * A first scan with 100 million hits therefore costs bits per hit rather than 8 bytes per address.
+ *
+ * @tparam T The type of the scanned values.
+ */
+template <typename T>
+class ScanResults {
+	// The scanner fills and narrows the regions in place
+	friend class Scanner;
+
+public:
+	/**
+	 * @brief The results of one scan chunk.
+	 */
+	struct Region {
+		uintptr_t base = 0;            // First address of the chunk
+		size_t size = 0;               // Size of the chunk in bytes
+		size_t count = 0;              // Number of results in the chunk
+		std::vector<uint64_t> bitmap;  // Dense form: one bit per aligned slot
+		std::vector<uint32_t> offsets; // Sparse form: sorted byte offsets from base
+		std::vector<T> values;         // Previous values in address order, empty while uniform
+		T value = T();                 // Previous value of every result while values is empty
+
+		/**
+		 * @brief Returns true if the results are stored as a bitmap.
+		 */
+		bool IsDense() const {
+			return !this->bitmap.empty();
+		}
+	};
+
+private:
+	// Chunks with at least one result, in ascending address order
+	std::vector<Region> regions;
+
+	// Distance between two candidate addresses used by the scan
+	size_t alignment = sizeof(T);
+
+	// Offset of the first aligned slot from a region base
+	size_t FirstSlot(const Region& region) const {
+		return (this->alignment - region.base % this->alignment) % this->alignment;
+	}
+
+	// Index of the lowest set bit of a non-zero word
+	static size_t CountTrailingZeros(uint64_t bits) {
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return index;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanForward(&index, (unsigned long)bits)) {
+			return index;
+		}
+		_BitScanForward(&index, (unsigned long)(bits >> 32));
+		return index + 32;
+#else
+		return (size_t)__builtin_ctzll(bits);
+#endif
+	}
+
+	// Drops regions without results and releases the spare capacity of the others
+	void Compact() {
+		this->regions.erase(std::remove_if(this->regions.begin(), this->regions.end(),
+			[](const Region& region) { return region.count == 0; }), this->regions.end());
+
+		for (Region& region : this->regions) {
+			region.offsets.shrink_to_fit();
+			region.values.shrink_to_fit();
+		}
+		this->regions.shrink_to_fit();
+	}
+
+public:
+	ScanResults() = default;
+
+	/**
+	 * @brief Creates an empty result set for a scan with the given alignment.
+	 */
+	explicit ScanResults(size_t alignment) : alignment(alignment) {
+	}
+
+	/**
+	 * @brief Returns the alignment the results were scanned with.
+	 */
+	size_t GetAlignment() const {
+		return this->alignment;
+	}
+
+	/**
+	 * @brief Returns the number of results.
+	 */
+	size_t GetCount() const {
+		size_t count = 0;
+		for (const Region& region : this->regions) {
+			count += region.count;
+		}
+		return count;
+	}
+
+	/**
+	 * @brief Returns the number of heap bytes used to store the results.
+	 */
+	size_t GetMemoryUsage() const {
+		size_t bytes = this->regions.capacity() * sizeof(Region);
+		for (const Region& region : this->regions) {
+			bytes += region.bitmap.capacity() * sizeof(uint64_t);
+			bytes += region.offsets.capacity() * sizeof(uint32_t);
+			bytes += region.values.capacity() * sizeof(T);
+		}
+		return bytes;
+	}
+
+	/**
+	 * @brief Returns the per-chunk storage, e.g. to inspect which chunks are dense.
+	 */
+	const std::vector<Region>& GetRegions() const {
+		return this->regions;
+	}
+
+	/**
+	 * @brief Calls callback(offset, index) for every result of a region in ascending order.
+	 *
+	 * offset is the byte offset from region.base and index the position of the result
+	 * within the region, which is also its position in region.values.
+	 */
+	template <typename Callback>
+	void ForEachOffset(const Region& region, Callback callback) const {
+		if (!region.IsDense()) {
+			for (size_t index = 0; index < region.offsets.size(); ++index) {
+				callback((size_t)region.offsets[index], index);
+			}
+			return;
+		}
+
+		// Walk the set bits of the bitmap word by word
+		size_t first = this->FirstSlot(region);
+		size_t index = 0;
+		for (size_t word = 0; word < region.bitmap.size(); ++word) {
+			for (uint64_t bits = region.bitmap[word]; bits; bits &= bits - 1) {
+				size_t bit = CountTrailingZeros(bits);
+				callback(first + (word * 64 + bit) * this->alignment, index++);
+			}
+		}
+	}
+
+	/**
+	 * @brief Calls callback(address, previousValue) for every result in ascending address order.
+	 */
+	template <typename Callback>
+	void ForEach(Callback callback) const {
+		for (const Region& region : this->regions) {
+			this->ForEachOffset(region, [&](size_t offset, size_t index) {
+				callback(region.base + offset, region.values.empty() ? region.value : region.values[index]);
+			});
+		}
+	}
+
+	/**
+	 * @brief Returns all result addresses in ascending order.
+	 *
+	 * This materializes 8 bytes per result, so prefer ForEach for large result sets.
+	 */
+	std::vector<uintptr_t> GetAddresses() const {
+		std::vector<uintptr_t> addresses;
+		addresses.reserve(this->GetCount());
+		this->ForEach([&](uintptr_t address, const T&) { addresses.push_back(address); });
+		return addresses;
+	}
+
+	/**
+	 * @brief Starts an empty region covering [base, base + size).
+	 */
+	static Region MakeRegion(uintptr_t base, size_t size) {
+		Region region;
+		region.base = base;
+		region.size = size;
+		return region;
+	}
+
+	/**
+	 * @brief Appends a result to a region; offsets must be appended in ascending order.
+	 *
+	 * The region switches from the sparse to the dense form as soon as the bitmap becomes
+	 * smaller than the offset list, and from a single uniform value to a value array as soon
+	 * as a value differs from the previous ones.
+	 *
+	 * @param region The region to append to.
+	 * @param offset The byte offset of the result from region.base.
+	 * @param value The value currently stored at the result.
+	 */
+	void Append(Region& region, size_t offset, const T& value) const {
+		size_t first = this->FirstSlot(region);
+
+		if (region.IsDense()) {
+			size_t slot = (offset - first) / this->alignment;
+			region.bitmap[slot / 64] |= 1ull << (slot % 64);
+		} else {
+			region.offsets.push_back((uint32_t)offset);
+
+			// Switch to a bitmap once it takes less memory than the offsets
+			size_t slots = region.size / this->alignment + 1;
+			size_t words = (slots + 63) / 64;
+			if (words * sizeof(uint64_t) < region.offsets.size() * sizeof(uint32_t)) {
+				region.bitmap.assign(words, 0);
+				for (uint32_t existing : region.offsets) {
+					size_t slot = (existing - first) / this->alignment;
+					region.bitmap[slot / 64] |= 1ull << (slot % 64);
+				}
+				std::vector<uint32_t>().swap(region.offsets);
+			}
+		}
+
+		// Values are compared bit for bit, so -0.0 and 0.0 or different NaNs are kept apart
+		if (region.count == 0) {
+			region.value = value;
+		} else if (!region.values.empty()) {
+			region.values.push_back(value);
+		} else if (std::memcmp(&value, &region.value, sizeof(T))) {
+			region.values.assign(region.count, region.value);
+			region.values.push_back(value);
+		}
+
+		++region.count;
+	}
+};
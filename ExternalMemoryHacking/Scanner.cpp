@@ -0,0 +1,551 @@
+#include "Scanner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+	// Unreadable pages are skipped with page granularity
+	const uintptr_t kPageSize = 0x1000;
+}
+
+double ScanStatistics::GetThroughput() const {
+	return this->seconds > 0 ? this->bytesScanned / this->seconds / 1e9 : 0;
+}
+
+Scanner::Scanner(MemoryReader& memory, const ScanOptions& options)
+	: memory(memory), options(options), pool(options.pool) {
+	if (!this->pool) {
+		this->ownPool.reset(new ThreadPool(options.threadCount));
+		this->pool = this->ownPool.get();
+	}
+
+	// Every worker gets its own buffers, allocated on first use
+	this->buffers.resize(this->pool->GetThreadCount());
+	this->offsets.resize(this->pool->GetThreadCount());
+	this->batches.resize(this->pool->GetThreadCount());
+	this->previousBuffers.resize(this->pool->GetThreadCount());
+}
+
+std::vector<MemoryRegion> Scanner::GetRegions() {
+	std::vector<MemoryRegion> regions = this->memory.GetRegions();
+
+	// Drop read-only regions if only writable memory is of interest
+	if (this->options.writableOnly) {
+		regions.erase(std::remove_if(regions.begin(), regions.end(),
+			[](const MemoryRegion& region) { return !region.writable; }), regions.end());
+	}
+
+	return regions;
+}
+
+std::vector<ScanChunk> Scanner::SplitRegions(const std::vector<MemoryRegion>& regions) const {
+	std::vector<ScanChunk> chunks;
+
+	for (const MemoryRegion& region : regions) {
+		uintptr_t end = region.base + region.size;
+
+		// Cut the region into pieces of at most chunkSize bytes
+		for (uintptr_t address = region.base; address < end; address += this->options.chunkSize) {
+			ScanChunk chunk;
+			chunk.address = address;
+			chunk.size = (size_t)std::min<uintptr_t>(this->options.chunkSize, end - address);
+			chunk.regionEnd = end;
+			chunks.push_back(chunk);
+		}
+	}
+
+	return chunks;
+}
+
+size_t Scanner::ScanChunks(const std::vector<ScanChunk>& chunks, size_t overlap, const std::function<void(const ScanBlock&)>& visitor) {
+	std::atomic<size_t> bytesScanned{ 0 };
+
+	this->pool->Run(chunks.size(), [&](size_t index, size_t worker) {
+		const ScanChunk& chunk = chunks[index];
+
+		// Reuse the worker's buffer, large enough for one block plus its overlap
+		std::vector<uint8_t>& buffer = this->buffers[worker];
+		if (buffer.size() < this->options.blockSize + overlap) {
+			buffer.resize(this->options.blockSize + overlap);
+		}
+
+		size_t chunkBytes = 0;
+		uintptr_t address = chunk.address;
+		uintptr_t end = chunk.address + chunk.size;
+
+		while (address < end) {
+			// Read one block, plus the overlap as far as the region reaches
+			size_t limit = (size_t)std::min<uintptr_t>(this->options.blockSize, end - address);
+			size_t readSize = (size_t)std::min<uintptr_t>(limit + overlap, chunk.regionEnd - address);
+			// Memory that is directly addressable (a mapped capture) is scanned in place
+			size_t bytesRead = readSize;
+			const uint8_t* data = this->memory.GetView(address, readSize);
+			if (!data) {
+				bytesRead = 0;
+				this->memory.ReadMemory(address, buffer.data(), readSize, &bytesRead);
+				data = buffer.data();
+			}
+
+			// Visit whatever prefix could be read
+			if (bytesRead > 0) {
+				ScanBlock block;
+				block.address = address;
+				block.data = data;
+				block.size = bytesRead;
+				block.limit = std::min(limit, bytesRead);
+				block.chunk = index;
+				block.worker = worker;
+				visitor(block);
+				chunkBytes += block.limit;
+			}
+
+			if (bytesRead < limit) {
+				// The read stopped at an unreadable page, continue on the page after it
+				address = ((address + bytesRead) & ~(kPageSize - 1)) + kPageSize;
+			} else {
+				address += limit;
+			}
+		}
+
+		bytesScanned.fetch_add(chunkBytes, std::memory_order_relaxed);
+	});
+
+	return bytesScanned.load();
+}
+
+template <typename T>
+ScanResults<T> Scanner::FirstScan(const ScanPredicate<T>& predicate) {
+	static_assert(std::is_arithmetic<T>::value && sizeof(T) <= 8, "FirstScan supports 8 to 64-bit integers, float and double");
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<MemoryRegion> regions = this->GetRegions();
+	std::vector<ScanChunk> chunks = this->SplitRegions(regions);
+	size_t alignment = this->options.alignment ? this->options.alignment : sizeof(T);
+
+	// Pages written from here on are read again by the next scan
+	if (this->tracker) {
+		this->tracker->Reset();
+	}
+
+	// Every chunk collects its own matches, so no locking is needed while scanning
+	ScanResults<T> results(alignment);
+	results.regions.reserve(chunks.size());
+	for (const ScanChunk& chunk : chunks) {
+		results.regions.push_back(ScanResults<T>::MakeRegion(chunk.address, chunk.size));
+	}
+
+	size_t bytesScanned = this->ScanChunks(chunks, sizeof(T) - 1, [&](const ScanBlock& block) {
+		typename ScanResults<T>::Region& region = results.regions[block.chunk];
+		std::vector<uint32_t>& offsets = this->offsets[block.worker];
+
+		// Candidates start at the first offset inside the block that lies on the requested alignment
+		ScanInput input;
+		input.data = block.data;
+		input.size = block.size;
+		input.first = (alignment - block.address % alignment) % alignment;
+		input.limit = block.limit;
+		input.stride = alignment;
+
+		offsets.clear();
+		ScanKernel<T>::Find(predicate, input, offsets);
+
+		// Blocks of a chunk are visited in order, so the offsets are appended in ascending order
+		size_t blockOffset = (size_t)(block.address - region.base);
+		for (uint32_t offset : offsets) {
+			T value;
+			std::memcpy(&value, block.data + offset, sizeof(T));
+			results.Append(region, blockOffset + offset, value);
+		}
+	});
+
+	// Chunks are in address order, so dropping the empty ones keeps the results sorted
+	results.Compact();
+
+	this->statistics.regionCount = regions.size();
+	this->statistics.bytesScanned = bytesScanned;
+	this->statistics.resultCount = results.GetCount();
+	this->statistics.cleanCount = 0;
+	this->statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return results;
+}
+
+std::vector<uintptr_t> Scanner::GroupScan(const ScanGroup& group) {
+	if (group.GetCount() == 0) {
+		this->statistics = ScanStatistics();
+		return std::vector<uintptr_t>();
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<MemoryRegion> regions = this->GetRegions();
+	std::vector<ScanChunk> chunks = this->SplitRegions(regions);
+	std::vector<std::vector<uintptr_t>> matches(chunks.size());
+
+	// Pointer fields may point anywhere readable, not only into the regions being scanned
+	std::vector<MemoryRegion> targets = this->options.writableOnly ? this->memory.GetRegions() : regions;
+	size_t alignment = this->options.alignment ? this->options.alignment : group.GetAlignment();
+	const ScanGroup::Field& anchor = group.GetAnchor();
+	size_t extent = group.GetExtent();
+
+	// Blocks overlap by the extent, so every structure starting in a block can be tested in it
+	size_t bytesScanned = this->ScanChunks(chunks, extent - 1, [&](const ScanBlock& block) {
+		if (block.size < anchor.offset + anchor.size) {
+			return;
+		}
+
+		// The anchor is searched at every structure start, so the kernel's offsets are structure offsets
+		ScanInput input;
+		input.data = block.data + anchor.offset;
+		input.size = block.size - anchor.offset;
+		input.first = (alignment - block.address % alignment) % alignment;
+		input.limit = block.limit;
+		input.stride = alignment;
+
+		std::vector<uint32_t>& offsets = this->offsets[block.worker];
+		offsets.clear();
+		anchor.find(anchor, input, offsets, SimdLevel::AVX2);
+
+		std::vector<uintptr_t>& found = matches[block.chunk];
+		for (uint32_t offset : offsets) {
+			if (offset + extent <= block.size && group.Matches(block.data + offset, targets)) {
+				found.push_back(block.address + offset);
+			}
+		}
+	});
+
+	// Chunks are in address order, so joining their matches keeps the addresses sorted
+	std::vector<uintptr_t> results;
+	for (const std::vector<uintptr_t>& found : matches) {
+		results.insert(results.end(), found.begin(), found.end());
+	}
+
+	this->statistics.regionCount = regions.size();
+	this->statistics.bytesScanned = bytesScanned;
+	this->statistics.resultCount = results.size();
+	this->statistics.cleanCount = 0;
+	this->statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return results;
+}
+
+template <typename T>
+ScanResults<T> Scanner::FirstScan(const Snapshot& snapshot, NextScanCompare compare) {
+	static_assert(std::is_arithmetic<T>::value && sizeof(T) <= 8, "FirstScan supports 8 to 64-bit integers, float and double");
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<ScanChunk> chunks = this->SplitRegions(snapshot.GetRegions());
+	size_t alignment = this->options.alignment ? this->options.alignment : sizeof(T);
+
+	if (this->tracker) {
+		this->tracker->Reset();
+	}
+
+	ScanResults<T> results(alignment);
+	results.regions.reserve(chunks.size());
+	for (const ScanChunk& chunk : chunks) {
+		results.regions.push_back(ScanResults<T>::MakeRegion(chunk.address, chunk.size));
+	}
+
+	size_t bytesScanned = this->ScanChunks(chunks, sizeof(T) - 1, [&](const ScanBlock& block) {
+		typename ScanResults<T>::Region& region = results.regions[block.chunk];
+		std::vector<uint8_t>& previous = this->previousBuffers[block.worker];
+		size_t pageCount = (block.size + kPageSize - 1) / kPageSize;
+		if (previous.size() < pageCount * kPageSize) {
+			previous.resize(pageCount * kPageSize);
+		}
+
+		// Raw and zero snapshot pages are used in place, compressed ones are decompressed into the worker's buffer
+		std::vector<const uint8_t*> pages(pageCount);
+		for (size_t page = 0; page < pageCount; ++page) {
+			pages[page] = snapshot.GetPage(block.address + page * kPageSize, previous.data() + page * kPageSize);
+		}
+
+		size_t blockOffset = (size_t)(block.address - region.base);
+		auto test = [&](size_t offset, const uint8_t* old) {
+			T current, value;
+			std::memcpy(&current, block.data + offset, sizeof(T));
+			std::memcpy(&value, old, sizeof(T));
+
+			bool keep;
+			switch (compare) {
+			case NextScanCompare::Changed: keep = std::memcmp(&current, &value, sizeof(T)) != 0; break;
+			case NextScanCompare::Unchanged: keep = std::memcmp(&current, &value, sizeof(T)) == 0; break;
+			case NextScanCompare::Increased: keep = current > value; break;
+			default: keep = current < value; break;
+			}
+
+			if (keep) {
+				results.Append(region, blockOffset + offset, current);
+			}
+		};
+
+		// Compare one page of candidate starts at a time
+		for (size_t page = 0; page * kPageSize < block.limit; ++page) {
+			const uint8_t* old = pages[page];
+			if (!old) {
+				continue;
+			}
+
+			size_t begin = page * kPageSize;
+			size_t end = std::min(begin + kPageSize, block.limit);
+			size_t inside = std::min(begin + kPageSize, block.size);
+			size_t offset = begin + (alignment - (block.address + begin) % alignment) % alignment;
+
+			// Values inside the page; a page that did not change has no changed values
+			if (compare == NextScanCompare::Unchanged || std::memcmp(block.data + begin, old, inside - begin) != 0) {
+				for (; offset < end && offset + sizeof(T) <= inside; offset += alignment) {
+					test(offset, old + (offset - begin));
+				}
+			} else if (offset + sizeof(T) <= inside) {
+				offset += (inside - sizeof(T) - offset) / alignment * alignment + alignment;
+			}
+
+			// Values reaching into the next page are assembled from both snapshot pages
+			for (; offset < end && offset + sizeof(T) <= block.size && pages[page + 1]; offset += alignment) {
+				uint8_t bytes[sizeof(T)];
+				size_t head = begin + kPageSize - offset;
+				std::memcpy(bytes, old + (offset - begin), head);
+				std::memcpy(bytes + head, pages[page + 1], sizeof(T) - head);
+				test(offset, bytes);
+			}
+		}
+	});
+
+	results.Compact();
+
+	this->statistics.regionCount = snapshot.GetRegions().size();
+	this->statistics.bytesScanned = bytesScanned;
+	this->statistics.resultCount = results.GetCount();
+	this->statistics.cleanCount = 0;
+	this->statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return results;
+}
+
+template <typename T, typename Keep>
+size_t Scanner::NarrowResults(ScanResults<T>& results, const Keep& keep) {
+	auto start = std::chrono::steady_clock::now();
+	std::atomic<size_t> bytesScanned{ 0 };
+	std::atomic<size_t> cleanCount{ 0 };
+
+	// With a tracker, collect the pages written since the last scan, then clear them for the next one
+	std::vector<std::vector<uint64_t>> dirtyPages;
+	if (this->tracker) {
+		if (this->tracker->IsTracking()) {
+			dirtyPages.resize(results.regions.size());
+			this->pool->Run(results.regions.size(), [&](size_t index, size_t) {
+				const typename ScanResults<T>::Region& region = results.regions[index];
+				uintptr_t firstPage = region.base & ~(kPageSize - 1);
+				size_t pageCount = (size_t)((region.base + region.size + sizeof(T) - 1 - firstPage + kPageSize - 1) / kPageSize);
+				dirtyPages[index].resize((pageCount + 63) / 64);
+				this->tracker->QueryPages(firstPage, pageCount, dirtyPages[index].data());
+			});
+		}
+		this->tracker->Reset();
+	}
+
+	// Every task rebuilds one chunk in place
+	this->pool->Run(results.regions.size(), [&](size_t index, size_t worker) {
+		typename ScanResults<T>::Region& region = results.regions[index];
+		std::vector<uint32_t>& hits = this->offsets[worker];
+		std::vector<BatchEntry>& batch = this->batches[worker];
+		std::vector<uint8_t>& buffer = this->buffers[worker];
+
+		// A result is clean if no page holding a byte of it was written since the last scan
+		const uint64_t* dirty = dirtyPages.empty() ? nullptr : dirtyPages[index].data();
+		uintptr_t firstPage = region.base & ~(kPageSize - 1);
+		auto isClean = [&](uintptr_t address) {
+			if (!dirty) {
+				return false;
+			}
+			for (size_t page = (address - firstPage) / kPageSize; page <= (address + sizeof(T) - 1 - firstPage) / kPageSize; ++page) {
+				if (dirty[page / 64] >> (page % 64) & 1) {
+					return false;
+				}
+			}
+			return true;
+		};
+
+		// Expand the chunk's results into a plain offset list
+		hits.clear();
+		results.ForEachOffset(region, [&](size_t offset, size_t) {
+			hits.push_back((uint32_t)offset);
+		});
+
+		// Coalesce the dirty results into runs of one page each. A batch entry fails as a whole, so
+		// a page protected since the last scan then only drops the results on that page
+		batch.clear();
+		for (uint32_t offset : hits) {
+			uintptr_t address = region.base + offset;
+			if (isClean(address)) {
+				continue;
+			}
+			if (batch.empty() || (address & ~(kPageSize - 1)) != (batch.back().address & ~(kPageSize - 1))) {
+				BatchEntry entry;
+				entry.address = address;
+				entry.size = sizeof(T);
+				batch.push_back(entry);
+			} else {
+				batch.back().size = (size_t)(address + sizeof(T) - batch.back().address);
+			}
+		}
+
+		// Lay the runs out back to back in the worker's buffer and fetch them in one batch
+		size_t total = 0;
+		for (const BatchEntry& entry : batch) {
+			total += entry.size;
+		}
+		if (buffer.size() < total) {
+			buffer.resize(total);
+		}
+
+		size_t position = 0;
+		for (BatchEntry& entry : batch) {
+			entry.buffer = buffer.data() + position;
+			position += entry.size;
+		}
+		this->memory.ReadBatch(batch);
+
+		// Keep the results that pass, along with their current values
+		typename ScanResults<T>::Region narrowed = ScanResults<T>::MakeRegion(region.base, region.size);
+		size_t run = 0, clean = 0;
+		for (size_t i = 0; i < hits.size(); ++i) {
+			uintptr_t address = region.base + hits[i];
+			const T& previous = region.values.empty() ? region.value : region.values[i];
+
+			// A clean result still holds the value read by the last scan
+			T current;
+			if (isClean(address)) {
+				current = previous;
+				++clean;
+			} else {
+				while (address + sizeof(T) > batch[run].address + batch[run].size) {
+					++run;
+				}
+
+				// A run that could not be read has been unmapped or protected since the last scan
+				if (!batch[run].success) {
+					continue;
+				}
+
+				std::memcpy(&current, (const uint8_t*)batch[run].buffer + (address - batch[run].address), sizeof(T));
+			}
+
+			if (keep(current, previous)) {
+				results.Append(narrowed, hits[i], current);
+			}
+		}
+
+		region = std::move(narrowed);
+		bytesScanned.fetch_add(total, std::memory_order_relaxed);
+		cleanCount.fetch_add(clean, std::memory_order_relaxed);
+	});
+
+	size_t regionCount = results.regions.size();
+	results.Compact();
+
+	this->statistics.regionCount = regionCount;
+	this->statistics.bytesScanned = bytesScanned.load();
+	this->statistics.resultCount = results.GetCount();
+	this->statistics.cleanCount = cleanCount.load();
+	this->statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return this->statistics.resultCount;
+}
+
+template <typename T>
+size_t Scanner::NextScan(ScanResults<T>& results, NextScanCompare compare) {
+	switch (compare) {
+	case NextScanCompare::Changed:
+		return this->NarrowResults(results, [](const T& current, const T& previous) {
+			return std::memcmp(&current, &previous, sizeof(T)) != 0;
+		});
+	case NextScanCompare::Unchanged:
+		return this->NarrowResults(results, [](const T& current, const T& previous) {
+			return std::memcmp(&current, &previous, sizeof(T)) == 0;
+		});
+	case NextScanCompare::Increased:
+		return this->NarrowResults(results, [](const T& current, const T& previous) {
+			return current > previous;
+		});
+	default:
+		return this->NarrowResults(results, [](const T& current, const T& previous) {
+			return current < previous;
+		});
+	}
+}
+
+template <typename T>
+size_t Scanner::NextScan(ScanResults<T>& results, const ScanPredicate<T>& predicate) {
+	return this->NarrowResults(results, [&predicate](const T& current, const T&) {
+		return predicate.Matches(current);
+	});
+}
+
+void Scanner::SetDirtyTracker(DirtyPageTracker* tracker) {
+	this->tracker = tracker;
+}
+
+const ScanStatistics& Scanner::GetStatistics() const {
+	return this->statistics;
+}
+
+const ScanOptions& Scanner::GetOptions() const {
+	return this->options;
+}
+
+size_t Scanner::GetThreadCount() const {
+	return this->pool->GetThreadCount();
+}
+
+ThreadPool& Scanner::GetThreadPool() {
+	return *this->pool;
+}
+
+// Value types supported by FirstScan and NextScan
+template ScanResults<int8_t> Scanner::FirstScan<int8_t>(const ScanPredicate<int8_t>&);
+template ScanResults<uint8_t> Scanner::FirstScan<uint8_t>(const ScanPredicate<uint8_t>&);
+template ScanResults<int16_t> Scanner::FirstScan<int16_t>(const ScanPredicate<int16_t>&);
+template ScanResults<uint16_t> Scanner::FirstScan<uint16_t>(const ScanPredicate<uint16_t>&);
+template ScanResults<int32_t> Scanner::FirstScan<int32_t>(const ScanPredicate<int32_t>&);
+template ScanResults<uint32_t> Scanner::FirstScan<uint32_t>(const ScanPredicate<uint32_t>&);
+template ScanResults<int64_t> Scanner::FirstScan<int64_t>(const ScanPredicate<int64_t>&);
+template ScanResults<uint64_t> Scanner::FirstScan<uint64_t>(const ScanPredicate<uint64_t>&);
+template ScanResults<float> Scanner::FirstScan<float>(const ScanPredicate<float>&);
+template ScanResults<double> Scanner::FirstScan<double>(const ScanPredicate<double>&);
+template ScanResults<int8_t> Scanner::FirstScan<int8_t>(const Snapshot&, NextScanCompare);
+template ScanResults<uint8_t> Scanner::FirstScan<uint8_t>(const Snapshot&, NextScanCompare);
+template ScanResults<int16_t> Scanner::FirstScan<int16_t>(const Snapshot&, NextScanCompare);
+template ScanResults<uint16_t> Scanner::FirstScan<uint16_t>(const Snapshot&, NextScanCompare);
+template ScanResults<int32_t> Scanner::FirstScan<int32_t>(const Snapshot&, NextScanCompare);
+template ScanResults<uint32_t> Scanner::FirstScan<uint32_t>(const Snapshot&, NextScanCompare);
+template ScanResults<int64_t> Scanner::FirstScan<int64_t>(const Snapshot&, NextScanCompare);
+template ScanResults<uint64_t> Scanner::FirstScan<uint64_t>(const Snapshot&, NextScanCompare);
+template ScanResults<float> Scanner::FirstScan<float>(const Snapshot&, NextScanCompare);
+template ScanResults<double> Scanner::FirstScan<double>(const Snapshot&, NextScanCompare);
+template size_t Scanner::NextScan<int8_t>(ScanResults<int8_t>&, NextScanCompare);
+template size_t Scanner::NextScan<uint8_t>(ScanResults<uint8_t>&, NextScanCompare);
+template size_t Scanner::NextScan<int16_t>(ScanResults<int16_t>&, NextScanCompare);
+template size_t Scanner::NextScan<uint16_t>(ScanResults<uint16_t>&, NextScanCompare);
+template size_t Scanner::NextScan<int32_t>(ScanResults<int32_t>&, NextScanCompare);
+template size_t Scanner::NextScan<uint32_t>(ScanResults<uint32_t>&, NextScanCompare);
+template size_t Scanner::NextScan<int64_t>(ScanResults<int64_t>&, NextScanCompare);
+template size_t Scanner::NextScan<uint64_t>(ScanResults<uint64_t>&, NextScanCompare);
+template size_t Scanner::NextScan<float>(ScanResults<float>&, NextScanCompare);
+template size_t Scanner::NextScan<double>(ScanResults<double>&, NextScanCompare);
+template size_t Scanner::NextScan<int8_t>(ScanResults<int8_t>&, const ScanPredicate<int8_t>&);
+template size_t Scanner::NextScan<uint8_t>(ScanResults<uint8_t>&, const ScanPredicate<uint8_t>&);
+template size_t Scanner::NextScan<int16_t>(ScanResults<int16_t>&, const ScanPredicate<int16_t>&);
+template size_t Scanner::NextScan<uint16_t>(ScanResults<uint16_t>&, const ScanPredicate<uint16_t>&);
+template size_t Scanner::NextScan<int32_t>(ScanResults<int32_t>&, const ScanPredicate<int32_t>&);
+template size_t Scanner::NextScan<uint32_t>(ScanResults<uint32_t>&, const ScanPredicate<uint32_t>&);
+template size_t Scanner::NextScan<int64_t>(ScanResults<int64_t>&, const ScanPredicate<int64_t>&);
+template size_t Scanner::NextScan<uint64_t>(ScanResults<uint64_t>&, const ScanPredicate<uint64_t>&);
+template size_t Scanner::NextScan<float>(ScanResults<float>&, const ScanPredicate<float>&);
+template size_t Scanner::NextScan<double>(ScanResults<double>&, const ScanPredicate<double>&);
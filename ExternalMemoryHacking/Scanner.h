@@ -0,0 +1,292 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "DirtyPageTracker.h"
+#include "Memory.h"
+#include "ScanGroup.h"
+#include "ScanKernels.h"
+#include "ScanResults.h"
+#include "Snapshot.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief Settings shared by all scans of a Scanner.
+ */
+struct ScanOptions {
+	size_t alignment = 0;        // Distance between candidate addresses, 0 uses sizeof(T)
+	size_t threadCount = 0;      // Number of worker threads, 0 uses one per hardware thread
+	ThreadPool* pool = nullptr;  // Workers shared with other scanners (threadCount is then ignored), nullptr starts its own
+	size_t chunkSize = 16 << 20; // Largest piece of a region handed to a single task (multiple of 4 KiB)
+	size_t blockSize = 1 << 20;  // Bytes copied per read into a worker's buffer (multiple of 4 KiB)
+	bool writableOnly = false;   // Skip read-only regions such as code and constants
+};
+
+/**
+ * @brief Numbers describing the last scan run by a Scanner.
+ */
+struct ScanStatistics {
+	size_t regionCount = 0;  // Regions that were scanned
+	size_t bytesScanned = 0; // Bytes copied from the target process
+	size_t resultCount = 0;  // Addresses that matched
+	size_t cleanCount = 0;   // Results of a next scan kept without a read because their pages were clean
+	double seconds = 0;      // Wall clock time of the whole scan
+
+	/**
+	 * @brief Returns the scan throughput in gigabytes (10^9 bytes) per second.
+	 */
+	double GetThroughput() const;
+};
+
+/**
+ * @brief A piece of a region scanned by one task.
+ *
+ * Candidate values start in [address, address + size). Reads may extend up to
+ * regionEnd so values crossing the end of the chunk are still found.
+ */
+struct ScanChunk {
+	uintptr_t address = 0;   // First candidate address
+	size_t size = 0;         // Number of candidate start bytes
+	uintptr_t regionEnd = 0; // End of the region the chunk belongs to
+};
+
+/**
+ * @brief A block of target memory copied into a worker's buffer.
+ *
+ * data holds size bytes copied from address. Only values starting before
+ * address + limit belong to this block; the bytes after that are the overlap
+ * into the next block.
+ */
+struct ScanBlock {
+	uintptr_t address = 0;         // Address of data[0] in the target process
+	const uint8_t* data = nullptr; // Local copy of the target memory
+	size_t size = 0;               // Number of valid bytes in data
+	size_t limit = 0;              // Values must start below this offset
+	size_t chunk = 0;              // Index of the chunk this block belongs to
+	size_t worker = 0;             // Worker thread running the visitor
+};
+
+/**
+ * @brief Finds addresses in a target process by the value stored there.
+ *
+ * The scanner enumerates the committed, readable regions of the process attached to a
+ * Memory instance, splits them into chunks and spreads the chunks over a thread pool.
+ * Every worker copies its chunk block by block into a buffer that is reused for the
+ * whole scan, so the scan runs close to memory bandwidth and scales with core count.
+ * Scanning a SnapshotFile instead of a Memory instance works the same way, except that
+ * blocks are scanned in place in the mapped file instead of being copied.
+ */
+class Scanner {
+private:
+	// Memory instance attached to the target process, or a capture of one
+	MemoryReader& memory;
+
+	// Settings used by every scan
+	ScanOptions options;
+
+	// Workers of this scanner, started by it unless ScanOptions::pool shares another pool
+	std::unique_ptr<ThreadPool> ownPool;
+	ThreadPool* pool = nullptr;
+
+	// One reusable read buffer per worker
+	std::vector<std::vector<uint8_t>> buffers;
+
+	// One reusable list of matching block offsets per worker
+	std::vector<std::vector<uint32_t>> offsets;
+
+	// One reusable list of batched reads per worker, used by next scans
+	std::vector<std::vector<BatchEntry>> batches;
+
+	// One reusable buffer per worker for the snapshot copy of a block, used by snapshot scans
+	std::vector<std::vector<uint8_t>> previousBuffers;
+
+	// Numbers of the last scan
+	ScanStatistics statistics;
+
+	// Optional tracker of the pages written between scans, nullptr to always read every result
+	DirtyPageTracker* tracker = nullptr;
+
+	/**
+	 * @brief Re-reads every result and keeps those for which keep(current, previous) is true.
+	 *
+	 * Shared by both NextScan overloads, defined in Scanner.cpp.
+	 */
+	template <typename T, typename Keep>
+	size_t NarrowResults(ScanResults<T>& results, const Keep& keep);
+
+public:
+	/**
+	 * @brief Creates a scanner for the process attached to memory.
+	 *
+	 * @param memory The Memory instance (or SnapshotFile) used for all reads. It must outlive the scanner.
+	 * @param options Settings used by every scan.
+	 */
+	Scanner(MemoryReader& memory, const ScanOptions& options = ScanOptions());
+
+	/**
+	 * @brief Returns the regions a scan would cover, filtered by the scan options.
+	 *
+	 * @return The readable regions of the target process in ascending address order.
+	 */
+	std::vector<MemoryRegion> GetRegions();
+
+	/**
+	 * @brief Splits regions into chunks of at most ScanOptions::chunkSize bytes.
+	 *
+	 * @param regions The regions to split.
+	 * @return The chunks in ascending address order.
+	 */
+	std::vector<ScanChunk> SplitRegions(const std::vector<MemoryRegion>& regions) const;
+
+	/**
+	 * @brief Copies every chunk block by block and passes the blocks to a visitor in parallel.
+	 *
+	 * This is the engine behind every scan. Chunks are distributed over the thread pool, and each
+	 * worker reads into its own reused buffer, unless the reader can hand out the memory in place
+	 * (MemoryReader::GetView). When a read hits an unreadable page, the readable
+	 * prefix is still visited and the scan continues after that page. The visitor is called from
+	 * several threads at once, but never concurrently for the same chunk.
+	 *
+	 * @param chunks The chunks to scan.
+	 * @param overlap Extra bytes to read past the end of each block (usually sizeof(T) - 1).
+	 * @param visitor Called for every block that could be read.
+	 * @return The number of bytes copied from the target process.
+	 */
+	size_t ScanChunks(const std::vector<ScanChunk>& chunks, size_t overlap, const std::function<void(const ScanBlock&)>& visitor);
+
+	/**
+	 * @brief Scans all readable memory for values matching a predicate.
+	 *
+	 * Every address that is a multiple of the alignment (sizeof(T) by default) and holds a value
+	 * matching the predicate is returned together with its current value. The blocks are searched
+	 * with the SIMD kernels of ScanKernel<T> (AVX2 or SSE4.2, chosen at runtime). Supported types
+	 * are the 8 to 64-bit integers, float and double. ScanOptions::chunkSize must stay below 4 GiB
+	 * because results are stored as 32-bit offsets into their chunk.
+	 *
+	 * @tparam T The type of the value stored in the target process.
+	 * @param predicate The condition to search for, e.g. ScanPredicate<float>::Between(0, 1).
+	 * @return The matching addresses and values in ascending address order.
+	 */
+	template <typename T>
+	ScanResults<T> FirstScan(const ScanPredicate<T>& predicate);
+
+	/**
+	 * @brief Scans all readable memory for a value.
+	 *
+	 * Shorthand for FirstScan(ScanPredicate<T>::Equal(value)).
+	 *
+	 * @tparam T The type of the value stored in the target process.
+	 * @param value The value to search for.
+	 * @return The matching addresses and values in ascending address order.
+	 */
+	template <typename T>
+	ScanResults<T> FirstScan(T value) {
+		return this->FirstScan(ScanPredicate<T>::Equal(value));
+	}
+
+	/**
+	 * @brief Scans all readable memory for structures whose fields match every condition of a group.
+	 *
+	 * Every block is searched once: the SIMD kernel of the group's anchor field yields the few
+	 * addresses where it matches, and the other fields are tested at those addresses in the same
+	 * local copy, so no candidate list is built and nothing is read twice. Pointer fields are
+	 * looked up in the regions of the scan. Structures may start at every multiple of the
+	 * alignment (ScanGroup::GetAlignment() by default) and must lie within one region.
+	 *
+	 * @param group The fields to match, e.g. an int of 100 at +0 and a float in [0, 1] at +8.
+	 * @return The addresses of the matching structures in ascending order.
+	 */
+	std::vector<uintptr_t> GroupScan(const ScanGroup& group);
+
+	/**
+	 * @brief Scans for an unknown initial value by comparing all memory captured in a snapshot with its current value.
+	 *
+	 * Every region of the snapshot is read again and compared, at every multiple of the alignment,
+	 * with the snapshot page by page. Pages that did not change at all are skipped with a single
+	 * compare, unless every value of them is wanted (Unchanged). Values on pages missing from the
+	 * snapshot or no longer readable are not reported. The results hold the current values, so
+	 * NextScan can narrow them further.
+	 *
+	 * @tparam T The type of the value stored in the target process.
+	 * @param snapshot A snapshot taken earlier with Snapshot::Capture.
+	 * @param compare The comparison between the current and the snapshot value.
+	 * @return The matching addresses and their current values in ascending address order.
+	 */
+	template <typename T>
+	ScanResults<T> FirstScan(const Snapshot& snapshot, NextScanCompare compare);
+
+	/**
+	 * @brief Narrows the results of an earlier scan by comparing every result with its previous value.
+	 *
+	 * Only the surviving addresses are read again. The results on one page are coalesced into a run,
+	 * and all runs of a chunk are fetched with one batched read. Results whose memory can no longer
+	 * be read are dropped; since runs never cross a page (except for a value straddling the
+	 * boundary), a protected page only drops its own results. The stored values of the survivors are
+	 * updated, so the next call compares against this scan. Changed and Unchanged compare the raw
+	 * bytes, which keeps a NaN that did not change as unchanged. With a dirty-page tracker
+	 * (SetDirtyTracker), results on pages that were not written since the last scan keep their
+	 * previous value without being read. Such a value is only exact if the target does not write
+	 * while the scan starts, see SetDirtyTracker.
+	 *
+	 * @tparam T The type of the value stored in the target process.
+	 * @param results The results to narrow in place.
+	 * @param compare The comparison between the current and the previous value.
+	 * @return The number of remaining results.
+	 */
+	template <typename T>
+	size_t NextScan(ScanResults<T>& results, NextScanCompare compare);
+
+	/**
+	 * @brief Narrows the results of an earlier scan to those whose current value matches a predicate.
+	 *
+	 * Use ScanPredicate<T>::Equal(newValue) for the "value is now X" step of a scan. Reads are
+	 * coalesced and batched as in the other NextScan overload.
+	 *
+	 * @tparam T The type of the value stored in the target process.
+	 * @param results The results to narrow in place.
+	 * @param predicate The condition the current value has to match.
+	 * @return The number of remaining results.
+	 */
+	template <typename T>
+	size_t NextScan(ScanResults<T>& results, const ScanPredicate<T>& predicate);
+
+	/**
+	 * @brief Lets next scans skip results on pages the target did not write since the previous scan.
+	 *
+	 * Every scan resets the tracker before it reads, so the following NextScan only reads the
+	 * results on pages written in between. Where tracking is unavailable the tracker reports every
+	 * page as dirty and scans read everything as before.
+	 *
+	 * A NextScan first queries the dirty pages of all results and then resets the tracker. A
+	 * write landing between the two on a page that was reported clean is lost: the result keeps
+	 * its old value in this and every later NextScan until its page is written again. On a large
+	 * heap the query takes milliseconds, so suspend the target around scans of values it writes
+	 * constantly, or drop the tracker when an occasional stale result is not acceptable.
+	 *
+	 * @param tracker The tracker, attached to the same process as the scanner, or nullptr to stop
+	 *        using one. It must outlive the scanner or be removed first.
+	 */
+	void SetDirtyTracker(DirtyPageTracker* tracker);
+
+	/**
+	 * @brief Returns the statistics of the last scan, including its throughput in GB/s.
+	 */
+	const ScanStatistics& GetStatistics() const;
+
+	/**
+	 * @brief Returns the options used by this scanner.
+	 */
+	const ScanOptions& GetOptions() const;
+
+	/**
+	 * @brief Returns the number of worker threads used by this scanner.
+	 */
+	size_t GetThreadCount() const;
+
+	/**
+	 * @brief Returns the workers of this scanner, so tools built on it can run their own parallel steps.
+	 */
+	ThreadPool& GetThreadPool();
+};
@@ -0,0 +1,248 @@
+#include "SessionManager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cwctype>
+#include <iterator>
+#include "TickSchedule.h"
+
+namespace {
+	// Nanoseconds of the steady clock, the time base of the events
+	uint64_t GetTimestamp() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	bool EqualsIgnoreCase(const std::wstring& left, const std::wstring& right) {
+		return left.size() == right.size() && std::equal(left.begin(), left.end(), right.begin(),
+			[](wchar_t a, wchar_t b) { return std::towlower(a) == std::towlower(b); });
+	}
+}
+
+Session::Session(DWORD processID, const SessionOptions& options, ThreadPool& pool)
+	: memory(processID), name(memory.GetProcessNameW()), options(options), pool(pool) {
+}
+
+DWORD Session::GetProcessID() {
+	return this->memory.GetProcessID();
+}
+
+const std::wstring& Session::GetName() const {
+	return this->name;
+}
+
+Memory& Session::GetMemory() {
+	return this->memory;
+}
+
+Scanner& Session::GetScanner() {
+	std::call_once(this->scannerCreated, [this] {
+		// Chunks of every session's scans go to the shared pool
+		ScanOptions scanOptions = this->options.scan;
+		scanOptions.pool = &this->pool;
+		this->scanner.reset(new Scanner(this->memory, scanOptions));
+	});
+	return *this->scanner;
+}
+
+Watcher& Session::GetWatcher() {
+	std::call_once(this->watcherCreated, [this] {
+		this->watcher.reset(new Watcher(this->memory, this->options.watch));
+	});
+	return *this->watcher;
+}
+
+bool Session::HasExited() {
+	return Platform::HasExited(this->memory.GetProcess());
+}
+
+SessionManager::SessionManager(const SessionOptions& options)
+	: options(options), pool(options.threadCount), queue(options.queueCapacity) {
+}
+
+SessionManager::~SessionManager() {
+	this->Stop();
+}
+
+size_t SessionManager::Track(const std::wstring& processName) {
+	return this->Track([processName](DWORD, const std::wstring& name) { return EqualsIgnoreCase(name, processName); });
+}
+
+size_t SessionManager::Track(Filter filter) {
+	{
+		// Every process has to be matched against the new filter, so forget which were seen
+		std::lock_guard<std::mutex> lock(this->refreshMutex);
+		this->filter = filter;
+		this->knownIDs.clear();
+	}
+
+	this->Refresh();
+	return this->GetSessionCount();
+}
+
+void SessionManager::Publish(DWORD processID, SessionEvent::Type type, uint64_t timestamp) {
+	SessionEvent event;
+	event.processID = processID;
+	event.type = type;
+	event.timestamp = timestamp;
+	if (!this->queue.TryPush(event)) {
+		++this->statistics.droppedEvents;
+	}
+}
+
+size_t SessionManager::Refresh() {
+	std::lock_guard<std::mutex> refreshLock(this->refreshMutex);
+	auto start = std::chrono::steady_clock::now();
+	uint64_t timestamp = GetTimestamp();
+
+	// Exits are read from the handles of the sessions; nothing is listed for them
+	std::vector<std::shared_ptr<Session>> current = this->GetSessions();
+	std::vector<DWORD> exitedIDs;
+	for (const std::shared_ptr<Session>& session : current) {
+		if (session->HasExited()) {
+			exitedIDs.push_back(session->GetProcessID());
+		}
+	}
+
+	std::sort(exitedIDs.begin(), exitedIDs.end());
+
+	// Spawns are the listed IDs that were not there before; only their names are looked up. An exited
+	// process stays listed until its parent reaps it, and is not looked up again while it is
+	std::vector<DWORD> processIDs = Platform::EnumerateProcessIDs();
+	std::sort(processIDs.begin(), processIDs.end());
+	std::vector<DWORD> newIDs;
+	std::set_difference(processIDs.begin(), processIDs.end(), this->knownIDs.begin(), this->knownIDs.end(), std::back_inserter(newIDs));
+	this->knownIDs = processIDs;
+
+	// Look up and attach the new processes in parallel; opening a process and reading its maps is most of an attach
+	std::vector<std::shared_ptr<Session>> attached(newIDs.size());
+	std::atomic<size_t> failed{ 0 };
+	if (this->filter) {
+		this->pool.Run(newIDs.size(), [&](size_t index, size_t) {
+			std::wstring name = Platform::FindProcessName(newIDs[index]);
+			if (name.empty() || !this->filter(newIDs[index], name)) {
+				return;
+			}
+
+			std::shared_ptr<Session> session = std::make_shared<Session>(newIDs[index], this->options, this->pool);
+			if (session->GetMemory().isAttached()) {
+				attached[index] = session;
+			}
+			else {
+				++failed;
+			}
+		});
+	}
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	size_t changes = 0;
+	if (!exitedIDs.empty()) {
+		this->sessions.erase(std::remove_if(this->sessions.begin(), this->sessions.end(), [&](const std::shared_ptr<Session>& session) {
+			return std::binary_search(exitedIDs.begin(), exitedIDs.end(), session->GetProcessID());
+		}), this->sessions.end());
+
+		for (DWORD processID : exitedIDs) {
+			this->Publish(processID, SessionEvent::Exited, timestamp);
+		}
+		this->statistics.exitCount += exitedIDs.size();
+		changes += exitedIDs.size();
+	}
+
+	for (std::shared_ptr<Session>& session : attached) {
+		if (session) {
+			this->Publish(session->GetProcessID(), SessionEvent::Attached, timestamp);
+			this->sessions.push_back(std::move(session));
+			++this->statistics.attachCount;
+			++changes;
+		}
+	}
+
+	this->statistics.sessionCount = this->sessions.size();
+	this->statistics.failedAttaches += failed;
+	this->statistics.lookupCount += this->filter ? newIDs.size() : 0;
+	++this->statistics.refreshCount;
+	this->statistics.lastRefreshSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return changes;
+}
+
+bool SessionManager::Start() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	if (this->running || this->options.refreshRate <= 0) {
+		return false;
+	}
+
+	this->stopping = false;
+	this->running = true;
+	this->thread = std::thread(&SessionManager::Run, this);
+	return true;
+}
+
+void SessionManager::Stop() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (!this->running) {
+			return;
+		}
+		this->stopping = true;
+	}
+
+	this->wake.notify_all();
+	this->thread.join();
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->running = false;
+}
+
+bool SessionManager::IsRunning() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->running;
+}
+
+void SessionManager::Run() {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	TickSchedule schedule(this->options.refreshRate);
+	while (schedule.Wait(lock, this->wake, [this] { return this->stopping; })) {
+		// Refresh takes the mutex itself when it publishes its changes
+		lock.unlock();
+		this->Refresh();
+		lock.lock();
+		schedule.Advance();
+	}
+}
+
+bool SessionManager::PollEvent(SessionEvent& event) {
+	return this->queue.TryPop(event);
+}
+
+std::vector<std::shared_ptr<Session>> SessionManager::GetSessions() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->sessions;
+}
+
+size_t SessionManager::GetSessionCount() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->sessions.size();
+}
+
+ThreadPool& SessionManager::GetThreadPool() {
+	return this->pool;
+}
+
+SessionStatistics SessionManager::GetStatistics() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->statistics;
+}
+
+void SessionManager::ForEach(const std::function<void(Session& session, size_t worker)>& task) {
+	// Work on a copy of the list, so refreshes can go on and exited sessions stay alive until their task is done
+	std::vector<std::shared_ptr<Session>> sessions = this->GetSessions();
+	this->pool.Run(sessions.size(), [&](size_t index, size_t worker) {
+		task(*sessions[index], worker);
+	});
+}
+
+void SessionManager::Tick() {
+	this->ForEach([](Session& session, size_t) {
+		session.GetWatcher().Tick();
+	});
+}
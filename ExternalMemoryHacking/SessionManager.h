@@ -0,0 +1,327 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "EventQueue.h"
+#include "Memory.h"
+#include "PointerPath.h"
+#include "Scanner.h"
+#include "ThreadPool.h"
+#include "Watcher.h"
+
+/**
+ * @brief Settings of a SessionManager.
+ */
+struct SessionOptions {
+	size_t threadCount = 0;              // Workers of the pool shared by all sessions, 0 uses one per hardware thread
+	double refreshRate = 10.0;           // Refreshes per second of the background thread started by Start
+	size_t queueCapacity = 4096;         // Attach and exit events the queue holds before further events are dropped
+	ScanOptions scan;                    // Settings of the scanner of every session; its pool is the shared one
+	WatchOptions watch = { 60.0, 1024 }; // Settings of the watcher of every session, with a small queue since there are many
+};
+
+/**
+ * @brief A process being attached to or found to have exited by a SessionManager.
+ */
+struct SessionEvent {
+	enum Type : uint8_t {
+		Attached, // A matching process was attached to
+		Exited    // An attached process exited and its session was removed
+	};
+
+	DWORD processID = 0;
+	Type type = Attached;
+	uint64_t timestamp = 0; // Time of the refresh in nanoseconds of std::chrono::steady_clock
+};
+
+/**
+ * @brief Numbers describing the refreshes of a SessionManager.
+ */
+struct SessionStatistics {
+	size_t sessionCount = 0;       // Processes attached right now
+	size_t attachCount = 0;        // Sessions created
+	size_t exitCount = 0;          // Sessions removed because their process exited
+	size_t failedAttaches = 0;     // Matching processes that could not be attached, e.g. for lack of rights
+	size_t refreshCount = 0;       // Refreshes run
+	size_t lookupCount = 0;        // Names of new processes looked up; every other process is only listed
+	size_t droppedEvents = 0;      // Events lost to a full queue
+	double lastRefreshSeconds = 0; // Time spent in the last refresh, including its attaches
+};
+
+/**
+ * @brief A value taken from one session by a fan-out call of SessionManager.
+ */
+template <typename T>
+struct SessionValue {
+	DWORD processID = 0;
+	T value = T();
+};
+
+/**
+ * @brief One process attached to by a SessionManager: its Memory instance, and a Scanner and
+ *        Watcher created on first use that run on the pool shared by all sessions.
+ */
+class Session {
+private:
+	Memory memory;
+	std::wstring name;
+
+	// Settings the scanner and the watcher are created with
+	const SessionOptions& options;
+	ThreadPool& pool;
+
+	// Created on first use, since most fan-out calls only read
+	std::once_flag scannerCreated;
+	std::unique_ptr<Scanner> scanner;
+	std::once_flag watcherCreated;
+	std::unique_ptr<Watcher> watcher;
+
+public:
+	/**
+	 * @brief Attaches to a process; check GetMemory().isAttached() afterwards.
+	 */
+	Session(DWORD processID, const SessionOptions& options, ThreadPool& pool);
+
+	Session(const Session&) = delete;
+	Session& operator=(const Session&) = delete;
+
+	/**
+	 * @brief Returns the ID of the process.
+	 */
+	DWORD GetProcessID();
+
+	/**
+	 * @brief Returns the executable name of the process.
+	 */
+	const std::wstring& GetName() const;
+
+	/**
+	 * @brief Returns the Memory instance attached to the process.
+	 */
+	Memory& GetMemory();
+
+	/**
+	 * @brief Returns the scanner of the process, which runs its chunks on the shared pool.
+	 */
+	Scanner& GetScanner();
+
+	/**
+	 * @brief Returns the watcher of the process, ticked by SessionManager::Tick.
+	 */
+	Watcher& GetWatcher();
+
+	/**
+	 * @brief Returns true if the process has exited, without waiting. See Platform::HasExited.
+	 */
+	bool HasExited();
+};
+
+/**
+ * @brief Attaches to every process matching a name or a filter and keeps the set up to date.
+ *
+ * Meant for fleets of identical processes: Track attaches to all matching processes at once,
+ * and every Refresh (called by hand or by the thread started with Start) removes the sessions
+ * whose process exited and attaches to the new matches:
+ *
+ *     SessionManager manager;
+ *     manager.Track(L"worker");
+ *     manager.Start();
+ *     std::vector<SessionValue<std::optional<int>>> health = manager.Read<int>(healthPath);
+ *
+ * A refresh does not take a snapshot of every process. Exits are detected through the handles
+ * of the sessions (a pidfd on Linux), and spawns by listing the process IDs and looking up the
+ * name of the IDs that were not there at the last refresh; see Platform::EnumerateProcessIDs.
+ * A process is matched once, when its ID first shows up, so an ID reused by a new process
+ * before the next refresh sees the old one gone is missed; such reuse is rare, since IDs are
+ * handed out in sequence.
+ *
+ * All sessions share one ThreadPool. New processes are looked up and attached in parallel on
+ * it, and ForEach, Read, FirstScan and Tick run one task per session on it. A scan started in
+ * such a task runs its chunks on the same pool, so idle workers steal chunks of the large
+ * processes and every core stays busy, whether there is one large process or hundreds of small ones.
+ */
+class SessionManager {
+public:
+	// Decides from the ID and executable name of a process whether to attach to it; called from pool workers
+	using Filter = std::function<bool(DWORD processID, const std::wstring& name)>;
+
+private:
+	SessionOptions options;
+
+	// Workers shared by every session
+	ThreadPool pool;
+
+	// The processes to attach to; set by Track
+	Filter filter;
+
+	// Attached sessions, in the order they were attached; guarded by mutex
+	std::vector<std::shared_ptr<Session>> sessions;
+
+	// Sorted process IDs seen by the last refresh, each already matched against the filter
+	std::vector<DWORD> knownIDs;
+
+	// Serializes refreshes; mutex guards the sessions, the statistics and the thread state
+	std::mutex refreshMutex;
+	std::mutex mutex;
+
+	// Attach and exit events
+	EventQueue<SessionEvent> queue;
+
+	// Background thread refreshing at SessionOptions::refreshRate
+	std::thread thread;
+	std::condition_variable wake;
+	bool running = false;
+	bool stopping = false;
+
+	SessionStatistics statistics;
+
+	// Queues an event, counting it as dropped if the queue is full
+	void Publish(DWORD processID, SessionEvent::Type type, uint64_t timestamp);
+
+	// Main loop of the background thread
+	void Run();
+
+public:
+	/**
+	 * @brief Creates a manager without sessions; Track chooses the processes to attach to.
+	 */
+	explicit SessionManager(const SessionOptions& options = SessionOptions());
+
+	/**
+	 * @brief Stops the background thread and detaches from every process.
+	 */
+	~SessionManager();
+
+	SessionManager(const SessionManager&) = delete;
+	SessionManager& operator=(const SessionManager&) = delete;
+
+	/**
+	 * @brief Attaches to every process with an executable name, compared case-insensitively, and to those started later.
+	 *
+	 * @return The number of sessions after the first refresh.
+	 */
+	size_t Track(const std::wstring& processName);
+
+	/**
+	 * @brief Attaches to every process a filter accepts, and to those started later.
+	 *
+	 * Sessions of processes the previous filter accepted are kept.
+	 *
+	 * @param filter Called once per process ID, from several pool workers at once.
+	 * @return The number of sessions after the first refresh.
+	 */
+	size_t Track(Filter filter);
+
+	/**
+	 * @brief Removes the sessions of exited processes and attaches to the new matches.
+	 *
+	 * @return The number of sessions attached or removed.
+	 */
+	size_t Refresh();
+
+	/**
+	 * @brief Starts refreshing on a background thread at SessionOptions::refreshRate.
+	 *
+	 * @return True if the thread was started, false if it already runs or the rate is not positive.
+	 */
+	bool Start();
+
+	/**
+	 * @brief Stops the background thread after its current refresh.
+	 */
+	void Stop();
+
+	/**
+	 * @brief Returns true while the background thread runs.
+	 */
+	bool IsRunning();
+
+	/**
+	 * @brief Takes the oldest attach or exit event from the queue. Safe to call from any thread.
+	 */
+	bool PollEvent(SessionEvent& event);
+
+	/**
+	 * @brief Returns the current sessions; they stay valid while held, even after their process exits, but not after the manager is destroyed.
+	 */
+	std::vector<std::shared_ptr<Session>> GetSessions();
+
+	/**
+	 * @brief Returns the number of current sessions.
+	 */
+	size_t GetSessionCount();
+
+	/**
+	 * @brief Returns the pool shared by the sessions, for parallel work of the caller's own.
+	 */
+	ThreadPool& GetThreadPool();
+
+	/**
+	 * @brief Returns the numbers describing the refreshes so far.
+	 */
+	SessionStatistics GetStatistics();
+
+	/**
+	 * @brief Runs task(session, worker) for every current session on the shared pool and waits for all of them.
+	 *
+	 * Tasks may start parallel work of their own on the pool, such as a scan. Fan-out calls must
+	 * not run concurrently on the same manager, since they share the scanners and watchers.
+	 */
+	void ForEach(const std::function<void(Session& session, size_t worker)>& task);
+
+	/**
+	 * @brief Runs a function on every current session and collects what it returns.
+	 *
+	 * @return One value per session, in the order of GetSessions.
+	 */
+	template <typename Result>
+	std::vector<SessionValue<Result>> Collect(const std::function<Result(Session& session)>& task) {
+		std::vector<std::shared_ptr<Session>> sessions = this->GetSessions();
+		std::vector<SessionValue<Result>> values(sessions.size());
+		this->pool.Run(sessions.size(), [&](size_t index, size_t) {
+			values[index].processID = sessions[index]->GetProcessID();
+			values[index].value = task(*sessions[index]);
+		});
+		return values;
+	}
+
+	/**
+	 * @brief Reads a value at the same address in every process, see Memory::TryRead.
+	 */
+	template <typename T>
+	std::vector<SessionValue<std::optional<T>>> Read(uintptr_t address) {
+		return this->Collect<std::optional<T>>([address](Session& session) { return session.GetMemory().TryRead<T>(address); });
+	}
+
+	/**
+	 * @brief Follows a pointer path in every process and reads the value it leads to, see Memory::TryGetAddress.
+	 */
+	template <typename T>
+	std::vector<SessionValue<std::optional<T>>> Read(const PointerPath& path) {
+		return this->Collect<std::optional<T>>([&path](Session& session) -> std::optional<T> {
+			std::optional<uintptr_t> address = session.GetMemory().TryGetAddress(path);
+			return address ? session.GetMemory().TryRead<T>(*address) : std::nullopt;
+		});
+	}
+
+	/**
+	 * @brief Scans every process for values matching a predicate, see Scanner::FirstScan.
+	 */
+	template <typename T>
+	std::vector<SessionValue<ScanResults<T>>> FirstScan(const ScanPredicate<T>& predicate) {
+		return this->Collect<ScanResults<T>>([&predicate](Session& session) { return session.GetScanner().FirstScan(predicate); });
+	}
+
+	/**
+	 * @brief Runs one tick of the watcher of every session, see Watcher::Tick.
+	 */
+	void Tick();
+};
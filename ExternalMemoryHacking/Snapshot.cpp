@@ -0,0 +1,419 @@
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include "Instrumentation.h"
+#include "Scanner.h"
+
+namespace {
+	// Pages that shrink less than this are stored as they are
+	const size_t kMaxCompressedSize = Snapshot::kPageSize - Snapshot::kPageSize / 8;
+
+	// Shortest match the codec encodes, and the size of its match finder table
+	const size_t kMinMatch = 4;
+	const unsigned kHashBits = 12;
+
+	// Bytes moved by one step of the decompressor's short copies
+	const size_t kWildCopy = 16;
+
+	// A page of zeros, returned for zero pages without a copy
+	const uint8_t kZeroPage[Snapshot::kPageSize] = {};
+
+	uint32_t Load32(const uint8_t* data) {
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	// Writes an LZ4-style length extension: 255 while the remainder is at least 255, then the rest
+	bool PutLength(size_t length, uint8_t* out, size_t& position, size_t capacity) {
+		for (; length >= 255; length -= 255) {
+			if (position >= capacity) {
+				return false;
+			}
+			out[position++] = 255;
+		}
+		if (position >= capacity) {
+			return false;
+		}
+		out[position++] = (uint8_t)length;
+		return true;
+	}
+
+	// Reads a length extension written by PutLength
+	bool GetLength(const uint8_t* in, size_t size, size_t& position, size_t& length) {
+		uint8_t value;
+		do {
+			if (position >= size) {
+				return false;
+			}
+			value = in[position++];
+			length += value;
+		} while (value == 255);
+		return true;
+	}
+
+	// Appends one sequence: a token, the literals, and a match unless matchLength is 0 (the last sequence)
+	bool PutSequence(const uint8_t* literals, size_t literalLength, size_t matchOffset, size_t matchLength,
+		uint8_t* out, size_t& position, size_t capacity) {
+		if (position >= capacity) {
+			return false;
+		}
+		size_t matchCode = matchLength ? matchLength - kMinMatch : 0;
+		out[position++] = (uint8_t)((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15));
+
+		if (literalLength >= 15 && !PutLength(literalLength - 15, out, position, capacity)) {
+			return false;
+		}
+		if (position + literalLength > capacity) {
+			return false;
+		}
+		std::memcpy(out + position, literals, literalLength);
+		position += literalLength;
+
+		if (!matchLength) {
+			return true;
+		}
+		if (position + 2 > capacity) {
+			return false;
+		}
+		out[position++] = (uint8_t)matchOffset;
+		out[position++] = (uint8_t)(matchOffset >> 8);
+		return matchCode < 15 || PutLength(matchCode - 15, out, position, capacity);
+	}
+
+	// Compresses one page into out, returning the compressed size, or 0 if it does not fit into capacity
+	size_t CompressPage(const uint8_t* page, uint8_t* out, size_t capacity) {
+		uint16_t table[1 << kHashBits] = {};
+		size_t position = 0, anchor = 0, index = 0;
+
+		while (index + kMinMatch <= Snapshot::kPageSize) {
+			uint32_t sequence = Load32(page + index);
+			uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+			size_t candidate = table[hash];
+			table[hash] = (uint16_t)index;
+
+			if (candidate >= index || Load32(page + candidate) != sequence) {
+				// Step faster through data that does not compress
+				index += 1 + ((index - anchor) >> 6);
+				continue;
+			}
+
+			size_t length = kMinMatch;
+			while (index + length < Snapshot::kPageSize && page[candidate + length] == page[index + length]) {
+				++length;
+			}
+
+			if (!PutSequence(page + anchor, index - anchor, index - candidate, length, out, position, capacity)) {
+				return 0;
+			}
+			index += length;
+			anchor = index;
+		}
+
+		// The rest of the page is one last run of literals
+		if (!PutSequence(page + anchor, Snapshot::kPageSize - anchor, 0, 0, out, position, capacity)) {
+			return 0;
+		}
+		return position;
+	}
+
+	// Decompresses a page written by CompressPage, returning false for corrupt data
+	bool DecompressPage(const uint8_t* in, size_t size, uint8_t* page) {
+		// Short copies always move 16 bytes, so the page is assembled in a buffer with room to overshoot
+		uint8_t buffer[Snapshot::kPageSize + 2 * kWildCopy];
+		size_t position = 0, output = 0;
+
+		while (position < size) {
+			uint8_t token = in[position++];
+
+			size_t literalLength = token >> 4;
+			if (literalLength == 15 && !GetLength(in, size, position, literalLength)) {
+				return false;
+			}
+			if (position + literalLength > size || output + literalLength > Snapshot::kPageSize) {
+				return false;
+			}
+			if (literalLength <= kWildCopy && position + kWildCopy <= size) {
+				std::memcpy(buffer + output, in + position, kWildCopy);
+			} else {
+				std::memcpy(buffer + output, in + position, literalLength);
+			}
+			position += literalLength;
+			output += literalLength;
+
+			// The last sequence has no match
+			if (position == size) {
+				break;
+			}
+
+			if (position + 2 > size) {
+				return false;
+			}
+			size_t matchOffset = in[position] | (size_t)in[position + 1] << 8;
+			position += 2;
+
+			size_t matchLength = token & 15;
+			if (matchLength == 15 && !GetLength(in, size, position, matchLength)) {
+				return false;
+			}
+			matchLength += kMinMatch;
+			if (matchOffset == 0 || matchOffset > output || output + matchLength > Snapshot::kPageSize) {
+				return false;
+			}
+
+			// Distant matches are copied in 16 byte steps; closer ones repeat the bytes just written, front to back
+			uint8_t* target = buffer + output;
+			const uint8_t* source = target - matchOffset;
+			if (matchOffset >= kWildCopy) {
+				for (size_t i = 0; i < matchLength; i += kWildCopy) {
+					std::memcpy(target + i, source + i, kWildCopy);
+				}
+			} else {
+				for (size_t i = 0; i < matchLength; ++i) {
+					target[i] = source[i];
+				}
+			}
+			output += matchLength;
+		}
+
+		if (output != Snapshot::kPageSize) {
+			return false;
+		}
+		std::memcpy(page, buffer, Snapshot::kPageSize);
+		return true;
+	}
+}
+
+double SnapshotStatistics::GetRatio() const {
+	return this->pageCount ? (double)this->storedBytes / (this->pageCount * Snapshot::kPageSize) : 0;
+}
+
+Snapshot::~Snapshot() {
+	this->Clear();
+}
+
+bool Snapshot::Capture(Scanner& scanner, const std::string& spillPath) {
+	auto start = std::chrono::steady_clock::now();
+	MEMORY_PROBE_START(probeStart);
+	this->Clear();
+	this->errorMessage.clear();
+
+	this->regions = scanner.GetRegions();
+	std::vector<ScanChunk> scanChunks = scanner.SplitRegions(this->regions);
+
+	this->chunks.resize(scanChunks.size());
+	for (size_t i = 0; i < scanChunks.size(); ++i) {
+		this->chunks[i].base = scanChunks[i].address;
+		this->chunks[i].pages.resize((scanChunks[i].size + kPageSize - 1) / kPageSize);
+	}
+
+	// Finished chunks are appended to the spill file one at a time
+	std::FILE* file = nullptr;
+	if (!spillPath.empty()) {
+		file = std::fopen(spillPath.c_str(), "wb");
+		if (!file) {
+			this->errorMessage = "Failed to create " + spillPath;
+			this->chunks.clear();
+			this->regions.clear();
+			MEMORY_PROBE_END(probeStart, Probe::SnapshotCapture, false, 0);
+			return false;
+		}
+		this->spillPath = spillPath;
+	}
+
+	// A finished chunk either moves its page data to the spill file or gives back the spare capacity
+	std::vector<uint8_t> finished(this->chunks.size());
+	std::mutex fileMutex;
+	uint64_t fileSize = 0;
+	bool fileFailed = false;
+	auto finish = [&](size_t index) {
+		Chunk& chunk = this->chunks[index];
+		finished[index] = 1;
+		if (!file) {
+			chunk.payload.shrink_to_fit();
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(fileMutex);
+		if (!chunk.payload.empty() && std::fwrite(chunk.payload.data(), 1, chunk.payload.size(), file) != chunk.payload.size()) {
+			fileFailed = true;
+		}
+		chunk.fileOffset = fileSize;
+		chunk.spilled = true;
+		fileSize += chunk.payload.size();
+		std::vector<uint8_t>().swap(chunk.payload);
+	};
+
+	scanner.ScanChunks(scanChunks, 0, [&](const ScanBlock& block) {
+		Chunk& chunk = this->chunks[block.chunk];
+		uint8_t compressed[kMaxCompressedSize];
+
+		// Only whole pages are stored; a partial read ends at an unreadable page anyway
+		for (size_t offset = 0; offset + kPageSize <= block.limit; offset += kPageSize) {
+			const uint8_t* data = block.data + offset;
+			size_t index = (size_t)(block.address + offset - chunk.base) / kPageSize;
+			Page& page = chunk.pages[index];
+
+			if (std::memcmp(data, kZeroPage, kPageSize) == 0) {
+				page.kind = PageKind::Zero;
+			} else if (offset >= kPageSize && std::memcmp(data, data - kPageSize, kPageSize) == 0) {
+				// The page before it was read in the same block, so its entry is already final
+				page = chunk.pages[index - 1];
+			} else {
+				size_t size = CompressPage(data, compressed, sizeof(compressed));
+				page.offset = (uint32_t)chunk.payload.size();
+				page.kind = size ? PageKind::Compressed : PageKind::Raw;
+				page.size = (uint16_t)(size ? size : kPageSize);
+				chunk.payload.insert(chunk.payload.end(), size ? compressed : data, (size ? compressed : data) + page.size);
+			}
+		}
+
+		// The last block of a chunk is visited last, so the chunk is complete after it
+		if (block.address + block.limit >= chunk.base + chunk.pages.size() * kPageSize) {
+			finish(block.chunk);
+		}
+	});
+
+	// Chunks ending in unreadable pages never reached their last block
+	for (size_t i = 0; i < this->chunks.size(); ++i) {
+		if (!finished[i]) {
+			finish(i);
+		}
+	}
+
+	if (file) {
+		fileFailed |= std::fclose(file) != 0;
+
+		if (fileFailed || !this->spillFile.Open(spillPath)) {
+			this->errorMessage = "Failed to write " + spillPath;
+			this->Clear();
+			MEMORY_PROBE_END(probeStart, Probe::SnapshotCapture, false, 0);
+			return false;
+		}
+	}
+
+	// Point every chunk at its page data and count the pages
+	this->statistics = SnapshotStatistics();
+	this->statistics.regionCount = this->regions.size();
+	for (Chunk& chunk : this->chunks) {
+		chunk.data = chunk.spilled ? this->spillFile.GetData() + chunk.fileOffset : chunk.payload.data();
+
+		const Page* previous = nullptr;
+		for (const Page& page : chunk.pages) {
+			if (page.kind == PageKind::Missing) {
+				previous = nullptr;
+				continue;
+			}
+
+			++this->statistics.pageCount;
+			if (page.kind == PageKind::Zero) {
+				++this->statistics.zeroPages;
+			} else if (previous && previous->kind == page.kind && previous->offset == page.offset) {
+				++this->statistics.repeatedPages;
+			} else {
+				++(page.kind == PageKind::Compressed ? this->statistics.compressedPages : this->statistics.rawPages);
+				this->statistics.storedBytes += page.size;
+			}
+			previous = &page;
+		}
+	}
+	this->statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	MEMORY_PROBE_END(probeStart, Probe::SnapshotCapture, true, this->statistics.pageCount * kPageSize);
+
+	return true;
+}
+
+void Snapshot::Clear() {
+	this->chunks.clear();
+	this->regions.clear();
+	this->statistics = SnapshotStatistics();
+
+	// The file can only be deleted once it is no longer mapped
+	this->spillFile.Close();
+	if (!this->spillPath.empty()) {
+		std::remove(this->spillPath.c_str());
+		this->spillPath.clear();
+	}
+}
+
+const Snapshot::Page* Snapshot::FindPage(uintptr_t address, const Chunk** chunk) const {
+	// Last chunk starting at or below the address
+	auto found = std::upper_bound(this->chunks.begin(), this->chunks.end(), address,
+		[](uintptr_t value, const Chunk& entry) { return value < entry.base; });
+	if (found == this->chunks.begin()) {
+		return nullptr;
+	}
+	--found;
+
+	size_t index = (size_t)(address - found->base) / kPageSize;
+	if (index >= found->pages.size() || found->pages[index].kind == PageKind::Missing) {
+		return nullptr;
+	}
+
+	*chunk = &*found;
+	return &found->pages[index];
+}
+
+const uint8_t* Snapshot::GetPage(uintptr_t address, uint8_t* scratch) const {
+	const Chunk* chunk = nullptr;
+	const Page* page = this->FindPage(address, &chunk);
+	if (!page) {
+		return nullptr;
+	}
+
+	switch (page->kind) {
+	case PageKind::Zero:
+		return kZeroPage;
+	case PageKind::Raw:
+		return chunk->data + page->offset;
+	default:
+		return DecompressPage(chunk->data + page->offset, page->size, scratch) ? scratch : nullptr;
+	}
+}
+
+bool Snapshot::Read(uintptr_t address, void* buffer, size_t size) const {
+	uint8_t scratch[kPageSize];
+	uint8_t* output = (uint8_t*)buffer;
+
+	// Copy the requested part of every page the range touches
+	while (size > 0) {
+		size_t offset = (size_t)(address % kPageSize);
+		size_t length = std::min(size, kPageSize - offset);
+
+		const uint8_t* page = this->GetPage(address, scratch);
+		if (!page) {
+			return false;
+		}
+		std::memcpy(output, page + offset, length);
+
+		address += length;
+		output += length;
+		size -= length;
+	}
+
+	return true;
+}
+
+const std::vector<MemoryRegion>& Snapshot::GetRegions() const {
+	return this->regions;
+}
+
+const SnapshotStatistics& Snapshot::GetStatistics() const {
+	return this->statistics;
+}
+
+size_t Snapshot::GetMemoryUsage() const {
+	size_t bytes = this->chunks.capacity() * sizeof(Chunk) + this->regions.capacity() * sizeof(MemoryRegion);
+	for (const Chunk& chunk : this->chunks) {
+		bytes += chunk.pages.capacity() * sizeof(Page) + chunk.payload.capacity();
+	}
+	return bytes;
+}
+
+const std::string& Snapshot::GetErrorMessage() const {
+	return this->errorMessage;
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Platform.h"
+
+class Scanner;
+
+/**
+ * @brief Numbers describing the last capture of a Snapshot.
+ */
+struct SnapshotStatistics {
+	size_t regionCount = 0;     // Regions that were captured
+	size_t pageCount = 0;       // Pages that could be read
+	size_t zeroPages = 0;       // Pages holding only zeros, stored as a flag
+	size_t repeatedPages = 0;   // Pages equal to the page before them, stored as a reference
+	size_t compressedPages = 0; // Pages stored compressed
+	size_t rawPages = 0;        // Pages that did not compress well and are stored as they are
+	size_t storedBytes = 0;     // Bytes of page data held in memory or in the spill file
+	double seconds = 0;         // Wall clock time of the capture
+
+	/**
+	 * @brief Returns the stored size as a share of the captured size, e.g. 0.25 for a 4:1 compression.
+	 */
+	double GetRatio() const;
+};
+
+/**
+ * @brief A compressed copy of every readable page of a target process.
+ *
+ * Scans for an unknown initial value compare the current memory with a copy taken earlier, and
+ * a plain copy needs as much RAM as the target. A snapshot stores every 4 KiB page on its own so
+ * it can be decompressed without its neighbours: pages of zeros are only flagged, a page equal to
+ * the page before it refers to that page's data, and every other page goes through a small
+ * LZ4-style codec, or is kept as it is when that saves less than an eighth.
+ *
+ * Capture reads the chunks of Scanner::ScanChunks in parallel, every chunk compressed by the
+ * worker that read it. With a spill path the compressed data of every chunk is written to that
+ * file as soon as the chunk is done and the file is mapped read-only at the end, so the snapshot
+ * costs little more than its page table in RAM. Scanner::FirstScan(snapshot, compare) compares the
+ * current memory with a snapshot, decompressing one page at a time.
+ *
+ * Reads are safe from several threads, but Capture and Clear must not run at the same time as them.
+ */
+class Snapshot {
+public:
+	// Size and alignment of a stored page
+	static const size_t kPageSize = 0x1000;
+
+private:
+	// How a page is stored
+	enum class PageKind : uint8_t {
+		Missing,    // The page could not be read
+		Zero,       // The page holds only zeros
+		Raw,        // The page is stored as it is
+		Compressed, // The page is stored compressed
+	};
+
+	// Location of a page's data in the payload of its chunk
+	struct Page {
+		uint32_t offset = 0;
+		uint16_t size = 0;
+		PageKind kind = PageKind::Missing;
+	};
+
+	// A piece of a region captured by one task
+	struct Chunk {
+		uintptr_t base = 0;            // Address of the first page
+		std::vector<Page> pages;       // One entry per page
+		std::vector<uint8_t> payload;  // Page data while held in memory
+		uint64_t fileOffset = 0;       // Position of the page data in the spill file
+		bool spilled = false;          // The page data was moved to the spill file
+		const uint8_t* data = nullptr; // Page data, in payload or in the mapped spill file
+	};
+
+	// Captured chunks in ascending address order
+	std::vector<Chunk> chunks;
+
+	// Regions the snapshot was taken of
+	std::vector<MemoryRegion> regions;
+
+	// Spill file holding the page data, if one was requested
+	std::string spillPath;
+	MappedFile spillFile;
+
+	// Numbers of the last capture
+	SnapshotStatistics statistics;
+
+	// Description of the last error
+	std::string errorMessage;
+
+	// Finds the page holding an address, or returns nullptr if it was not captured
+	const Page* FindPage(uintptr_t address, const Chunk** chunk) const;
+
+public:
+	Snapshot() = default;
+	~Snapshot();
+
+	Snapshot(const Snapshot&) = delete;
+	Snapshot& operator=(const Snapshot&) = delete;
+
+	/**
+	 * @brief Captures every region the scanner would scan, replacing the previous contents.
+	 *
+	 * @param scanner The scanner whose regions, options and workers are used.
+	 * @param spillPath A file receiving the compressed page data, or an empty string to keep it in memory.
+	 *        The file is overwritten, and deleted again by Clear or the destructor.
+	 * @return True if the snapshot was taken, false if the spill file could not be written.
+	 */
+	bool Capture(Scanner& scanner, const std::string& spillPath = std::string());
+
+	/**
+	 * @brief Drops all pages and deletes the spill file.
+	 */
+	void Clear();
+
+	/**
+	 * @brief Returns a captured page.
+	 *
+	 * Pages stored as they are in memory or in the spill file are returned without a copy, all
+	 * other pages are decompressed into the scratch buffer.
+	 *
+	 * @param address An address inside the page.
+	 * @param scratch A buffer of kPageSize bytes that may receive the page.
+	 * @return The contents of the page, or nullptr if the page was not captured.
+	 */
+	const uint8_t* GetPage(uintptr_t address, uint8_t* scratch) const;
+
+	/**
+	 * @brief Copies captured memory into a buffer, as Memory::ReadMemory does for live memory.
+	 *
+	 * @param address The address to read from.
+	 * @param buffer The buffer receiving the data.
+	 * @param size The number of bytes to read.
+	 * @return True if every byte was captured, false otherwise.
+	 */
+	bool Read(uintptr_t address, void* buffer, size_t size) const;
+
+	/**
+	 * @brief Returns the regions the snapshot was taken of, in ascending address order.
+	 */
+	const std::vector<MemoryRegion>& GetRegions() const;
+
+	/**
+	 * @brief Returns the statistics of the last capture.
+	 */
+	const SnapshotStatistics& GetStatistics() const;
+
+	/**
+	 * @brief Returns the number of bytes of RAM held by the snapshot, excluding a mapped spill file.
+	 */
+	size_t GetMemoryUsage() const;
+
+	/**
+	 * @brief Returns a description of the last error.
+	 */
+	const std::string& GetErrorMessage() const;
+};
@@ -0,0 +1,406 @@
+#include "SnapshotFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+
+namespace {
+	// Identifies a capture file
+	const char kFileMagic[4] = { 'M', 'H', 'S', 'F' };
+
+	// Bytes copied from the process per read while capturing
+	const size_t kCaptureBlockSize = (size_t)16 << 20;
+
+	// Protection flags of a region record
+	const uint32_t kRegionWritable = 1;
+	const uint32_t kRegionExecutable = 2;
+	const uint32_t kRegionImage = 4;
+
+	// The first bytes of the file; the rest of its page is zero
+	struct FileHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t pageSize;
+		uint32_t pointerSize;
+		uint32_t processID;
+		uint32_t processNameLength;  // UTF-16 units at the start of the name table
+		uint64_t captureTime;        // Seconds since 1970
+		uint64_t moduleBase;         // Main module, as in MODULEINFO
+		uint64_t moduleSize;
+		uint64_t moduleEntryPoint;
+		uint64_t regionTableOffset;
+		uint64_t regionCount;
+		uint64_t moduleTableOffset;
+		uint64_t moduleCount;
+		uint64_t nameTableOffset;
+		uint64_t nameTableLength;    // In UTF-16 units
+	};
+
+	// One captured run
+	struct RegionRecord {
+		uint64_t base;
+		uint64_t size;
+		uint64_t dataOffset;
+		uint32_t flags;
+		uint32_t reserved;
+	};
+
+	// One module; the name is nameLength UTF-16 units at nameOffset in the name table
+	struct ModuleRecord {
+		uint64_t base;
+		uint64_t size;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+	};
+
+	// Appends a wide string to the name table as UTF-16
+	void PutName(std::vector<uint16_t>& names, const std::wstring& name) {
+		for (wchar_t c : name) {
+			names.push_back((uint16_t)c);
+		}
+	}
+
+	// Reads a name back from the name table
+	std::wstring GetName(const uint16_t* names, size_t offset, size_t length) {
+		std::wstring name;
+		name.reserve(length);
+		for (size_t i = 0; i < length; ++i) {
+			name.push_back((wchar_t)names[offset + i]);
+		}
+		return name;
+	}
+
+	// Returns true if count records of a given size starting at offset lie inside the file
+	bool InFile(uint64_t offset, uint64_t count, size_t recordSize, size_t fileSize) {
+		return offset <= fileSize && count <= (fileSize - offset) / recordSize;
+	}
+}
+
+bool SnapshotFile::Capture(Memory& memory, const std::string& path) {
+	this->Close();
+
+	std::unique_ptr<FILE, int (*)(FILE*)> file(fopen(path.c_str(), "wb"), fclose);
+	if (!file) {
+		this->errorMessage = "Failed to create " + path;
+		return false;
+	}
+
+	// The header is written last, once the tables are placed; the first page is reserved for it
+	std::vector<uint8_t> buffer(std::max(kCaptureBlockSize, kPageSize));
+	std::memset(buffer.data(), 0, kPageSize);
+	bool written = fwrite(buffer.data(), 1, kPageSize, file.get()) == kPageSize;
+	uint64_t position = kPageSize;
+
+	// Copy every region block by block; an unreadable page ends the current run
+	std::vector<RegionRecord> records;
+	for (const MemoryRegion& region : memory.GetRegions()) {
+		uint32_t flags = (region.writable ? kRegionWritable : 0) | (region.executable ? kRegionExecutable : 0) | (region.image ? kRegionImage : 0);
+		uintptr_t address = region.base;
+		uintptr_t end = region.base + region.size;
+		bool inRun = false;
+
+		while (written && address < end) {
+			size_t size = std::min(kCaptureBlockSize, (size_t)(end - address));
+			size_t bytesRead = 0;
+			memory.ReadMemory(address, buffer.data(), size, &bytesRead);
+			size_t kept = bytesRead / kPageSize * kPageSize;
+
+			if (kept) {
+				if (!inRun) {
+					records.push_back({ address, 0, position, flags, 0 });
+					inRun = true;
+				}
+				written = fwrite(buffer.data(), 1, kept, file.get()) == kept;
+				records.back().size += kept;
+				position += kept;
+			}
+
+			if (kept < size) {
+				inRun = false;
+				address += kept + kPageSize;
+			}
+			else {
+				address += size;
+			}
+		}
+	}
+
+	// Tables after the page data; the names start with the process name
+	std::vector<ModuleEntry> modules = memory.GetModules();
+	std::vector<ModuleRecord> moduleRecords;
+	std::vector<uint16_t> names;
+	std::wstring processName = memory.GetProcessNameW();
+	PutName(names, processName);
+	for (const ModuleEntry& module : modules) {
+		moduleRecords.push_back({ module.base, module.size, (uint32_t)names.size(), (uint32_t)module.name.size() });
+		PutName(names, module.name);
+	}
+
+	MODULEINFO moduleInfo = memory.GetModuleInfo();
+	FileHeader header = {};
+	std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+	header.version = kVersion;
+	header.pageSize = (uint32_t)kPageSize;
+	header.pointerSize = (uint32_t)sizeof(uintptr_t);
+	header.processID = memory.GetProcessID();
+	header.processNameLength = (uint32_t)processName.size();
+	header.captureTime = (uint64_t)std::time(nullptr);
+	header.moduleBase = (uintptr_t)moduleInfo.lpBaseOfDll;
+	header.moduleSize = moduleInfo.SizeOfImage;
+	header.moduleEntryPoint = (uintptr_t)moduleInfo.EntryPoint;
+	header.regionTableOffset = position;
+	header.regionCount = records.size();
+	header.moduleTableOffset = header.regionTableOffset + records.size() * sizeof(RegionRecord);
+	header.moduleCount = moduleRecords.size();
+	header.nameTableOffset = header.moduleTableOffset + moduleRecords.size() * sizeof(ModuleRecord);
+	header.nameTableLength = names.size();
+
+	written = written &&
+		fwrite(records.data(), sizeof(RegionRecord), records.size(), file.get()) == records.size() &&
+		fwrite(moduleRecords.data(), sizeof(ModuleRecord), moduleRecords.size(), file.get()) == moduleRecords.size() &&
+		fwrite(names.data(), sizeof(uint16_t), names.size(), file.get()) == names.size() &&
+		fseek(file.get(), 0, SEEK_SET) == 0 &&
+		fwrite(&header, sizeof(header), 1, file.get()) == 1;
+	written = fclose(file.release()) == 0 && written;
+
+	if (!written) {
+		this->errorMessage = "Failed to write " + path;
+		remove(path.c_str());
+		return false;
+	}
+	return this->Open(path);
+}
+
+bool SnapshotFile::Open(const std::string& path) {
+	this->Close();
+
+	if (!this->file.Open(path)) {
+		this->errorMessage = "Failed to open " + path;
+		return false;
+	}
+
+	// Check the header and that every table and run lies inside the file before using any of them
+	const uint8_t* data = this->file.GetData();
+	size_t size = this->file.GetSize();
+	FileHeader header = {};
+	if (size < kPageSize) {
+		this->Close();
+		this->errorMessage = path + " is not a snapshot file";
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+
+	if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0) {
+		this->Close();
+		this->errorMessage = path + " is not a snapshot file";
+		return false;
+	}
+	if (header.version != kVersion || header.pageSize != kPageSize || header.pointerSize != sizeof(uintptr_t)) {
+		this->Close();
+		this->errorMessage = path + " was written by an incompatible version";
+		return false;
+	}
+	if (!InFile(header.regionTableOffset, header.regionCount, sizeof(RegionRecord), size) ||
+		!InFile(header.moduleTableOffset, header.moduleCount, sizeof(ModuleRecord), size) ||
+		!InFile(header.nameTableOffset, header.nameTableLength, sizeof(uint16_t), size) ||
+		header.processNameLength > header.nameTableLength) {
+		this->Close();
+		this->errorMessage = path + " is truncated";
+		return false;
+	}
+
+	// The tables follow the page data, so they may not be aligned for direct access
+	std::vector<RegionRecord> records(header.regionCount);
+	std::vector<ModuleRecord> moduleRecords(header.moduleCount);
+	std::vector<uint16_t> names(header.nameTableLength);
+	std::memcpy(records.data(), data + header.regionTableOffset, records.size() * sizeof(RegionRecord));
+	std::memcpy(moduleRecords.data(), data + header.moduleTableOffset, moduleRecords.size() * sizeof(ModuleRecord));
+	std::memcpy(names.data(), data + header.nameTableOffset, names.size() * sizeof(uint16_t));
+
+	// Runs hold whole pages, which Diff compares without checking for a partial last page
+	uintptr_t previousEnd = 0;
+	for (const RegionRecord& record : records) {
+		if (!InFile(record.dataOffset, record.size, 1, size) || record.base < previousEnd || record.base + record.size < record.base ||
+			record.base % kPageSize != 0 || record.size % kPageSize != 0) {
+			this->Close();
+			this->errorMessage = path + " has an invalid region table";
+			return false;
+		}
+		previousEnd = (uintptr_t)(record.base + record.size);
+
+		MemoryRegion region;
+		region.base = (uintptr_t)record.base;
+		region.size = (size_t)record.size;
+		region.writable = (record.flags & kRegionWritable) != 0;
+		region.executable = (record.flags & kRegionExecutable) != 0;
+		region.image = (record.flags & kRegionImage) != 0;
+		this->regions.push_back(region);
+		this->regionData.push_back(data + record.dataOffset);
+	}
+
+	for (const ModuleRecord& record : moduleRecords) {
+		if ((uint64_t)record.nameOffset + record.nameLength > names.size()) {
+			this->Close();
+			this->errorMessage = path + " has an invalid module table";
+			return false;
+		}
+
+		ModuleEntry module;
+		module.name = GetName(names.data(), record.nameOffset, record.nameLength);
+		module.base = (uintptr_t)record.base;
+		module.size = (size_t)record.size;
+		this->modules.push_back(module);
+	}
+
+	this->processName = GetName(names.data(), 0, header.processNameLength);
+	this->processID = header.processID;
+	this->moduleInfo.lpBaseOfDll = (LPVOID)(uintptr_t)header.moduleBase;
+	this->moduleInfo.SizeOfImage = (DWORD)header.moduleSize;
+	this->moduleInfo.EntryPoint = (LPVOID)(uintptr_t)header.moduleEntryPoint;
+	this->captureTime = header.captureTime;
+	return true;
+}
+
+void SnapshotFile::Close() {
+	this->file.Close();
+	this->regions.clear();
+	this->regionData.clear();
+	this->modules.clear();
+	this->processName.clear();
+	this->processID = 0;
+	this->moduleInfo = {};
+	this->captureTime = 0;
+}
+
+bool SnapshotFile::IsOpen() const {
+	return this->file.IsOpen();
+}
+
+size_t SnapshotFile::FindRegion(uintptr_t address) const {
+	// The last run starting at or before the address
+	auto next = std::upper_bound(this->regions.begin(), this->regions.end(), address, [](uintptr_t value, const MemoryRegion& region) {
+		return value < region.base;
+	});
+	if (next == this->regions.begin() || address - (next - 1)->base >= (next - 1)->size) {
+		return this->regions.size();
+	}
+	return (size_t)(next - this->regions.begin()) - 1;
+}
+
+bool SnapshotFile::ReadMemory(uintptr_t address, void* buffer, size_t size, size_t* bytesRead) {
+	// Copy run by run until the range leaves the captured memory
+	size_t done = 0;
+	while (done < size) {
+		size_t index = this->FindRegion(address + done);
+		if (index == this->regions.size()) {
+			break;
+		}
+
+		const MemoryRegion& region = this->regions[index];
+		size_t offset = address + done - region.base;
+		size_t length = std::min(size - done, region.size - offset);
+		std::memcpy((uint8_t*)buffer + done, this->regionData[index] + offset, length);
+		done += length;
+	}
+
+	if (bytesRead) {
+		*bytesRead = done;
+	}
+	return done == size;
+}
+
+bool SnapshotFile::ReadBatch(std::vector<BatchEntry>& entries) {
+	bool all = true;
+	for (BatchEntry& entry : entries) {
+		entry.success = this->ReadMemory(entry.address, entry.buffer, entry.size);
+		all &= entry.success;
+	}
+	return all;
+}
+
+std::vector<MemoryRegion> SnapshotFile::GetRegions() {
+	return this->regions;
+}
+
+std::vector<ModuleEntry> SnapshotFile::GetModules() {
+	return this->modules;
+}
+
+const uint8_t* SnapshotFile::GetView(uintptr_t address, size_t size) {
+	size_t index = this->FindRegion(address);
+	if (index == this->regions.size() || size > this->regions[index].size - (address - this->regions[index].base)) {
+		return nullptr;
+	}
+	return this->regionData[index] + (address - this->regions[index].base);
+}
+
+const std::wstring& SnapshotFile::GetProcessName() const {
+	return this->processName;
+}
+
+DWORD SnapshotFile::GetProcessID() const {
+	return this->processID;
+}
+
+MODULEINFO SnapshotFile::GetModuleInfo() const {
+	return this->moduleInfo;
+}
+
+uint64_t SnapshotFile::GetCaptureTime() const {
+	return this->captureTime;
+}
+
+const std::string& SnapshotFile::GetErrorMessage() const {
+	return this->errorMessage;
+}
+
+size_t SnapshotFile::Diff(SnapshotFile& before, SnapshotFile& after, const std::function<bool(uintptr_t address, size_t size)>& visitor) {
+	// Both files are read front to back exactly once
+	before.file.AdviseSequential();
+	after.file.AdviseSequential();
+
+	// Walk both run lists together, comparing the pages where they overlap
+	size_t changed = 0;
+	uintptr_t runStart = 0, runEnd = 0;
+	bool stopped = false;
+	auto report = [&](uintptr_t page) {
+		if (runEnd == page && runEnd != runStart) {
+			runEnd += kPageSize;
+			return;
+		}
+		if (runEnd != runStart && !visitor(runStart, runEnd - runStart)) {
+			stopped = true;
+		}
+		runStart = page;
+		runEnd = page + kPageSize;
+	};
+
+	size_t i = 0, j = 0;
+	while (!stopped && i < before.regions.size() && j < after.regions.size()) {
+		const MemoryRegion& a = before.regions[i];
+		const MemoryRegion& b = after.regions[j];
+		uintptr_t start = std::max(a.base, b.base);
+		uintptr_t end = std::min(a.base + a.size, b.base + b.size);
+
+		for (uintptr_t page = start; !stopped && page < end; page += kPageSize) {
+			if (std::memcmp(before.regionData[i] + (page - a.base), after.regionData[j] + (page - b.base), kPageSize) != 0) {
+				changed += kPageSize;
+				report(page);
+			}
+		}
+
+		if (a.base + a.size <= b.base + b.size) {
+			++i;
+		}
+		else {
+			++j;
+		}
+	}
+
+	if (!stopped && runEnd != runStart) {
+		visitor(runStart, runEnd - runStart);
+	}
+	return changed;
+}
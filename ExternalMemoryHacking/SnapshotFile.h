@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Memory.h"
+#include "MemoryReader.h"
+
+/**
+ * @brief A capture of a process written to disk and mapped back for offline analysis.
+ *
+ * The file starts with a header page, followed by the contents of every readable region stored
+ * as they are, each run of pages starting on a page boundary of the file. The region table,
+ * the module table and the UTF-16 names come last:
+ *
+ *   header      "MHSF", version, page size, pointer size, process ID, capture time,
+ *               main module base, size and entry point, table offsets and counts
+ *   page data   the readable pages of every region, page aligned
+ *   regions     base, size, offset of the data in the file and protection flags, by address
+ *   modules     base, size and the position of the name in the name table, by address
+ *   names       the process name followed by the module names, UTF-16
+ *
+ * Because the pages are neither compressed nor moved, Open only maps the file and reads the
+ * tables; GetView then hands out pointers straight into the mapping. SnapshotFile implements
+ * MemoryReader, so Scanner, PointerScanner and Memory::FindPatterns run on a capture long after
+ * the process is gone, exactly as on the live process. Diff compares two captures page by page
+ * while the operating system streams both files in, so it runs at the speed of the disk.
+ *
+ * Reads are safe from several threads, but Open and Close must not run at the same time as them.
+ */
+class SnapshotFile : public MemoryReader {
+public:
+	// Version written into new files; Open rejects any other
+	static const uint32_t kVersion = 1;
+
+	// Granularity of captured runs and alignment of their data in the file
+	static const size_t kPageSize = 0x1000;
+
+private:
+	// The mapped file
+	MappedFile file;
+
+	// Captured runs in ascending address order, and where the data of each starts in the mapping
+	std::vector<MemoryRegion> regions;
+	std::vector<const uint8_t*> regionData;
+
+	// Modules of the process at capture time, in ascending address order
+	std::vector<ModuleEntry> modules;
+
+	// Process the capture was taken of
+	std::wstring processName;
+	DWORD processID = 0;
+	MODULEINFO moduleInfo = {};
+	uint64_t captureTime = 0;
+
+	// Description of the last error
+	std::string errorMessage;
+
+	// Returns the index of the run holding an address, or regions.size() if it was not captured
+	size_t FindRegion(uintptr_t address) const;
+
+public:
+	SnapshotFile() = default;
+
+	SnapshotFile(const SnapshotFile&) = delete;
+	SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+	/**
+	 * @brief Writes every readable region of a process to a file, then opens that file.
+	 *
+	 * Pages that cannot be read are left out, splitting their region into separate runs.
+	 *
+	 * @param memory The Memory instance attached to the process.
+	 * @param path The file to write; an existing file is overwritten.
+	 * @return True if the capture was written and opened, false otherwise.
+	 */
+	bool Capture(Memory& memory, const std::string& path);
+
+	/**
+	 * @brief Maps a capture written by Capture, closing the one opened before.
+	 *
+	 * @param path The path of the file.
+	 * @return True if the file is a valid capture, false otherwise.
+	 */
+	bool Open(const std::string& path);
+
+	/**
+	 * @brief Unmaps the capture. Pointers returned by GetView become invalid.
+	 */
+	void Close();
+
+	/**
+	 * @brief Returns true while a capture is open.
+	 */
+	bool IsOpen() const;
+
+	/**
+	 * @brief Copies captured memory into a local buffer, as Memory::ReadMemory does for a live process.
+	 *
+	 * @param address The address to read from.
+	 * @param buffer The buffer receiving the data.
+	 * @param size The number of bytes to read.
+	 * @param bytesRead Optional output for the number of bytes of the prefix that were captured.
+	 * @return True if every byte was captured, false otherwise.
+	 */
+	bool ReadMemory(uintptr_t address, void* buffer, size_t size, size_t* bytesRead = nullptr) override;
+
+	/**
+	 * @brief Reads many independent ranges, updating the success flag of every entry.
+	 *
+	 * @return True if every entry was read, false if at least one failed.
+	 */
+	bool ReadBatch(std::vector<BatchEntry>& entries) override;
+
+	/**
+	 * @brief Returns the captured runs in ascending address order.
+	 */
+	std::vector<MemoryRegion> GetRegions() override;
+
+	/**
+	 * @brief Returns the modules of the process at capture time.
+	 */
+	std::vector<ModuleEntry> GetModules() override;
+
+	/**
+	 * @brief Returns a pointer into the mapped file if the whole range was captured as one run.
+	 */
+	const uint8_t* GetView(uintptr_t address, size_t size) override;
+
+	/**
+	 * @brief Returns the name of the captured process.
+	 */
+	const std::wstring& GetProcessName() const;
+
+	/**
+	 * @brief Returns the ID the captured process had.
+	 */
+	DWORD GetProcessID() const;
+
+	/**
+	 * @brief Returns the main module of the captured process, as Memory::GetModuleInfo did at capture time.
+	 */
+	MODULEINFO GetModuleInfo() const;
+
+	/**
+	 * @brief Returns the time of the capture in seconds since 1970.
+	 */
+	uint64_t GetCaptureTime() const;
+
+	/**
+	 * @brief Returns a description of the last error.
+	 */
+	const std::string& GetErrorMessage() const;
+
+	/**
+	 * @brief Finds the memory that changed between two captures of the same process.
+	 *
+	 * Only addresses captured in both files are compared. Changed pages next to each other are
+	 * reported as one range.
+	 *
+	 * @param before The earlier capture.
+	 * @param after The later capture.
+	 * @param visitor Called with the address and size of every changed range, in ascending
+	 *        address order. Returning false stops the comparison.
+	 * @return The number of changed bytes, counted in whole pages.
+	 */
+	static size_t Diff(SnapshotFile& before, SnapshotFile& after, const std::function<bool(uintptr_t address, size_t size)>& visitor);
+};
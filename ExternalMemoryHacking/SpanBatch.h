@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "MemoryReader.h"
+
+/**
+ * @brief A fixed set of small values read together, neighbours sharing one element of a ReadBatch.
+ *
+ * Build sorts the values by address and merges values lying at most kMaxGap bytes apart into
+ * spans, since copying the gap is cheaper than another batch element. A batch then has one
+ * element per cluster of values, such as the fields of one object, rather than one per value.
+ * Build is meant to run once per change of the addresses; Read reuses the spans every time.
+ *
+ *     spans.Build(indices, [&](size_t index) { return std::make_pair(values[index].address, values[index].size); });
+ *     spans.Read(memory);
+ *     for (size_t i = 0; i < spans.GetSpanCount(); ++i) {
+ *         for (size_t j = spans.GetSpan(i).first; j < spans.GetSpan(i).last; ++j) {
+ *             ... values[spans.GetOrder()[j]] is at spans.GetBytes(i, its address) if spans.IsRead(i) ...
+ *         }
+ *     }
+ */
+class SpanBatch {
+public:
+	// Values at most this many bytes apart are read as one span
+	static const size_t kMaxGap = 256;
+
+	// A contiguous range covering the values GetOrder()[first, last)
+	struct Span {
+		uintptr_t address = 0;
+		size_t size = 0;
+		size_t offset = 0; // Position of the bytes in the buffer of the batch
+		size_t first = 0;
+		size_t last = 0;
+	};
+
+private:
+	std::vector<size_t> order;
+	std::vector<Span> spans;
+	std::vector<uint8_t> data;
+	std::vector<BatchEntry> batch;
+
+public:
+	/**
+	 * @brief Merges values into spans.
+	 *
+	 * @param values The indices of the values to read, in any order.
+	 * @param locate Returns the address and size of a value as a std::pair<uintptr_t, size_t>, given its index.
+	 */
+	template <typename Locate>
+	void Build(const std::vector<size_t>& values, const Locate& locate) {
+		this->order = values;
+		std::sort(this->order.begin(), this->order.end(), [&](size_t a, size_t b) { return locate(a).first < locate(b).first; });
+
+		// Start a new span wherever the gap to the previous value is too large
+		this->spans.clear();
+		size_t dataSize = 0;
+		for (size_t i = 0; i < this->order.size(); ++i) {
+			std::pair<uintptr_t, size_t> value = locate(this->order[i]);
+			uintptr_t end = value.first + value.second;
+			if (!this->spans.empty() && value.first <= this->spans.back().address + this->spans.back().size + kMaxGap) {
+				Span& span = this->spans.back();
+				if (end > span.address + span.size) {
+					dataSize += end - (span.address + span.size);
+					span.size = end - span.address;
+				}
+				span.last = i + 1;
+				continue;
+			}
+
+			Span span;
+			span.address = value.first;
+			span.size = value.second;
+			span.offset = dataSize;
+			span.first = i;
+			span.last = i + 1;
+			this->spans.push_back(span);
+			dataSize += value.second;
+		}
+
+		this->data.assign(dataSize, 0);
+		this->batch.resize(this->spans.size());
+		for (size_t i = 0; i < this->spans.size(); ++i) {
+			this->batch[i].address = this->spans[i].address;
+			this->batch[i].buffer = this->data.data() + this->spans[i].offset;
+			this->batch[i].size = this->spans[i].size;
+			this->batch[i].success = false;
+		}
+	}
+
+	/**
+	 * @brief Reads every span with one ReadBatch call.
+	 *
+	 * @return True if every span was read; check IsRead for the others.
+	 */
+	bool Read(MemoryReader& reader) {
+		return this->batch.empty() || reader.ReadBatch(this->batch);
+	}
+
+	/**
+	 * @brief Returns the indices of the values in ascending address order.
+	 */
+	const std::vector<size_t>& GetOrder() const {
+		return this->order;
+	}
+
+	/**
+	 * @brief Returns the number of spans, and so of batch elements.
+	 */
+	size_t GetSpanCount() const {
+		return this->spans.size();
+	}
+
+	/**
+	 * @brief Returns a span.
+	 */
+	const Span& GetSpan(size_t span) const {
+		return this->spans[span];
+	}
+
+	/**
+	 * @brief Returns true if the last Read read a span.
+	 */
+	bool IsRead(size_t span) const {
+		return this->batch[span].success;
+	}
+
+	/**
+	 * @brief Returns the bytes read at an address inside a span.
+	 */
+	const uint8_t* GetBytes(size_t span, uintptr_t address) const {
+		return this->data.data() + this->spans[span].offset + (address - this->spans[span].address);
+	}
+};
@@ -0,0 +1,105 @@
+#include "StringSearch.h"
+
+namespace {
+	// Lowercases the letters A-Z and leaves every other byte alone
+	uint8_t FoldCase(uint8_t value) {
+		return value >= 'A' && value <= 'Z' ? (uint8_t)(value + ('a' - 'A')) : value;
+	}
+
+	// Adds a character to an anchor set, in both cases if case is ignored
+	void AddCharacter(ByteSet& set, uint8_t value, bool ignoreCase) {
+		set.Add(value);
+		if (ignoreCase && value >= 'a' && value <= 'z') {
+			set.Add((uint8_t)(value - ('a' - 'A')));
+		}
+	}
+}
+
+StringSearch::StringSearch(const std::string& text, const StringSearchOptions& options) : text(text), options(options) {
+	if (this->text.empty() || (!options.ascii && !options.utf16)) {
+		return;
+	}
+
+	if (options.ignoreCase) {
+		for (char& character : this->text) {
+			character = (char)FoldCase((uint8_t)character);
+		}
+	}
+
+	// The first byte is the first character in both encodings
+	AddCharacter(this->first, (uint8_t)this->text[0], options.ignoreCase);
+
+	// A single ASCII character has no second byte to anchor on, so every occurrence of it is a candidate
+	this->single = this->text.size() == 1 && options.ascii;
+	if (options.ascii && this->text.size() > 1) {
+		AddCharacter(this->second, (uint8_t)this->text[1], options.ignoreCase);
+	}
+	if (options.utf16) {
+		this->second.Add(0);
+	}
+}
+
+bool StringSearch::IsValid() const {
+	return !this->text.empty() && (this->options.ascii || this->options.utf16);
+}
+
+size_t StringSearch::GetLongest() const {
+	return this->text.size() * (this->options.utf16 ? 2 : 1);
+}
+
+const StringSearchOptions& StringSearch::GetOptions() const {
+	return this->options;
+}
+
+bool StringSearch::Matches(const uint8_t* data, size_t size, size_t offset, StringEncoding encoding) const {
+	size_t width = encoding == StringEncoding::UTF16 ? 2 : 1;
+	if (offset + this->text.size() * width > size) {
+		return false;
+	}
+
+	const uint8_t* at = data + offset;
+	for (size_t i = 0; i < this->text.size(); ++i, at += width) {
+		uint8_t value = this->options.ignoreCase ? FoldCase(*at) : *at;
+		if (value != (uint8_t)this->text[i] || (width == 2 && at[1] != 0)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool StringSearch::Find(const uint8_t* data, size_t size, size_t limit, uintptr_t base, std::vector<StringMatch>& matches, SimdLevel level) const {
+	if (!this->IsValid()) {
+		return false;
+	}
+
+	// One vectorized pass yields every position holding a possible first and second byte
+	std::vector<uint32_t> candidates;
+	if (this->single) {
+		this->first.Find(data, size, candidates, level);
+	}
+	else {
+		ByteSet::FindPairs(this->first, this->second, data, size, candidates, level);
+	}
+
+	for (uint32_t offset : candidates) {
+		if (offset >= limit) {
+			break;
+		}
+
+		for (StringEncoding encoding : { StringEncoding::ASCII, StringEncoding::UTF16 }) {
+			bool enabled = encoding == StringEncoding::ASCII ? this->options.ascii : this->options.utf16;
+			if (!enabled || !this->Matches(data, size, offset, encoding)) {
+				continue;
+			}
+
+			StringMatch match;
+			match.address = base + offset;
+			match.encoding = encoding;
+			matches.push_back(match);
+			if (this->options.maxMatches && matches.size() >= this->options.maxMatches) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
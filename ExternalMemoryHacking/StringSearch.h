@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ScanKernels.h"
+
+/**
+ * @brief The encoding a string was found in.
+ */
+enum class StringEncoding {
+	ASCII, // One byte per character
+	UTF16  // Two bytes per character, little endian
+};
+
+/**
+ * @brief Settings of a string search.
+ */
+struct StringSearchOptions {
+	bool ascii = true;       // Find the text stored one byte per character
+	bool utf16 = true;       // Find the text stored as UTF-16
+	bool ignoreCase = false; // Treat the letters A-Z and a-z as equal
+	size_t maxMatches = 0;   // Stop after this many matches, 0 for no limit
+};
+
+/**
+ * @brief One occurrence of the searched text.
+ */
+struct StringMatch {
+	uintptr_t address = 0;
+	StringEncoding encoding = StringEncoding::ASCII;
+};
+
+/**
+ * @brief Searches a buffer for a piece of text stored as ASCII, UTF-16 or both, in a single pass.
+ *
+ * The text is anchored on its first two bytes: the first character followed by the second
+ * character (ASCII) or by a zero byte (UTF-16 of a character below 0x100). The anchor pairs of
+ * both encodings and, when ignoring case, of both cases are merged into two ByteSets, so one
+ * vectorized FindPairs pass yields the few positions that can start a match, and only those
+ * are compared with the text. Characters are taken byte by byte, so the text should be ASCII
+ * or Latin-1; case folding only applies to A-Z.
+ */
+class StringSearch {
+private:
+	// The text, lowercased if case is ignored
+	std::string text;
+
+	// Settings given at construction
+	StringSearchOptions options;
+
+	// Possible first and second bytes of a match
+	ByteSet first;
+	ByteSet second;
+
+	// Set if a single character is searched only as ASCII, so there is no second anchor byte
+	bool single = false;
+
+	// Compares the text with the data at an offset in one encoding
+	bool Matches(const uint8_t* data, size_t size, size_t offset, StringEncoding encoding) const;
+
+public:
+	/**
+	 * @brief Prepares a search. An empty text or one without any encoding never matches.
+	 *
+	 * @param text The text to find, without a terminator.
+	 * @param options The encodings to search and whether case is ignored.
+	 */
+	StringSearch(const std::string& text, const StringSearchOptions& options = StringSearchOptions());
+
+	/**
+	 * @brief Returns true if the search can find anything.
+	 */
+	bool IsValid() const;
+
+	/**
+	 * @brief Returns the length of the longest match in bytes, the overlap needed between two searched blocks.
+	 */
+	size_t GetLongest() const;
+
+	/**
+	 * @brief Returns the settings of the search.
+	 */
+	const StringSearchOptions& GetOptions() const;
+
+	/**
+	 * @brief Searches a local copy of target memory for the text.
+	 *
+	 * Only matches that start before limit are reported, so consecutive blocks can overlap by
+	 * GetLongest() - 1 bytes without reporting a match twice. At a position holding both an
+	 * ASCII and a UTF-16 match, which only a single character can, both are reported.
+	 *
+	 * @param data The local copy of the target memory.
+	 * @param size The number of valid bytes in data; must be below 4 GiB.
+	 * @param limit Matches must start below this offset.
+	 * @param base The address of data[0] in the target process.
+	 * @param matches Receives the matches in ascending address order.
+	 * @param level The highest instruction set to use, clamped to what the CPU supports.
+	 * @return True if matches holds options.maxMatches matches, so later blocks need not be searched.
+	 */
+	bool Find(const uint8_t* data, size_t size, size_t limit, uintptr_t base, std::vector<StringMatch>& matches, SimdLevel level = SimdLevel::AVX2) const;
+};
@@ -0,0 +1,121 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+thread_local ThreadPool* ThreadPool::currentPool = nullptr;
+thread_local size_t ThreadPool::currentWorker = 0;
+
+ThreadPool::ThreadPool(size_t threadCount) {
+	// Default to one worker per hardware thread
+	if (threadCount == 0) {
+		threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+
+	// The calling thread is worker 0, so only threadCount - 1 threads are started
+	this->queues.resize(threadCount);
+	for (size_t worker = 1; worker < threadCount; ++worker) {
+		this->threads.emplace_back(&ThreadPool::WorkerLoop, this, worker);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->wake.notify_all();
+
+	for (std::thread& thread : this->threads) {
+		thread.join();
+	}
+}
+
+size_t ThreadPool::GetThreadCount() const {
+	return this->threads.size() + 1;
+}
+
+void ThreadPool::Drain(Job& job, size_t worker) {
+	// Claim indices one at a time so fast workers pick up the remaining work
+	for (size_t index = job.next.fetch_add(1); index < job.count; index = job.next.fetch_add(1)) {
+		(*job.task)(index, worker);
+	}
+}
+
+ThreadPool::Job* ThreadPool::FindJob(size_t worker) {
+	// The newest job of the worker's own queue is the deepest nesting level, whose data is still in its caches
+	std::deque<Job*>& own = this->queues[worker];
+	for (auto job = own.rbegin(); job != own.rend(); ++job) {
+		if ((*job)->next.load(std::memory_order_relaxed) < (*job)->count) {
+			return *job;
+		}
+	}
+
+	// Steal from the oldest job of the other queues, starting with the next worker so thieves spread out
+	for (size_t i = 1; i < this->queues.size(); ++i) {
+		for (Job* job : this->queues[(worker + i) % this->queues.size()]) {
+			if (job->next.load(std::memory_order_relaxed) < job->count) {
+				return job;
+			}
+		}
+	}
+
+	return nullptr;
+}
+
+void ThreadPool::WorkerLoop(size_t worker) {
+	currentPool = this;
+	currentWorker = worker;
+
+	std::unique_lock<std::mutex> lock(this->mutex);
+	for (;;) {
+		// Sleep until a job with work left is published or the pool shuts down
+		Job* job = nullptr;
+		this->wake.wait(lock, [&] { return this->stopping || (job = this->FindJob(worker)) != nullptr; });
+		if (this->stopping) {
+			return;
+		}
+
+		// The job stays alive while it has helpers, since Run waits for them before returning
+		++job->helpers;
+		lock.unlock();
+		Drain(*job, worker);
+		lock.lock();
+
+		// The last helper to leave a job wakes up its Run
+		if (--job->helpers == 0) {
+			this->done.notify_all();
+		}
+	}
+}
+
+void ThreadPool::Run(size_t count, const std::function<void(size_t index, size_t worker)>& task) {
+	size_t worker = currentPool == this ? currentWorker : 0;
+
+	// Without background threads, or with a single task, the job simply runs inline
+	if (this->threads.empty() || count <= 1) {
+		for (size_t index = 0; index < count; ++index) {
+			task(index, worker);
+		}
+		return;
+	}
+
+	Job job;
+	job.task = &task;
+	job.count = count;
+
+	{
+		// Publish the job on the caller's queue and wake the workers
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->queues[worker].push_back(&job);
+	}
+	this->wake.notify_all();
+
+	// The calling thread works on its own job, and only on it, until every index is claimed
+	Drain(job, worker);
+
+	// Unpublish the job, then wait until no helper is still running one of its tasks
+	std::unique_lock<std::mutex> lock(this->mutex);
+	std::deque<Job*>& queue = this->queues[worker];
+	queue.erase(std::find(queue.begin(), queue.end(), &job));
+	this->done.wait(lock, [&] { return job.helpers == 0; });
+}
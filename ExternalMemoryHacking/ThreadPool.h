@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads that run indexed tasks in parallel.
+ *
+ * The threads are created once and reused by every Run call, so repeated scans do not
+ * pay for thread creation. Tasks are handed out from a counter per job, which keeps all
+ * workers busy even when tasks take very different amounts of time.
+ *
+ * Run may be called from several threads at once and from inside a task, so one pool can be
+ * shared by many scanners, and a task of one job (say, one process of a SessionManager) can
+ * run a parallel job of its own (a scan of that process). Every thread keeps the jobs it starts
+ * in a queue of its own and works on the newest one; workers out of work steal tasks from the
+ * oldest job of another queue, the job highest up the nesting and so the one with the most
+ * work left. A thread waiting for its job only runs tasks of that job, so a task never has a
+ * second task of the same job run beneath it on its thread, and per-worker state stays safe.
+ */
+class ThreadPool {
+private:
+	// One Run call: its task, the next index to hand out and the threads helping with it
+	struct Job {
+		const std::function<void(size_t, size_t)>* task = nullptr;
+		size_t count = 0;
+		std::atomic<size_t> next{ 0 };
+		size_t helpers = 0; // Threads other than the caller of Run working on the job, guarded by mutex
+	};
+
+	// Background threads; threads outside the pool act as worker 0
+	std::vector<std::thread> threads;
+
+	// Protects the queues and the helper counts
+	std::mutex mutex;
+
+	// Jobs started by every worker, oldest first; worker 0's queue is shared by all threads outside the pool
+	std::vector<std::deque<Job*>> queues;
+
+	// Wakes workers when a job is published or the pool is stopping
+	std::condition_variable wake;
+
+	// Signals Run when the last helper left a job
+	std::condition_variable done;
+
+	// Set by the destructor to shut the workers down
+	bool stopping = false;
+
+	// Pool and worker index of the calling thread, set for the pool's own threads
+	static thread_local ThreadPool* currentPool;
+	static thread_local size_t currentWorker;
+
+	/**
+	 * @brief Claims and runs task indices of a job until none are left.
+	 */
+	static void Drain(Job& job, size_t worker);
+
+	/**
+	 * @brief Finds a job with unclaimed tasks, its own newest first, then the oldest of the other queues.
+	 *
+	 * The mutex must be held.
+	 */
+	Job* FindJob(size_t worker);
+
+	/**
+	 * @brief Main loop of a background worker thread.
+	 */
+	void WorkerLoop(size_t worker);
+
+public:
+	/**
+	 * @brief Creates the pool.
+	 *
+	 * @param threadCount The total number of workers including the calling thread.
+	 * 0 uses one worker per hardware thread.
+	 */
+	explicit ThreadPool(size_t threadCount = 0);
+
+	/**
+	 * @brief Stops and joins all worker threads.
+	 */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * @brief Returns the number of workers, including the thread calling Run.
+	 */
+	size_t GetThreadCount() const;
+
+	/**
+	 * @brief Runs task(index, worker) for every index in [0, count) and waits for all of them.
+	 *
+	 * The worker argument is in [0, GetThreadCount()) and identifies the thread running the
+	 * task, so callers can keep per-worker state such as reusable buffers without locking.
+	 * Threads outside the pool run their tasks as worker 0, so per-worker state must not be
+	 * shared by jobs started from different outside threads at the same time.
+	 *
+	 * @param count The number of task indices.
+	 * @param task The function to run for every index.
+	 */
+	void Run(size_t count, const std::function<void(size_t index, size_t worker)>& task);
+};
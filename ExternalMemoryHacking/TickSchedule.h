@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+/**
+ * @brief The schedule of a background thread doing work at a fixed rate.
+ *
+ * Deadlines are absolute, so the rate does not drift with the time the work takes. Ticks that
+ * are already overdue when one ends are skipped, not run back to back, so a thread that fell
+ * behind catches up at once instead of bursting:
+ *
+ *     TickSchedule schedule(this->options.rate);
+ *     while (schedule.Wait(lock, this->wake, [this] { return this->stopping; })) {
+ *         ... do the work of one tick ...
+ *         this->missedTicks += schedule.Advance();
+ *     }
+ */
+class TickSchedule {
+public:
+	using Clock = std::chrono::steady_clock;
+
+private:
+	Clock::duration interval;
+	Clock::time_point deadline;
+
+public:
+	/**
+	 * @brief Creates a schedule whose first tick is due right away.
+	 *
+	 * @param rate Ticks per second; must be positive.
+	 */
+	explicit TickSchedule(double rate)
+		: interval(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate))), deadline(Clock::now()) {
+	}
+
+	/**
+	 * @brief Waits until the next tick is due or stop returns true.
+	 *
+	 * @param lock The held lock of the mutex guarding the state stop reads; it is held again on return.
+	 * @param wake The condition variable notified when stop may have become true.
+	 * @param stop Returns true once the thread has to leave.
+	 * @return True if the tick is due, false if the thread has to stop.
+	 */
+	template <typename Stop>
+	bool Wait(std::unique_lock<std::mutex>& lock, std::condition_variable& wake, const Stop& stop) {
+		return !wake.wait_until(lock, this->deadline, stop);
+	}
+
+	/**
+	 * @brief Returns the time the current tick was due.
+	 */
+	Clock::time_point GetDeadline() const {
+		return this->deadline;
+	}
+
+	/**
+	 * @brief Moves on to the next tick that is not overdue yet.
+	 *
+	 * @return The number of ticks skipped because they were already overdue.
+	 */
+	size_t Advance() {
+		this->deadline += this->interval;
+		Clock::time_point now = Clock::now();
+		if (this->deadline >= now) {
+			return 0;
+		}
+
+		size_t missed = (size_t)((now - this->deadline) / this->interval) + 1;
+		this->deadline += this->interval * missed;
+		return missed;
+	}
+};
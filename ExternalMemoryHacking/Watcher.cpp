@@ -0,0 +1,269 @@
+#include "Watcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include "TickSchedule.h"
+
+Watcher::Watcher(Memory& memory, const WatchOptions& options)
+	: memory(memory), options(options), ownQueue(options.queueCapacity), queue(&ownQueue) {
+}
+
+Watcher::~Watcher() {
+	this->Stop();
+}
+
+size_t Watcher::Add(uintptr_t address, const PointerPath* path, const void* frozenValue, size_t size) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	Entry entry;
+	entry.id = this->nextID++;
+	entry.address = address;
+	entry.size = (uint32_t)size;
+	if (path) {
+		entry.path = *path;
+		entry.pathIndex = this->resolver.Add(*path);
+	}
+	if (frozenValue) {
+		std::memcpy(&entry.frozenValue, frozenValue, size);
+		entry.frozen = true;
+	}
+
+	this->slots[entry.id] = this->entries.size();
+	this->entries.push_back(entry);
+	this->layoutChanged = true;
+	return entry.id;
+}
+
+bool Watcher::Remove(size_t id) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	auto slot = this->slots.find(id);
+	if (slot == this->slots.end()) {
+		return false;
+	}
+
+	// Move the last entry into the gap so the entries stay contiguous
+	size_t index = slot->second;
+	this->rebuildPaths |= this->entries[index].pathIndex != kNoPath;
+	this->slots.erase(slot);
+	if (index != this->entries.size() - 1) {
+		this->entries[index] = this->entries.back();
+		this->slots[this->entries[index].id] = index;
+	}
+	this->entries.pop_back();
+	this->layoutChanged = true;
+	return true;
+}
+
+void Watcher::Clear() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->entries.clear();
+	this->slots.clear();
+	this->resolver.Clear();
+	this->rebuildPaths = false;
+	this->layoutChanged = true;
+}
+
+size_t Watcher::GetCount() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->entries.size();
+}
+
+bool Watcher::Start() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	if (this->running || this->options.rate <= 0) {
+		return false;
+	}
+
+	this->statistics = WatchStatistics();
+	this->stopping = false;
+	this->running = true;
+	this->thread = std::thread(&Watcher::Run, this);
+	return true;
+}
+
+void Watcher::Stop() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (!this->running) {
+			return;
+		}
+		this->stopping = true;
+	}
+
+	this->wake.notify_all();
+	this->thread.join();
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->running = false;
+}
+
+bool Watcher::IsRunning() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->running;
+}
+
+void Watcher::Tick() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->TickLocked();
+}
+
+void Watcher::SetEventQueue(EventQueue<WatchEvent>* queue) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->queue.store(queue ? queue : &this->ownQueue, std::memory_order_release);
+}
+
+bool Watcher::PollEvent(WatchEvent& event) {
+	return this->queue.load(std::memory_order_acquire)->TryPop(event);
+}
+
+WatchStatistics Watcher::GetStatistics() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	WatchStatistics copy = this->statistics;
+	copy.entryCount = this->entries.size();
+	return copy;
+}
+
+void Watcher::Run() {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	TickSchedule schedule(this->options.rate);
+	while (schedule.Wait(lock, this->wake, [this] { return this->stopping; })) {
+		double late = std::chrono::duration<double>(TickSchedule::Clock::now() - schedule.GetDeadline()).count();
+		this->statistics.maxLateSeconds = std::max(this->statistics.maxLateSeconds, late);
+		this->statistics.totalLateSeconds += late;
+
+		this->TickLocked();
+		this->statistics.missedTicks += schedule.Advance();
+	}
+}
+
+void Watcher::BuildSpans() {
+	this->located.clear();
+	for (size_t i = 0; i < this->entries.size(); ++i) {
+		if (this->entries[i].address) {
+			this->located.push_back(i);
+		}
+	}
+	this->spans.Build(this->located, [this](size_t index) {
+		return std::make_pair(this->entries[index].address, (size_t)this->entries[index].size);
+	});
+	this->layoutChanged = false;
+}
+
+void Watcher::Update(Entry& entry, uint64_t value, uint64_t timestamp) {
+	if (entry.known && value != entry.value) {
+		WatchEvent event;
+		event.id = entry.id;
+		event.address = entry.address;
+		event.oldValue = entry.value;
+		event.newValue = value;
+		event.timestamp = timestamp;
+		event.size = entry.size;
+		if (this->queue.load(std::memory_order_relaxed)->TryPush(event)) {
+			++this->statistics.eventCount;
+		}
+		else {
+			++this->statistics.droppedEvents;
+		}
+	}
+	entry.value = value;
+	entry.known = true;
+
+	if (entry.frozen && value != entry.frozenValue) {
+		BatchEntry write;
+		write.address = entry.address;
+		write.buffer = &entry.frozenValue;
+		write.size = entry.size;
+		this->writes.push_back(write);
+		entry.value = entry.frozenValue;
+	}
+}
+
+void Watcher::TickLocked() {
+	auto start = std::chrono::steady_clock::now();
+	uint64_t timestamp = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count();
+
+	// Removing a path entry leaves its nodes in the resolver, so the remaining paths are added again
+	if (this->rebuildPaths) {
+		this->resolver.Clear();
+		for (Entry& entry : this->entries) {
+			if (entry.pathIndex != kNoPath) {
+				entry.pathIndex = this->resolver.Add(entry.path);
+			}
+		}
+		this->rebuildPaths = false;
+	}
+
+	// A path leading somewhere else changes the spans
+	if (this->resolver.GetCount()) {
+		this->resolver.Resolve(this->memory.GetProcess(), this->memory.GetModuleBaseAddress(), this->pathAddresses);
+		for (Entry& entry : this->entries) {
+			if (entry.pathIndex != kNoPath && entry.address != this->pathAddresses[entry.pathIndex]) {
+				entry.address = this->pathAddresses[entry.pathIndex];
+				entry.known = false;
+				this->layoutChanged = true;
+			}
+		}
+	}
+
+	if (this->layoutChanged) {
+		this->BuildSpans();
+	}
+
+	// Read every span in one batch
+	this->spans.Read(this->memory);
+
+	// Publish the changes and collect the frozen values that have to be written back. A span
+	// that failed may still hold readable values, so its values are read again one by one
+	this->writes.clear();
+	this->retrySlots.clear();
+	const std::vector<size_t>& order = this->spans.GetOrder();
+	for (size_t i = 0; i < this->spans.GetSpanCount(); ++i) {
+		const SpanBatch::Span& span = this->spans.GetSpan(i);
+		for (size_t j = span.first; j < span.last; ++j) {
+			Entry& entry = this->entries[order[j]];
+			if (!this->spans.IsRead(i)) {
+				this->retrySlots.push_back(order[j]);
+				continue;
+			}
+
+			uint64_t value = 0;
+			std::memcpy(&value, this->spans.GetBytes(i, entry.address), entry.size);
+			this->Update(entry, value, timestamp);
+		}
+	}
+
+	if (!this->retrySlots.empty()) {
+		this->retryValues.assign(this->retrySlots.size(), 0);
+		this->retries.resize(this->retrySlots.size());
+		for (size_t i = 0; i < this->retrySlots.size(); ++i) {
+			const Entry& entry = this->entries[this->retrySlots[i]];
+			this->retries[i].address = entry.address;
+			this->retries[i].buffer = &this->retryValues[i];
+			this->retries[i].size = entry.size;
+		}
+
+		this->memory.ReadBatch(this->retries);
+		for (size_t i = 0; i < this->retrySlots.size(); ++i) {
+			Entry& entry = this->entries[this->retrySlots[i]];
+			if (this->retries[i].success) {
+				this->Update(entry, this->retryValues[i], timestamp);
+			}
+			else {
+				entry.known = false;
+				++this->statistics.failedReads;
+			}
+		}
+	}
+
+	if (!this->writes.empty()) {
+		this->memory.WriteBatch(this->writes);
+		this->statistics.writeCount += this->writes.size();
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	++this->statistics.tickCount;
+	this->statistics.lastTickSeconds = seconds;
+	this->statistics.maxTickSeconds = std::max(this->statistics.maxTickSeconds, seconds);
+	this->statistics.totalTickSeconds += seconds;
+}
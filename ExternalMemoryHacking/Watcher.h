@@ -0,0 +1,314 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "EventQueue.h"
+#include "Memory.h"
+#include "PointerPath.h"
+#include "SpanBatch.h"
+
+/**
+ * @brief A watched value that changed between two ticks of a Watcher.
+ */
+struct WatchEvent {
+	size_t id = 0;          // Entry the value belongs to, as returned by Watch or Freeze
+	uintptr_t address = 0;  // Address the value was read from
+	uint64_t oldValue = 0;  // Value seen in the tick before, in the low size bytes
+	uint64_t newValue = 0;  // Value seen in this tick, in the low size bytes
+	uint64_t timestamp = 0; // Start of the tick in nanoseconds of std::chrono::steady_clock
+	uint32_t size = 0;      // Size of the value in bytes
+
+	/**
+	 * @brief Returns the value before the change as the type it was watched as.
+	 */
+	template <typename T>
+	T GetOldValue() const {
+		T value;
+		std::memcpy(&value, &this->oldValue, sizeof(T));
+		return value;
+	}
+
+	/**
+	 * @brief Returns the value after the change as the type it was watched as.
+	 */
+	template <typename T>
+	T GetNewValue() const {
+		T value;
+		std::memcpy(&value, &this->newValue, sizeof(T));
+		return value;
+	}
+};
+
+/**
+ * @brief Settings of a Watcher.
+ */
+struct WatchOptions {
+	double rate = 60.0;           // Ticks per second of the background thread
+	size_t queueCapacity = 65536; // Events the queue holds before further events are dropped
+};
+
+/**
+ * @brief Numbers describing the ticks of a Watcher since it was started.
+ */
+struct WatchStatistics {
+	size_t entryCount = 0;      // Watched and frozen values
+	size_t tickCount = 0;       // Ticks run
+	size_t missedTicks = 0;     // Ticks skipped because a tick or the scheduler ran late
+	size_t eventCount = 0;      // Change events queued
+	size_t droppedEvents = 0;   // Change events lost to a full queue
+	size_t failedReads = 0;     // Values that could not be read, summed over all ticks
+	size_t writeCount = 0;      // Frozen values written back, summed over all ticks
+	double lastTickSeconds = 0; // Time spent in the last tick
+	double maxTickSeconds = 0;  // Longest tick
+	double totalTickSeconds = 0;
+	double maxLateSeconds = 0;  // Largest delay between the scheduled and the actual start of a tick
+	double totalLateSeconds = 0;
+
+	/**
+	 * @brief Returns the average time spent in a tick.
+	 */
+	double GetAverageTickSeconds() const {
+		return this->tickCount ? this->totalTickSeconds / this->tickCount : 0;
+	}
+
+	/**
+	 * @brief Returns the average delay of a tick behind its schedule, the jitter of the watcher.
+	 */
+	double GetAverageLateSeconds() const {
+		return this->tickCount ? this->totalLateSeconds / this->tickCount : 0;
+	}
+};
+
+/**
+ * @brief Watches values of a target process for changes and keeps frozen values in place.
+ *
+ * Values are registered by address or by PointerPath and may be up to 8 bytes. Every tick
+ * resolves the paths through a PointerResolver, reads every value with a single ReadBatch call,
+ * writes every frozen value that drifted back with a single WriteBatch call and publishes a
+ * WatchEvent for every value that differs from the tick before.
+ *
+ * Values lying close together, such as the fields of one object or the elements of an array,
+ * are read as one span, so a batch has one element per cluster of values rather than one per
+ * value. The spans and batches are only rebuilt when an address changes; a tick of a stable
+ * watch list does not sort or allocate anything.
+ *
+ * Start runs the ticks on a background thread at WatchOptions::rate, scheduled against absolute
+ * deadlines so the rate does not drift. Events go into a lock-free EventQueue that a consumer
+ * drains with PollEvent from any thread; several watchers can share one queue through
+ * SetEventQueue. Without Start, Tick runs a single tick on the calling thread.
+ *
+ * Registering and removing values is allowed while the thread runs; the change is picked up by
+ * the next tick.
+ */
+class Watcher {
+public:
+	// Largest value that can be watched or frozen
+	static const size_t kMaxValueSize = sizeof(uint64_t);
+
+private:
+	// Path index of entries watched by address
+	static const size_t kNoPath = (size_t)-1;
+
+	// One watched or frozen value
+	struct Entry {
+		size_t id = 0;
+		PointerPath path;           // Path leading to the value, if pathIndex is set
+		size_t pathIndex = kNoPath; // Index of the path in the resolver
+		uintptr_t address = 0;      // Address of the value, resolved again every tick for paths
+		uint64_t value = 0;         // Value seen in the last tick, valid if known is set
+		uint64_t frozenValue = 0;   // Value written back while frozen
+		uint32_t size = 0;
+		bool frozen = false;
+		bool known = false;
+	};
+
+	// Memory instance attached to the target process
+	Memory& memory;
+
+	// Settings given at construction
+	WatchOptions options;
+
+	// Registered values, and the position of every ID in entries
+	std::vector<Entry> entries;
+	std::unordered_map<size_t, size_t> slots;
+	size_t nextID = 1;
+
+	// Resolves the paths of all entries; rebuilt when a path entry is removed
+	PointerResolver resolver;
+	std::vector<uintptr_t> pathAddresses;
+	bool rebuildPaths = false;
+
+	// Entries with a known address, and the spans covering them in address order; rebuilt when an address changes
+	std::vector<size_t> located;
+	SpanBatch spans;
+	bool layoutChanged = true;
+
+	// Batches reused by every tick: single values of failed spans, and frozen values to restore
+	std::vector<BatchEntry> retries;
+	std::vector<size_t> retrySlots;
+	std::vector<uint64_t> retryValues;
+	std::vector<BatchEntry> writes;
+
+	// Queue owned by the watcher, and the queue events are published to; PollEvent reads it without the mutex
+	EventQueue<WatchEvent> ownQueue;
+	std::atomic<EventQueue<WatchEvent>*> queue;
+
+	// Background thread and its state; mutex also guards the entries and statistics
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool running = false;
+	bool stopping = false;
+
+	// Numbers since the last Start
+	WatchStatistics statistics;
+
+	// Registers a value and returns its ID
+	size_t Add(uintptr_t address, const PointerPath* path, const void* frozenValue, size_t size);
+
+	// Sorts the entries by address and merges neighbours into spans
+	void BuildSpans();
+
+	// Compares a value read in this tick with the last one, publishing the change and queueing a frozen value
+	void Update(Entry& entry, uint64_t value, uint64_t timestamp);
+
+	// Runs one tick; the mutex must be held
+	void TickLocked();
+
+	// Main loop of the background thread
+	void Run();
+
+public:
+	/**
+	 * @brief Creates a watcher for a target process. The thread is started with Start.
+	 *
+	 * @param memory The Memory instance attached to the target, which must outlive the watcher.
+	 * @param options Settings of the watcher.
+	 */
+	explicit Watcher(Memory& memory, const WatchOptions& options = WatchOptions());
+
+	/**
+	 * @brief Stops the background thread.
+	 */
+	~Watcher();
+
+	Watcher(const Watcher&) = delete;
+	Watcher& operator=(const Watcher&) = delete;
+
+	/**
+	 * @brief Watches the value at an address for changes.
+	 *
+	 * @return The ID of the entry, found in the events of the value.
+	 */
+	template <typename T>
+	size_t Watch(uintptr_t address) {
+		static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= kMaxValueSize, "Watched values must be trivially copyable and at most 8 bytes");
+		return this->Add(address, nullptr, nullptr, sizeof(T));
+	}
+
+	/**
+	 * @brief Watches the value a pointer path leads to, following the path again every tick.
+	 *
+	 * @param path The path, relative to the main module base as in Memory::GetAddress.
+	 * @return The ID of the entry, found in the events of the value.
+	 */
+	template <typename T>
+	size_t Watch(const PointerPath& path) {
+		static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= kMaxValueSize, "Watched values must be trivially copyable and at most 8 bytes");
+		return this->Add(0, &path, nullptr, sizeof(T));
+	}
+
+	/**
+	 * @brief Keeps a value at an address, writing it back whenever the target changes it.
+	 *
+	 * Changes made by the target are still published as events before the value is restored.
+	 *
+	 * @return The ID of the entry.
+	 */
+	template <typename T>
+	size_t Freeze(uintptr_t address, T value) {
+		static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= kMaxValueSize, "Frozen values must be trivially copyable and at most 8 bytes");
+		return this->Add(address, nullptr, &value, sizeof(T));
+	}
+
+	/**
+	 * @brief Keeps the value a pointer path leads to, following the path again every tick.
+	 *
+	 * @return The ID of the entry.
+	 */
+	template <typename T>
+	size_t Freeze(const PointerPath& path, T value) {
+		static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= kMaxValueSize, "Frozen values must be trivially copyable and at most 8 bytes");
+		return this->Add(0, &path, &value, sizeof(T));
+	}
+
+	/**
+	 * @brief Stops watching or freezing a value.
+	 *
+	 * @param id The ID returned by Watch or Freeze.
+	 * @return True if the entry existed, false otherwise.
+	 */
+	bool Remove(size_t id);
+
+	/**
+	 * @brief Removes every entry.
+	 */
+	void Clear();
+
+	/**
+	 * @brief Returns the number of registered entries.
+	 */
+	size_t GetCount();
+
+	/**
+	 * @brief Starts ticking on a background thread and resets the statistics.
+	 *
+	 * @return True if the thread was started, false if it already runs or the rate is not positive.
+	 */
+	bool Start();
+
+	/**
+	 * @brief Stops the background thread after its current tick.
+	 */
+	void Stop();
+
+	/**
+	 * @brief Returns true while the background thread runs.
+	 */
+	bool IsRunning();
+
+	/**
+	 * @brief Runs a single tick on the calling thread, e.g. from the main loop of a tool.
+	 */
+	void Tick();
+
+	/**
+	 * @brief Publishes the events of this watcher to another queue, such as one shared by several watchers.
+	 *
+	 * Must not be called while the background thread runs.
+	 *
+	 * @param queue The queue, which must outlive the watcher, or nullptr for the watcher's own queue.
+	 */
+	void SetEventQueue(EventQueue<WatchEvent>* queue);
+
+	/**
+	 * @brief Takes the oldest change event from the queue. Safe to call from any thread.
+	 *
+	 * @param event Receives the event.
+	 * @return True if an event was taken, false if the queue is empty.
+	 */
+	bool PollEvent(WatchEvent& event);
+
+	/**
+	 * @brief Returns the statistics since the last Start.
+	 */
+	WatchStatistics GetStatistics();
+};
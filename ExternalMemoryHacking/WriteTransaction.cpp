@@ -0,0 +1,220 @@
+#include "WriteTransaction.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+WriteTransaction::WriteTransaction(Memory& memory) : memory(memory) {
+}
+
+bool WriteTransaction::WriteMemory(uintptr_t address, const void* buffer, size_t size) {
+	// The saved bytes describe the committed writes, so the set cannot change until it is rolled back
+	if (this->committed || !size) {
+		return false;
+	}
+
+	Staged write;
+	write.address = address;
+	write.offset = this->staged.size();
+	write.size = size;
+	this->writes.push_back(write);
+
+	const uint8_t* bytes = (const uint8_t*)buffer;
+	this->staged.insert(this->staged.end(), bytes, bytes + size);
+	this->dirty = true;
+	return true;
+}
+
+bool WriteTransaction::WriteString(uintptr_t address, const std::string& value) {
+	// Include the null terminator, like Memory::WriteString
+	return this->WriteMemory(address, value.c_str(), value.length() + 1);
+}
+
+void WriteTransaction::BuildSpans() {
+	this->spans.clear();
+
+	// Visit the writes by address, keeping the staging order among writes at the same address
+	std::vector<size_t> order(this->writes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return this->writes[a].address < this->writes[b].address; });
+
+	// Merge writes that overlap or touch; a gap is never written, since its bytes belong to the target
+	std::vector<size_t> spanOf(this->writes.size());
+	size_t total = 0;
+	for (size_t index : order) {
+		const Staged& write = this->writes[index];
+		if (!this->spans.empty() && write.address <= this->spans.back().address + this->spans.back().size) {
+			Span& span = this->spans.back();
+			size_t end = std::max(span.address + span.size, write.address + write.size) - span.address;
+			total += end - span.size;
+			span.size = end;
+		}
+		else {
+			Span span;
+			span.address = write.address;
+			span.offset = total;
+			span.size = write.size;
+			this->spans.push_back(span);
+			total += write.size;
+		}
+		spanOf[index] = this->spans.size() - 1;
+	}
+
+	// Lay the bytes out in staging order, so a later write wins where writes overlap
+	this->values.assign(total, 0);
+	this->originals.assign(total, 0);
+	for (size_t i = 0; i < this->writes.size(); ++i) {
+		const Staged& write = this->writes[i];
+		const Span& span = this->spans[spanOf[i]];
+		std::memcpy(&this->values[span.offset + (write.address - span.address)], &this->staged[write.offset], write.size);
+	}
+
+	this->dirty = false;
+}
+
+bool WriteTransaction::Commit() {
+	if (this->committed) {
+		return false;
+	}
+
+	if (this->dirty) {
+		this->BuildSpans();
+	}
+
+	if (this->spans.empty()) {
+		return true;
+	}
+
+	// Save the original bytes of every span with one batch; if any of them is unreadable, write nothing
+	this->batch.resize(this->spans.size());
+	for (size_t i = 0; i < this->spans.size(); ++i) {
+		this->batch[i].address = this->spans[i].address;
+		this->batch[i].buffer = &this->originals[this->spans[i].offset];
+		this->batch[i].size = this->spans[i].size;
+	}
+	++this->statistics.batches;
+	if (!this->memory.ReadBatch(this->batch)) {
+		++this->statistics.failedCommits;
+		return false;
+	}
+
+	// Apply every span with one batch
+	for (size_t i = 0; i < this->spans.size(); ++i) {
+		this->batch[i].buffer = &this->values[this->spans[i].offset];
+	}
+	++this->statistics.batches;
+	bool written = this->memory.WriteBatch(this->batch);
+	for (size_t i = 0; i < this->spans.size(); ++i) {
+		this->spans[i].written = this->batch[i].success;
+	}
+
+	if (written) {
+		this->committed = true;
+		++this->statistics.commits;
+		return true;
+	}
+
+	// Undo the spans that were written, so the target does not keep half of the patch
+	++this->statistics.failedCommits;
+	if (!this->Restore()) {
+		// Keep the saved bytes, so Rollback can retry the spans that are still modified
+		this->committed = true;
+	}
+	return false;
+}
+
+bool WriteTransaction::Restore() {
+	this->batch.clear();
+	for (const Span& span : this->spans) {
+		if (span.written) {
+			BatchEntry entry;
+			entry.address = span.address;
+			entry.buffer = &this->originals[span.offset];
+			entry.size = span.size;
+			this->batch.push_back(entry);
+		}
+	}
+
+	if (this->batch.empty()) {
+		return true;
+	}
+
+	++this->statistics.batches;
+	bool restored = this->memory.WriteBatch(this->batch);
+
+	// The entries are in span order, so walk both to clear the flags of the restored spans
+	size_t unrestored = 0;
+	size_t entry = 0;
+	for (Span& span : this->spans) {
+		if (span.written) {
+			span.written = !this->batch[entry++].success;
+			unrestored += span.written;
+		}
+	}
+	this->statistics.unrestoredSpans = unrestored;
+	return restored;
+}
+
+bool WriteTransaction::Rollback() {
+	if (!this->committed) {
+		return false;
+	}
+
+	if (!this->Restore()) {
+		return false;
+	}
+
+	this->committed = false;
+	++this->statistics.rollbacks;
+	return true;
+}
+
+void WriteTransaction::Clear() {
+	this->writes.clear();
+	this->staged.clear();
+	this->spans.clear();
+	this->values.clear();
+	this->originals.clear();
+	this->dirty = false;
+	this->committed = false;
+}
+
+bool WriteTransaction::IsCommitted() const {
+	return this->committed;
+}
+
+size_t WriteTransaction::GetWriteCount() const {
+	return this->writes.size();
+}
+
+size_t WriteTransaction::GetSpanCount() {
+	if (this->dirty) {
+		this->BuildSpans();
+	}
+	return this->spans.size();
+}
+
+bool WriteTransaction::ReadOriginal(uintptr_t address, void* buffer, size_t size) const {
+	if (!this->committed) {
+		return false;
+	}
+
+	// The last span starting at or before the address is the only one that can hold it
+	auto next = std::upper_bound(this->spans.begin(), this->spans.end(), address,
+		[](uintptr_t value, const Span& span) { return value < span.address; });
+	if (next == this->spans.begin()) {
+		return false;
+	}
+
+	const Span& span = *(next - 1);
+	if (address >= span.address + span.size || size > span.address + span.size - address) {
+		return false;
+	}
+
+	std::memcpy(buffer, &this->originals[span.offset + (address - span.address)], size);
+	return true;
+}
+
+WriteTransactionStatistics WriteTransaction::GetStatistics() const {
+	return this->statistics;
+}
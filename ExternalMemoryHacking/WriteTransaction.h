@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Memory.h"
+
+/**
+ * @brief Numbers describing the commits and rollbacks of a WriteTransaction.
+ */
+struct WriteTransactionStatistics {
+	size_t commits = 0;         // Commits that applied every write
+	size_t failedCommits = 0;   // Commits that were undone or never started writing
+	size_t rollbacks = 0;       // Rollbacks that restored every span
+	size_t unrestoredSpans = 0; // Spans left modified because restoring them failed
+	size_t batches = 0;         // ReadBatch and WriteBatch calls made
+};
+
+/**
+ * @brief A set of writes applied to the target together, and undone together.
+ *
+ * Writes are staged first and only reach the target on Commit:
+ *
+ *     WriteTransaction patch(memory);
+ *     patch.Write<int>(player + 0xEC, 1000);
+ *     patch.Write<int>(player + 0x140, 50);
+ *     patch.WriteMemory(recoilCode, nops, sizeof(nops));
+ *     patch.Commit();   // one batched read of the original bytes, one batched write
+ *     ...
+ *     patch.Rollback(); // one batched write of the original bytes
+ *
+ * Commit merges writes that touch or overlap into spans, the later write winning where they
+ * overlap, reads the original bytes of every span with a single ReadBatch and writes every span
+ * with a single WriteBatch. If a span cannot be read nothing is written; if a span cannot be
+ * written the spans that were written are restored, so a failed commit leaves the target as it
+ * was. Writes into read-only pages such as code go through the fallback of WriteBatch.
+ *
+ * Rollback writes the saved bytes back. A rolled back transaction can be committed again, which
+ * saves the original bytes afresh, so one transaction can switch a patch on and off.
+ */
+class WriteTransaction {
+public:
+	/**
+	 * @brief Creates an empty transaction on the process a Memory instance is attached to.
+	 *
+	 * @param memory The attached Memory instance; it must outlive the transaction.
+	 */
+	explicit WriteTransaction(Memory& memory);
+
+	/**
+	 * @brief Stages a write of raw bytes.
+	 *
+	 * @param address The address in the target process to write to.
+	 * @param buffer The bytes to write; they are copied.
+	 * @param size The number of bytes.
+	 * @return False if the transaction is committed or size is 0, in which case nothing is staged.
+	 */
+	bool WriteMemory(uintptr_t address, const void* buffer, size_t size);
+
+	/**
+	 * @brief Stages a write of a string including its null terminator, as Memory::WriteString writes it.
+	 */
+	bool WriteString(uintptr_t address, const std::string& value);
+
+	/**
+	 * @brief Stages a write of a value of type T.
+	 */
+	template <typename T>
+	bool Write(uintptr_t address, const T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Staged values must be trivially copyable");
+		return this->WriteMemory(address, &value, sizeof(T));
+	}
+
+	/**
+	 * @brief Saves the original bytes of every staged write and applies all of them.
+	 *
+	 * @return True if every write was applied. On false the target is unchanged, unless restoring
+	 *         a written span failed as well, which GetStatistics reports.
+	 */
+	bool Commit();
+
+	/**
+	 * @brief Writes the bytes saved by Commit back to the target.
+	 *
+	 * @return True if every span was restored, false if the transaction is not committed or a span failed.
+	 *         The transaction stays committed while a span is not restored, so Rollback can be retried.
+	 */
+	bool Rollback();
+
+	/**
+	 * @brief Drops every staged write and the saved bytes, without writing anything.
+	 */
+	void Clear();
+
+	/**
+	 * @brief Returns true between a successful Commit and a successful Rollback.
+	 */
+	bool IsCommitted() const;
+
+	/**
+	 * @brief Returns the number of staged writes.
+	 */
+	size_t GetWriteCount() const;
+
+	/**
+	 * @brief Returns the number of spans the staged writes merge into, the elements of each batch.
+	 */
+	size_t GetSpanCount();
+
+	/**
+	 * @brief Returns the original bytes saved by the last Commit of a range of a staged write.
+	 *
+	 * @param address The first address of the range.
+	 * @param buffer Receives the bytes.
+	 * @param size The number of bytes.
+	 * @return False if the transaction is not committed or the range is not inside one span.
+	 */
+	bool ReadOriginal(uintptr_t address, void* buffer, size_t size) const;
+
+	/**
+	 * @brief Returns the numbers describing the calls made so far.
+	 */
+	WriteTransactionStatistics GetStatistics() const;
+
+private:
+	// One staged write, its bytes at offset in staged
+	struct Staged {
+		uintptr_t address = 0;
+		size_t offset = 0;
+		size_t size = 0;
+	};
+
+	// A contiguous range written as one batch element, its bytes at offset in the span buffers
+	struct Span {
+		uintptr_t address = 0;
+		size_t offset = 0;
+		size_t size = 0;
+		bool written = false; // The target currently holds the new bytes
+	};
+
+	// Memory instance attached to the target process
+	Memory& memory;
+
+	// Staged writes in the order they were made, and their bytes
+	std::vector<Staged> writes;
+	std::vector<uint8_t> staged;
+
+	// Merged spans, the bytes they write and the bytes they replaced; rebuilt after a write is staged
+	std::vector<Span> spans;
+	std::vector<uint8_t> values;
+	std::vector<uint8_t> originals;
+	bool dirty = false;
+
+	// Batch elements, kept to avoid allocating on every commit
+	std::vector<BatchEntry> batch;
+
+	bool committed = false;
+	WriteTransactionStatistics statistics;
+
+	// Merges the staged writes into spans and lays out their bytes
+	void BuildSpans();
+
+	// Writes the saved bytes of the spans marked written; returns true if all of them were restored
+	bool Restore();
+};
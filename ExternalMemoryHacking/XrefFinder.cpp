@@ -0,0 +1,283 @@
+#include "XrefFinder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	// Prefixes at most this many bytes long are walked back over to find the start of an instruction
+	const size_t kMaxPrefixes = 4;
+
+	// Returns true for the legacy prefixes (operand and address size, rep, lock and segments)
+	bool IsLegacyPrefix(uint8_t value) {
+		switch (value) {
+		case 0x66: case 0x67: case 0xF0: case 0xF2: case 0xF3:
+		case 0x26: case 0x2E: case 0x36: case 0x3E: case 0x64: case 0x65:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Returns true for the REX prefixes of x64
+	bool IsRex(uint8_t value) {
+		return (value & 0xF0) == 0x40;
+	}
+
+	// Returns the size of the immediate after the ModRM operand of a one-byte opcode, or -1 if the opcode takes no ModRM byte
+	int GetImmediateSize(uint8_t opcode, uint8_t modRM, bool operandSize16) {
+		int imm32 = operandSize16 ? 2 : 4;
+		uint8_t reg = (modRM >> 3) & 7;
+
+		// The ALU operations add, or, adc, sbb, and, sub, xor and cmp in their four ModRM forms
+		if (opcode < 0x40 && (opcode & 7) < 4) {
+			return 0;
+		}
+
+		switch (opcode) {
+		case 0x63: case 0x84: case 0x85: case 0x86: case 0x87: case 0x88: case 0x89: case 0x8A: case 0x8B: case 0x8D:
+		case 0xD0: case 0xD1: case 0xD2: case 0xD3: case 0xFE: case 0xFF:
+			return 0;
+		case 0x6B: case 0x80: case 0x83: case 0xC0: case 0xC1: case 0xC6:
+			return 1;
+		case 0x69: case 0x81: case 0xC7:
+			return imm32;
+		case 0xF6:
+			return reg < 2 ? 1 : 0;
+		case 0xF7:
+			return reg < 2 ? imm32 : 0;
+		default:
+			return -1;
+		}
+	}
+
+	// Returns the size of the immediate after the ModRM operand of a 0F xx opcode, or -1 if it is not one of the common ones
+	int GetTwoByteImmediateSize(uint8_t opcode) {
+		if ((opcode >= 0x10 && opcode <= 0x17) || (opcode >= 0x28 && opcode <= 0x2F) || (opcode & 0xF0) == 0x40 ||
+			(opcode >= 0x51 && opcode <= 0x5F) || (opcode & 0xF0) == 0x90) {
+			return 0;
+		}
+
+		switch (opcode) {
+		case 0x6E: case 0x6F: case 0x7E: case 0x7F: case 0xAF: case 0xB6: case 0xB7: case 0xBE: case 0xBF: case 0xD6: case 0xE6: case 0xE7:
+			return 0;
+		case 0x70: case 0xBA: case 0xC2: case 0xC6:
+			return 1;
+		default:
+			return -1;
+		}
+	}
+
+	// Walks back from the opcode over a REX prefix and legacy prefixes; returns the start and whether 66 was seen
+	size_t FindStart(const uint8_t* data, size_t opcode, bool x64, bool& operandSize16) {
+		size_t start = opcode;
+		if (x64 && start > 0 && IsRex(data[start - 1])) {
+			--start;
+		}
+
+		operandSize16 = false;
+		for (size_t i = 0; i < kMaxPrefixes && start > 0 && IsLegacyPrefix(data[start - 1]); ++i) {
+			operandSize16 |= data[--start] == 0x66;
+		}
+		return start;
+	}
+
+	// Reads a little endian value of 4 or 8 bytes
+	uint64_t ReadValue(const uint8_t* data, size_t size) {
+		if (size == 4) {
+			uint32_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		uint64_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+}
+
+XrefFinder::XrefFinder(const std::vector<uintptr_t>& targets, const XrefOptions& options) : targets(targets), options(options) {
+	std::sort(this->targets.begin(), this->targets.end());
+	this->targets.erase(std::unique(this->targets.begin(), this->targets.end()), this->targets.end());
+
+	// Every opcode that can carry a RIP-relative operand, as a one-byte opcode or as the second byte of 0F xx
+	for (int value = 0; value < 0x100; ++value) {
+		if (GetImmediateSize((uint8_t)value, 0, false) >= 0 || GetTwoByteImmediateSize((uint8_t)value) >= 0) {
+			this->opcodes.Add((uint8_t)value);
+		}
+	}
+
+	// ModRM with mod 00 and rm 101, for every register
+	for (int reg = 0; reg < 8; ++reg) {
+		this->ripModRM.Add((uint8_t)(0x05 | (reg << 3)));
+	}
+}
+
+uintptr_t XrefFinder::FindTarget(uintptr_t value) const {
+	auto next = std::upper_bound(this->targets.begin(), this->targets.end(), value);
+	if (next == this->targets.begin()) {
+		return 0;
+	}
+
+	uintptr_t target = *(next - 1);
+	return value - target <= this->options.maxOffset ? target : 0;
+}
+
+bool XrefFinder::DecodeRipRelative(const uint8_t* data, size_t size, size_t offset, uintptr_t base, CodeReference& reference) const {
+	uint8_t opcode = data[offset];
+	uint8_t modRM = data[offset + 1];
+	int32_t displacement;
+	std::memcpy(&displacement, data + offset + 2, sizeof(displacement));
+
+	// A 0F before the opcode makes it a two-byte opcode; if that does not lead to a target, try the one-byte reading
+	for (int twoByte = 1; twoByte >= 0; --twoByte) {
+		if (twoByte && (offset == 0 || data[offset - 1] != 0x0F)) {
+			continue;
+		}
+
+		bool operandSize16 = false;
+		size_t start = FindStart(data, twoByte ? offset - 1 : offset, true, operandSize16);
+		int immediate = twoByte ? GetTwoByteImmediateSize(opcode) : GetImmediateSize(opcode, modRM, operandSize16);
+		size_t end = offset + 2 + sizeof(displacement) + immediate;
+		if (immediate < 0 || end > size) {
+			continue;
+		}
+
+		// RIP points at the end of the instruction, after the immediate
+		uintptr_t value = base + end + (intptr_t)displacement;
+		uintptr_t target = this->FindTarget(value);
+		if (!target) {
+			continue;
+		}
+
+		reference.address = base + start;
+		reference.target = target;
+		reference.value = value;
+		reference.length = (uint8_t)(end - start);
+		reference.kind = XrefKind::RipRelative;
+		return true;
+	}
+	return false;
+}
+
+bool XrefFinder::DecodeAbsolute(const uint8_t* data, size_t size, size_t offset, size_t valueSize, uintptr_t base, CodeReference& reference) const {
+	uintptr_t value = (uintptr_t)ReadValue(data + offset, valueSize);
+	uintptr_t target = this->FindTarget(value);
+	if (!target || offset == 0) {
+		return false;
+	}
+
+	bool x64 = this->options.x64;
+	uint8_t previous = data[offset - 1];
+	bool rexW = offset >= 2 && x64 && IsRex(data[offset - 2]) && (data[offset - 2] & 0x08);
+	size_t opcode = 0, end = 0;
+	bool operandSize16 = false;
+
+	// disp32 without a base register: ModRM mod 00 rm 101 on x86, or a SIB byte with base 101 on both
+	size_t modRM = 0;
+	if (!x64 && offset >= 2 && (previous & 0xC7) == 0x05) {
+		modRM = offset - 1;
+	}
+	else if (offset >= 3 && (previous & 0x07) == 0x05 && (data[offset - 2] & 0xC7) == 0x04) {
+		modRM = offset - 2;
+	}
+
+	int immediate = -1;
+	if (valueSize == 4 && modRM) {
+		uint8_t code = data[modRM - 1];
+		bool twoByte = modRM >= 2 && data[modRM - 2] == 0x0F && GetTwoByteImmediateSize(code) >= 0;
+		opcode = twoByte ? modRM - 2 : modRM - 1;
+		FindStart(data, opcode, x64, operandSize16);
+		immediate = twoByte ? GetTwoByteImmediateSize(code) : GetImmediateSize(code, data[modRM], operandSize16);
+	}
+
+	if (immediate >= 0) {
+		end = offset + 4 + immediate;
+	}
+	else if (valueSize == 8) {
+		// movabs r64, imm64 and mov rax, [moffs64] need REX.W
+		if (!rexW || !((previous >= 0xB8 && previous <= 0xBF) || (previous >= 0xA0 && previous <= 0xA3))) {
+			return false;
+		}
+		opcode = offset - 1;
+		end = offset + 8;
+	}
+	else if ((previous >= 0xB8 && previous <= 0xBF && !rexW) || previous == 0x68 || previous == 0xA9 ||
+		(previous < 0x40 && (previous & 7) == 5) || (!x64 && previous >= 0xA0 && previous <= 0xA3)) {
+		// mov r32, imm32, push imm32, test/ALU eax, imm32 and, on x86, mov eax, [moffs32]
+		opcode = offset - 1;
+		end = offset + 4;
+	}
+	else if (offset >= 2 && (previous >> 6) == 3 && (data[offset - 2] == 0x69 || data[offset - 2] == 0x81 || data[offset - 2] == 0xC7)) {
+		// imul/ALU/mov with a register operand and an imm32
+		opcode = offset - 2;
+		end = offset + 4;
+	}
+	else {
+		return false;
+	}
+
+	if (end > size) {
+		return false;
+	}
+
+	size_t start = FindStart(data, opcode, x64, operandSize16);
+	reference.address = base + start;
+	reference.target = target;
+	reference.value = value;
+	reference.length = (uint8_t)(end - start);
+	reference.kind = valueSize == 8 ? XrefKind::Absolute64 : XrefKind::Absolute32;
+	return true;
+}
+
+void XrefFinder::Find(const uint8_t* data, size_t size, size_t first, size_t limit, uintptr_t base, std::vector<CodeReference>& references, SimdLevel level) const {
+	if (this->targets.empty()) {
+		return;
+	}
+
+	std::vector<uint32_t> candidates;
+	CodeReference reference;
+
+	// RIP-relative: an opcode followed by a RIP-relative ModRM, with the displacement at +2
+	if (this->options.x64 && this->options.ripRelative) {
+		ByteSet::FindPairs(this->opcodes, this->ripModRM, data, size, candidates, level);
+		for (uint32_t offset : candidates) {
+			if (offset + 2 >= first && offset + 2 < limit && offset + 6 <= size && this->DecodeRipRelative(data, size, offset, base, reference)) {
+				references.push_back(reference);
+			}
+		}
+	}
+
+	if (!this->options.absolute) {
+		return;
+	}
+
+	// Absolute: every byte position holding a value between the lowest and the highest target
+	uint64_t low = this->targets.front();
+	uint64_t high = (uint64_t)this->targets.back() + this->options.maxOffset;
+	ScanInput input;
+	input.data = data;
+	input.size = size;
+	input.first = first;
+	input.limit = limit;
+	input.stride = 1;
+
+	if (high <= UINT32_MAX) {
+		candidates.clear();
+		ScanKernel<uint32_t>::Find(ScanPredicate<uint32_t>::Between((uint32_t)low, (uint32_t)high), input, candidates, level);
+		for (uint32_t offset : candidates) {
+			if (this->DecodeAbsolute(data, size, offset, 4, base, reference)) {
+				references.push_back(reference);
+			}
+		}
+	}
+
+	if (this->options.x64 && sizeof(uintptr_t) == 8) {
+		candidates.clear();
+		ScanKernel<uint64_t>::Find(ScanPredicate<uint64_t>::Between(low, high), input, candidates, level);
+		for (uint32_t offset : candidates) {
+			if (this->DecodeAbsolute(data, size, offset, 8, base, reference)) {
+				references.push_back(reference);
+			}
+		}
+	}
+}
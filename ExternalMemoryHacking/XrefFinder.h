@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ScanKernels.h"
+
+/**
+ * @brief How an instruction refers to an address.
+ */
+enum class XrefKind {
+	RipRelative, // [rip + disp32], x64 only
+	Absolute32,  // 32-bit immediate, moffs or disp32 without a base register
+	Absolute64   // 64-bit immediate or moffs, x64 only
+};
+
+/**
+ * @brief Settings of a cross-reference search.
+ */
+struct XrefOptions {
+	bool x64 = sizeof(void*) == 8; // Decode the code as x64 instead of 32-bit x86
+	bool ripRelative = true;       // Find [rip + disp32] operands
+	bool absolute = true;          // Find absolute immediates and displacements
+	size_t maxOffset = 0;          // Also report references up to this many bytes past a target, e.g. to fields of a global
+};
+
+/**
+ * @brief One instruction referring to one of the searched addresses.
+ */
+struct CodeReference {
+	uintptr_t address = 0;             // First byte of the instruction, prefixes included
+	uintptr_t target = 0;              // Searched address the reference belongs to
+	uintptr_t value = 0;               // Address the operand refers to, target plus at most maxOffset
+	uint8_t length = 0;                // Length of the instruction in bytes
+	XrefKind kind = XrefKind::RipRelative;
+};
+
+/**
+ * @brief Finds the x86 and x64 instructions that refer to a set of addresses, such as static globals.
+ *
+ * Hardcoded offsets like the one in GetAddress(0x17E0A8, ...) move with every build of the target,
+ * but the code using them still refers to the same global, so finding the instructions that
+ * refer to the old address in the old build gives the signature to find the new one.
+ *
+ * Candidates are found with the vector kernels before anything is decoded:
+ * - RIP-relative operands with one ByteSet::FindPairs pass for an opcode that takes a ModRM byte
+ *   (one-byte opcodes and the common 0F xx ones: mov, lea, cmp, test, the ALU operations,
+ *   movzx/movsx, cmovcc, setcc and SSE moves and compares) followed by a ModRM byte with
+ *   mod 00 and rm 101;
+ * - absolute references with a ScanKernel range search over every byte for 32-bit and, on x64,
+ *   64-bit values between the lowest and the highest target.
+ *
+ * A small length decoder then confirms each candidate: for RIP-relative operands it works out the
+ * size of the immediate following the displacement, which the end of the instruction and so the
+ * referenced address depend on; for absolute values it checks that an opcode taking an immediate,
+ * a moffs or a disp32 without a base register precedes them. Only references landing on a target
+ * (or up to maxOffset past it) are kept, so the rare false candidate is filtered by its value.
+ */
+class XrefFinder {
+private:
+	// Searched addresses in ascending order
+	std::vector<uintptr_t> targets;
+
+	// Settings given at construction
+	XrefOptions options;
+
+	// Opcodes taking a ModRM byte, and the ModRM bytes of a RIP-relative operand
+	ByteSet opcodes;
+	ByteSet ripModRM;
+
+	// Returns the target a referenced address belongs to, or 0
+	uintptr_t FindTarget(uintptr_t value) const;
+
+	// Confirms a RIP-relative candidate with the opcode at offset
+	bool DecodeRipRelative(const uint8_t* data, size_t size, size_t offset, uintptr_t base, CodeReference& reference) const;
+
+	// Confirms an absolute candidate with the value at offset
+	bool DecodeAbsolute(const uint8_t* data, size_t size, size_t offset, size_t valueSize, uintptr_t base, CodeReference& reference) const;
+
+public:
+	// Bytes an instruction may start before the operand a candidate is found at, and extend past it
+	static const size_t kLookBehind = 8;
+	static const size_t kLookAhead = 16;
+
+	/**
+	 * @brief Prepares a search for references to a set of addresses.
+	 *
+	 * @param targets The addresses to find references to, in any order.
+	 * @param options The instruction set and the kinds of references to find.
+	 */
+	XrefFinder(const std::vector<uintptr_t>& targets, const XrefOptions& options = XrefOptions());
+
+	/**
+	 * @brief Searches a local copy of code for references.
+	 *
+	 * References are reported once, by the position of their displacement or immediate, which has
+	 * to lie in [first, limit). Instructions may start up to kLookBehind bytes before first and end
+	 * up to kLookAhead bytes after limit, so consecutive blocks should overlap by that much.
+	 *
+	 * @param data The local copy of the code.
+	 * @param size The number of valid bytes in data; must be below 4 GiB.
+	 * @param first Operands must start at or after this offset.
+	 * @param limit Operands must start below this offset.
+	 * @param base The address of data[0] in the target process.
+	 * @param references Receives the references; the order is by kind and then by address.
+	 * @param level The highest instruction set to use, clamped to what the CPU supports.
+	 */
+	void Find(const uint8_t* data, size_t size, size_t first, size_t limit, uintptr_t base, std::vector<CodeReference>& references, SimdLevel level = SimdLevel::AVX2) const;
+};